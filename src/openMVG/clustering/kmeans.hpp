@@ -12,6 +12,7 @@
 #include "openMVG/clustering/kmeans_trait.hpp"
 #include "openMVG/numeric/eigen_alias_definition.hpp"
 
+#include <algorithm>
 #include <limits>
 #include <random>
 #include <vector>
@@ -128,6 +129,8 @@ std::vector< DataType > ComputeCenterOfMass( const std::vector< DataType > & pts
 * @param nb_cluster requested number of cluster in the output
 * @param max_nb_iteration maximum number of iteration to do for clustering
 * @note This is the standard llyod algorithm
+* @note With the Kmeans++ initialization, less than nb_cluster centers are
+*  returned if the input data has less than nb_cluster distinct points
 */
 template< typename DataType >
 void KMeans( const std::vector< DataType > & source_data,
@@ -164,6 +167,13 @@ void KMeans( const std::vector< DataType > & source_data,
     {
       // Compute Di / \sum Di pdf
       MinimumDistanceToAnyCenter( source_data, centers, dists );
+      // All the points lie on the existing centers (i.e. duplicated points):
+      // the pdf is undefined and no other center can be found
+      if( std::all_of( dists.cbegin(), dists.cend(),
+            []( const typename trait::scalar_type d ) { return !( d > 0 ); } ) )
+      {
+        break;
+      }
       std::discrete_distribution<size_t> distrib_c( dists.cbegin(), dists.cend() );
 
       // Sample a point from this distribution
@@ -214,7 +224,7 @@ void KMeans( const std::vector< DataType > & source_data,
     }
 
     // 2.2 Compute new centers of mass
-    centers = ComputeCenterOfMass( source_data, cluster_assignment, nb_cluster );
+    centers = ComputeCenterOfMass( source_data, cluster_assignment, centers.size() );
 
     ++id_iteration;
   }
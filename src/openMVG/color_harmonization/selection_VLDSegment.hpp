@@ -13,6 +13,8 @@
 #include <vector>
 
 #include "openMVG/color_harmonization/selection_interface.hpp"
+#include "openMVG/image/image_converter.hpp"
+#include "openMVG/image/image_io.hpp"
 #include "openMVG/matching/kvld/kvld.h"
 #include "openMVG/matching/kvld/kvld_draw.h"
 
@@ -26,10 +28,13 @@ class commonDataByPair_VLDSegment  : public commonDataByPair
                                const std::string & sRightImage,
                                const std::vector<matching::IndMatch>& vec_PutativeMatches,
                                const std::vector<features::SIOPointFeature >& vec_featsL,
-                               const std::vector<features::SIOPointFeature >& vec_featsR):
+                               const std::vector<features::SIOPointFeature >& vec_featsR,
+                               const image::Image<image::RGBColor> * imageL = nullptr,
+                               const image::Image<image::RGBColor> * imageR = nullptr):
            commonDataByPair( sLeftImage, sRightImage ),
            _vec_featsL( vec_featsL ), _vec_featsR( vec_featsR ),
-           _vec_PutativeMatches( vec_PutativeMatches )
+           _vec_PutativeMatches( vec_PutativeMatches ),
+           _imageL( imageL ), _imageR( imageR )
   {}
 
   ~commonDataByPair_VLDSegment() override = default;
@@ -49,8 +54,15 @@ class commonDataByPair_VLDSegment  : public commonDataByPair
     std::vector<matching::IndMatch> vec_KVLDMatches;
 
     image::Image<unsigned char> imageL, imageR;
-    image::ReadImage( _sLeftImage.c_str(), &imageL );
-    image::ReadImage( _sRightImage.c_str(), &imageR );
+    // Use the already decoded images if any, else read them from disk
+    if ( _imageL )
+      image::ConvertPixelType( *_imageL, &imageL );
+    else
+      image::ReadImage( _sLeftImage.c_str(), &imageL );
+    if ( _imageR )
+      image::ConvertPixelType( *_imageR, &imageR );
+    else
+      image::ReadImage( _sRightImage.c_str(), &imageR );
 
     image::Image<float> imgA ( imageL.GetMat().cast<float>() );
     image::Image<float> imgB(imageR.GetMat().cast<float>());
@@ -113,6 +125,9 @@ private:
   std::vector<features::SIOPointFeature > _vec_featsL, _vec_featsR;
   // Left and Right corresponding index (putatives matches)
   std::vector<matching::IndMatch> _vec_PutativeMatches;
+  // Optional decoded Left and Right images (not owned)
+  const image::Image<image::RGBColor> * _imageL;
+  const image::Image<image::RGBColor> * _imageR;
 };
 
 }  // namespace color_harmonization
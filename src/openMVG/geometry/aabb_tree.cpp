@@ -0,0 +1,67 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/geometry/aabb_tree.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace openMVG{
+namespace geometry{
+
+// Maximal number of boxes per leaf
+static const uint32_t kLeafSize = 4;
+
+AABB_Tree::AABB_Tree(const std::vector<AABB> & boxes)
+  : boxes_(boxes)
+{
+  indexes_.resize(boxes_.size());
+  std::iota(indexes_.begin(), indexes_.end(), 0);
+  if (!boxes_.empty())
+  {
+    nodes_.reserve(2 * boxes_.size() / kLeafSize + 1);
+    Build(0, boxes_.size());
+  }
+}
+
+int32_t AABB_Tree::Build(const uint32_t begin, const uint32_t end)
+{
+  const int32_t node_index = nodes_.size();
+  nodes_.push_back({AABB(), begin, end, -1, -1});
+
+  AABB box, centers;
+  box.setEmpty();
+  centers.setEmpty();
+  for (uint32_t i = begin; i < end; ++i)
+  {
+    box.extend(boxes_[indexes_[i]]);
+    centers.extend(boxes_[indexes_[i]].center());
+  }
+  nodes_[node_index].box = box;
+
+  if (end - begin > kLeafSize)
+  {
+    // Median split along the largest axis of the box centers
+    int axis;
+    centers.sizes().maxCoeff(&axis);
+    const uint32_t middle = begin + (end - begin) / 2;
+    std::nth_element(indexes_.begin() + begin, indexes_.begin() + middle, indexes_.begin() + end,
+      [&](const uint32_t lhs, const uint32_t rhs)
+      {
+        return boxes_[lhs].center()(axis) < boxes_[rhs].center()(axis);
+      });
+    const int32_t left = Build(begin, middle);
+    const int32_t right = Build(middle, end);
+    nodes_[node_index].left = left;
+    nodes_[node_index].right = right;
+  }
+  return node_index;
+}
+
+} // namespace geometry
+} // namespace openMVG
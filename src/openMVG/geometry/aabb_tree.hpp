@@ -0,0 +1,95 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_GEOMETRY_AABB_TREE_HPP
+#define OPENMVG_GEOMETRY_AABB_TREE_HPP
+
+#include "openMVG/numeric/eigen_alias_definition.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace openMVG
+{
+namespace geometry
+{
+
+/**
+* @brief Bounding volume hierarchy over a set of axis aligned bounding boxes:
+*  - binary tree built by median split of the box centers along the largest axis,
+*  - used to list the boxes that overlap a query box without testing all the boxes
+*    (i.e. broad phase of the frustum intersection test).
+*/
+class AABB_Tree
+{
+public:
+  using AABB = Eigen::AlignedBox<double, 3>;
+
+  /**
+  * @brief Build the tree
+  * @param boxes The indexed boxes (Query reports their index)
+  */
+  explicit AABB_Tree(const std::vector<AABB> & boxes);
+
+  /**
+  * @brief Call functor(box_index) for all the boxes that overlap the query box
+  *  (boxes that touch are considered overlapping)
+  * @param box The query box
+  * @param functor The callback
+  */
+  template <typename Functor>
+  void Query(const AABB & box, Functor functor) const
+  {
+    if (nodes_.empty())
+      return;
+    std::vector<uint32_t> stack(1, 0);
+    while (!stack.empty())
+    {
+      const Node & node = nodes_[stack.back()];
+      stack.pop_back();
+      if (!node.box.intersects(box))
+        continue;
+      if (node.left < 0) // leaf
+      {
+        for (uint32_t i = node.begin; i < node.end; ++i)
+        {
+          if (boxes_[indexes_[i]].intersects(box))
+            functor(indexes_[i]);
+        }
+      }
+      else
+      {
+        stack.push_back(node.left);
+        stack.push_back(node.right);
+      }
+    }
+  }
+
+  /// Number of indexed boxes
+  size_t size() const { return boxes_.size(); }
+
+private:
+
+  struct Node
+  {
+    AABB box;
+    uint32_t begin, end;  // Range of the node boxes in indexes_
+    int32_t left, right;  // Children nodes (-1 for a leaf)
+  };
+
+  int32_t Build(const uint32_t begin, const uint32_t end);
+
+  std::vector<AABB> boxes_;
+  std::vector<uint32_t> indexes_; // Box indexes sorted by node
+  std::vector<Node> nodes_;       // nodes_[0] is the root
+};
+
+} // namespace geometry
+} // namespace openMVG
+
+#endif // OPENMVG_GEOMETRY_AABB_TREE_HPP
@@ -0,0 +1,60 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/geometry/aabb_tree.hpp"
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace openMVG;
+using namespace openMVG::geometry;
+
+TEST(AABB_Tree, Empty)
+{
+  const AABB_Tree tree({});
+  int count = 0;
+  tree.Query(AABB_Tree::AABB(Vec3::Zero(), Vec3::Ones()), [&](uint32_t) { ++count; });
+  EXPECT_EQ(0, count);
+}
+
+TEST(AABB_Tree, Query)
+{
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::uniform_real_distribution<double> position(0.0, 100.0);
+  std::uniform_real_distribution<double> size(0.1, 5.0);
+
+  const int nb_boxes = 1000;
+  std::vector<AABB_Tree::AABB> boxes;
+  for (int i = 0; i < nb_boxes; ++i)
+  {
+    const Vec3 min(position(random_generator), position(random_generator), position(random_generator));
+    boxes.emplace_back(min, min + Vec3(size(random_generator), size(random_generator), size(random_generator)));
+  }
+  const AABB_Tree tree(boxes);
+  EXPECT_EQ(nb_boxes, tree.size());
+
+  // The tree lists the same boxes as an exhaustive search
+  for (int i = 0; i < nb_boxes; ++i)
+  {
+    std::vector<uint32_t> found, expected;
+    tree.Query(boxes[i], [&](const uint32_t j) { found.push_back(j); });
+    for (int j = 0; j < nb_boxes; ++j)
+    {
+      if (boxes[i].intersects(boxes[j]))
+        expected.push_back(j);
+    }
+    std::sort(found.begin(), found.end());
+    EXPECT_TRUE(found == expected);
+  }
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
@@ -8,8 +8,10 @@
 
 #include "openMVG/geometry/frustum.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <iomanip>
+#include <limits>
 
 namespace openMVG{
 namespace geometry{
@@ -139,6 +141,145 @@ const std::vector<Vec3> & Frustum::frustum_points() const
   return points;
 }
 
+namespace
+{
+
+/// Convex polytope description used by the separating axis test:
+/// the volume is the convex hull of the vertices extended along the rays.
+struct SAT_Polytope
+{
+  Vec3 vertices[8];
+  Vec3 rays[4];
+  Vec3 edges[6];   // Edge directions
+  Vec3 normals[6]; // Face normals
+  int nb_vertices = 0, nb_rays = 0, nb_edges = 0, nb_normals = 0;
+};
+
+bool Make_SAT_Polytope(const Frustum & frustum, SAT_Polytope & polytope)
+{
+  if (frustum.isTruncated() && frustum.points.size() == 8)
+  {
+    // Near (0-3) and far (4-7) rectangles
+    for (int i = 0; i < 8; ++i)
+      polytope.vertices[i] = frustum.points[i];
+    polytope.nb_vertices = 8;
+    for (int i = 0; i < 4; ++i)
+      polytope.edges[i] = frustum.points[i + 4] - frustum.points[i];
+    polytope.edges[4] = frustum.points[1] - frustum.points[0];
+    polytope.edges[5] = frustum.points[3] - frustum.points[0];
+    polytope.nb_edges = 6;
+  }
+  else if (frustum.isInfinite())
+  {
+    // Apex and the 4 cone rays
+    polytope.vertices[0] = frustum.cones[0];
+    polytope.nb_vertices = 1;
+    for (int i = 0; i < 4; ++i)
+    {
+      polytope.rays[i] = polytope.edges[i] = frustum.cones[i + 1] - frustum.cones[0];
+    }
+    polytope.nb_rays = polytope.nb_edges = 4;
+  }
+  else
+  {
+    return false;
+  }
+  for (const Half_plane & plane : frustum.planes)
+    polytope.normals[polytope.nb_normals++] = plane.normal();
+  return true;
+}
+
+/// Projection interval of a polytope on an axis (infinite bounds along the rays)
+void Project
+(
+  const SAT_Polytope & polytope,
+  const Vec3 & axis,
+  double & min,
+  double & max
+)
+{
+  min = std::numeric_limits<double>::infinity();
+  max = -std::numeric_limits<double>::infinity();
+  for (int i = 0; i < polytope.nb_vertices; ++i)
+  {
+    const double d = axis.dot(polytope.vertices[i]);
+    min = std::min(min, d);
+    max = std::max(max, d);
+  }
+  // A ray (almost) orthogonal to the axis does not extend the interval
+  // (i.e. the rays of a face projected on the face normal)
+  const double tolerance = 1e-9;
+  for (int i = 0; i < polytope.nb_rays; ++i)
+  {
+    const double d = axis.dot(polytope.rays[i]);
+    const double eps = tolerance * axis.norm() * polytope.rays[i].norm();
+    if (d > eps)
+      max = std::numeric_limits<double>::infinity();
+    else if (d < -eps)
+      min = -std::numeric_limits<double>::infinity();
+  }
+}
+
+/// Tell if the polytopes projections are disjoint on the axis
+bool IsSeparatingAxis
+(
+  const SAT_Polytope & lhs,
+  const SAT_Polytope & rhs,
+  const Vec3 & axis
+)
+{
+  double min_lhs, max_lhs, min_rhs, max_rhs;
+  Project(lhs, axis, min_lhs, max_lhs);
+  Project(rhs, axis, min_rhs, max_rhs);
+  return max_lhs < min_rhs || max_rhs < min_lhs;
+}
+
+} // namespace
+
+bool Frustum::intersect_SAT(const Frustum & rhs) const
+{
+  SAT_Polytope polytope_lhs, polytope_rhs;
+  if (!Make_SAT_Polytope(*this, polytope_lhs) || !Make_SAT_Polytope(rhs, polytope_rhs))
+  {
+    // Not a frustum volume, use the linear program test
+    return intersect(rhs);
+  }
+
+  // Two convex polytopes do not intersect iff their projections are disjoint
+  // on one of the axes: the face normals and the edge cross products.
+  for (int i = 0; i < polytope_lhs.nb_normals; ++i)
+    if (IsSeparatingAxis(polytope_lhs, polytope_rhs, polytope_lhs.normals[i]))
+      return false;
+  for (int i = 0; i < polytope_rhs.nb_normals; ++i)
+    if (IsSeparatingAxis(polytope_lhs, polytope_rhs, polytope_rhs.normals[i]))
+      return false;
+  for (int i = 0; i < polytope_lhs.nb_edges; ++i)
+  {
+    const Vec3 & edge_lhs = polytope_lhs.edges[i];
+    for (int j = 0; j < polytope_rhs.nb_edges; ++j)
+    {
+      const Vec3 & edge_rhs = polytope_rhs.edges[j];
+      const Vec3 axis = edge_lhs.cross(edge_rhs);
+      // Skip parallel edges
+      if (axis.squaredNorm() <= 1e-20 * edge_lhs.squaredNorm() * edge_rhs.squaredNorm())
+        continue;
+      if (IsSeparatingAxis(polytope_lhs, polytope_rhs, axis))
+        return false;
+    }
+  }
+  return true;
+}
+
+bool Frustum::bounding_box(Eigen::AlignedBox<double, 3> & box) const
+{
+  if (!isTruncated() || points.empty())
+    return false;
+  box.setEmpty();
+  for (const Vec3 & point : points)
+    box.extend(point);
+  return true;
+}
+
 bool Frustum::export_Ply
 (
   const Frustum & frustum,
@@ -129,6 +129,23 @@ struct Frustum : public HalfPlaneObject
   */
   const std::vector<Vec3> & frustum_points() const;
 
+  /**
+  * @brief Test if two frustums intersect with the separating axis theorem
+  *  (exact convex polytope test on the frustum vertices and edge directions,
+  *  no linear program is solved as in HalfPlaneObject::intersect)
+  * @param rhs Another frustum
+  * @retval true If a non empty intersection exists
+  * @retval false If there's no intersection
+  */
+  bool intersect_SAT(const Frustum & rhs) const;
+
+  /**
+  * @brief Compute the axis aligned bounding box of a truncated frustum
+  * @param[out] box The frustum bounding box
+  * @retval false If the frustum is not truncated (unbounded volume)
+  */
+  bool bounding_box(Eigen::AlignedBox<double, 3> & box) const;
+
   /**
   * @brief Export the Frustum as a PLY file (infinite frustum as exported as a normalized cone)
   * @return true if the file can be saved on disk
@@ -17,6 +17,7 @@
 #include "testing/testing.h"
 
 #include <iostream>
+#include <random>
 
 using namespace openMVG;
 using namespace openMVG::geometry;
@@ -54,8 +55,10 @@ TEST(frustum, intersection)
       for (int j = 0; j < iNviews; ++j)
       {
         EXPECT_TRUE(vec_frustum[i].intersect(vec_frustum[j]));
+        EXPECT_TRUE(vec_frustum[i].intersect_SAT(vec_frustum[j]));
         // check test symmetry
         EXPECT_TRUE(vec_frustum[j].intersect(vec_frustum[i]));
+        EXPECT_TRUE(vec_frustum[j].intersect_SAT(vec_frustum[i]));
       }
   }
 
@@ -86,8 +89,10 @@ TEST(frustum, intersection)
       for (int j = 0; j < iNviews; ++j)
       {
         EXPECT_TRUE(vec_frustum[i].intersect(vec_frustum[j]));
+        EXPECT_TRUE(vec_frustum[i].intersect_SAT(vec_frustum[j]));
         // Check test symmetry
         EXPECT_TRUE(vec_frustum[j].intersect(vec_frustum[i]));
+        EXPECT_TRUE(vec_frustum[j].intersect_SAT(vec_frustum[i]));
       }
   }
 }
@@ -129,10 +134,12 @@ TEST(frustum, empty_intersection)
         if (i == j) // Same frustum (intersection must exist)
         {
           EXPECT_TRUE(vec_frustum[i].intersect(vec_frustum[j]));
+          EXPECT_TRUE(vec_frustum[i].intersect_SAT(vec_frustum[j]));
         }
         else // different frustum
         {
           EXPECT_FALSE(vec_frustum[i].intersect(vec_frustum[j]));
+          EXPECT_FALSE(vec_frustum[i].intersect_SAT(vec_frustum[j]));
         }
       }
     }
@@ -169,16 +176,73 @@ TEST(frustum, empty_intersection)
         if (i == j) // Same frustum (intersection must exist)
         {
           EXPECT_TRUE(vec_frustum[i].intersect(vec_frustum[j]));
+          EXPECT_TRUE(vec_frustum[i].intersect_SAT(vec_frustum[j]));
         }
         else // different frustum
         {
           EXPECT_FALSE(vec_frustum[i].intersect(vec_frustum[j]));
+          EXPECT_FALSE(vec_frustum[i].intersect_SAT(vec_frustum[j]));
         }
       }
     }
   }
 }
 
+// Compare the separating axis test to the linear program test (reference)
+TEST(frustum, intersection_SAT_vs_LP)
+{
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::uniform_real_distribution<double> position(-5.0, 5.0);
+  std::uniform_real_distribution<double> angle(-M_PI, M_PI);
+  std::uniform_real_distribution<double> depth(0.1, 4.0);
+
+  Mat3 K;
+  K << 1000, 0, 500,
+       0, 1000, 500,
+       0, 0, 1;
+
+  const int nb_frustums = 60;
+  std::vector<Frustum> truncated_frustums, infinite_frustums;
+  for (int i = 0; i < nb_frustums; ++i)
+  {
+    const Mat3 R =
+      RotationAroundX(angle(random_generator)) *
+      RotationAroundY(angle(random_generator)) *
+      RotationAroundZ(angle(random_generator));
+    const Vec3 C(position(random_generator), position(random_generator), position(random_generator));
+    const double z_near = depth(random_generator);
+    truncated_frustums.emplace_back(1000, 1000, K, R, C, z_near, z_near + depth(random_generator));
+    infinite_frustums.emplace_back(1000, 1000, K, R, C);
+  }
+
+  for (const auto & frustums : {truncated_frustums, infinite_frustums})
+  {
+    int intersection_count = 0;
+    for (int i = 0; i < nb_frustums; ++i)
+    {
+      for (int j = 0; j < nb_frustums; ++j)
+      {
+        const bool b_intersect = frustums[i].intersect(frustums[j]);
+        EXPECT_EQ(b_intersect, frustums[i].intersect_SAT(frustums[j]));
+        intersection_count += b_intersect;
+      }
+    }
+    // Both intersecting and non intersecting pairs are tested
+    EXPECT_TRUE(intersection_count > nb_frustums);
+    EXPECT_TRUE(intersection_count < nb_frustums * nb_frustums);
+  }
+
+  // Truncated vs infinite frustums
+  for (int i = 0; i < nb_frustums; ++i)
+  {
+    for (int j = 0; j < nb_frustums; ++j)
+    {
+      EXPECT_EQ(truncated_frustums[i].intersect(infinite_frustums[j]),
+                truncated_frustums[i].intersect_SAT(infinite_frustums[j]));
+    }
+  }
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
@@ -13,6 +13,7 @@
 #include <array>
 #include <ostream>
 #include <set>
+#include <tuple>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -96,10 +97,210 @@ inline std::ostream & operator<<( std::ostream & os, const Triplet & t )
   return os;
 }
 
+/**
+* @brief Compact forward adjacency of an undirected graph.
+* - Nodes are ranked by ascending degree (ties are broken by node id),
+* - each edge is stored once, oriented from the lowest to the highest rank,
+* - the forward neighbors are stored in CSR arrays (sorted by rank).
+* A node has at most O(sqrt(#edges)) forward neighbors, each triplet of the
+* graph is found exactly once by intersecting the forward neighborhoods of the
+* two first nodes of the triplet (the "forward" triangle listing algorithm).
+*/
+class Forward_Adjacency
+{
+public:
+
+  /**
+  * @brief Build the forward adjacency from an edge list
+  * @param pairs A list of pairs (duplicated edges and self loops are ignored)
+  */
+  template <typename IterablePairs>
+  explicit Forward_Adjacency( const IterablePairs & pairs )
+  {
+    // Normalized and unique edge list
+    std::vector<std::pair<IndexT, IndexT>> edges;
+    for (const auto & edge : pairs)
+    {
+      const IndexT a = static_cast<IndexT>(edge.first);
+      const IndexT b = static_cast<IndexT>(edge.second);
+      if (a != b)
+        edges.emplace_back(std::min(a, b), std::max(a, b));
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    // Node ids (node_ids_[i] is the id of the node of rank i once ranked)
+    node_ids_.reserve(2 * edges.size());
+    for (const auto & edge : edges)
+    {
+      node_ids_.push_back(edge.first);
+      node_ids_.push_back(edge.second);
+    }
+    std::sort(node_ids_.begin(), node_ids_.end());
+    node_ids_.erase(std::unique(node_ids_.begin(), node_ids_.end()), node_ids_.end());
+    const auto index_of = [&](const IndexT id) -> IndexT
+    {
+      return static_cast<IndexT>(
+        std::lower_bound(node_ids_.cbegin(), node_ids_.cend(), id) - node_ids_.cbegin());
+    };
+    for (auto & edge : edges)
+    {
+      edge.first = index_of(edge.first);
+      edge.second = index_of(edge.second);
+    }
+
+    // Rank the nodes by ascending degree
+    const IndexT node_count = static_cast<IndexT>(node_ids_.size());
+    std::vector<IndexT> degree(node_count, 0);
+    for (const auto & edge : edges)
+    {
+      ++degree[edge.first];
+      ++degree[edge.second];
+    }
+    std::vector<IndexT> order(node_count);
+    for (IndexT i = 0; i < node_count; ++i)
+      order[i] = i;
+    std::stable_sort(order.begin(), order.end(),
+      [&degree](const IndexT a, const IndexT b) { return degree[a] < degree[b]; });
+    std::vector<IndexT> rank(node_count);
+    std::vector<IndexT> ranked_node_ids(node_count);
+    for (IndexT i = 0; i < node_count; ++i)
+    {
+      rank[order[i]] = i;
+      ranked_node_ids[i] = node_ids_[order[i]];
+    }
+    node_ids_.swap(ranked_node_ids);
+
+    // Fill the CSR arrays with the forward (lowest to highest rank) edges
+    offsets_.assign(node_count + 1, 0);
+    for (auto & edge : edges)
+    {
+      edge = {std::min(rank[edge.first], rank[edge.second]),
+              std::max(rank[edge.first], rank[edge.second])};
+      ++offsets_[edge.first + 1];
+    }
+    for (IndexT i = 0; i < node_count; ++i)
+      offsets_[i + 1] += offsets_[i];
+    // Sorting the edges sorts each forward neighborhood
+    std::sort(edges.begin(), edges.end());
+    neighbors_.resize(edges.size());
+    for (size_t i = 0; i < edges.size(); ++i)
+      neighbors_[i] = edges[i].second;
+  }
+
+  /// Number of nodes of the graph
+  IndexT NodeCount() const
+  {
+    return static_cast<IndexT>(node_ids_.size());
+  }
+
+  /// Id of the node of the given rank
+  IndexT NodeId( const IndexT rank ) const
+  {
+    return node_ids_[rank];
+  }
+
+  /// Forward neighbors (ranks sorted by ascending order) of the node of the given rank
+  const IndexT * NeighborsBegin( const IndexT rank ) const
+  {
+    return neighbors_.data() + offsets_[rank];
+  }
+  const IndexT * NeighborsEnd( const IndexT rank ) const
+  {
+    return neighbors_.data() + offsets_[rank + 1];
+  }
+
+  /**
+  * @brief List the triplets whose lowest ranked node is the given node
+  * @param rank Rank of the node
+  * @param callback Function called with each found triplet (i<j<k)
+  */
+  template <typename TripletCallback>
+  void ListNodeTriplets
+  (
+    const IndexT rank,
+    TripletCallback & callback
+  ) const
+  {
+    const IndexT * u_begin = NeighborsBegin(rank);
+    const IndexT * u_end = NeighborsEnd(rank);
+    for (const IndexT * v_it = u_begin; v_it != u_end; ++v_it)
+    {
+      // Merge intersection of the forward neighborhoods of u and v.
+      // The common nodes have a rank greater than v: the search in the u
+      // neighborhood starts after v.
+      const IndexT * a = v_it + 1;
+      const IndexT * b = NeighborsBegin(*v_it);
+      const IndexT * b_end = NeighborsEnd(*v_it);
+      while (a != u_end && b != b_end)
+      {
+        if (*a == *b)
+        {
+          std::array<IndexT, 3> triplet_indexes {{
+            node_ids_[rank], node_ids_[*v_it], node_ids_[*a]}};
+          // sort the triplet indexes as i<j<k (monotonic ascending sorting)
+          std::sort(triplet_indexes.begin(), triplet_indexes.end());
+          callback(Triplet(triplet_indexes[0], triplet_indexes[1], triplet_indexes[2]));
+          ++a;
+          ++b;
+        }
+        else
+        {
+          const bool b_advance_a = *a < *b;
+          a += b_advance_a;
+          b += !b_advance_a;
+        }
+      }
+    }
+  }
+
+private:
+  /// Node ids sorted by rank
+  std::vector<IndexT> node_ids_;
+  /// CSR forward adjacency (neighbors_[offsets_[i]:offsets_[i+1]] are the
+  /// forward neighbors of the node of rank i)
+  std::vector<size_t> offsets_;
+  std::vector<IndexT> neighbors_;
+};
+
+/**
+* @brief Stream the triplets contained in the graph build from IterablePairs.
+* The triplets are not stored, so the memory usage is linear in the edge count.
+* @param[in] pairs A list of pairs
+* @param[in] callback Function called with each found triplet (i<j<k).
+* @note The nodes are processed in parallel (if OpenMP is enabled): the callback
+*  can be called concurrently and the triplet order is not deterministic.
+* @return the number of found triplets
+**/
+template <typename IterablePairs, typename TripletCallback>
+size_t ForEachTriplet
+(
+  const IterablePairs & pairs,
+  TripletCallback callback
+)
+{
+  const Forward_Adjacency adjacency(pairs);
+  size_t triplet_count = 0;
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(dynamic, 64) reduction(+:triplet_count)
+#endif
+  for (int rank = 0; rank < static_cast<int>(adjacency.NodeCount()); ++rank)
+  {
+    auto counting_callback = [&](const Triplet & triplet)
+    {
+      ++triplet_count;
+      callback(triplet);
+    };
+    adjacency.ListNodeTriplets(static_cast<IndexT>(rank), counting_callback);
+  }
+  return triplet_count;
+}
+
 /**
 * @brief Return triplets contained in the graph build from IterablePairs
 * @param[in] pairs A list of pairs
 * @param[out] triplets List of triplet found in graph
+*  (sorted by ascending (i,j,k) order)
 * @return boolean return true if some triplet are found
 **/
 template <typename IterablePairs, class TTripletContainer>
@@ -111,52 +312,36 @@ bool ListTriplets
 {
   triplets.clear();
 
-  // Build an adjacency list corresponding to the edge list
-  std::unordered_map<IndexT, std::set<IndexT>> adjacency_list;
-  for (const auto & edge : pairs)
+  const Forward_Adjacency adjacency(pairs);
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel
+#endif
   {
-    adjacency_list[edge.first].insert(edge.second);
-    adjacency_list[edge.second].insert(edge.first);
-  }
-
-  std::vector<IndexT> node_candidate_for_triplet;
-
-  // List the pair and find all triplets thanks to the adjacency list
-  for (const auto & edge_it : pairs)
-  {
-    // Find any targeting edge that contains the first and the second node index
-    const auto & node1_edges = adjacency_list.find(edge_it.first)->second;
-    const auto & node2_edges = adjacency_list.find(edge_it.second)->second;
-
-    // Compute the intersection between the two adjacency lists to find
-    //  triplets (it will list the nodes that are connected to the first and
-    //  second)
-    node_candidate_for_triplet.clear();
-    std::set_intersection(node1_edges.cbegin(),
-                          node1_edges.cend(),
-                          node2_edges.cbegin(),
-                          node2_edges.cend(),
-                          std::back_inserter(node_candidate_for_triplet));
-    // Add a triplet
-    for (const auto & node_index_it : node_candidate_for_triplet)
+    // Thread local triplet list
+    std::vector<Triplet> local_triplets;
+    auto callback = [&local_triplets](const Triplet & triplet)
     {
-      std::array<IndexT, 3> triplet_indexes {{
-        static_cast<IndexT>(edge_it.first),
-        static_cast<IndexT>(edge_it.second),
-        node_index_it}};
-      // sort the triplet indexes as i<j<k (monotonic ascending sorting)
-      std::sort(triplet_indexes.begin(), triplet_indexes.end());
-      triplets.emplace_back(triplet_indexes[0],
-                            triplet_indexes[1],
-                            triplet_indexes[2]);
+      local_triplets.push_back(triplet);
+    };
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp for schedule(dynamic, 64) nowait
+#endif
+    for (int rank = 0; rank < static_cast<int>(adjacency.NodeCount()); ++rank)
+    {
+      adjacency.ListNodeTriplets(static_cast<IndexT>(rank), callback);
     }
-
-    // Since we have already listed all the triplets than contain this edge.
-    // We can now remove the edge from the adjacency graph to reduce the
-    // node array size for the next iterations.
-    adjacency_list[edge_it.first].erase(edge_it.second);
-    adjacency_list[edge_it.second].erase(edge_it.first);
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp critical
+#endif
+    triplets.insert(triplets.end(), local_triplets.cbegin(), local_triplets.cend());
   }
+
+  // Use a deterministic order (independent of the thread scheduling)
+  std::sort(triplets.begin(), triplets.end(),
+    [](const Triplet & a, const Triplet & b)
+    {
+      return std::tie(a.i, a.j, a.k) < std::tie(b.i, b.j, b.k);
+    });
   return ( !triplets.empty() );
 }
 
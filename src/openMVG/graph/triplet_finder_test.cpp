@@ -11,7 +11,10 @@
 #include "CppUnitLite/TestHarness.h"
 #include "testing/testing.h"
 
+#include <atomic>
 #include <iostream>
+#include <random>
+#include <set>
 #include <vector>
 
 using namespace openMVG::graph;
@@ -187,6 +190,67 @@ TEST(TripletFinder, test_for_triplet) {
   }
 }
 
+TEST(TripletFinder, test_random_graph) {
+
+  // Compare the triplet listing to a brute force enumeration
+  const int node_count = 60;
+  std::mt19937 random_generator(std::mt19937::result_type(42));
+  std::bernoulli_distribution edge_distribution(0.3);
+  Pairs pairs;
+  std::set<std::pair<int,int>> edges;
+  for (int i = 0; i < node_count; ++i)
+    for (int j = i + 1; j < node_count; ++j)
+      if (edge_distribution(random_generator))
+      {
+        // Use non contiguous node ids and random edge orientations
+        if (edge_distribution(random_generator))
+          pairs.emplace_back(10 * j, 10 * i);
+        else
+          pairs.emplace_back(10 * i, 10 * j);
+        edges.emplace(i, j);
+      }
+
+  std::vector<Triplet> expected_triplets;
+  for (int i = 0; i < node_count; ++i)
+    for (int j = i + 1; j < node_count; ++j)
+      for (int k = j + 1; k < node_count; ++k)
+        if (edges.count({i, j}) && edges.count({i, k}) && edges.count({j, k}))
+          expected_triplets.emplace_back(10 * i, 10 * j, 10 * k);
+
+  std::vector<Triplet> vec_triplets;
+  EXPECT_TRUE(ListTriplets(pairs, vec_triplets));
+  CHECK_EQUAL(expected_triplets.size(), vec_triplets.size());
+  // Same (i<j<k) triplets in the same (lexicographic) order
+  for (size_t i = 0; i < vec_triplets.size(); ++i)
+  {
+    EXPECT_EQ(expected_triplets[i].i, vec_triplets[i].i);
+    EXPECT_EQ(expected_triplets[i].j, vec_triplets[i].j);
+    EXPECT_EQ(expected_triplets[i].k, vec_triplets[i].k);
+  }
+}
+
+TEST(TripletFinder, test_for_each_triplet) {
+
+  //
+  // a__b
+  // |\/|
+  // |/\|
+  // c--d
+  // (with duplicated edges and a self loop)
+  const int a = 0, b = 1, c = 2, d = 3;
+  const Pairs pairs = { {a,b}, {a,c}, {a,d}, {c,d}, {b,d}, {c,b}, {b,a}, {d,d} };
+
+  std::atomic<int> callback_count(0);
+  const size_t triplet_count = ForEachTriplet(pairs,
+    [&callback_count](const Triplet & triplet)
+    {
+      if (triplet.i < triplet.j && triplet.j < triplet.k)
+        ++callback_count;
+    });
+  EXPECT_EQ(4, triplet_count);
+  EXPECT_EQ(4, callback_count);
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
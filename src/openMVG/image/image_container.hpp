@@ -58,6 +58,18 @@ class Image : public Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::Row
       }
     };
 
+    /**
+    * @brief Copy constructor
+    * @param I Source image
+    */
+    inline Image( const Image& I ) = default;
+
+    /**
+    * @brief Move constructor (the pixel buffer is moved, no allocation)
+    * @param src Source image
+    */
+    inline Image( Image&& src ) = default;
+
     /**
     * @brief Copy constructor
     * @param I Source image
@@ -89,6 +101,20 @@ class Image : public Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::Row
       return *this;
     }
 
+    /**
+    * @brief Copy assignment operator
+    * @param I Source image
+    * @return Image after assignment
+    */
+    inline Image& operator=( const Image& I ) = default;
+
+    /**
+    * @brief Move assignment operator (the pixel buffer is moved, no allocation)
+    * @param src Source image
+    * @return Image after assignment
+    */
+    inline Image& operator=( Image&& src ) = default;
+
     /**
     * @brief destructor
     */
@@ -81,7 +81,8 @@ inline void Convert<RGBAColor, RGBColor>(
 template<typename ImageIn, typename ImageOut>
 void ConvertPixelType( const ImageIn& imaIn, ImageOut *imaOut )
 {
-  ( *imaOut ) = ImageOut( imaIn.Width(), imaIn.Height() );
+  // The output buffer is kept if it has the good size
+  imaOut->resize( imaIn.Width(), imaIn.Height(), false );
   // Convert each input pixel to destination pixel
   for (int j = 0; j < imaIn.Height(); ++j )
     for (int i = 0; i < imaIn.Width(); ++i )
@@ -11,6 +11,7 @@
 
 #include "openMVG/image/image_container.hpp"
 #include "openMVG/image/image_converter.hpp"
+#include "openMVG/image/image_pool.hpp"
 
 #include <cstdio>
 #include <vector>
@@ -356,6 +357,122 @@ bool Read_PNM_ImageHeader( const char * path , ImageHeader * hdr );
 bool Read_TIFF_ImageHeader( const char * path , ImageHeader * hdr );
 
 
+/**
+* @brief Convert a decoded pixel array to an image
+* @param ptr Decoded pixels (depth bytes per pixel)
+* @param w Width of the decoded image
+* @param h Height of the decoded image
+* @param[out] im Output image
+* @param pool If not null, the image buffer is borrowed from this pool when
+*  the output image size does not match
+* @tparam Tin Pixel type of the decoded pixels
+*/
+template<typename Tin, typename T>
+inline void ConvertDecodedPixels
+(
+  const unsigned char * ptr,
+  int w,
+  int h,
+  Image<T> * im,
+  Image_Pool<T> * pool
+)
+{
+  if ( im->Width() != w || im->Height() != h )
+  {
+    if ( pool )
+    {
+      pool->Release( std::move( *im ) );
+      *im = pool->Acquire( w, h );
+    }
+    else
+    {
+      im->resize( w, h, false );
+    }
+  }
+  const Tin * pixels = reinterpret_cast<const Tin*>( ptr );
+  T * out = im->data();
+  for ( Eigen::Index i = 0; i < im->size(); ++i )
+  {
+    Convert( pixels[i], out[i] );
+  }
+}
+
+/**
+* @brief Convert a decoded pixel array to a gray image
+* @retval 0 if the depth cannot be converted to gray
+* @retval 1 if the conversion is correct
+*/
+inline int ConvertDecodedImage
+(
+  const unsigned char * ptr,
+  int w, int h, int depth,
+  Image<unsigned char> * im,
+  Image_Pool<unsigned char> * pool = nullptr
+)
+{
+  switch ( depth )
+  {
+    case 1:
+      ConvertDecodedPixels<unsigned char>( ptr, w, h, im, pool );
+      return 1;
+    case 3: //-- Must convert RGB to gray
+      ConvertDecodedPixels<RGBColor>( ptr, w, h, im, pool );
+      return 1;
+    case 4: //-- Must convert RGBA to gray
+      ConvertDecodedPixels<RGBAColor>( ptr, w, h, im, pool );
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+/**
+* @brief Convert a decoded pixel array to a RGB image
+* @retval 0 if the depth cannot be converted to RGB
+* @retval 1 if the conversion is correct
+*/
+inline int ConvertDecodedImage
+(
+  const unsigned char * ptr,
+  int w, int h, int depth,
+  Image<RGBColor> * im,
+  Image_Pool<RGBColor> * pool = nullptr
+)
+{
+  switch ( depth )
+  {
+    case 3:
+      ConvertDecodedPixels<RGBColor>( ptr, w, h, im, pool );
+      return 1;
+    case 4: //-- Must convert RGBA to RGB
+      ConvertDecodedPixels<RGBAColor>( ptr, w, h, im, pool );
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+/**
+* @brief Convert a decoded pixel array to a RGBA image
+* @retval 0 if the depth cannot be converted to RGBA
+* @retval 1 if the conversion is correct
+*/
+inline int ConvertDecodedImage
+(
+  const unsigned char * ptr,
+  int w, int h, int depth,
+  Image<RGBAColor> * im,
+  Image_Pool<RGBAColor> * pool = nullptr
+)
+{
+  if ( depth != 4 )
+  {
+    return 0;
+  }
+  ConvertDecodedPixels<RGBAColor>( ptr, w, h, im, pool );
+  return 1;
+}
+
 /**
 * @brief Generic Image read from file
 * @param[in] path Input image path
@@ -369,37 +486,9 @@ inline int ReadImage( const char * path, Image<unsigned char> * im )
   std::vector<unsigned char> ptr;
   int w, h, depth;
   const int res = ReadImage( path, &ptr, &w, &h, &depth );
-  if ( res == 1 && depth == 1 )
-  {
-    //convert raw array to Image
-    ( *im ) = Eigen::Map<Image<unsigned char>::Base>( &ptr[0], h, w );
-  }
-  else if ( res == 1 && depth == 3 )
-  {
-    //-- Must convert RGB to gray
-    RGBColor * ptrCol = reinterpret_cast<RGBColor*>( &ptr[0] );
-    Image<RGBColor> rgbColIm;
-    rgbColIm = Eigen::Map<Image<RGBColor>::Base>( ptrCol, h, w );
-    //convert RGB to gray
-    ConvertPixelType( rgbColIm, im );
-  }
-  else if ( res == 1 && depth == 4 )
-  {
-    //-- Must convert RGBA to gray
-    RGBAColor * ptrCol = reinterpret_cast<RGBAColor*>( &ptr[0] );
-    Image<RGBAColor> rgbaColIm;
-    rgbaColIm = Eigen::Map<Image<RGBAColor>::Base>( ptrCol, h, w );
-    //convert RGBA to gray
-    ConvertPixelType( rgbaColIm, im );
-  }
-  else if ( depth != 1 )
-  {
-    return 0;
-  }
-  return res;
+  return ( res == 1 ) ? ConvertDecodedImage( ptr.data(), w, h, depth, im ) : 0;
 }
 
-
 /**
 * @brief Generic Image read from file (overload for RGBColor)
 * @param[in] path Input image path
@@ -413,26 +502,7 @@ inline int ReadImage( const char * path, Image<RGBColor> * im )
   std::vector<unsigned char> ptr;
   int w, h, depth;
   const int res = ReadImage( path, &ptr, &w, &h, &depth );
-  if ( res == 1 && depth == 3 )
-  {
-    RGBColor * ptrCol = reinterpret_cast<RGBColor*>( &ptr[0] );
-    //convert raw array to Image
-    ( *im ) = Eigen::Map<Image<RGBColor>::Base>( ptrCol, h, w );
-  }
-  else if ( res == 1 && depth == 4 )
-  {
-    //-- Must convert RGBA to RGB
-    RGBAColor * ptrCol = reinterpret_cast<RGBAColor*>( &ptr[0] );
-    Image<RGBAColor> rgbaColIm;
-    rgbaColIm = Eigen::Map<Image<RGBAColor>::Base>( ptrCol, h, w );
-    //convert RGBA to RGB
-    ConvertPixelType( rgbaColIm, im );
-  }
-  else
-  {
-    return 0;
-  }
-  return res;
+  return ( res == 1 ) ? ConvertDecodedImage( ptr.data(), w, h, depth, im ) : 0;
 }
 
 /**
@@ -448,16 +518,33 @@ inline int ReadImage( const char * path, Image<RGBAColor> * im )
   std::vector<unsigned char> ptr;
   int w, h, depth;
   const int res = ReadImage( path, &ptr, &w, &h, &depth );
-  if ( depth != 4 )
-  {
-    return 0;
-  }
+  return ( res == 1 ) ? ConvertDecodedImage( ptr.data(), w, h, depth, im ) : 0;
+}
+
+/**
+* @brief Image read from file using a buffer pool (no allocation in steady state)
+* - the decoding buffer is borrowed from the pool,
+* - if the output image size does not match, its buffer is given back to the
+*   pool and a buffer of the good size is borrowed from the pool.
+* @param[in] path Input image path
+* @param[out] im Ouput image
+* @param pool Image buffer pool
+* @retval 0 if there was an error during read operation
+* @retval 1 if read is correct
+*/
+template<typename T>
+int ReadImage( const char * path, Image<T> * im, Image_Pool<T> & pool )
+{
+  std::vector<unsigned char> ptr = pool.AcquireDecodingBuffer();
+  const size_t capacity = ptr.capacity();
+  int w, h, depth;
+  int res = ReadImage( path, &ptr, &w, &h, &depth );
   if ( res == 1 )
   {
-    RGBAColor * ptrCol = reinterpret_cast<RGBAColor*>( &ptr[0] );
-    //convert raw array to Image
-    ( *im ) = Eigen::Map<Image<RGBAColor>::Base>( ptrCol, h, w );
+    res = ConvertDecodedImage( ptr.data(), w, h, depth, im, &pool );
   }
+  const bool bAllocated = ptr.capacity() != capacity;
+  pool.ReleaseDecodingBuffer( std::move( ptr ), bAllocated );
   return res;
 }
 
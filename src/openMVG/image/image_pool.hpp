@@ -0,0 +1,265 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_IMAGE_IMAGE_POOL_HPP
+#define OPENMVG_IMAGE_IMAGE_POOL_HPP
+
+#include "openMVG/image/image_container.hpp"
+
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace openMVG
+{
+namespace image
+{
+
+/**
+* @brief Allocation statistics of an image pool
+*/
+struct Image_Pool_Statistics
+{
+  /// Number of borrowed image buffers
+  size_t acquire_count = 0;
+  /// Number of borrowed image buffers that had to be allocated
+  size_t allocation_count = 0;
+  /// Number of bytes allocated for the borrowed image buffers
+  size_t allocated_bytes = 0;
+  /// Number of image buffers freed because the pool was full
+  size_t discard_count = 0;
+  /// Number of borrowed decoding buffers
+  size_t decoding_acquire_count = 0;
+  /// Number of decoding buffers (re)allocated by the image decoders
+  size_t decoding_allocation_count = 0;
+};
+
+inline std::ostream & operator<<( std::ostream & os, const Image_Pool_Statistics & statistics )
+{
+  return os
+    << "image buffers: " << statistics.acquire_count << " borrowed, "
+    << statistics.allocation_count << " allocated ("
+    << statistics.allocated_bytes / ( 1024 * 1024 ) << " MB), "
+    << statistics.discard_count << " discarded\n"
+    << "decoding buffers: " << statistics.decoding_acquire_count << " borrowed, "
+    << statistics.decoding_allocation_count << " allocated";
+}
+
+/**
+* @brief Pool of image buffers keyed by their size.
+* Pipelines processing many images of the same size borrow their images from
+* the pool and give them back once processed: in steady state no large buffer
+* is allocated nor freed.
+* - An image is reused for any image size having the same number of pixels
+*   (Eigen does not reallocate the buffer in this case).
+* - The pool keeps at most max_buffer_count images, the least recently
+*   released image is freed when the pool is full.
+* - The pool also keeps the decoding buffers of ReadImage (their capacity is
+*   kept between the uses).
+* The pool is thread safe.
+* @tparam T Pixel type
+*/
+template <typename T>
+class Image_Pool
+{
+  public:
+
+    /**
+    * @brief Constructor
+    * @param max_buffer_count Maximal number of image buffers kept by the pool
+    */
+    explicit Image_Pool( const size_t max_buffer_count = 16 )
+      : max_buffer_count_( max_buffer_count )
+    {
+    }
+
+    Image_Pool( const Image_Pool & ) = delete;
+    Image_Pool & operator=( const Image_Pool & ) = delete;
+
+    /**
+    * @brief Borrow an image (the pixels are not initialized)
+    * @param width Width of the image
+    * @param height Height of the image
+    * @return An image of the pool if one has the same number of pixels, else a new image
+    */
+    Image<T> Acquire( const int width, const int height )
+    {
+      const Eigen::Index pixel_count = static_cast<Eigen::Index>( width ) * height;
+      if ( pixel_count == 0 )
+        return Image<T>();
+      {
+        std::lock_guard<std::mutex> lock( mutex_ );
+        ++statistics_.acquire_count;
+        // Use the most recently released image
+        for ( auto it = images_.rbegin(); it != images_.rend(); ++it )
+        {
+          if ( it->size() == pixel_count )
+          {
+            Image<T> image( std::move( *it ) );
+            images_.erase( std::next( it ).base() );
+            image.resize( width, height, false ); // Same number of pixels: no allocation
+            return image;
+          }
+        }
+        ++statistics_.allocation_count;
+        statistics_.allocated_bytes += pixel_count * sizeof( T );
+      }
+      return Image<T>( width, height, false );
+    }
+
+    /**
+    * @brief Give back an image buffer to the pool
+    * @param image Image to give back (it is empty after the call)
+    */
+    void Release( Image<T> && image )
+    {
+      if ( image.size() == 0 )
+        return;
+      Image<T> discarded;
+      {
+        std::lock_guard<std::mutex> lock( mutex_ );
+        images_.push_back( std::move( image ) );
+        if ( images_.size() > max_buffer_count_ )
+        {
+          // The buffer is freed out of the lock
+          discarded = std::move( images_.front() );
+          images_.pop_front();
+          ++statistics_.discard_count;
+        }
+      }
+    }
+
+    /**
+    * @brief Borrow a decoding buffer (as used by ReadImage)
+    * @return A decoding buffer of the pool, an empty buffer if none is available
+    */
+    std::vector<unsigned char> AcquireDecodingBuffer()
+    {
+      std::lock_guard<std::mutex> lock( mutex_ );
+      ++statistics_.decoding_acquire_count;
+      if ( decoding_buffers_.empty() )
+        return {};
+      std::vector<unsigned char> buffer( std::move( decoding_buffers_.back() ) );
+      decoding_buffers_.pop_back();
+      return buffer;
+    }
+
+    /**
+    * @brief Give back a decoding buffer to the pool
+    * @param buffer Decoding buffer to give back
+    * @param bAllocated Tell if the buffer was (re)allocated since it was borrowed
+    */
+    void ReleaseDecodingBuffer( std::vector<unsigned char> && buffer, const bool bAllocated )
+    {
+      std::lock_guard<std::mutex> lock( mutex_ );
+      if ( bAllocated )
+        ++statistics_.decoding_allocation_count;
+      if ( decoding_buffers_.size() < max_buffer_count_ )
+        decoding_buffers_.push_back( std::move( buffer ) );
+    }
+
+    /**
+    * @brief Free the buffers kept by the pool
+    */
+    void Clear()
+    {
+      std::lock_guard<std::mutex> lock( mutex_ );
+      images_.clear();
+      decoding_buffers_.clear();
+    }
+
+    /**
+    * @brief Number of image buffers kept by the pool
+    */
+    size_t Size() const
+    {
+      std::lock_guard<std::mutex> lock( mutex_ );
+      return images_.size();
+    }
+
+    /**
+    * @brief Allocation statistics
+    */
+    Image_Pool_Statistics Statistics() const
+    {
+      std::lock_guard<std::mutex> lock( mutex_ );
+      return statistics_;
+    }
+
+  private:
+
+    const size_t max_buffer_count_;
+    mutable std::mutex mutex_;
+    std::deque<Image<T>> images_; // From the least to the most recently released
+    std::vector<std::vector<unsigned char>> decoding_buffers_;
+    Image_Pool_Statistics statistics_;
+};
+
+/**
+* @brief Image borrowed from a pool, the buffer is given back to the pool on destruction.
+* @note The pool must outlive the image
+* @tparam T Pixel type
+*/
+template <typename T>
+class Pooled_Image : public Image<T>
+{
+  public:
+
+    /**
+    * @brief Constructor
+    * @param pool Pool the buffer is borrowed from
+    * @param width Width of the image
+    * @param height Height of the image
+    * @note The pixels are not initialized
+    */
+    explicit Pooled_Image( Image_Pool<T> & pool, const int width = 0, const int height = 0 )
+      : Image<T>( pool.Acquire( width, height ) ),
+        pool_( pool )
+    {
+    }
+
+    Pooled_Image( const Pooled_Image & ) = delete;
+
+    /**
+    * @brief Copy the pixels (the buffer stays borrowed from the same pool)
+    * @param I Source image
+    * @return Image after assignment
+    */
+    Pooled_Image & operator=( const Pooled_Image & I )
+    {
+      Image<T>::operator=( I );
+      return *this;
+    }
+
+    using Image<T>::operator=;
+
+    ~Pooled_Image() override
+    {
+      pool_.Release( std::move( static_cast<Image<T>&>( *this ) ) );
+    }
+
+    /**
+    * @brief Pool the buffer is borrowed from
+    */
+    Image_Pool<T> & Pool() const
+    {
+      return pool_;
+    }
+
+  private:
+
+    Image_Pool<T> & pool_;
+};
+
+} // namespace image
+} // namespace openMVG
+
+#endif // OPENMVG_IMAGE_IMAGE_POOL_HPP
@@ -0,0 +1,128 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/image/image_io.hpp"
+#include "openMVG/image/image_pool.hpp"
+
+#include "testing/testing.h"
+
+#include <cstdio>
+#include <string>
+#include <utility>
+
+using namespace openMVG;
+using namespace openMVG::image;
+
+TEST(Image, Move) {
+  Image<unsigned char> image(10, 10, true, 1);
+  const unsigned char * data = image.data();
+  // The pixel buffer is moved (not copied)
+  Image<unsigned char> moved(std::move(image));
+  EXPECT_EQ(data, moved.data());
+  EXPECT_EQ(0, image.size());
+
+  Image<unsigned char> assigned;
+  assigned = std::move(moved);
+  EXPECT_EQ(data, assigned.data());
+  EXPECT_EQ(10, assigned.Width());
+}
+
+TEST(Image_Pool, Reuse) {
+  Image_Pool<unsigned char> pool;
+  Image<unsigned char> image = pool.Acquire(40, 30);
+  EXPECT_EQ(40, image.Width());
+  EXPECT_EQ(30, image.Height());
+  const unsigned char * data = image.data();
+  pool.Release(std::move(image));
+  EXPECT_EQ(0, image.size());
+  EXPECT_EQ(1, pool.Size());
+
+  // A buffer with the same number of pixels is reused (even if the shape differs)
+  image = pool.Acquire(30, 40);
+  EXPECT_EQ(data, image.data());
+  EXPECT_EQ(30, image.Width());
+  EXPECT_EQ(40, image.Height());
+  EXPECT_EQ(0, pool.Size());
+
+  // Another size is allocated
+  Image<unsigned char> other = pool.Acquire(20, 20);
+  EXPECT_EQ(3, pool.Statistics().acquire_count);
+  EXPECT_EQ(2, pool.Statistics().allocation_count);
+  EXPECT_EQ(40 * 30 + 20 * 20, pool.Statistics().allocated_bytes);
+}
+
+TEST(Image_Pool, Discard) {
+  Image_Pool<float> pool(2);
+  for (int i = 1; i <= 3; ++i)
+    pool.Release(Image<float>(i, i));
+  EXPECT_EQ(2, pool.Size());
+  EXPECT_EQ(1, pool.Statistics().discard_count);
+
+  // The least recently released image was freed
+  pool.Acquire(1, 1);
+  EXPECT_EQ(1, pool.Statistics().allocation_count);
+  pool.Acquire(3, 3);
+  EXPECT_EQ(1, pool.Statistics().allocation_count);
+
+  pool.Clear();
+  EXPECT_EQ(0, pool.Size());
+}
+
+TEST(Pooled_Image, Scope) {
+  Image_Pool<RGBColor> pool;
+  const RGBColor * data = nullptr;
+  {
+    Pooled_Image<RGBColor> image(pool, 16, 8);
+    image.fill(RGBColor(1, 2, 3));
+    data = image.data();
+    EXPECT_EQ(0, pool.Size());
+  }
+  // The buffer is given back to the pool
+  EXPECT_EQ(1, pool.Size());
+  {
+    Pooled_Image<RGBColor> image(pool, 8, 16);
+    EXPECT_EQ(data, image.data());
+  }
+  EXPECT_EQ(1, pool.Statistics().allocation_count);
+  EXPECT_EQ(2, pool.Statistics().acquire_count);
+}
+
+TEST(Image_Pool, ReadImage) {
+  const std::string filename = std::string(THIS_SOURCE_DIR) + "/image_pool_test.png";
+  Image<RGBColor> color(64, 48);
+  for (int y = 0; y < color.Height(); ++y)
+    for (int x = 0; x < color.Width(); ++x)
+      color(y, x) = RGBColor(x, y, x + y);
+  EXPECT_TRUE(WriteImage(filename.c_str(), color));
+
+  Image_Pool<unsigned char> pool;
+  Image<unsigned char> reference;
+  EXPECT_TRUE(ReadImage(filename.c_str(), &reference));
+
+  // The first read allocates the image & the decoding buffer, the next reads reuse them
+  for (int i = 0; i < 5; ++i)
+  {
+    Pooled_Image<unsigned char> image(pool);
+    EXPECT_TRUE(ReadImage(filename.c_str(), &image, pool));
+    EXPECT_EQ(64, image.Width());
+    EXPECT_EQ(48, image.Height());
+    EXPECT_TRUE(image.GetMat() == reference.GetMat());
+  }
+  EXPECT_EQ(1, pool.Statistics().allocation_count);
+  EXPECT_EQ(5, pool.Statistics().decoding_acquire_count);
+  EXPECT_EQ(1, pool.Statistics().decoding_allocation_count);
+
+  // Invalid files are reported
+  Image<unsigned char> image;
+  EXPECT_FALSE(ReadImage("not_an_image.png", &image, pool));
+  remove(filename.c_str());
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
@@ -23,6 +23,8 @@ namespace linearProgramming  {
 /// http://en.wikipedia.org/wiki/Bisection_method
 /// The bisection algorithm continue as long as
 ///  precision or max iteration number is not reach.
+/// The problems of the successive gamma values share the same structure:
+///  the solver is warm started from the basis of the previous gamma (if supported).
 ///
 template <typename ConstraintBuilder, typename ConstraintType>
 bool BisectionLP(
@@ -34,8 +36,11 @@ bool BisectionLP(
   double eps      = 1e-8, // precision that stop dichotomy
   const int maxIteration = 20, // max number of iteration
   double * bestFeasibleGamma = nullptr , // value of best bisection found value
-  bool bVerbose = false)
+  bool bVerbose = false,
+  bool bWarmStart = true) // reuse the basis of the previous gamma
 {
+  solver.useWarmStart(bWarmStart);
+
   int k = 0;
   bool bModelFound = false;
   ConstraintType constraint;
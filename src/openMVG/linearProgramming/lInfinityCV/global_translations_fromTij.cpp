@@ -66,6 +66,8 @@ void EncodeTi_from_tij
     3 * Ncam + vec_relative_motion_groups.size() + 1;
 
   A.resize(Nconstraint, NVar);
+  // Reserve the non-zero coefficients of each row (no reallocation by coeffRef)
+  A.reserve(Eigen::VectorXi::Constant(A.rows(), 6));
 
   C.resize(Nconstraint, 1);
   C.fill(0.0);
@@ -56,6 +56,8 @@ void EncodeResection
   assert(Pt2D.cols() >= 6 && "The problem requires at least 6 points");
 
   A.resize(Nobs * 5, 11);
+  // Reserve the non-zero coefficients of each row (no reallocation by coeffRef)
+  A.reserve(Eigen::VectorXi::Constant(A.rows(), 11));
 
   C.resize(Nobs * 5, 1);
   C.fill(0.0);
@@ -55,6 +55,8 @@ void EncodeTiXi
   assert(Ncam == Ri.size());
 
   A.resize(5 * Nobs, 3 * (N3D + Ncam));
+  // Reserve the non-zero coefficients of each row (no reallocation by coeffRef)
+  A.reserve(Eigen::VectorXi::Constant(A.rows(), 5));
 
   C.resize(5 * Nobs, 1);
   C.fill(0.0);
@@ -97,6 +97,12 @@ public:
   /// Get back solution. Call it after solve.
   virtual bool getSolution(std::vector<double> & estimatedParams) = 0;
 
+  /// Start the next solve from the basis of the previous one (if the problem
+  ///  dimensions are unchanged). Useful for a sequence of close problems
+  ///  (i.e. the gamma values of a bisection).
+  /// Return false if the solver does not support warm start.
+  virtual bool useWarmStart(bool /*bWarmStart*/) { return false; }
+
 protected :
   int nbParams_; // The number of parameter considered in constraint formulation.
 };
@@ -7,103 +7,245 @@
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
 #include "openMVG/linearProgramming/linearProgrammingOSI_X.hpp"
+#include <algorithm>
 #include <assert.h>
 #include <cstddef>
-#include "CoinPackedVector.hpp"
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "CoinPackedMatrix.hpp"
+#include "CoinWarmStartBasis.hpp"
 #include "OsiClpSolverInterface.hpp"
 #include "openMVG/numeric/eigen_alias_definition.hpp"
 
 namespace openMVG   {
 namespace linearProgramming  {
 
-OSI_X_SolverWrapper::OSI_X_SolverWrapper(int nbParams) : LP_Solver(nbParams)
-{
-  si.reset(new OsiClpSolverInterface);
-  si->setLogLevel(0);
-}
+namespace {
 
-bool OSI_X_SolverWrapper::setup(const LP_Constraints & cstraints) //cstraints <-> constraints
+// Pool of the unused OSI solvers.
+// - A returned solver is reset (its model is freed): only the solver object
+//   is reused, the pooled solvers do not keep the last loaded problem.
+// - The pool keeps at most one solver per hardware thread.
+// - The pool is shared by the threads and is kept alive by the solvers in use
+//   (a solver can be released by any thread, at any time).
+class OSI_Solver_Pool : public std::enable_shared_from_this<OSI_Solver_Pool>
 {
-  if (!si)
+public:
+  static std::shared_ptr<OSI_Solver_Pool> Instance()
   {
-    return false;
+    static const std::shared_ptr<OSI_Solver_Pool> pool(new OSI_Solver_Pool);
+    return pool;
   }
-  assert(nbParams_ == cstraints.nbParams_);
 
-  const unsigned int NUMVAR = cstraints.constraint_mat_.cols();
-  std::vector<double>
-    col_lb(NUMVAR), // the column lower bounds
-    col_ub(NUMVAR); // the column upper bounds
+  // Get a pooled solver (or create one).
+  // The solver goes back to the pool once it is unused.
+  std::shared_ptr<OsiClpSolverInterface> Acquire()
+  {
+    std::unique_ptr<OsiClpSolverInterface> solver;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!solvers_.empty())
+      {
+        solver = std::move(solvers_.back());
+        solvers_.pop_back();
+      }
+    }
+    if (!solver)
+      solver.reset(new OsiClpSolverInterface);
+    solver->setLogLevel(0);
+    const std::shared_ptr<OSI_Solver_Pool> pool = shared_from_this();
+    return std::shared_ptr<OsiClpSolverInterface>(
+      solver.release(),
+      [pool](OsiClpSolverInterface * unused_solver)
+      {
+        pool->Release(std::unique_ptr<OsiClpSolverInterface>(unused_solver));
+      });
+  }
 
-  this->nbParams_ = NUMVAR;
+private:
+  OSI_Solver_Pool()
+    : max_size_(std::max(1u, std::thread::hardware_concurrency()))
+  {
+  }
 
-  si->setObjSense( ((cstraints.bminimize_) ? 1 : -1) );
+  void Release(std::unique_ptr<OsiClpSolverInterface> solver)
+  {
+    solver->reset(); // Free the model
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (solvers_.size() < max_size_)
+      solvers_.emplace_back(std::move(solver));
+    // else the solver is deleted
+  }
 
-  const Mat & A = cstraints.constraint_mat_;
+  const size_t max_size_;
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<OsiClpSolverInterface>> solvers_;
+};
 
-  //Equality constraint will be done by two constraints due to the API limitation ( >= & <=).
-  const size_t nbLine = A.rows() +
-    std::count(cstraints.vec_sign_.begin(), cstraints.vec_sign_.end(), LP_Constraints::LP_EQUAL);
+/// Constraints in the OSI form (-inf <= A x <= row_ub) stored row wise (CSR).
+/// Equality constraint will be done by two constraints due to the API limitation (>= & <=).
+struct OSI_RowConstraints
+{
+  std::vector<CoinBigIndex> starts;
+  std::vector<int> lengths;
+  std::vector<int> indexes;
+  std::vector<double> values;
+  std::vector<double> row_ub;
 
-  // Define default lower and upper bound to [-inf, inf]
-  std::vector<double>
-    row_lb(nbLine, -si->getInfinity()), // the row lower bounds
-    row_ub(nbLine, si->getInfinity()); // the row upper bounds
+  void reserve(const size_t nbRow, const size_t nbValue)
+  {
+    starts.reserve(nbRow);
+    lengths.reserve(nbRow);
+    row_ub.reserve(nbRow);
+    indexes.reserve(nbValue);
+    values.reserve(nbValue);
+  }
 
-  std::unique_ptr<CoinPackedMatrix> matrix(new CoinPackedMatrix(false,0,0));
-  matrix->setDimensions(0, NUMVAR);
+  // Add the row(s) of the constraint a^T x (sign) objective
+  void add
+  (
+    const int * row_indexes,
+    const double * row_values,
+    const int nbValue,
+    const LP_Constraints::eLP_SIGN sign,
+    const double objective
+  )
+  {
+    if (sign == LP_Constraints::LP_EQUAL ||
+        sign == LP_Constraints::LP_LESS_OR_EQUAL)
+    {
+      append(row_indexes, row_values, nbValue, 1.0, objective);
+    }
+    if (sign == LP_Constraints::LP_EQUAL ||
+        sign == LP_Constraints::LP_GREATER_OR_EQUAL)
+    {
+      append(row_indexes, row_values, nbValue, -1.0, objective);
+    }
+  }
 
-  //-- Add row-wise constraint
-  size_t indexRow = 0;
-  for (int i=0; i < A.rows(); ++i)
+  // Load the constraints and the variable bounds in the solver
+  void load
+  (
+    OsiClpSolverInterface & si,
+    const int nbVar,
+    const std::vector<std::pair<double, double>> & vec_bounds,
+    const std::vector<double> & vec_cost
+  ) const
   {
-    const Vec temp = A.row(i);
-    CoinPackedVector row;
+    std::vector<double>
+      col_lb(nbVar), // the column lower bounds
+      col_ub(nbVar); // the column upper bounds
 
-    if (cstraints.vec_sign_[i] == LP_Constraints::LP_EQUAL ||
-        cstraints.vec_sign_[i] == LP_Constraints::LP_LESS_OR_EQUAL)
+    //-- Setup bounds for all the parameters
+    if (vec_bounds.size() == 1)
+    {
+      // Setup the same bound for all the parameters
+      std::fill(col_lb.begin(), col_lb.end(), vec_bounds[0].first);
+      std::fill(col_ub.begin(), col_ub.end(), vec_bounds[0].second);
+    }
+    else // each parameter have its own bounds
     {
-      const int coef = 1;
-      for ( int j = 0; j < A.cols(); ++j )
+      for (int i=0; i < nbVar; ++i)
       {
-        row.insert(j, coef * temp.data()[j]);
+        col_lb[i] = vec_bounds[i].first;
+        col_ub[i] = vec_bounds[i].second;
       }
-      row_ub[indexRow] = coef * cstraints.constraint_objective_(i);
-      matrix->appendRow(row);
-      ++indexRow;
     }
 
-    if (cstraints.vec_sign_[i] == LP_Constraints::LP_EQUAL ||
-        cstraints.vec_sign_[i] == LP_Constraints::LP_GREATER_OR_EQUAL)
+    // Define default lower bound to -inf
+    const std::vector<double> row_lb(row_ub.size(), -si.getInfinity());
+
+    const CoinPackedMatrix matrix(
+      false, // row ordered
+      nbVar,
+      static_cast<int>(row_ub.size()),
+      static_cast<CoinBigIndex>(values.size()),
+      values.data(),
+      indexes.data(),
+      starts.data(),
+      lengths.data());
+
+    si.loadProblem(
+      matrix,
+      col_lb.data(),
+      col_ub.data(),
+      vec_cost.empty() ? nullptr : vec_cost.data(),
+      row_lb.data(),
+      row_ub.data());
+  }
+
+private:
+
+  void append
+  (
+    const int * row_indexes,
+    const double * row_values,
+    const int nbValue,
+    const double coef,
+    const double objective
+  )
+  {
+    starts.push_back(static_cast<CoinBigIndex>(values.size()));
+    lengths.push_back(nbValue);
+    indexes.insert(indexes.end(), row_indexes, row_indexes + nbValue);
+    for (int j = 0; j < nbValue; ++j)
     {
-      const int coef = -1;
-      for ( int j = 0; j < A.cols(); ++j )
-      {
-        row.insert(j, coef * temp.data()[j]);
-      }
-      row_ub[indexRow] = coef * cstraints.constraint_objective_(i);
-      matrix->appendRow(row);
-      ++indexRow;
+      values.push_back(coef * row_values[j]);
     }
+    row_ub.push_back(coef * objective);
   }
+};
 
-  //-- Setup bounds for all the parameters
-  if (cstraints.vec_bounds_.size() == 1)
+} // namespace
+
+OSI_X_SolverWrapper::OSI_X_SolverWrapper(int nbParams) : LP_Solver(nbParams),
+  si(OSI_Solver_Pool::Instance()->Acquire()),
+  bWarmStart_(false),
+  bWarmStarted_(false)
+{
+}
+
+bool OSI_X_SolverWrapper::setup(const LP_Constraints & cstraints) //cstraints <-> constraints
+{
+  if (!si)
   {
-    // Setup the same bound for all the parameters
-    std::fill(col_lb.begin(), col_lb.end(), cstraints.vec_bounds_[0].first);
-    std::fill(col_ub.begin(), col_ub.end(), cstraints.vec_bounds_[0].second);
+    return false;
   }
-  else // each parameter have its own bounds
+  assert(nbParams_ == cstraints.nbParams_);
+
+  const int NUMVAR = cstraints.constraint_mat_.cols();
+  this->nbParams_ = NUMVAR;
+
+  si->setObjSense( ((cstraints.bminimize_) ? 1 : -1) );
+
+  const Mat & A = cstraints.constraint_mat_;
+
+  //-- Add row-wise constraint (only the non zero coefficients are stored)
+  OSI_RowConstraints osi_constraints;
+  osi_constraints.reserve(2 * A.rows(), 2 * (A.array() != 0.0).count());
+  std::vector<int> vec_colno;
+  std::vector<double> vec_value;
+  for (int i=0; i < A.rows(); ++i)
   {
-    for (int i=0; i < this->nbParams_; ++i)
+    vec_colno.clear();
+    vec_value.clear();
+    for ( int j = 0; j < A.cols(); ++j )
     {
-      col_lb[i] = cstraints.vec_bounds_[i].first;
-      col_ub[i] = cstraints.vec_bounds_[i].second;
+      if (A(i, j) != 0.0)
+      {
+        vec_colno.push_back(j);
+        vec_value.push_back(A(i, j));
+      }
     }
+    osi_constraints.add(vec_colno.data(), vec_value.data(), vec_colno.size(),
+      cstraints.vec_sign_[i], cstraints.constraint_objective_(i));
   }
 
-  si->loadProblem(*matrix, &col_lb[0], &col_ub[0], cstraints.vec_cost_.empty() ? nullptr : &cstraints.vec_cost_[0], &row_lb[0], &row_ub[0] );
+  osi_constraints.load(*si, NUMVAR, cstraints.vec_bounds_, cstraints.vec_cost_);
+  setupWarmStart();
 
   return true;
 }
@@ -117,102 +259,81 @@ bool OSI_X_SolverWrapper::setup(const LP_Constraints_Sparse & cstraints) //cstra
   assert(nbParams_ == cstraints.nbParams_);
 
   const int NUMVAR = cstraints.constraint_mat_.cols();
-  std::vector<double>
-    col_lb(NUMVAR), // the column lower bounds
-    col_ub(NUMVAR); // the column upper bounds
-
   this->nbParams_ = NUMVAR;
 
   si->setObjSense( ((cstraints.bminimize_) ? 1 : -1) );
 
   const sRMat & A = cstraints.constraint_mat_;
 
-  //Equality constraint will be done by two constraints due to the API limitation (>= & <=)
-  const size_t nbLine = A.rows() +
-    std::count(cstraints.vec_sign_.begin(), cstraints.vec_sign_.end(), LP_Constraints::LP_EQUAL);
-
-  // Define default lower and upper bound to [-inf, inf]
-  std::vector<double>
-    row_lb(nbLine, -si->getInfinity()), // the row lower bounds
-    row_ub(nbLine, si->getInfinity()); // the row upper bounds
-
-  std::unique_ptr<CoinPackedMatrix> matrix(new CoinPackedMatrix(false,0,0));
-  matrix->setDimensions(0, NUMVAR);
-
   //-- Add row-wise constraint
-  size_t rowindex = 0;
+  OSI_RowConstraints osi_constraints;
+  osi_constraints.reserve(2 * A.rows(), 2 * A.nonZeros());
+  std::vector<int> vec_colno;
+  std::vector<double> vec_value;
   for (int i=0; i < A.rows(); ++i)
   {
-    std::vector<int> vec_colno;
-    std::vector<double> vec_value;
+    vec_colno.clear();
+    vec_value.clear();
     for (sRMat::InnerIterator it(A,i); it; ++it)
     {
       vec_colno.push_back(it.col());
       vec_value.push_back(it.value());
     }
+    osi_constraints.add(vec_colno.data(), vec_value.data(), vec_colno.size(),
+      cstraints.vec_sign_[i], cstraints.constraint_objective_(i));
+  }
 
-    if ( cstraints.vec_sign_[i] == LP_Constraints::LP_EQUAL ||
-         cstraints.vec_sign_[i] == LP_Constraints::LP_LESS_OR_EQUAL )
-    {
-      const int coef = 1;
-      row_ub[rowindex] = coef * cstraints.constraint_objective_(i);
-      matrix->appendRow( vec_colno.size(),
-                   &vec_colno[0],
-                   &vec_value[0] );
-      ++rowindex;
-    }
+  osi_constraints.load(*si, NUMVAR, cstraints.vec_bounds_, cstraints.vec_cost_);
+  setupWarmStart();
 
-    if ( cstraints.vec_sign_[i] == LP_Constraints::LP_EQUAL ||
-         cstraints.vec_sign_[i] == LP_Constraints::LP_GREATER_OR_EQUAL )
-    {
-      const int coef = -1;
-      for (auto &  iter_val : vec_value)
-      {
-        iter_val *= coef;
-      }
-      row_ub[rowindex] = coef * cstraints.constraint_objective_(i);
-      matrix->appendRow( vec_colno.size(),
-                   &vec_colno[0],
-                   &vec_value[0] );
-      ++rowindex;
-    }
-  }
+  return true;
+}
 
-  //-- Setup bounds for all the parameters
-  if (cstraints.vec_bounds_.size() == 1)
-  {
-    // Setup the same bound for all the parameters
-    std::fill(col_lb.begin(), col_lb.end(), cstraints.vec_bounds_[0].first);
-    std::fill(col_ub.begin(), col_ub.end(), cstraints.vec_bounds_[0].second);
-  }
-  else  // each parameter have its own bounds
+void OSI_X_SolverWrapper::setupWarmStart()
+{
+  // Start from the basis of the previous solve if it fits the new problem
+  bWarmStarted_ = false;
+  if (bWarmStart_ && warm_start_)
   {
-    for (int i=0; i < this->nbParams_; ++i)
+    const CoinWarmStartBasis * basis =
+      dynamic_cast<const CoinWarmStartBasis *>(warm_start_.get());
+    if (basis &&
+        basis->getNumStructural() == si->getNumCols() &&
+        basis->getNumArtificial() == si->getNumRows())
     {
-      col_lb[i] = cstraints.vec_bounds_[i].first;
-      col_ub[i] = cstraints.vec_bounds_[i].second;
+      bWarmStarted_ = si->setWarmStart(basis);
     }
   }
+}
 
-  si->loadProblem(
-    *matrix,
-    &col_lb[0],
-    &col_ub[0],
-    cstraints.vec_cost_.empty() ? nullptr : &cstraints.vec_cost_[0],
-    &row_lb[0],
-    &row_ub[0]);
-
+bool OSI_X_SolverWrapper::useWarmStart(bool bWarmStart)
+{
+  bWarmStart_ = bWarmStart;
+  if (!bWarmStart_)
+  {
+    warm_start_.reset();
+  }
   return true;
 }
 
-
 bool OSI_X_SolverWrapper::solve()
 {
   //-- Compute solution
   if ( si )
   {
     si->getModelPtr()->setPerturbation(50);
-    si->initialSolve();
+    if (bWarmStarted_)
+    {
+      si->resolve(); // (dual simplex) from the basis of the previous problem
+    }
+    else
+    {
+      si->initialSolve();
+    }
+    if (bWarmStart_)
+    {
+      warm_start_.reset(si->getWarmStart());
+    }
     return si->isProvenOptimal();
   }
   return false;
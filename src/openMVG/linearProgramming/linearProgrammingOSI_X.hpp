@@ -14,12 +14,16 @@
 
 #include "openMVG/linearProgramming/linearProgrammingInterface.hpp"
 
+class CoinWarmStart;
 class OsiClpSolverInterface;
 
 namespace openMVG   {
 namespace linearProgramming  {
 
 /// OSI_Clp wrapper for the LP_Solver
+/// The OSI solver instances are pooled (at most one idle solver per hardware
+///  thread, reset when returned): creating a wrapper for each small LP (i.e. in
+///  a robust estimation loop) does not allocate a new solver.
 class OSI_X_SolverWrapper : public LP_Solver
 {
 public:
@@ -36,8 +40,17 @@ public:
 
   bool getSolution(std::vector<double> & estimatedParams) override;
 
+  bool useWarmStart(bool bWarmStart) override;
+
 private:
+  // Set the basis of the previous solve as start point (if enabled and valid)
+  void setupWarmStart();
+
   std::shared_ptr<OsiClpSolverInterface> si;
+
+  bool bWarmStart_; // Start from the basis of the previous solve
+  bool bWarmStarted_; // The basis of the previous solve is set for the next solve
+  std::shared_ptr<CoinWarmStart> warm_start_; // Basis of the previous solve
 };
 
 using OSI_CLP_SolverWrapper = OSI_X_SolverWrapper;
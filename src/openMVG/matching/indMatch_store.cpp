@@ -0,0 +1,431 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/matching/indMatch_store.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define OPENMVG_MATCHES_STORE_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace openMVG {
+namespace matching {
+
+namespace {
+
+// File signature, version & byte order mark
+const char kStore_Signature[8] = {'o', 'M', 'V', 'G', 'm', 't', 'c', 'h'};
+const uint32_t kStore_Version = 1;
+const uint32_t kByte_Order_Mark = 0x01020304;
+const size_t kHeader_Size = sizeof(kStore_Signature) + 2 * sizeof(uint32_t) + sizeof(uint64_t);
+const size_t kIndex_Entry_Size = 2 * sizeof(uint32_t) + 3 * sizeof(uint64_t);
+
+template <typename T>
+void AppendValue(std::vector<uint8_t> & buffer, const T & value)
+{
+  const uint8_t * bytes = reinterpret_cast<const uint8_t *>(&value);
+  buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+// Return true if the block [offset, offset + size) lies in [0, limit)
+// (written without offset + size, that can wrap around for a corrupted entry)
+bool IsBlockInRange(const uint64_t offset, const uint64_t size, const uint64_t limit)
+{
+  return offset <= limit && size <= limit - offset;
+}
+
+template <typename T>
+T ReadValue(const uint8_t *& it)
+{
+  T value;
+  std::memcpy(&value, it, sizeof(T));
+  it += sizeof(T);
+  return value;
+}
+
+void AppendVarint(std::vector<uint8_t> & buffer, uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    buffer.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  buffer.push_back(static_cast<uint8_t>(value));
+}
+
+bool ReadVarint(const uint8_t *& it, const uint8_t * end, uint64_t & value)
+{
+  value = 0;
+  for (int shift = 0; it != end && shift < 64; shift += 7)
+  {
+    const uint8_t byte = *it++;
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+// Map signed deltas to unsigned values (small magnitudes to small values)
+uint64_t ZigZag(const int64_t value)
+{
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t UnZigZag(const uint64_t value)
+{
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void EncodeMatches(const IndMatches & matches, std::vector<uint8_t> & block)
+{
+  block.clear();
+  AppendVarint(block, matches.size());
+  int64_t previous_i = 0, previous_j = 0;
+  for (const IndMatch & match : matches)
+  {
+    AppendVarint(block, ZigZag(static_cast<int64_t>(match.i_) - previous_i));
+    AppendVarint(block, ZigZag(static_cast<int64_t>(match.j_) - previous_j));
+    previous_i = match.i_;
+    previous_j = match.j_;
+  }
+}
+
+bool DecodeMatches(const uint8_t * it, const uint8_t * end, IndMatches & matches)
+{
+  uint64_t match_count;
+  if (!ReadVarint(it, end, match_count)
+      || match_count > static_cast<uint64_t>(end - it)) // at least 1 byte per match
+    return false;
+  matches.resize(match_count);
+  int64_t previous_i = 0, previous_j = 0;
+  for (IndMatch & match : matches)
+  {
+    uint64_t delta_i, delta_j;
+    if (!ReadVarint(it, end, delta_i) || !ReadVarint(it, end, delta_j))
+      return false;
+    previous_i += UnZigZag(delta_i);
+    previous_j += UnZigZag(delta_j);
+    match.i_ = static_cast<IndexT>(previous_i);
+    match.j_ = static_cast<IndexT>(previous_j);
+  }
+  return it == end;
+}
+
+} // namespace
+
+//--
+// Matches_Store_Writer
+//--
+
+Matches_Store_Writer::Matches_Store_Writer(const std::string & filename):
+  stream_(filename.c_str(), std::ios::binary | std::ios::out)
+{
+  if (!stream_.is_open())
+    return;
+  // Header (the index offset is written by Close)
+  std::vector<uint8_t> header(kStore_Signature, kStore_Signature + sizeof(kStore_Signature));
+  AppendValue<uint32_t>(header, kStore_Version);
+  AppendValue<uint32_t>(header, kByte_Order_Mark);
+  AppendValue<uint64_t>(header, 0);
+  stream_.write(reinterpret_cast<const char *>(header.data()), header.size());
+}
+
+Matches_Store_Writer::~Matches_Store_Writer()
+{
+  if (IsOpen())
+    Close();
+}
+
+bool Matches_Store_Writer::IsOpen() const
+{
+  return stream_.is_open();
+}
+
+bool Matches_Store_Writer::Append(const Pair & pair, const IndMatches & matches)
+{
+  // Encode outside of the lock
+  std::vector<uint8_t> block;
+  EncodeMatches(matches, block);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!IsOpen())
+    return false;
+  Matches_Store_Entry & entry = index_[pair];
+  entry.offset = stream_.tellp();
+  entry.size = block.size();
+  entry.match_count = matches.size();
+  stream_.write(reinterpret_cast<const char *>(block.data()), block.size());
+  return static_cast<bool>(stream_);
+}
+
+bool Matches_Store_Writer::Close()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!IsOpen())
+    return false;
+
+  // Index
+  std::vector<uint8_t> index;
+  index.reserve(sizeof(uint64_t) + index_.size() * kIndex_Entry_Size);
+  const uint64_t index_offset = stream_.tellp();
+  AppendValue<uint64_t>(index, index_.size());
+  for (const auto & entry_it : index_)
+  {
+    AppendValue<uint32_t>(index, entry_it.first.first);
+    AppendValue<uint32_t>(index, entry_it.first.second);
+    AppendValue<uint64_t>(index, entry_it.second.offset);
+    AppendValue<uint64_t>(index, entry_it.second.size);
+    AppendValue<uint64_t>(index, entry_it.second.match_count);
+  }
+  stream_.write(reinterpret_cast<const char *>(index.data()), index.size());
+
+  // Update the header
+  stream_.seekp(kHeader_Size - sizeof(uint64_t));
+  stream_.write(reinterpret_cast<const char *>(&index_offset), sizeof(uint64_t));
+  stream_.flush();
+  const bool b_ok = static_cast<bool>(stream_);
+  stream_.close();
+  index_.clear();
+  return b_ok;
+}
+
+//--
+// Matches_Store
+//--
+
+Matches_Store::Matches_Store() = default;
+
+Matches_Store::~Matches_Store()
+{
+#ifdef OPENMVG_MATCHES_STORE_USE_MMAP
+  if (data_)
+    munmap(const_cast<uint8_t *>(data_), data_size_);
+#endif
+}
+
+bool Matches_Store::Open(const std::string & filename)
+{
+  // Release the previously opened file
+  index_.clear();
+#ifdef OPENMVG_MATCHES_STORE_USE_MMAP
+  if (data_)
+    munmap(const_cast<uint8_t *>(data_), data_size_);
+#endif
+  data_ = nullptr;
+  data_size_ = 0;
+  if (stream_.is_open())
+    stream_.close();
+
+#ifdef OPENMVG_MATCHES_STORE_USE_MMAP
+  {
+    const int file_descriptor = open(filename.c_str(), O_RDONLY);
+    if (file_descriptor == -1)
+      return false;
+    struct stat file_status;
+    if (fstat(file_descriptor, &file_status) == 0 && file_status.st_size > 0)
+    {
+      void * mapping = mmap(nullptr, file_status.st_size, PROT_READ, MAP_SHARED, file_descriptor, 0);
+      if (mapping != MAP_FAILED)
+      {
+        data_ = static_cast<const uint8_t *>(mapping);
+        data_size_ = file_status.st_size;
+      }
+    }
+    close(file_descriptor);
+  }
+#endif
+  if (!data_)
+  {
+    stream_.open(filename.c_str(), std::ios::binary | std::ios::in);
+    if (!stream_.is_open())
+      return false;
+    stream_.seekg(0, std::ios::end);
+    data_size_ = stream_.tellg();
+  }
+
+  //-- Header
+  std::vector<uint8_t> buffer;
+  if (data_size_ < kHeader_Size
+      || !ReadBlock({0, kHeader_Size, 0}, buffer)
+      || !std::equal(kStore_Signature, kStore_Signature + sizeof(kStore_Signature),
+            reinterpret_cast<const char *>(buffer.data())))
+  {
+    std::cerr << "Invalid indexed match file: " << filename << std::endl;
+    return false;
+  }
+  const uint8_t * it = buffer.data() + sizeof(kStore_Signature);
+  const uint32_t version = ReadValue<uint32_t>(it);
+  const uint32_t byte_order_mark = ReadValue<uint32_t>(it);
+  const uint64_t index_offset = ReadValue<uint64_t>(it);
+  if (version != kStore_Version || byte_order_mark != kByte_Order_Mark)
+  {
+    std::cerr << "Unsupported indexed match file version or byte order: "
+      << filename << std::endl;
+    return false;
+  }
+
+  //-- Index
+  if (index_offset < kHeader_Size
+      || !IsBlockInRange(index_offset, sizeof(uint64_t), data_size_)
+      || !ReadBlock({index_offset, sizeof(uint64_t), 0}, buffer))
+    return false;
+  it = buffer.data();
+  const uint64_t pair_count = ReadValue<uint64_t>(it);
+  if (pair_count > (data_size_ - index_offset - sizeof(uint64_t)) / kIndex_Entry_Size
+      || !ReadBlock({index_offset + sizeof(uint64_t), pair_count * kIndex_Entry_Size, 0}, buffer))
+    return false;
+  it = buffer.data();
+  for (uint64_t i = 0; i < pair_count; ++i)
+  {
+    const IndexT I = ReadValue<uint32_t>(it);
+    const IndexT J = ReadValue<uint32_t>(it);
+    Matches_Store_Entry entry;
+    entry.offset = ReadValue<uint64_t>(it);
+    entry.size = ReadValue<uint64_t>(it);
+    entry.match_count = ReadValue<uint64_t>(it);
+    if (!IsBlockInRange(entry.offset, entry.size, index_offset))
+    {
+      index_.clear();
+      return false;
+    }
+    index_.emplace_hint(index_.end(), Pair(I, J), entry);
+  }
+  return true;
+}
+
+bool Matches_Store::IsOpen() const
+{
+  return data_ != nullptr || stream_.is_open();
+}
+
+Pair_Set Matches_Store::GetPairs() const
+{
+  Pair_Set pairs;
+  for (const auto & entry_it : index_)
+    pairs.insert(pairs.end(), entry_it.first);
+  return pairs;
+}
+
+const std::map<Pair, Matches_Store_Entry> & Matches_Store::GetIndex() const
+{
+  return index_;
+}
+
+size_t Matches_Store::MatchCount(const Pair & pair) const
+{
+  const auto entry_it = index_.find(pair);
+  return (entry_it == index_.end()) ? 0 : entry_it->second.match_count;
+}
+
+bool Matches_Store::ReadBlock
+(
+  const Matches_Store_Entry & entry,
+  std::vector<uint8_t> & block
+) const
+{
+  if (!IsBlockInRange(entry.offset, entry.size, data_size_))
+    return false;
+  if (data_)
+  {
+    block.assign(data_ + entry.offset, data_ + entry.offset + entry.size);
+    return true;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  block.resize(entry.size);
+  stream_.clear();
+  stream_.seekg(entry.offset);
+  stream_.read(reinterpret_cast<char *>(block.data()), entry.size);
+  return static_cast<bool>(stream_);
+}
+
+bool Matches_Store::Get(const Pair & pair, IndMatches & matches) const
+{
+  matches.clear();
+  const auto entry_it = index_.find(pair);
+  if (entry_it == index_.end())
+    return false;
+  const Matches_Store_Entry & entry = entry_it->second;
+  if (data_)
+  {
+    // Decode in place from the mapped file
+    return IsBlockInRange(entry.offset, entry.size, data_size_)
+      && DecodeMatches(data_ + entry.offset, data_ + entry.offset + entry.size, matches);
+  }
+  std::vector<uint8_t> block;
+  return ReadBlock(entry, block)
+    && DecodeMatches(block.data(), block.data() + block.size(), matches);
+}
+
+Matches_Store_Stream::Matches_Store_Stream
+(
+  Matches_Store_Writer & writer,
+  PairWiseMatchesContainer * matches
+):
+  writer_(writer),
+  matches_(matches),
+  b_valid_(writer.IsOpen())
+{
+}
+
+void Matches_Store_Stream::insert(std::pair<Pair, IndMatches> && pairWiseMatches)
+{
+  if (!writer_.Append(pairWiseMatches.first, pairWiseMatches.second))
+    b_valid_ = false;
+  if (matches_)
+    matches_->insert(std::move(pairWiseMatches));
+}
+
+bool Matches_Store_Stream::IsValid() const
+{
+  return b_valid_;
+}
+
+bool Save_Matches_Store
+(
+  const PairWiseMatches & matches,
+  const std::string & filename
+)
+{
+  Matches_Store_Writer writer(filename);
+  if (!writer.IsOpen())
+    return false;
+  bool b_ok = true;
+  for (const auto & pair_matches : matches)
+    b_ok &= writer.Append(pair_matches.first, pair_matches.second);
+  return writer.Close() && b_ok;
+}
+
+bool Load_Matches_Store
+(
+  PairWiseMatches & matches,
+  const std::string & filename
+)
+{
+  matches.clear();
+  Matches_Store store;
+  if (!store.Open(filename))
+    return false;
+  for (const auto & entry_it : store.GetIndex())
+  {
+    IndMatches & pair_matches = matches[entry_it.first];
+    if (!store.Get(entry_it.first, pair_matches))
+      return false;
+  }
+  return true;
+}
+
+}  // namespace matching
+}  // namespace openMVG
@@ -0,0 +1,148 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_MATCHING_IND_MATCH_STORE_HPP
+#define OPENMVG_MATCHING_IND_MATCH_STORE_HPP
+
+#include "openMVG/matching/indMatch.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace openMVG {
+namespace matching {
+
+/// Indexed pairwise match file (".mstore").
+///
+/// - Header: signature (8 bytes), version (uint32), byte order mark (uint32),
+///   index offset (uint64).
+/// - Match blocks (one per pair, appended in any order):
+///   varint match count, then for each match the zigzag varint deltas of i_
+///   and j_ to the previous match (a few bytes per match for sorted matches).
+/// - Index: pair count, {I, J, block offset, block size, match count}...
+///
+/// The file is written append only (the index is written on close), the
+/// matches of a pair are then read on demand without reading the others.
+struct Matches_Store_Entry
+{
+  uint64_t offset;      // Block offset in the file
+  uint64_t size;        // Block size in bytes
+  uint64_t match_count;
+};
+
+/// Write an indexed match file (the pairs are appended, Append is thread safe)
+class Matches_Store_Writer
+{
+public:
+  explicit Matches_Store_Writer(const std::string & filename);
+
+  /// Close the file (if not done yet)
+  ~Matches_Store_Writer();
+
+  bool IsOpen() const;
+
+  /// Append the matches of a pair (a pair appended twice keeps its last matches)
+  bool Append(const Pair & pair, const IndMatches & matches);
+
+  /// Write the index and close the file
+  bool Close();
+
+private:
+  std::mutex mutex_;
+  std::ofstream stream_;
+  std::map<Pair, Matches_Store_Entry> index_;
+};
+
+/// Pairwise matches container that appends the pairs to an indexed match
+/// file as they are inserted (i.e. as they are computed by the image
+/// collection matchers). The pairs are also forwarded to an optional
+/// container (the writer must outlive the stream).
+class Matches_Store_Stream : public PairWiseMatchesContainer
+{
+public:
+  explicit Matches_Store_Stream
+  (
+    Matches_Store_Writer & writer,
+    PairWiseMatchesContainer * matches = nullptr
+  );
+
+  void insert(std::pair<Pair, IndMatches> && pairWiseMatches) override;
+
+  /// Tell if all the inserted pairs were written
+  bool IsValid() const;
+
+private:
+  Matches_Store_Writer & writer_;
+  PairWiseMatchesContainer * matches_;
+  std::atomic<bool> b_valid_;
+};
+
+/// Read an indexed match file, the matches are read per pair on demand.
+/// The file is memory mapped when the platform supports it, else the match
+/// blocks are read from the file. Get can be called concurrently.
+class Matches_Store
+{
+public:
+  Matches_Store();
+  ~Matches_Store();
+
+  /// Open the file and read its index
+  bool Open(const std::string & filename);
+
+  bool IsOpen() const;
+
+  /// The indexed pairs
+  Pair_Set GetPairs() const;
+
+  /// The pair index
+  const std::map<Pair, Matches_Store_Entry> & GetIndex() const;
+
+  /// Number of matches of a pair (0 if the pair is unknown)
+  size_t MatchCount(const Pair & pair) const;
+
+  /// Read the matches of a pair
+  bool Get(const Pair & pair, IndMatches & matches) const;
+
+private:
+  bool ReadBlock(const Matches_Store_Entry & entry, std::vector<uint8_t> & block) const;
+
+  std::map<Pair, Matches_Store_Entry> index_;
+
+  // Memory mapped file
+  const uint8_t * data_ = nullptr;
+  uint64_t data_size_ = 0;
+
+  // Stream fallback
+  mutable std::mutex mutex_;
+  mutable std::ifstream stream_;
+};
+
+/// Save PairWiseMatches as an indexed match file
+bool Save_Matches_Store
+(
+  const PairWiseMatches & matches,
+  const std::string & filename
+);
+
+/// Load all the matches of an indexed match file
+bool Load_Matches_Store
+(
+  PairWiseMatches & matches,
+  const std::string & filename
+);
+
+}  // namespace matching
+}  // namespace openMVG
+
+#endif // OPENMVG_MATCHING_IND_MATCH_STORE_HPP
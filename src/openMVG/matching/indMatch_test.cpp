@@ -8,10 +8,16 @@
 
 
 #include "openMVG/matching/indMatch.hpp"
+#include "openMVG/matching/indMatch_store.hpp"
 #include "openMVG/matching/indMatch_utils.hpp"
 
 #include "testing/testing.h"
 
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+
 using namespace openMVG;
 using namespace matching;
 
@@ -106,6 +112,164 @@ TEST(IndMatch, DuplicateRemoval)
   EXPECT_EQ(IndMatch(3,3), vec_indMatch[4]);
 }
 
+TEST(IndMatch, Store_IO)
+{
+  PairWiseMatches matches;
+
+  // Test save + load of empty data
+  EXPECT_TRUE(Save(matches, "matches.mstore"));
+  EXPECT_TRUE(Load(matches, "matches.mstore"));
+  EXPECT_EQ(0, matches.size());
+
+  // Sorted, unsorted and large indexes (the match order is kept)
+  matches[{0,1}] = {{0,0},{1,1}};
+  matches[{1,2}] = {{5,3},{1,400000}, {2,2}, {UndefinedIndexT - 1, 0}};
+  matches[{2,3}] = {};
+
+  EXPECT_TRUE(Save(matches, "matches.mstore"));
+  PairWiseMatches loaded_matches;
+  EXPECT_TRUE(Load(loaded_matches, "matches.mstore"));
+  EXPECT_EQ(3, loaded_matches.size());
+  for (const auto & pair_matches : matches)
+  {
+    EXPECT_EQ(1, loaded_matches.count(pair_matches.first));
+    EXPECT_TRUE(pair_matches.second == loaded_matches.at(pair_matches.first));
+  }
+}
+
+TEST(IndMatch, Store_RandomAccess)
+{
+  {
+    Matches_Store_Writer writer("matches.mstore");
+    EXPECT_TRUE(writer.IsOpen());
+    // Pairs are appended in any order
+    EXPECT_TRUE(writer.Append({4,5}, {{0,0},{1,1}}));
+    EXPECT_TRUE(writer.Append({0,1}, {{0,0}}));
+    // The last matches of a pair are kept
+    EXPECT_TRUE(writer.Append({4,5}, {{0,2},{1,3},{2,4}}));
+    EXPECT_TRUE(writer.Close());
+  }
+
+  Matches_Store store;
+  EXPECT_TRUE(store.Open("matches.mstore"));
+  EXPECT_EQ(2, store.GetPairs().size());
+  EXPECT_EQ(1, store.MatchCount({0,1}));
+  EXPECT_EQ(3, store.MatchCount({4,5}));
+  EXPECT_EQ(0, store.MatchCount({1,2}));
+
+  IndMatches pair_matches;
+  EXPECT_TRUE(store.Get({4,5}, pair_matches));
+  EXPECT_EQ(3, pair_matches.size());
+  EXPECT_EQ(IndMatch(2,4), pair_matches[2]);
+  EXPECT_FALSE(store.Get({1,2}, pair_matches));
+  EXPECT_EQ(0, pair_matches.size());
+
+  // A cereal binary file is not an indexed match file
+  EXPECT_TRUE(Save(PairWiseMatches(), "matches.bin"));
+  Matches_Store invalid_store;
+  EXPECT_FALSE(invalid_store.Open("matches.bin"));
+}
+
+TEST(IndMatch, Store_Stream)
+{
+  // The pairs are appended as they are inserted and forwarded to the map
+  PairWiseMatches matches;
+  {
+    Matches_Store_Writer writer("matches.mstore");
+    Matches_Store_Stream matches_stream(writer, &matches);
+    matches_stream.insert({{0,1}, {{0,0},{1,1}}});
+    matches_stream.insert({{1,2}, {{2,3}}});
+    EXPECT_TRUE(matches_stream.IsValid());
+    EXPECT_TRUE(writer.Close());
+    // A closed file cannot be appended
+    matches_stream.insert({{2,3}, {{0,0}}});
+    EXPECT_FALSE(matches_stream.IsValid());
+  }
+  EXPECT_EQ(3, matches.size());
+
+  PairWiseMatches loaded_matches;
+  EXPECT_TRUE(Load(loaded_matches, "matches.mstore"));
+  EXPECT_EQ(2, loaded_matches.size());
+  EXPECT_TRUE(matches.at({0,1}) == loaded_matches.at({0,1}));
+  EXPECT_TRUE(matches.at({1,2}) == loaded_matches.at({1,2}));
+}
+
+// Write a copy of the file bytes where the uint64_t at the given offset is
+// replaced by value
+static bool WriteCorruptedCopy
+(
+  const std::vector<char> & bytes,
+  const size_t offset,
+  const uint64_t value,
+  const std::string & filename
+)
+{
+  std::vector<char> corrupted_bytes(bytes);
+  std::memcpy(&corrupted_bytes[offset], &value, sizeof(uint64_t));
+  std::ofstream stream(filename, std::ios::binary);
+  stream.write(corrupted_bytes.data(), corrupted_bytes.size());
+  return static_cast<bool>(stream);
+}
+
+TEST(IndMatch, Store_Corrupted)
+{
+  {
+    Matches_Store_Writer writer("matches.mstore");
+    EXPECT_TRUE(writer.Append({0,1}, {{0,0},{1,1}}));
+    EXPECT_TRUE(writer.Append({1,2}, {{2,3}}));
+    EXPECT_TRUE(writer.Close());
+  }
+  std::ifstream stream("matches.mstore", std::ios::binary);
+  const std::vector<char> bytes(
+    (std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+  stream.close();
+
+  // Header: signature (8), version (4), byte order mark (4), index offset (8)
+  // Index: pair count (8), then per pair: I, J (2 * 4), offset, size, count (3 * 8)
+  const size_t index_offset_position = 16;
+  uint64_t index_offset;
+  std::memcpy(&index_offset, &bytes[index_offset_position], sizeof(uint64_t));
+  const size_t pair_count_position = index_offset;
+  const size_t entry_offset_position = index_offset + 8 + 8;
+  const size_t entry_size_position = entry_offset_position + 8;
+
+  Matches_Store store;
+  EXPECT_TRUE(store.Open("matches.mstore"));
+
+  // Truncated index
+  {
+    std::ofstream truncated("matches_corrupted.mstore", std::ios::binary);
+    truncated.write(bytes.data(), bytes.size() - 10);
+  }
+  EXPECT_FALSE(Matches_Store().Open("matches_corrupted.mstore"));
+  // Truncated header
+  {
+    std::ofstream truncated("matches_corrupted.mstore", std::ios::binary);
+    truncated.write(bytes.data(), 12);
+  }
+  EXPECT_FALSE(Matches_Store().Open("matches_corrupted.mstore"));
+
+  const uint64_t max_value = std::numeric_limits<uint64_t>::max();
+  // Index offset past the end of the file (index offset + 8 wraps around)
+  EXPECT_TRUE(WriteCorruptedCopy(bytes, index_offset_position, max_value - 4,
+    "matches_corrupted.mstore"));
+  EXPECT_FALSE(Matches_Store().Open("matches_corrupted.mstore"));
+  // Pair count whose index size wraps around (2^59 + 1 entries of 32 bytes)
+  EXPECT_TRUE(WriteCorruptedCopy(bytes, pair_count_position, (uint64_t(1) << 59) + 1,
+    "matches_corrupted.mstore"));
+  EXPECT_FALSE(Matches_Store().Open("matches_corrupted.mstore"));
+  // Pair block past the index
+  EXPECT_TRUE(WriteCorruptedCopy(bytes, entry_size_position, index_offset,
+    "matches_corrupted.mstore"));
+  EXPECT_FALSE(Matches_Store().Open("matches_corrupted.mstore"));
+  // Pair block whose end wraps around
+  EXPECT_TRUE(WriteCorruptedCopy(bytes, entry_size_position, max_value - 8,
+    "matches_corrupted.mstore"));
+  EXPECT_FALSE(Matches_Store().Open("matches_corrupted.mstore"));
+  EXPECT_TRUE(WriteCorruptedCopy(bytes, entry_offset_position, max_value - 2,
+    "matches_corrupted.mstore"));
+  EXPECT_FALSE(Matches_Store().Open("matches_corrupted.mstore"));
+}
 
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
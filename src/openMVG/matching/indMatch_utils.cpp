@@ -11,6 +11,7 @@
 
 #include "openMVG/matching/indMatch_utils.hpp"
 #include "openMVG/matching/indMatch_io.hpp"
+#include "openMVG/matching/indMatch_store.hpp"
 
 #include <algorithm>
 #include <fstream>
@@ -69,6 +70,10 @@ bool Load
       return true;
     }
   }
+  else if (ext == "mstore") // Indexed match file
+  {
+    return Load_Matches_Store(matches, filename);
+  }
   else
   {
     std::cerr << "Unknown PairWiseMatches input format: " << ext << std::endl;
@@ -114,6 +119,10 @@ bool Save
       return true;
     }
   }
+  else if (ext == "mstore") // Indexed match file
+  {
+    return Save_Matches_Store(matches, filename);
+  }
   else
   {
     std::cerr << "Unknown PairWiseMatches output format: " << ext << std::endl;
@@ -183,10 +183,9 @@ struct GeometricFilter_EMatrix_AC
         regionsI = regions_provider->get(iIndex),
         regionsJ = regions_provider->get(jIndex);
 
-      geometry_aware::GuidedMatching<
-        Mat3,
+      // Compare the descriptors of the regions close to the epipolar lines
+      geometry_aware::GuidedMatching_Fundamental_Grid<
         openMVG::fundamental::kernel::EpipolarDistanceError>(
-          //openMVG::fundamental::kernel::SymmetricEpipolarDistanceError>(
           F,
           cam_I, *regionsI,
           cam_J, *regionsJ,
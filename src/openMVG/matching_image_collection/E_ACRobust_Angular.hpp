@@ -21,12 +21,12 @@
 #include "openMVG/multiview/motion_from_essential.hpp"
 #include "openMVG/multiview/solver_essential_eight_point.hpp"
 #include "openMVG/multiview/solver_essential_three_point.hpp"
+#include "openMVG/robust_estimation/guided_matching.hpp"
 #include "openMVG/robust_estimation/robust_estimator_ACRansac.hpp"
 #include "openMVG/robust_estimation/robust_estimator_ACRansacKernelAdaptator.hpp"
+#include "openMVG/sfm/pipelines/sfm_regions_provider.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
 
-namespace openMVG { namespace sfm { struct Regions_Provider; } }
-
 namespace openMVG {
 namespace matching_image_collection {
 
@@ -164,7 +164,42 @@ struct GeometricFilter_ESphericalMatrix_AC_Angular
     matching::IndMatches & matches
   )
   {
-    return false;
+    if (m_precision_upper_bound_robust != std::numeric_limits<double>::infinity())
+    {
+      // Get back corresponding view index
+      const IndexT iIndex = pairIndex.first;
+      const IndexT jIndex = pairIndex.second;
+
+      const sfm::View
+        * view_I = sfm_data->views.at(iIndex).get(),
+        * view_J = sfm_data->views.at(jIndex).get();
+
+      // Check that valid cameras can be retrieved for the pair of views
+      const cameras::IntrinsicBase
+        * cam_I =
+          sfm_data->GetIntrinsics().count(view_I->id_intrinsic) ?
+            sfm_data->GetIntrinsics().at(view_I->id_intrinsic).get() : nullptr,
+        * cam_J =
+          sfm_data->GetIntrinsics().count(view_J->id_intrinsic) ?
+            sfm_data->GetIntrinsics().at(view_J->id_intrinsic).get() : nullptr;
+
+      if (!cam_I || !cam_J)
+        return false;
+
+      const std::shared_ptr<features::Regions>
+        regionsI = regions_provider->get(iIndex),
+        regionsJ = regions_provider->get(jIndex);
+
+      // Compare the descriptors of the regions close to the epipolar great circles
+      // (the robust precision is an angle in radian)
+      geometry_aware::GuidedMatching_Essential_Angular_Grid(
+        m_E,
+        cam_I, *regionsI,
+        cam_J, *regionsJ,
+        m_precision_upper_bound_robust, Square(dDistanceRatio),
+        matches);
+    }
+    return matches.size() != 0;
   }
 
   // upper_bound precision used for robust estimation
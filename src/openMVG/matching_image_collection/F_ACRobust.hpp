@@ -137,10 +137,9 @@ struct GeometricFilter_FMatrix_AC
         regionsJ = regions_provider->get(jIndex);
 
       // Check the features correspondences that agree in the geometric and photometric domain
-      geometry_aware::GuidedMatching<
-        Mat3,
+      //  (only the regions close to the epipolar lines are compared)
+      geometry_aware::GuidedMatching_Fundamental_Grid<
         openMVG::fundamental::kernel::EpipolarDistanceError>(
-          //openMVG::fundamental::kernel::SymmetricEpipolarDistanceError>(
           m_F,
           cam_I, *regionsI,
           cam_J, *regionsJ,
@@ -174,8 +174,8 @@ struct GeometricFilter_HMatrix_AC
         PointsToMat(cam_I, pointsFeaturesI, xI);
         PointsToMat(cam_J, pointsFeaturesJ, xJ);
 
-        geometry_aware::GuidedMatching
-          <Mat3, openMVG::homography::kernel::AsymmetricError>(
+        geometry_aware::GuidedMatching_Homography_Grid
+          <openMVG::homography::kernel::AsymmetricError>(
           m_H, xI, xJ, Square(m_dPrecision_robust), matches);
 
         // Remove duplicates
@@ -188,8 +188,8 @@ struct GeometricFilter_HMatrix_AC
       else
       {
         // Filtering based on region positions and regions descriptors
-        geometry_aware::GuidedMatching<
-          Mat3,
+        //  (only the regions close to the transferred positions are compared)
+        geometry_aware::GuidedMatching_Homography_Grid<
           openMVG::homography::kernel::AsymmetricError>(
             m_H,
             cam_I, *regionsI,
@@ -0,0 +1,435 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/matching_image_collection/Retrieval_Pair_Builder.hpp"
+
+#include "openMVG/clustering/kmeans.hpp"
+#include "openMVG/features/regions.hpp"
+#include "openMVG/sfm/pipelines/sfm_regions_provider.hpp"
+
+#include "third_party/progress/progress.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <typeinfo>
+
+namespace openMVG {
+namespace matching_image_collection {
+
+//--
+// Vocabulary_Tree
+//--
+
+bool Vocabulary_Tree::Build
+(
+  const std::vector<Descriptor> & training_descriptors,
+  const uint32_t branching_factor,
+  const uint32_t depth,
+  const uint32_t max_kmeans_iterations
+)
+{
+  nodes_.clear();
+  nb_words_ = 0;
+  if (training_descriptors.empty() || branching_factor < 2 || depth == 0)
+    return false;
+
+  branching_factor_ = branching_factor;
+  depth_ = depth;
+  max_kmeans_iterations_ = max_kmeans_iterations;
+  descriptor_length_ = training_descriptors[0].size();
+
+  nodes_.emplace_back();
+  BuildNode(0, training_descriptors, 0);
+  return true;
+}
+
+void Vocabulary_Tree::BuildNode
+(
+  const uint32_t node_id,
+  const std::vector<Descriptor> & descriptors,
+  const uint32_t level
+)
+{
+  if (level == depth_ || descriptors.size() < branching_factor_)
+  {
+    // Leaf: a visual word
+    nodes_[node_id].word_id = nb_words_++;
+    return;
+  }
+
+  std::vector<uint32_t> assignment;
+  std::vector<Descriptor> centers;
+  clustering::KMeans(descriptors, assignment, centers,
+    branching_factor_, max_kmeans_iterations_);
+
+  // Split the descriptors according their cluster
+  std::vector<std::vector<Descriptor>> cluster_descriptors(centers.size());
+  for (size_t i = 0; i < descriptors.size(); ++i)
+    cluster_descriptors[assignment[i]].push_back(descriptors[i]);
+
+  // The descriptors cannot be split (i.e. duplicated descriptors): leaf
+  if (std::count_if(cluster_descriptors.cbegin(), cluster_descriptors.cend(),
+        [](const std::vector<Descriptor> & cluster) { return !cluster.empty(); }) < 2)
+  {
+    nodes_[node_id].word_id = nb_words_++;
+    return;
+  }
+
+  for (size_t id_center = 0; id_center < centers.size(); ++id_center)
+  {
+    if (cluster_descriptors[id_center].empty())
+      continue;
+    const uint32_t child_id = nodes_.size();
+    nodes_.emplace_back();
+    nodes_[child_id].center = std::move(centers[id_center]);
+    nodes_[node_id].children.push_back(child_id);
+  }
+
+  // Recursion (the child nodes are appended after the parent children list is set)
+  const std::vector<uint32_t> children = nodes_[node_id].children;
+  size_t id_child = 0;
+  for (size_t id_center = 0; id_center < cluster_descriptors.size(); ++id_center)
+  {
+    if (cluster_descriptors[id_center].empty())
+      continue;
+    std::vector<Descriptor> child_descriptors;
+    child_descriptors.swap(cluster_descriptors[id_center]);
+    BuildNode(children[id_child++], child_descriptors, level + 1);
+  }
+}
+
+uint32_t Vocabulary_Tree::Quantize(const float * descriptor) const
+{
+  uint32_t node_id = 0;
+  while (!nodes_[node_id].children.empty())
+  {
+    float min_dist = std::numeric_limits<float>::max();
+    uint32_t nearest_child = nodes_[node_id].children[0];
+    for (const uint32_t child_id : nodes_[node_id].children)
+    {
+      const float * center = nodes_[child_id].center.data();
+      float dist = 0.f;
+      for (size_t i = 0; i < descriptor_length_; ++i)
+      {
+        const float d = descriptor[i] - center[i];
+        dist += d * d;
+      }
+      if (dist < min_dist)
+      {
+        min_dist = dist;
+        nearest_child = child_id;
+      }
+    }
+    node_id = nearest_child;
+  }
+  return nodes_[node_id].word_id;
+}
+
+//--
+// BoW_Database
+//--
+
+BoW_Database::BoW_Database(const uint32_t nb_words)
+: nb_words_(nb_words)
+{
+}
+
+void BoW_Database::AddImage(const IndexT image_id, const std::vector<uint32_t> & words)
+{
+  std::map<uint32_t, uint32_t> word_count;
+  for (const uint32_t word : words)
+    ++word_count[word];
+
+  // Term frequency
+  Sparse_Vector image_vector;
+  image_vector.reserve(word_count.size());
+  for (const auto & it : word_count)
+    image_vector.emplace_back(it.first, it.second / static_cast<float>(words.size()));
+
+  image_index_[image_id] = image_ids_.size();
+  image_ids_.push_back(image_id);
+  image_vectors_.emplace_back(std::move(image_vector));
+}
+
+void BoW_Database::Finalize()
+{
+  // Inverse document frequency
+  std::vector<uint32_t> document_count(nb_words_, 0);
+  for (const Sparse_Vector & image_vector : image_vectors_)
+    for (const auto & word_it : image_vector)
+      ++document_count[word_it.first];
+
+  inverted_file_.assign(nb_words_, {});
+  for (size_t image_index = 0; image_index < image_vectors_.size(); ++image_index)
+  {
+    Sparse_Vector & image_vector = image_vectors_[image_index];
+    float norm = 0.f;
+    for (auto & word_it : image_vector)
+    {
+      word_it.second *= std::log(image_vectors_.size() / static_cast<float>(document_count[word_it.first]));
+      norm += word_it.second * word_it.second;
+    }
+    norm = std::sqrt(norm);
+    for (auto & word_it : image_vector)
+    {
+      if (norm > 0.f)
+        word_it.second /= norm;
+      if (word_it.second > 0.f)
+        inverted_file_[word_it.first].emplace_back(image_index, word_it.second);
+    }
+  }
+}
+
+std::vector<std::pair<IndexT, float>> BoW_Database::Query
+(
+  const IndexT image_id,
+  const size_t nb_neighbors
+) const
+{
+  const auto it = image_index_.find(image_id);
+  if (it == image_index_.end())
+    return {};
+  Query_Buffer buffer;
+  return Query(it->second, nb_neighbors, buffer);
+}
+
+std::vector<std::pair<IndexT, float>> BoW_Database::Query
+(
+  const size_t image_index,
+  const size_t nb_neighbors,
+  Query_Buffer & buffer
+) const
+{
+  // Accumulate the scores of the images that share some words with the query:
+  // only the touched images are visited (the scores are reset afterwards)
+  std::vector<float> & scores = buffer.scores;
+  std::vector<uint32_t> & touched = buffer.touched;
+  scores.resize(image_ids_.size(), 0.f);
+  touched.clear();
+  for (const auto & word_it : image_vectors_[image_index])
+  {
+    if (word_it.second <= 0.f) // Word seen by all the images
+      continue;
+    for (const auto & image_it : inverted_file_[word_it.first])
+    {
+      if (scores[image_it.first] == 0.f)
+        touched.push_back(image_it.first);
+      scores[image_it.first] += word_it.second * image_it.second;
+    }
+  }
+
+  std::vector<std::pair<float, uint32_t>> & candidates = buffer.candidates;
+  candidates.clear();
+  for (const uint32_t touched_index : touched)
+  {
+    if (touched_index != image_index && scores[touched_index] > 0.f)
+      candidates.emplace_back(scores[touched_index], touched_index);
+    scores[touched_index] = 0.f;
+  }
+
+  const size_t nb_candidates = std::min(nb_neighbors, candidates.size());
+  std::partial_sort(candidates.begin(), candidates.begin() + nb_candidates, candidates.end(),
+    [](const std::pair<float, uint32_t> & a, const std::pair<float, uint32_t> & b)
+    {
+      return a.first > b.first || (a.first == b.first && a.second < b.second);
+    });
+
+  std::vector<std::pair<IndexT, float>> neighbors;
+  neighbors.reserve(nb_candidates);
+  for (size_t i = 0; i < nb_candidates; ++i)
+    neighbors.emplace_back(image_ids_[candidates[i].second], candidates[i].first);
+  return neighbors;
+}
+
+std::map<IndexT, std::vector<IndexT>> BoW_Database::QueryAll(const size_t nb_neighbors) const
+{
+  std::vector<std::vector<IndexT>> neighbors(image_ids_.size());
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel
+#endif
+  {
+    // The score buffers are reused by the queries of a thread
+    Query_Buffer buffer;
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp for schedule(dynamic)
+#endif
+    for (int image_index = 0; image_index < static_cast<int>(image_ids_.size()); ++image_index)
+    {
+      for (const auto & neighbor_it : Query(image_index, nb_neighbors, buffer))
+        neighbors[image_index].push_back(neighbor_it.first);
+    }
+  }
+
+  std::map<IndexT, std::vector<IndexT>> neighbors_per_image;
+  for (size_t image_index = 0; image_index < image_ids_.size(); ++image_index)
+    neighbors_per_image[image_ids_[image_index]] = std::move(neighbors[image_index]);
+  return neighbors_per_image;
+}
+
+//--
+// Retrieval pairs
+//--
+
+/// Length of the float representation of a regions descriptor
+/// (binary descriptors are expanded to one float per bit)
+static size_t FloatDescriptorLength(const features::Regions & regions)
+{
+  return regions.IsBinary() ? regions.DescriptorLength() * 8 : regions.DescriptorLength();
+}
+
+/// Convert the descriptor i of a regions to floats (see FloatDescriptorLength)
+static bool ToFloatDescriptor
+(
+  const features::Regions & regions,
+  const size_t i,
+  float * descriptor
+)
+{
+  const size_t length = regions.DescriptorLength();
+  if (regions.IsBinary())
+  {
+    // The L2 squared distance of the expanded bits is the Hamming distance
+    const unsigned char * data =
+      reinterpret_cast<const unsigned char*>(regions.DescriptorRawData()) + i * length;
+    for (size_t byte = 0; byte < length; ++byte)
+      for (int bit = 0; bit < 8; ++bit)
+        descriptor[byte * 8 + bit] = (data[byte] >> bit) & 1;
+    return true;
+  }
+  if (regions.Type_id() == typeid(unsigned char).name())
+  {
+    const unsigned char * data =
+      reinterpret_cast<const unsigned char*>(regions.DescriptorRawData()) + i * length;
+    std::copy(data, data + length, descriptor);
+    return true;
+  }
+  if (regions.Type_id() == typeid(float).name())
+  {
+    const float * data =
+      reinterpret_cast<const float*>(regions.DescriptorRawData()) + i * length;
+    std::copy(data, data + length, descriptor);
+    return true;
+  }
+  return false;
+}
+
+Pair_Set retrievalPairs
+(
+  const sfm::Regions_Provider & regions_provider,
+  const std::set<IndexT> & view_ids,
+  const Retrieval_Pair_Options & options,
+  C_Progress * my_progress_bar
+)
+{
+  if (!my_progress_bar)
+    my_progress_bar = &C_Progress::dummy();
+
+  Pair_Set pairs;
+  if (view_ids.size() < 2)
+    return pairs;
+
+  const std::vector<IndexT> vec_view_ids(view_ids.cbegin(), view_ids.cend());
+  const int nb_views = vec_view_ids.size();
+
+  // 1. Sample the training descriptors (evenly spread over the views)
+  my_progress_bar->restart(nb_views, "\n- Vocabulary training data -\n");
+  const size_t descriptors_per_view =
+    std::max<size_t>(1, options.max_training_descriptors_ / nb_views);
+  std::vector<Vocabulary_Tree::Descriptor> training_descriptors;
+  bool b_supported_regions = true;
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(dynamic)
+#endif
+  for (int i = 0; i < nb_views; ++i)
+  {
+    const std::shared_ptr<features::Regions> regions = regions_provider.get(vec_view_ids[i]);
+    if (regions && regions->RegionCount() > 0)
+    {
+      const size_t nb_samples = std::min(descriptors_per_view, regions->RegionCount());
+      std::vector<Vocabulary_Tree::Descriptor> samples(nb_samples,
+        Vocabulary_Tree::Descriptor(FloatDescriptorLength(*regions)));
+      bool b_supported = true;
+      for (size_t k = 0; k < nb_samples && b_supported; ++k)
+        b_supported = ToFloatDescriptor(*regions, k * regions->RegionCount() / nb_samples,
+                                        samples[k].data());
+#ifdef OPENMVG_USE_OPENMP
+      #pragma omp critical
+#endif
+      {
+        b_supported_regions &= b_supported;
+        training_descriptors.insert(training_descriptors.end(),
+          std::make_move_iterator(samples.begin()), std::make_move_iterator(samples.end()));
+      }
+    }
+    ++(*my_progress_bar);
+  }
+  if (!b_supported_regions)
+  {
+    std::cerr << "Image retrieval: unsupported regions type." << std::endl;
+    return pairs;
+  }
+  // Make the training independent of the thread scheduling
+  std::sort(training_descriptors.begin(), training_descriptors.end());
+
+  // 2. Build the vocabulary
+  Vocabulary_Tree vocabulary;
+  if (!vocabulary.Build(training_descriptors, options.branching_factor_,
+                        options.depth_, options.max_kmeans_iterations_))
+  {
+    std::cerr << "Image retrieval: cannot build the vocabulary." << std::endl;
+    return pairs;
+  }
+  training_descriptors.clear();
+  training_descriptors.shrink_to_fit();
+  std::cout << "Image retrieval: vocabulary of " << vocabulary.WordCount() << " words." << std::endl;
+
+  // 3. Quantize the descriptors of every view
+  my_progress_bar->restart(nb_views, "\n- Bag of words computation -\n");
+  std::vector<std::vector<uint32_t>> view_words(nb_views);
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(dynamic)
+#endif
+  for (int i = 0; i < nb_views; ++i)
+  {
+    const std::shared_ptr<features::Regions> regions = regions_provider.get(vec_view_ids[i]);
+    if (regions && FloatDescriptorLength(*regions) == vocabulary.DescriptorLength())
+    {
+      std::vector<float> descriptor(vocabulary.DescriptorLength());
+      view_words[i].reserve(regions->RegionCount());
+      for (size_t k = 0; k < regions->RegionCount(); ++k)
+      {
+        ToFloatDescriptor(*regions, k, descriptor.data());
+        view_words[i].push_back(vocabulary.Quantize(descriptor.data()));
+      }
+    }
+    ++(*my_progress_bar);
+  }
+
+  BoW_Database database(vocabulary.WordCount());
+  for (int i = 0; i < nb_views; ++i)
+  {
+    if (!view_words[i].empty())
+      database.AddImage(vec_view_ids[i], view_words[i]);
+  }
+  view_words.clear();
+  database.Finalize();
+
+  // 4. Link every view to its most similar views
+  for (const auto & neighbors_it : database.QueryAll(options.nb_neighbors_))
+  {
+    const IndexT I = neighbors_it.first;
+    for (const IndexT J : neighbors_it.second)
+      pairs.insert({std::min(I, J), std::max(I, J)});
+  }
+  return pairs;
+}
+
+} // namespace matching_image_collection
+} // namespace openMVG
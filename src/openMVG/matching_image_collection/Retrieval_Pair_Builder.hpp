@@ -0,0 +1,156 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_MATCHING_IMAGE_COLLECTION_RETRIEVAL_PAIR_BUILDER_HPP
+#define OPENMVG_MATCHING_IMAGE_COLLECTION_RETRIEVAL_PAIR_BUILDER_HPP
+
+#include "openMVG/types.hpp"
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+class C_Progress;
+
+namespace openMVG {
+
+namespace sfm {
+  struct Regions_Provider;
+} // namespace sfm
+
+namespace matching_image_collection {
+
+/// Hierarchical k-means vocabulary tree
+/// (see "Scalable Recognition with a Vocabulary Tree",
+///  D. Nister and H. Stewenius, CVPR 2006).
+/// Every level splits the descriptors of a node into branching_factor clusters,
+/// the leaves of the tree are the visual words.
+class Vocabulary_Tree
+{
+public:
+  using Descriptor = std::vector<float>;
+
+  /// Build the tree from a set of training descriptors
+  bool Build
+  (
+    const std::vector<Descriptor> & training_descriptors,
+    const uint32_t branching_factor,
+    const uint32_t depth,
+    const uint32_t max_kmeans_iterations = 20
+  );
+
+  /// Return the visual word of a descriptor (walk down the nearest centers)
+  uint32_t Quantize(const float * descriptor) const;
+
+  uint32_t WordCount() const { return nb_words_; }
+  size_t DescriptorLength() const { return descriptor_length_; }
+
+private:
+  struct Node
+  {
+    Descriptor center;
+    std::vector<uint32_t> children; // node indexes (empty for a leaf)
+    uint32_t word_id = 0;
+  };
+
+  void BuildNode
+  (
+    const uint32_t node_id,
+    const std::vector<Descriptor> & descriptors,
+    const uint32_t level
+  );
+
+  std::vector<Node> nodes_; // nodes_[0] is the root
+  uint32_t nb_words_ = 0;
+  uint32_t branching_factor_ = 0;
+  uint32_t depth_ = 0;
+  uint32_t max_kmeans_iterations_ = 0;
+  size_t descriptor_length_ = 0;
+};
+
+/// TF-IDF weighted bag of visual words database with an inverted file.
+/// Images are scored by the dot product of their L2 normalized TF-IDF vectors.
+class BoW_Database
+{
+public:
+  explicit BoW_Database(const uint32_t nb_words);
+
+  /// Add the visual words of an image
+  void AddImage(const IndexT image_id, const std::vector<uint32_t> & words);
+
+  /// Compute the IDF weights and the normalized image vectors.
+  /// Must be called once all the images are added.
+  void Finalize();
+
+  /// Return the most similar images of a database image (sorted by decreasing score)
+  std::vector<std::pair<IndexT, float>> Query
+  (
+    const IndexT image_id,
+    const size_t nb_neighbors
+  ) const;
+
+  /// Return the nb_neighbors most similar images of every image
+  std::map<IndexT, std::vector<IndexT>> QueryAll(const size_t nb_neighbors) const;
+
+private:
+  using Sparse_Vector = std::vector<std::pair<uint32_t, float>>; // (word, weight)
+
+  // Scratch buffers of a query (reused by the queries of a thread)
+  struct Query_Buffer
+  {
+    std::vector<float> scores;     // image index -> score (zero between the queries)
+    std::vector<uint32_t> touched; // image indexes with a non zero score
+    std::vector<std::pair<float, uint32_t>> candidates; // (score, image index)
+  };
+
+  std::vector<std::pair<IndexT, float>> Query
+  (
+    const size_t image_index,
+    const size_t nb_neighbors,
+    Query_Buffer & buffer
+  ) const;
+
+  uint32_t nb_words_;
+  std::vector<IndexT> image_ids_;
+  std::map<IndexT, size_t> image_index_;
+  std::vector<Sparse_Vector> image_vectors_;
+  // word -> (image index, weight)
+  std::vector<std::vector<std::pair<uint32_t, float>>> inverted_file_;
+};
+
+struct Retrieval_Pair_Options
+{
+  uint32_t branching_factor_ = 10;
+  uint32_t depth_ = 4; // branching_factor^depth visual words
+  uint32_t max_kmeans_iterations_ = 20;
+  // Number of descriptors sampled to train the vocabulary
+  uint32_t max_training_descriptors_ = 100000;
+  // Number of similar images linked to every image
+  uint32_t nb_neighbors_ = 20;
+};
+
+/// Image retrieval pair selection:
+/// - train a vocabulary tree on a sample of the image descriptors,
+/// - describe every image by its TF-IDF bag of visual words,
+/// - link every image to its most similar images.
+/// The pairs are (I,J) view ids with I < J.
+/// Scalar (unsigned char and float) and binary descriptors are supported.
+Pair_Set retrievalPairs
+(
+  const sfm::Regions_Provider & regions_provider,
+  const std::set<IndexT> & view_ids,
+  const Retrieval_Pair_Options & options = Retrieval_Pair_Options(),
+  C_Progress * progress = nullptr
+);
+
+} // namespace matching_image_collection
+} // namespace openMVG
+
+#endif // OPENMVG_MATCHING_IMAGE_COLLECTION_RETRIEVAL_PAIR_BUILDER_HPP
@@ -0,0 +1,124 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/matching_image_collection/Retrieval_Pair_Builder.hpp"
+#include "testing/testing.h"
+
+#include <random>
+
+using namespace openMVG;
+using namespace openMVG::matching_image_collection;
+
+// Three scenes of 4 images: the images of a scene see noisy versions of the
+// same scene descriptors.
+// The images retrieved for a query must come from the same scene.
+TEST(Retrieval_Pair_Builder, BoW_Database)
+{
+  const int nb_scenes = 3, nb_images_per_scene = 4;
+  const int nb_descriptors_per_scene = 60, descriptor_length = 16;
+
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::uniform_real_distribution<float> scene_distribution(0.f, 255.f);
+  std::normal_distribution<float> noise_distribution(0.f, 2.f);
+
+  std::vector<std::vector<Vocabulary_Tree::Descriptor>> scene_descriptors(nb_scenes);
+  for (auto & descriptors : scene_descriptors)
+  {
+    descriptors.resize(nb_descriptors_per_scene, Vocabulary_Tree::Descriptor(descriptor_length));
+    for (auto & descriptor : descriptors)
+      for (float & value : descriptor)
+        value = scene_distribution(random_generator);
+  }
+
+  // Image I belongs to the scene I / nb_images_per_scene
+  std::vector<std::vector<Vocabulary_Tree::Descriptor>> image_descriptors;
+  std::vector<Vocabulary_Tree::Descriptor> training_descriptors;
+  for (int scene = 0; scene < nb_scenes; ++scene)
+  {
+    for (int image = 0; image < nb_images_per_scene; ++image)
+    {
+      std::vector<Vocabulary_Tree::Descriptor> descriptors = scene_descriptors[scene];
+      for (auto & descriptor : descriptors)
+        for (float & value : descriptor)
+          value += noise_distribution(random_generator);
+      training_descriptors.insert(training_descriptors.end(), descriptors.cbegin(), descriptors.cend());
+      image_descriptors.emplace_back(descriptors);
+    }
+  }
+
+  Vocabulary_Tree vocabulary;
+  EXPECT_TRUE(vocabulary.Build(training_descriptors, 4, 3));
+  EXPECT_TRUE(vocabulary.WordCount() > 1);
+  EXPECT_TRUE(vocabulary.WordCount() <= 64);
+
+  BoW_Database database(vocabulary.WordCount());
+  for (size_t image = 0; image < image_descriptors.size(); ++image)
+  {
+    std::vector<uint32_t> words;
+    for (const auto & descriptor : image_descriptors[image])
+      words.push_back(vocabulary.Quantize(descriptor.data()));
+    database.AddImage(image, words);
+  }
+  database.Finalize();
+
+  const auto neighbors = database.QueryAll(nb_images_per_scene - 1);
+  EXPECT_EQ(image_descriptors.size(), neighbors.size());
+  for (const auto & neighbors_it : neighbors)
+  {
+    EXPECT_EQ(nb_images_per_scene - 1, neighbors_it.second.size());
+    for (const IndexT neighbor : neighbors_it.second)
+    {
+      EXPECT_TRUE(neighbor != neighbors_it.first);
+      EXPECT_EQ(neighbors_it.first / nb_images_per_scene, neighbor / nb_images_per_scene);
+    }
+  }
+}
+
+// Duplicated training descriptors cannot be split by the KMeans:
+// the vocabulary is a single word
+TEST(Retrieval_Pair_Builder, Vocabulary_Tree_Duplicated_Descriptors)
+{
+  const std::vector<Vocabulary_Tree::Descriptor> training_descriptors(
+    50, Vocabulary_Tree::Descriptor(16, 7.f));
+
+  Vocabulary_Tree vocabulary;
+  EXPECT_TRUE(vocabulary.Build(training_descriptors, 4, 3));
+  EXPECT_EQ(1, vocabulary.WordCount());
+  EXPECT_EQ(0, vocabulary.Quantize(training_descriptors[0].data()));
+}
+
+// The images that share no word with the query are not retrieved
+TEST(Retrieval_Pair_Builder, BoW_Database_Chain)
+{
+  // Image i has the words {2i, 2i+1, 2i+2}: it shares a word with i-1 and i+1
+  const int nb_images = 1000;
+  BoW_Database database(2 * nb_images + 1);
+  for (int image = 0; image < nb_images; ++image)
+    database.AddImage(image, {2u * image, 2u * image + 1, 2u * image + 2});
+  database.Finalize();
+
+  const auto neighbors = database.QueryAll(5);
+  EXPECT_EQ(nb_images, neighbors.size());
+  for (const auto & neighbors_it : neighbors)
+  {
+    const IndexT image = neighbors_it.first;
+    const size_t expected_count = (image == 0 || image == nb_images - 1) ? 1 : 2;
+    EXPECT_EQ(expected_count, neighbors_it.second.size());
+    for (const IndexT neighbor : neighbors_it.second)
+      EXPECT_TRUE(neighbor + 1 == image || neighbor == image + 1);
+  }
+  // Same result with a single query
+  const auto single = database.Query(10, 5);
+  EXPECT_EQ(2, single.size());
+  EXPECT_EQ(neighbors.at(10)[0], single[0].first);
+  EXPECT_EQ(neighbors.at(10)[1], single[1].first);
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
@@ -35,7 +35,9 @@ using namespace lemon;
 #include <Eigen/Cholesky>
 #include <Eigen/SparseCholesky>
 
+#include <algorithm>
 #include <queue>
+#include <vector>
 
 namespace openMVG   {
 namespace rotation_averaging  {
@@ -309,12 +311,15 @@ bool GlobalRotationsRobust(
   Matrix3x3Arr& Rs,
   const uint32_t nMainViewID,
   float threshold,
-  std::vector<bool> * vec_Inliers)
+  std::vector<bool> * vec_Inliers,
+  const bool b_use_input_rotations)
 {
   assert(!Rs.empty());
 
-  // -- Compute coarse global rotation estimates:
-  InitRotationsMST(RelRs, Rs, nMainViewID);
+  // -- Compute coarse global rotation estimates
+  //    (or start from the input ones, i.e a previous solution)
+  if (!b_use_input_rotations)
+    InitRotationsMST(RelRs, Rs, nMainViewID);
 
   // refine global rotations based on the relative rotations
   const bool bOk = RefineRotationsAvgL1IRLS(RelRs, Rs, nMainViewID);
@@ -394,6 +399,73 @@ inline void CorrectMatrix(
   }
 }
 
+// Weighted normal equations (A^T W A) of a fixed sparse matrix A.
+// The sparsity pattern of A^T W A is computed once and the contributions of
+// every row of A are precomputed, so that updating the weights only refreshes
+// the values of the matrix (and the linear solver can keep its symbolic
+// factorization).
+// Only the lower triangular part is stored (as used by Eigen::SimplicialLDLT).
+class Weighted_Normal_Equations
+{
+public:
+  explicit Weighted_Normal_Equations(const sMat & A)
+  {
+    using Row_Major_Mat = Eigen::SparseMatrix<double, Eigen::RowMajor>;
+    const Row_Major_Mat A_rows(A);
+
+    // Build the pattern of the lower triangular part of A^T A
+    std::vector<Eigen::Triplet<double>> triplets;
+    for (Row_Major_Mat::Index row = 0; row < A_rows.outerSize(); ++row)
+      for (Row_Major_Mat::InnerIterator it_k(A_rows, row); it_k; ++it_k)
+        for (Row_Major_Mat::InnerIterator it_l(A_rows, row); it_l; ++it_l)
+          if (it_k.col() >= it_l.col())
+            triplets.emplace_back(it_k.col(), it_l.col(), 1.0);
+    AtWA_.resize(A.cols(), A.cols());
+    AtWA_.setFromTriplets(triplets.cbegin(), triplets.cend());
+    AtWA_.makeCompressed();
+
+    // Locate the contribution of every row in the values of A^T W A
+    contributions_.reserve(triplets.size());
+    for (Row_Major_Mat::Index row = 0; row < A_rows.outerSize(); ++row)
+      for (Row_Major_Mat::InnerIterator it_k(A_rows, row); it_k; ++it_k)
+        for (Row_Major_Mat::InnerIterator it_l(A_rows, row); it_l; ++it_l)
+          if (it_k.col() >= it_l.col())
+            contributions_.push_back(
+              {ValueIndex(it_k.col(), it_l.col()), row, it_k.value() * it_l.value()});
+  }
+
+  /// Refresh the values of A^T W A for the given row weights
+  const sMat & Update(const Eigen::ArrayXd & weights)
+  {
+    double * values = AtWA_.valuePtr();
+    std::fill(values, values + AtWA_.nonZeros(), 0.0);
+    for (const Contribution & contribution : contributions_)
+      values[contribution.value_index] += weights[contribution.row] * contribution.coeff;
+    return AtWA_;
+  }
+
+  const sMat & Matrix() const { return AtWA_; }
+
+private:
+  struct Contribution
+  {
+    sMat::Index value_index;
+    sMat::Index row;
+    double coeff;
+  };
+
+  // Index of the (row, col) entry in the compressed values of AtWA_
+  sMat::Index ValueIndex(const sMat::Index row, const sMat::Index col) const
+  {
+    const sMat::StorageIndex * begin = AtWA_.innerIndexPtr() + AtWA_.outerIndexPtr()[col];
+    const sMat::StorageIndex * end = AtWA_.innerIndexPtr() + AtWA_.outerIndexPtr()[col + 1];
+    return std::lower_bound(begin, end, row) - AtWA_.innerIndexPtr();
+  }
+
+  sMat AtWA_;
+  std::vector<Contribution> contributions_;
+};
+
 // L1RA -> L1 Rotation Averaging implementation
 bool SolveL1RA
 (
@@ -411,6 +483,14 @@ bool SolveL1RA
   // init x with 0 that corresponds to trusting completely the initial Ri guess
   Vec x(Vec::Zero(n)), b(m);
 
+  // A does not change along the iterations: factorize A^T A only once
+  L1Solver<sMat >::Options options;
+  L1Solver<sMat > l1_solver(options, A);
+  if (!l1_solver.Status()) {
+    std::cerr << "Cholesky decomposition failed." << std::endl;
+    return false;
+  }
+
   // Current error and the previous one
   double e = std::numeric_limits<double>::max(), ep;
   unsigned iter = 0;
@@ -420,8 +500,6 @@ bool SolveL1RA
     FillErrorMatrix(RelRs, Rs, b);
 
     // solve the linear system using l1 norm
-    L1Solver<sMat >::Options options;
-    L1Solver<sMat > l1_solver(options, A);
     l1_solver.Solve(b, &x);
 
     ep = e; e = x.norm();
@@ -455,11 +533,14 @@ bool SolveIRLS
   Vec x(Vec::Zero(n)), b(m);
 
   // Since the sparsity pattern will not change with each linear solve
-  //  compute it once to speed up the solution time.
+  //  compute it once to speed up the solution time:
+  //  - the weighted normal equations are updated in place,
+  //  - only the numeric factorization is done at each iteration.
   using Linear_Solver_T = Eigen::SimplicialLDLT<sMat >;
 
+  Weighted_Normal_Equations normal_equations(A);
   Linear_Solver_T linear_solver;
-  linear_solver.analyzePattern(A.transpose() * A);
+  linear_solver.analyzePattern(normal_equations.Matrix());
   if (linear_solver.info() != Eigen::Success) {
     std::cerr << "Cholesky decomposition failed." << std::endl;
     return false;
@@ -485,15 +566,14 @@ bool SolveIRLS
     weights = sigmaSq / (errors.square() + sigmaSq).square();
 
     // Update the factorization for the weighted values
-    const sMat at_weight = A.transpose() * weights.matrix().asDiagonal();
-    linear_solver.factorize(at_weight * A);
+    linear_solver.factorize(normal_equations.Update(weights));
     if (linear_solver.info() != Eigen::Success) {
       std::cerr << "Failed to factorize the least squares system." << std::endl;
       return false;
     }
 
     // Solve the least squares problem
-    x = linear_solver.solve(at_weight * b);
+    x = linear_solver.solve(A.transpose() * (weights * b.array()).matrix());
     if (linear_solver.info() != Eigen::Success) {
       std::cerr << "Failed to solve the least squares system." << std::endl;
       return false;
@@ -50,13 +50,17 @@ void InitRotationsMST
  * @param[in] nMainViewID Id of the image considered as Identity (unit rotation)
  * @param[in] threshold (optional) threshold
  * @param[out] vec_inliers rotation labelled as inliers or outliers
+ * @param[in] b_use_input_rotations (optional) use Rs as initial estimation
+ *  instead of the MST initialization (i.e warm start from a previous solution
+ *  when only a few relative rotations have changed)
  */
 bool GlobalRotationsRobust(
   const RelativeRotations& RelRs,
   Matrix3x3Arr& Rs,
   const uint32_t nMainViewID,
   float threshold = 0.f,
-  std::vector<bool> * vec_inliers = nullptr );
+  std::vector<bool> * vec_inliers = nullptr,
+  const bool b_use_input_rotations = false );
 
 /**
  * @brief Implementation of Iteratively Reweighted Least Squares (IRLS) [1].
@@ -15,6 +15,11 @@
 #include <ceres/ceres.h>
 #include <ceres/rotation.h>
 
+#include <Eigen/SparseCholesky>
+
+#include <iostream>
+#include <random>
+
 #ifdef _MSC_VER
 #pragma warning( once : 4267 ) //warning C4267: 'argument' : conversion from 'size_t' to 'const int', possible loss of data
 #endif
@@ -59,9 +64,88 @@ bool compare_first_abs(std::pair<double, Vec> const &x, std::pair<double, Vec> c
  return std::abs(x.first) < std::abs(y.first);
 }
 
+// Compute the eigen vectors related to the nb_vectors smallest eigen values
+//  of a sparse symmetric positive semi-definite matrix.
+// Shift-and-invert subspace iteration with a Rayleigh-Ritz projection:
+//  - the (slightly shifted) matrix is factorized once (sparse LDLT),
+//  - a block of vectors is repeatedly multiplied by the inverse matrix and
+//    orthonormalized, so it converges to the smallest eigen space,
+//  - the Ritz vectors of the block are the eigen vector estimates.
+// The block is oversampled to speed up the convergence
+//  (rate: lambda_{nb_vectors} / lambda_{block_size + 1}).
+// Return false if the eigen vectors did not converge in max_iteration iterations.
+static bool SparseSmallestEigenVectors
+(
+  const sMat & AtA,
+  const Mat::Index nb_vectors,
+  Mat & eigen_vectors
+)
+{
+  const Mat::Index n = AtA.rows();
+  const Mat::Index block_size = std::min(n, 2 * nb_vectors);
+  const int max_iteration = 100;
+
+  const double scale = AtA.diagonal().cwiseAbs().maxCoeff();
+  if (n < nb_vectors || scale <= 0.0)
+  {
+    return false;
+  }
+
+  // AtA is singular (the solution is its null space): a small shift makes its
+  // factorization well defined without changing the eigen vectors.
+  sMat identity(n, n);
+  identity.setIdentity();
+  const sMat shifted_AtA = AtA + (1e-10 * scale) * identity;
+  const Eigen::SimplicialLDLT<sMat> ldlt(shifted_AtA);
+  if (ldlt.info() != Eigen::Success)
+  {
+    return false;
+  }
+
+  // Random initial block (fixed seed for repeatability)
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::normal_distribution<double> distribution;
+  Mat X(n, block_size);
+  for (Mat::Index i = 0; i < X.size(); ++i)
+  {
+    X.data()[i] = distribution(random_generator);
+  }
+
+  bool b_converged = false;
+  for (int iteration = 0; iteration < max_iteration && !b_converged; ++iteration)
+  {
+    // Inverse iteration & orthonormalization
+    const Eigen::HouseholderQR<Mat> qr(ldlt.solve(X));
+    const Mat Q = qr.householderQ() * Mat::Identity(n, block_size);
+
+    // Rayleigh-Ritz projection
+    const Mat AtAQ = AtA * Q;
+    const Eigen::SelfAdjointEigenSolver<Mat> es(Q.transpose() * AtAQ);
+    if (es.info() != Eigen::Success)
+    {
+      return false;
+    }
+    X = Q * es.eigenvectors(); // sorted by increasing eigen values
+
+    // Convergence: || AtA x - lambda x || of the wanted eigen vectors
+    const Mat residuals =
+      AtAQ * es.eigenvectors().leftCols(nb_vectors)
+      - X.leftCols(nb_vectors) * es.eigenvalues().head(nb_vectors).asDiagonal();
+    b_converged = residuals.colwise().norm().maxCoeff() < 1e-10 * scale;
+  }
+  if (!b_converged)
+  {
+    std::cerr << "Sparse eigen solver: no convergence after "
+      << max_iteration << " iterations." << std::endl;
+    return false;
+  }
+  eigen_vectors = X.leftCols(nb_vectors);
+  return true;
+}
+
 //-- Solve the Global Rotation matrix registration for each camera given a list
 //    of relative orientation using matrix parametrization
-//    [1] formula 6.62 page 100. Dense formulation.
+//    [1] formula 6.62 page 100. Dense or sparse eigen solver.
 //- nCamera:               The number of camera to solve
 //- vec_rotationEstimate:  The relative rotation i->j
 //- vec_ApprRotMatrix:     The output global rotation
@@ -93,7 +177,8 @@ bool L2RotationAveraging
   size_t nCamera,
   const RelativeRotations& vec_relativeRot,
   // Output
-  std::vector<Mat3> & global_rotations
+  std::vector<Mat3> & global_rotations,
+  const EigenSolverType eigen_solver_type
 )
 {
   const size_t nRotationEstimation = vec_relativeRot.size();
@@ -129,7 +214,8 @@ bool L2RotationAveraging
   }
 
   // nCamera * 3 because each columns have 3 elements.
-  Mat AtA(3*nCamera,3*nCamera);
+  // Solve Ax=0 => eigen vectors related to the three smallest eigen values of AtA
+  Mat null_space(3*nCamera, 3);
   {
     sMat A(nRotationEstimation*3, 3*nCamera);
     A.setFromTriplets(tripletList.begin(), tripletList.end());
@@ -137,29 +223,43 @@ bool L2RotationAveraging
     tripletList.shrink_to_fit();
 
     const sMat AtAsparse = A.transpose() * A;
-    AtA = Mat(AtAsparse); // convert to dense
-  }
-
-  // Solve Ax=0 => eigen vectors
-  Eigen::SelfAdjointEigenSolver<Mat> es(AtA, Eigen::ComputeEigenvectors);
 
-  if (es.info() != Eigen::Success)
-  {
-    return false;
-  }
-  // else
-  {
-    // Sort abs(eigenvalues)
-    std::vector<std::pair<double, Vec>> eigs(AtA.cols());
-    for (Mat::Index i = 0; i < AtA.cols(); ++i)
+    const bool b_dense_solver =
+      eigen_solver_type == EigenSolverType::DENSE
+      || (eigen_solver_type == EigenSolverType::AUTO
+          && nCamera <= kDenseEigenSolverMaxCameraCount);
+    if (b_dense_solver)
     {
-      eigs[i] = {es.eigenvalues()[i], es.eigenvectors().col(i)};
+      const Mat AtA(AtAsparse); // convert to dense
+      Eigen::SelfAdjointEigenSolver<Mat> es(AtA, Eigen::ComputeEigenvectors);
+      if (es.info() != Eigen::Success)
+      {
+        return false;
+      }
+      // Sort abs(eigenvalues)
+      std::vector<std::pair<double, Vec>> eigs(AtA.cols());
+      for (Mat::Index i = 0; i < AtA.cols(); ++i)
+      {
+        eigs[i] = {es.eigenvalues()[i], es.eigenvectors().col(i)};
+      }
+      std::stable_sort(eigs.begin(), eigs.end(), &compare_first_abs);
+      for (Mat::Index i = 0; i < 3; ++i)
+      {
+        null_space.col(i) = eigs[i].second;
+      }
     }
-    std::stable_sort(eigs.begin(), eigs.end(), &compare_first_abs);
-
-    const Vec & NullspaceVector0 = eigs[0].second;
-    const Vec & NullspaceVector1 = eigs[1].second;
-    const Vec & NullspaceVector2 = eigs[2].second;
+    else
+    {
+      if (!SparseSmallestEigenVectors(AtAsparse, 3, null_space))
+      {
+        return false;
+      }
+    }
+  }
+  {
+    const auto NullspaceVector0 = null_space.col(0);
+    const auto NullspaceVector1 = null_space.col(1);
+    const auto NullspaceVector2 = null_space.col(2);
 
     //--
     // Search the closest matrix :
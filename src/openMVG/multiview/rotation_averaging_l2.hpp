@@ -35,12 +35,26 @@ namespace l2  {
 //  approximate rotation in the Frobenius norm using SVD
 Mat3 ClosestSVDRotationMatrix(const Mat3 & rotMat);
 
+// Eigen solver used to find the null space of the L2 rotation averaging system
+enum class EigenSolverType
+{
+  AUTO,   // DENSE up to kDenseEigenSolverMaxCameraCount cameras, SPARSE beyond
+  DENSE,  // Full eigen decomposition of the dense 3n x 3n AtA matrix
+  SPARSE  // Three smallest eigen vectors of the sparse AtA matrix (iterative)
+};
+
+// Camera count up to which the AUTO mode uses the dense eigen solver
+static const size_t kDenseEigenSolverMaxCameraCount = 1000;
+
 //-- Solve the Global Rotation matrix registration for each camera given a list
 //    of relative orientation using matrix parametrization
-//    [1] formula 6.62 page 100. Dense formulation.
+//    [1] formula 6.62 page 100.
 //- nCamera:               The number of camera to solve
 //- vec_rotationEstimate:  The relative rotation i->j
 //- vec_ApprRotMatrix:     The output global rotation
+//- eigen_solver_type:     The eigen solver (the dense one is O(n^3) in time
+//                         and O(n^2) in memory, the sparse one only computes
+//                         the three smallest eigen vectors)
 
 // Minimization of the norm of:
 // => || wij * (rj - Rij * ri) ||= 0
@@ -61,7 +75,8 @@ Mat3 ClosestSVDRotationMatrix(const Mat3 & rotMat);
 bool L2RotationAveraging( size_t nCamera,
   const RelativeRotations& vec_relativeRot,
   // Output
-  std::vector<Mat3> & vec_ApprRotMatrix);
+  std::vector<Mat3> & vec_ApprRotMatrix,
+  const EigenSolverType eigen_solver_type = EigenSolverType::AUTO);
 
 // None linear refinement of the rotation using an angle-axis representation
 bool L2RotationAveraging_Refine(
@@ -17,6 +17,7 @@
 #include <iostream>
 #include <iterator>
 #include <numeric>
+#include <random>
 #include <vector>
 
 using namespace openMVG;
@@ -160,6 +161,92 @@ TEST ( rotation_averaging, RefineRotationsL2_CompleteGraph)
   }
 }
 
+// The sparse eigen solver must give the same global rotations as the dense one
+TEST ( rotation_averaging, RotationLeastSquare_SparseEigenSolver)
+{
+  //-- Setup a circular camera rig
+  const int iNviews = 60;
+  const NViewDataSet d = NRealisticCamerasRing(iNviews, 5,
+    nViewDatasetConfigurator(1,1,0,0,5,0)); // Suppose a camera with Unit matrix as K
+
+  //Link each camera to the three next ones
+  RelativeRotations vec_relativeRotEstimate;
+  for (size_t i = 0; i < iNviews; ++i)
+  {
+    for (size_t k = 1; k <= 3; ++k)
+    {
+      const size_t index0 = i;
+      const size_t index1 = (i+k)%iNviews;
+      Mat3 Rrel;
+      Vec3 trel;
+      RelativeCameraMotion(d._R[index0], d._t[index0], d._R[index1], d._t[index1], &Rrel, &trel);
+      vec_relativeRotEstimate.push_back(RelativeRotation(index0, index1, Rrel, 1));
+    }
+  }
+
+  std::vector<Mat3> vec_globalR_dense, vec_globalR_sparse;
+  EXPECT_TRUE(L2RotationAveraging(iNviews, vec_relativeRotEstimate, vec_globalR_dense,
+    EigenSolverType::DENSE));
+  EXPECT_TRUE(L2RotationAveraging(iNviews, vec_relativeRotEstimate, vec_globalR_sparse,
+    EigenSolverType::SPARSE));
+  EXPECT_EQ(iNviews, vec_globalR_sparse.size());
+
+  for (size_t i = 0; i < iNviews; ++i)
+  {
+    EXPECT_NEAR(0.0, FrobeniusDistance(vec_globalR_dense[i], vec_globalR_sparse[i]), 1e-6);
+  }
+
+  // Check that the relative rotations are respected
+  for (const RelativeRotation & relative_rotation : vec_relativeRotEstimate)
+  {
+    const Mat3 Rrel =
+      vec_globalR_sparse[relative_rotation.j] * vec_globalR_sparse[relative_rotation.i].transpose();
+    EXPECT_NEAR(0.0, FrobeniusDistance(relative_rotation.Rij, Rrel), 1e-6);
+  }
+}
+
+// With noisy relative rotations the null space is only approximate:
+// the sparse eigen solver must still converge to the dense solution
+TEST ( rotation_averaging, RotationLeastSquare_SparseEigenSolver_Noisy)
+{
+  const int iNviews = 60;
+  const NViewDataSet d = NRealisticCamerasRing(iNviews, 5,
+    nViewDatasetConfigurator(1,1,0,0,5,0)); // Suppose a camera with Unit matrix as K
+
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::normal_distribution<double> distribution(0.0, D2R(1.0));
+  RelativeRotations vec_relativeRotEstimate;
+  for (size_t i = 0; i < iNviews; ++i)
+  {
+    for (size_t k = 1; k <= 3; ++k)
+    {
+      const size_t index0 = i;
+      const size_t index1 = (i+k)%iNviews;
+      Mat3 Rrel;
+      Vec3 trel;
+      RelativeCameraMotion(d._R[index0], d._t[index0], d._R[index1], d._t[index1], &Rrel, &trel);
+      const Vec3 axis = Vec3::Random().normalized();
+      Rrel = Rrel * Eigen::AngleAxisd(distribution(random_generator), axis).toRotationMatrix();
+      vec_relativeRotEstimate.push_back(RelativeRotation(index0, index1, Rrel, 1));
+    }
+  }
+
+  std::vector<Mat3> vec_globalR_dense, vec_globalR_sparse;
+  EXPECT_TRUE(L2RotationAveraging(iNviews, vec_relativeRotEstimate, vec_globalR_dense,
+    EigenSolverType::DENSE));
+  EXPECT_TRUE(L2RotationAveraging(iNviews, vec_relativeRotEstimate, vec_globalR_sparse,
+    EigenSolverType::SPARSE));
+  EXPECT_EQ(iNviews, vec_globalR_sparse.size());
+
+  // The solutions are defined up to a global rotation
+  const Mat3 R0 = vec_globalR_sparse[0].transpose() * vec_globalR_dense[0];
+  for (size_t i = 0; i < iNviews; ++i)
+  {
+    const Mat3 R = vec_globalR_sparse[i] * R0;
+    EXPECT_NEAR(0.0, FrobeniusDistance(vec_globalR_dense[i], R), 1e-6);
+  }
+}
+
 TEST ( rotation_averaging, RefineRotationsAvgL1IRLS_SimpleTriplet)
 {
   using namespace std;
@@ -377,6 +464,59 @@ TEST ( rotation_averaging, RefineRotationsAvgL1IRLS_CompleteGraph_outliers)
   }
 }
 
+// Warm start the robust rotation averaging from a previous solution
+// (some relative rotations are removed from the problem)
+TEST ( rotation_averaging, RefineRotationsAvgL1IRLS_WarmStart)
+{
+  //-- Setup a circular camera rig
+  const int iNviews = 8;
+  const NViewDataSet d = NRealisticCamerasRing(iNviews, 5,
+    nViewDatasetConfigurator(1,1,0,0,5,0)); // Suppose a camera with Unit matrix as K
+
+  //Link each camera to the three next ones
+  RelativeRotations vec_relativeRotEstimate;
+  for (size_t i = 0; i < iNviews; ++i)
+  {
+    for (size_t k = 1; k <= 3; ++k)
+    {
+      const size_t index0 = i;
+      const size_t index1 = (i+k)%iNviews;
+      Mat3 Rrel;
+      Vec3 trel;
+      RelativeCameraMotion(d._R[index0], d._t[index0], d._R[index1], d._t[index1], &Rrel, &trel);
+      vec_relativeRotEstimate.push_back(RelativeRotation(index0, index1, Rrel, 1));
+    }
+  }
+
+  //- Solve the global rotation estimation problem :
+  Matrix3x3Arr vec_globalR(iNviews);
+  const size_t nMainViewID = 0;
+  EXPECT_TRUE(GlobalRotationsRobust(vec_relativeRotEstimate, vec_globalR, nMainViewID, 0.0f, nullptr));
+
+  //- Remove some relative rotations and start from the previous solution
+  vec_relativeRotEstimate.erase(vec_relativeRotEstimate.begin() + 4);
+  vec_relativeRotEstimate.erase(vec_relativeRotEstimate.begin() + 10);
+  const bool b_use_input_rotations = true;
+  EXPECT_TRUE(GlobalRotationsRobust(vec_relativeRotEstimate, vec_globalR, nMainViewID, 0.0f, nullptr,
+    b_use_input_rotations));
+
+  // Fix the sign of the rotations (put the global rotation in the same rotation axis as GT)
+  if ( SIGN(vec_globalR[0](0,0)) != SIGN( d._R[0](0,0) ))
+  {
+    Mat3 Rrel;
+    Vec3 trel;
+    RelativeCameraMotion(vec_globalR[0], Vec3::Zero(), d._R[0], Vec3::Zero(), &Rrel, &trel);
+    for (size_t i = 0; i < iNviews; ++i)
+      vec_globalR[i] *= Rrel;
+  }
+
+  // Check that each global rotations is near the true ones
+  for (size_t i = 0; i < iNviews; ++i)
+  {
+    EXPECT_NEAR(0.0, FrobeniusDistance(d._R[i], vec_globalR[i]), 1e-8);
+  }
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
@@ -10,7 +10,10 @@
 #define OPENMVG_ROBUST_ESTIMATION_GUIDED_MATCHING_HPP
 
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <limits>
+#include <utility>
 #include <vector>
 
 #include "openMVG/cameras/Camera_Intrinsics.hpp"
@@ -390,6 +393,476 @@ void GuidedMatching_Fundamental_Fast(
   }
 }
 
+/// Return the cell index of a cell coordinate clamped to [0, count-1].
+///  The clamping is done before the cast to int (the cast of a non-finite or
+///  out of range value is undefined), NaN is mapped to the cell 0.
+inline int ClampedCellIndex(const double coordinate, const int count)
+{
+  const double index = std::floor(coordinate);
+  if (!(index > 0.0))
+    return 0;
+  if (index >= count - 1)
+    return count - 1;
+  return static_cast<int>(index);
+}
+
+/// Uniform grid over a 2D point set:
+///  the point indexes are bucketed per cell (cell_offsets_/point_indexes_
+///  compressed arrays), so the points of an image area (a disk, an epipolar
+///  band) are listed without testing all the points.
+class Point_Grid
+{
+public:
+  /// Build a grid over the points bounding box.
+  /// The cell size is chosen to have a few points per cell, but is not
+  /// smaller than min_cell_size (i.e. the search radius).
+  Point_Grid
+  (
+    const std::vector<Vec2> & points,
+    const double min_cell_size
+  )
+  {
+    // Bounding box of the finite points (the other points are not indexed)
+    min_ = Vec2::Constant(std::numeric_limits<double>::max());
+    Vec2 max = Vec2::Constant(std::numeric_limits<double>::lowest());
+    for (const Vec2 & pt : points)
+    {
+      if (!pt.allFinite())
+        continue;
+      min_ = min_.cwiseMin(pt);
+      max = max.cwiseMax(pt);
+    }
+    if (min_(0) > max(0))
+      min_ = max = Vec2::Zero();
+    const Vec2 extent = (max - min_).cwiseMax(Vec2::Constant(1.0));
+    // ~4 points per cell
+    const double points_per_cell = 4.0;
+    cell_size_ = std::max(
+      std::max(min_cell_size, 1.0),
+      std::sqrt(extent(0) * extent(1) * points_per_cell / std::max<size_t>(points.size(), 1)));
+    // Bound the number of cells (for sparse points on a large area)
+    const double max_cells_per_axis = 1024.0;
+    cell_size_ = std::max(cell_size_, extent.maxCoeff() / max_cells_per_axis);
+    cols_ = ClampedCellIndex(extent(0) / cell_size_, static_cast<int>(max_cells_per_axis)) + 1;
+    rows_ = ClampedCellIndex(extent(1) / cell_size_, static_cast<int>(max_cells_per_axis)) + 1;
+
+    // Counting sort of the points per cell
+    const uint32_t kNoCell = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> point_cells(points.size());
+    cell_offsets_.assign(cols_ * rows_ + 1, 0);
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+      if (!points[i].allFinite())
+      {
+        point_cells[i] = kNoCell;
+        continue;
+      }
+      point_cells[i] = Cell(Col(points[i](0)), Row(points[i](1)));
+      ++cell_offsets_[point_cells[i] + 1];
+    }
+    for (size_t i = 1; i < cell_offsets_.size(); ++i)
+      cell_offsets_[i] += cell_offsets_[i - 1];
+    point_indexes_.resize(cell_offsets_.back());
+    std::vector<uint32_t> cell_fill(cell_offsets_.begin(), cell_offsets_.end() - 1);
+    for (size_t i = 0; i < points.size(); ++i)
+      if (point_cells[i] != kNoCell)
+        point_indexes_[cell_fill[point_cells[i]]++] = i;
+  }
+
+  /// Call functor(point_index) for the points of the cells that intersect
+  ///  the disk (center, radius)
+  template <typename Functor>
+  void ForEachInDisk
+  (
+    const Vec2 & center,
+    const double radius,
+    Functor functor
+  ) const
+  {
+    if (!center.allFinite() || !std::isfinite(radius))
+      return;
+    VisitCells(
+      Col(center(0) - radius), Col(center(0) + radius),
+      Row(center(1) - radius), Row(center(1) + radius),
+      functor);
+  }
+
+  /// Call functor(point_index) for the points of the cells that intersect
+  ///  the band {x : |line.(x,1)| / |line.head<2>()| <= half_width}
+  template <typename Functor>
+  void ForEachInBand
+  (
+    const Vec3 & line,
+    const double half_width,
+    Functor functor
+  ) const
+  {
+    const double norm = line.head<2>().norm();
+    if (norm == 0.0 || !line.allFinite() || !std::isfinite(half_width))
+      return;
+    const Vec3 l = line / norm;
+    // Walk along the main direction of the line: per column (resp. row),
+    //  the line spans an interval of rows (resp. columns), extended by the
+    //  band half width along the secondary axis.
+    const bool by_column = std::abs(l(1)) >= std::abs(l(0));
+    const int a = by_column ? 0 : 1; // walk axis
+    const int b = 1 - a;             // secondary axis
+    const int count = by_column ? cols_ : rows_;
+    const double extension = half_width / std::abs(l(b));
+    for (int k = 0; k < count; ++k)
+    {
+      const double u0 = min_(a) + k * cell_size_, u1 = u0 + cell_size_;
+      // Line coordinate along the secondary axis at u0 and u1
+      const double
+        v0 = -(l(a) * u0 + l(2)) / l(b),
+        v1 = -(l(a) * u1 + l(2)) / l(b);
+      const double
+        v_min = std::min(v0, v1) - extension,
+        v_max = std::max(v0, v1) + extension;
+      if (v_max < min_(b) || v_min > min_(b) + (by_column ? rows_ : cols_) * cell_size_)
+        continue;
+      if (by_column)
+        VisitCells(k, k, Row(v_min), Row(v_max), functor);
+      else
+        VisitCells(Col(v_min), Col(v_max), k, k, functor);
+    }
+  }
+
+private:
+
+  int Col(const double x) const
+  {
+    return ClampedCellIndex((x - min_(0)) / cell_size_, cols_);
+  }
+
+  int Row(const double y) const
+  {
+    return ClampedCellIndex((y - min_(1)) / cell_size_, rows_);
+  }
+
+  uint32_t Cell(const int col, const int row) const { return row * cols_ + col; }
+
+  template <typename Functor>
+  void VisitCells
+  (
+    const int col_min, const int col_max,
+    const int row_min, const int row_max,
+    Functor & functor
+  ) const
+  {
+    for (int row = row_min; row <= row_max; ++row)
+    {
+      const uint32_t
+        begin = cell_offsets_[Cell(col_min, row)],
+        end = cell_offsets_[Cell(col_max, row) + 1];
+      for (uint32_t k = begin; k < end; ++k)
+        functor(point_indexes_[k]);
+    }
+  }
+
+  Vec2 min_;
+  double cell_size_;
+  int cols_, rows_;
+  std::vector<uint32_t> cell_offsets_;  // Cell -> [begin, end[ in point_indexes_
+  std::vector<uint32_t> point_indexes_; // Point indexes sorted by cell
+};
+
+/// Uniform grid over a set of bearing vectors (unit vectors):
+///  the [-1,1]^3 cube is split in cells, only the occupied cells (close to
+///  the unit sphere) are stored with their bearing vector indexes.
+class Bearing_Grid
+{
+public:
+  explicit Bearing_Grid
+  (
+    const std::vector<Vec3> & bearings
+  )
+  {
+    // The sphere surface crosses ~ 4.7 * resolution^2 cells: ~16 bearings per cell
+    resolution_ = std::min(std::max(static_cast<int>(
+      std::sqrt(bearings.size() / (16.0 * 4.7))), 1), 64);
+    const double cell_size = 2.0 / resolution_;
+    cell_radius_ = std::sqrt(3.0) * cell_size / 2.0;
+
+    std::vector<std::pair<uint32_t, uint32_t>> cell_bearings(bearings.size());
+    for (size_t i = 0; i < bearings.size(); ++i)
+    {
+      uint32_t cell = 0;
+      for (int k = 2; k >= 0; --k)
+      {
+        const int c = ClampedCellIndex((bearings[i](k) + 1.0) / cell_size, resolution_);
+        cell = cell * resolution_ + c;
+      }
+      cell_bearings[i] = {cell, i};
+    }
+    std::sort(cell_bearings.begin(), cell_bearings.end());
+
+    bearing_indexes_.resize(bearings.size());
+    for (size_t i = 0; i < cell_bearings.size(); ++i)
+    {
+      bearing_indexes_[i] = cell_bearings[i].second;
+      if (i == 0 || cell_bearings[i].first != cell_bearings[i - 1].first)
+      {
+        uint32_t cell = cell_bearings[i].first;
+        Vec3 center;
+        for (int k = 0; k < 3; ++k)
+        {
+          center(k) = -1.0 + ((cell % resolution_) + 0.5) * cell_size;
+          cell /= resolution_;
+        }
+        cell_centers_.push_back(center);
+        cell_offsets_.push_back(i);
+      }
+    }
+    cell_offsets_.push_back(bearings.size());
+  }
+
+  /// Call functor(bearing_index) for the bearings of the cells that intersect
+  ///  the slab {x : |normal.x| <= half_width} (normal is a unit vector),
+  ///  i.e. the band around a great circle of the sphere.
+  template <typename Functor>
+  void ForEachInBand
+  (
+    const Vec3 & normal,
+    const double half_width,
+    Functor functor
+  ) const
+  {
+    for (size_t c = 0; c < cell_centers_.size(); ++c)
+    {
+      if (std::abs(normal.dot(cell_centers_[c])) > half_width + cell_radius_)
+        continue;
+      for (uint32_t k = cell_offsets_[c]; k < cell_offsets_[c + 1]; ++k)
+        functor(bearing_indexes_[k]);
+    }
+  }
+
+private:
+  int resolution_;
+  double cell_radius_;
+  std::vector<Vec3> cell_centers_;        // Occupied cell centers
+  std::vector<uint32_t> cell_offsets_;    // Cell -> [begin, end[ in bearing_indexes_
+  std::vector<uint32_t> bearing_indexes_; // Bearing indexes sorted by cell
+};
+
+/// Return the (optionally un-distorted) region positions
+inline std::vector<Vec2> RegionsPositions
+(
+  const cameras::IntrinsicBase * cam,
+  const features::Regions & regions
+)
+{
+  std::vector<Vec2> positions(regions.RegionCount());
+  for (size_t i = 0; i < regions.RegionCount(); ++i)
+  {
+    positions[i] = cam ? cam->get_ud_pixel(regions.GetRegionPosition(i)) : regions.GetRegionPosition(i);
+  }
+  return positions;
+}
+
+/// Guided Matching (features only) for a homography:
+///  Same result as GuidedMatching, but the right points are indexed in a grid
+///  and only the right points around the left point transfer (H.x) are tested.
+/// ErrorArg must be the transfer error in the right image (i.e.
+///  homography::kernel::AsymmetricError): a candidate is at most sqrt(errorTh)
+///  away from the transferred point.
+template<
+  typename ErrorArg> // The metric to compute distance to the model
+void GuidedMatching_Homography_Grid(
+  const Mat3 & H,       // The homography
+  const Mat & xLeft,    // The left data points
+  const Mat & xRight,   // The right data points
+  double errorTh,       // Maximal authorized error threshold (square threshold)
+  matching::IndMatches & vec_corresponding_index) // Ouput corresponding index
+{
+  assert(xLeft.rows() == 2 && xRight.rows() == 2);
+
+  std::vector<Vec2> rPoints(xRight.cols());
+  for (Mat::Index j = 0; j < xRight.cols(); ++j)
+    rPoints[j] = xRight.col(j);
+  const double radius = std::sqrt(errorTh);
+  const Point_Grid grid(rPoints, radius);
+
+  for (Mat::Index i = 0; i < xLeft.cols(); ++i)
+  {
+    const Vec2 xL = xLeft.col(i);
+    double min = std::numeric_limits<double>::max();
+    matching::IndMatch match;
+    grid.ForEachInDisk(Vec3(H * xL.homogeneous()).hnormalized(), radius,
+      [&](const uint32_t j)
+      {
+        // Compute the geometric error: error to the model
+        const double err = ErrorArg::Error(H, xL, rPoints[j]);
+        // if smaller error update corresponding index
+        if (err < errorTh && (err < min || (err == min && j < match.j_)))
+        {
+          min = err;
+          match = matching::IndMatch(i, j);
+        }
+      });
+    if (min < errorTh)
+    {
+      // save the best corresponding index
+      vec_corresponding_index.push_back(match);
+    }
+  }
+
+  // Remove duplicates (when multiple points at same position exist)
+  matching::IndMatch::getDeduplicated(vec_corresponding_index);
+}
+
+/// Guided Matching (features + descriptors with distance ratio) for a homography:
+///  Same result as GuidedMatching, but the right regions are indexed in a grid
+///  and the descriptors are compared only for the right regions around the
+///  left region transfer (H.x).
+/// ErrorArg must be the transfer error in the right image (i.e.
+///  homography::kernel::AsymmetricError).
+template<
+  typename ErrorArg> // The metric to compute distance to the model
+void GuidedMatching_Homography_Grid(
+  const Mat3 & H,       // The homography
+  const cameras::IntrinsicBase * camL, // Optional camera (in order to undistord on the fly feature positions, can be nullptr)
+  const features::Regions & lRegions,  // regions (point features & corresponding descriptors)
+  const cameras::IntrinsicBase * camR, // Optional camera (in order to undistord on the fly feature positions, can be nullptr)
+  const features::Regions & rRegions,  // regions (point features & corresponding descriptors)
+  double errorTh,       // Maximal authorized error threshold (square threshold)
+  double distRatio,     // Maximal authorized distance ratio
+  matching::IndMatches & vec_corresponding_index) // Ouput corresponding index
+{
+  const std::vector<Vec2>
+    lRegionsPos = RegionsPositions(camL, lRegions),
+    rRegionsPos = RegionsPositions(camR, rRegions);
+  const double radius = std::sqrt(errorTh);
+  const Point_Grid grid(rRegionsPos, radius);
+
+  for (size_t i = 0; i < lRegionsPos.size(); ++i)
+  {
+    distanceRatio<double> dR;
+    grid.ForEachInDisk(Vec3(H * lRegionsPos[i].homogeneous()).hnormalized(), radius,
+      [&](const uint32_t j)
+      {
+        if (ErrorArg::Error(H, lRegionsPos[i], rRegionsPos[j]) < errorTh)
+          dR.update(j, lRegions.SquaredDescriptorDistance(i, &rRegions, j));
+      });
+    // Add correspondence only iff the distance ratio is valid
+    if (dR.isValid(distRatio))
+    {
+      // save the best corresponding index
+      vec_corresponding_index.push_back(matching::IndMatch(i, dR.idx));
+    }
+  }
+
+  // Remove duplicates (when multiple points at same position exist)
+  matching::IndMatch::getDeduplicated(vec_corresponding_index);
+}
+
+/// Guided Matching (features + descriptors with distance ratio) for a
+///  fundamental matrix:
+///  Same result as GuidedMatching, but the right regions are indexed in a grid
+///  and the descriptors are compared only for the right regions of the grid
+///  cells crossed by the epipolar band (F.x line, sqrt(errorTh) half width).
+/// ErrorArg must be the distance to the epipolar line in the right image
+///  (i.e. fundamental::kernel::EpipolarDistanceError).
+template<
+  typename ErrorArg> // The metric to compute distance to the model
+void GuidedMatching_Fundamental_Grid(
+  const Mat3 & F,       // The fundamental matrix
+  const cameras::IntrinsicBase * camL, // Optional camera (in order to undistord on the fly feature positions, can be nullptr)
+  const features::Regions & lRegions,  // regions (point features & corresponding descriptors)
+  const cameras::IntrinsicBase * camR, // Optional camera (in order to undistord on the fly feature positions, can be nullptr)
+  const features::Regions & rRegions,  // regions (point features & corresponding descriptors)
+  double errorTh,       // Maximal authorized error threshold (square threshold)
+  double distRatio,     // Maximal authorized distance ratio
+  matching::IndMatches & vec_corresponding_index) // Ouput corresponding index
+{
+  const std::vector<Vec2>
+    lRegionsPos = RegionsPositions(camL, lRegions),
+    rRegionsPos = RegionsPositions(camR, rRegions);
+  const double half_width = std::sqrt(errorTh);
+  const Point_Grid grid(rRegionsPos, half_width);
+
+  for (size_t i = 0; i < lRegionsPos.size(); ++i)
+  {
+    distanceRatio<double> dR;
+    grid.ForEachInBand(F * lRegionsPos[i].homogeneous(), half_width,
+      [&](const uint32_t j)
+      {
+        if (ErrorArg::Error(F, lRegionsPos[i], rRegionsPos[j]) < errorTh)
+          dR.update(j, lRegions.SquaredDescriptorDistance(i, &rRegions, j));
+      });
+    // Add correspondence only iff the distance ratio is valid
+    if (dR.isValid(distRatio))
+    {
+      // save the best corresponding index
+      vec_corresponding_index.push_back(matching::IndMatch(i, dR.idx));
+    }
+  }
+
+  // Remove duplicates (when multiple points at same position exist)
+  matching::IndMatch::getDeduplicated(vec_corresponding_index);
+}
+
+/// Guided Matching (features + descriptors with distance ratio) for an
+///  essential matrix with an angular error (i.e. spherical cameras):
+///  The right bearing vectors are indexed in a grid and the descriptors are
+///  compared only for the right regions close to the epipolar great circle
+///  (E.x normal) with an angular error (|asin(x'.E.x / |E.x|)|) below angularTh.
+inline void GuidedMatching_Essential_Angular_Grid(
+  const Mat3 & E,       // The essential matrix
+  const cameras::IntrinsicBase * camL, // Left camera (to compute the bearing vectors)
+  const features::Regions & lRegions,  // regions (point features & corresponding descriptors)
+  const cameras::IntrinsicBase * camR, // Right camera (to compute the bearing vectors)
+  const features::Regions & rRegions,  // regions (point features & corresponding descriptors)
+  double angularTh,     // Maximal authorized angular error (radian)
+  double distRatio,     // Maximal authorized distance ratio
+  matching::IndMatches & vec_corresponding_index) // Ouput corresponding index
+{
+  // Compute the bearing vectors
+  const auto bearings = [](
+    const cameras::IntrinsicBase * cam,
+    const features::Regions & regions)
+  {
+    const std::vector<Vec2> positions = RegionsPositions(cam, regions);
+    const Mat3X rays = (*cam)(Eigen::Map<const Mat2X>(positions[0].data(), 2, positions.size()));
+    std::vector<Vec3> vec_bearings(positions.size());
+    for (size_t i = 0; i < positions.size(); ++i)
+      vec_bearings[i] = rays.col(i).normalized();
+    return vec_bearings;
+  };
+  if (lRegions.RegionCount() == 0 || rRegions.RegionCount() == 0)
+    return;
+  const std::vector<Vec3>
+    lBearings = bearings(camL, lRegions),
+    rBearings = bearings(camR, rRegions);
+
+  const double half_width = std::sin(std::min(angularTh, M_PI / 2.0));
+  const Bearing_Grid grid(rBearings);
+
+  for (size_t i = 0; i < lBearings.size(); ++i)
+  {
+    const Vec3 normal = E * lBearings[i];
+    if (normal.squaredNorm() == 0.0)
+      continue;
+    const Vec3 n = normal.normalized();
+    distanceRatio<double> dR;
+    grid.ForEachInBand(n, half_width,
+      [&](const uint32_t j)
+      {
+        if (std::abs(n.dot(rBearings[j])) < half_width)
+          dR.update(j, lRegions.SquaredDescriptorDistance(i, &rRegions, j));
+      });
+    // Add correspondence only iff the distance ratio is valid
+    if (dR.isValid(distRatio))
+    {
+      // save the best corresponding index
+      vec_corresponding_index.push_back(matching::IndMatch(i, dR.idx));
+    }
+  }
+
+  // Remove duplicates (when multiple points at same position exist)
+  matching::IndMatch::getDeduplicated(vec_corresponding_index);
+}
+
 } // namespace geometry_aware
 } // namespace openMVG
 
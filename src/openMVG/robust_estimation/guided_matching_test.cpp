@@ -0,0 +1,231 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/cameras/Camera_Spherical.hpp"
+#include "openMVG/features/regions_factory.hpp"
+#include "openMVG/multiview/solver_fundamental_kernel.hpp"
+#include "openMVG/multiview/solver_homography_kernel.hpp"
+#include "openMVG/robust_estimation/guided_matching.hpp"
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+
+using namespace openMVG;
+using namespace openMVG::features;
+using namespace openMVG::geometry_aware;
+
+// Random descriptors, the descriptors of the pairs (i, i) are close
+void MakeDescriptors
+(
+  const int nb_regions,
+  SIFT_Regions & regionsL,
+  SIFT_Regions & regionsR,
+  std::mt19937 & random_generator
+)
+{
+  std::uniform_int_distribution<int> distribution(0, 255);
+  regionsL.Descriptors().resize(nb_regions);
+  regionsR.Descriptors().resize(nb_regions);
+  for (int i = 0; i < nb_regions; ++i)
+  {
+    for (int k = 0; k < 128; ++k)
+    {
+      regionsL.Descriptors()[i][k] = distribution(random_generator);
+      regionsR.Descriptors()[i][k] = (k % 16 == 0) ?
+        distribution(random_generator) : regionsL.Descriptors()[i][k];
+    }
+  }
+}
+
+// Bearing vector of an image point
+Vec3 Bearing(const cameras::IntrinsicBase & camera, const Vec2 & x)
+{
+  return camera(Mat2X(x)).col(0).normalized();
+}
+
+matching::IndMatches Sorted(matching::IndMatches matches)
+{
+  std::sort(matches.begin(), matches.end());
+  return matches;
+}
+
+TEST(GuidedMatching_Grid, Homography) {
+
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::uniform_real_distribution<double> distribution(0.0, 1000.0);
+  std::normal_distribution<double> noise(0.0, 1.0);
+
+  Mat3 H;
+  H << 1.1, 0.05, 20.0,
+       -0.03, 0.95, -15.0,
+       1e-5, 2e-5, 1.0;
+
+  // The first half of the right points are the transfer of the left points
+  const int nb_regions = 2000;
+  SIFT_Regions regionsL, regionsR;
+  Mat xL(2, nb_regions), xR(2, nb_regions);
+  for (int i = 0; i < nb_regions; ++i)
+  {
+    xL.col(i) = Vec2(distribution(random_generator), distribution(random_generator));
+    xR.col(i) = (i < nb_regions / 2) ?
+      Vec2(Vec3(H * xL.col(i).homogeneous()).hnormalized() + Vec2(noise(random_generator), noise(random_generator)))
+      : Vec2(distribution(random_generator), distribution(random_generator));
+    regionsL.Features().emplace_back(xL(0, i), xL(1, i));
+    regionsR.Features().emplace_back(xR(0, i), xR(1, i));
+  }
+  MakeDescriptors(nb_regions, regionsL, regionsR, random_generator);
+
+  const double errorTh = Square(4.0);
+  {
+    // Features only
+    matching::IndMatches matches, matches_grid;
+    GuidedMatching<Mat3, homography::kernel::AsymmetricError>(H, xL, xR, errorTh, matches);
+    GuidedMatching_Homography_Grid<homography::kernel::AsymmetricError>(H, xL, xR, errorTh, matches_grid);
+    EXPECT_TRUE(matches.size() >= nb_regions / 2);
+    EXPECT_TRUE(Sorted(matches) == Sorted(matches_grid));
+  }
+  {
+    // Features & descriptors
+    matching::IndMatches matches, matches_grid;
+    GuidedMatching<Mat3, homography::kernel::AsymmetricError>(
+      H, nullptr, regionsL, nullptr, regionsR, errorTh, Square(0.8), matches);
+    GuidedMatching_Homography_Grid<homography::kernel::AsymmetricError>(
+      H, nullptr, regionsL, nullptr, regionsR, errorTh, Square(0.8), matches_grid);
+    EXPECT_TRUE(!matches.empty());
+    EXPECT_TRUE(Sorted(matches) == Sorted(matches_grid));
+  }
+}
+
+TEST(Point_Grid, NonFinite) {
+  const double inf = std::numeric_limits<double>::infinity();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const std::vector<Vec2> points = {
+    Vec2(0.0, 0.0), Vec2(10.0, 10.0), Vec2(nan, 5.0), Vec2(inf, -inf), Vec2(1e300, -1e300)};
+  const Point_Grid grid(points, 4.0);
+
+  // The non-finite points are not indexed
+  std::vector<uint32_t> visited;
+  const auto visit = [&](const uint32_t i) { visited.push_back(i); };
+  grid.ForEachInDisk(Vec2(5.0, 5.0), 1e9, visit);
+  EXPECT_TRUE(std::find(visited.begin(), visited.end(), 2) == visited.end());
+  EXPECT_TRUE(std::find(visited.begin(), visited.end(), 3) == visited.end());
+  EXPECT_TRUE(std::find(visited.begin(), visited.end(), 4) != visited.end());
+
+  // The non-finite queries visit nothing, the far queries are clamped
+  visited.clear();
+  grid.ForEachInDisk(Vec2(nan, 0.0), 1.0, visit);
+  grid.ForEachInDisk(Vec2(0.0, 0.0), inf, visit);
+  grid.ForEachInBand(Vec3(1.0, nan, 0.0), 1.0, visit);
+  EXPECT_EQ(0, visited.size());
+  grid.ForEachInDisk(Vec2(-1e200, -1e200), 1.0, visit);
+  grid.ForEachInBand(Vec3(1.0, 1e-300, 1e300), 1.0, visit);
+}
+
+TEST(GuidedMatching_Grid, Fundamental) {
+
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::uniform_real_distribution<double> distribution(0.0, 1000.0);
+
+  // F = K^-T [t]x R K^-1
+  Mat3 K;
+  K << 800, 0, 500,
+       0, 800, 500,
+       0, 0, 1;
+  const Mat3 R = RotationAroundY(0.1) * RotationAroundX(0.05);
+  const Vec3 t(1.0, 0.2, 0.1);
+  const Mat3 F = K.inverse().transpose() * CrossProductMatrix(t) * R * K.inverse();
+
+  // The first half of the right points are on the epipolar line of the left points
+  const int nb_regions = 2000;
+  SIFT_Regions regionsL, regionsR;
+  for (int i = 0; i < nb_regions; ++i)
+  {
+    const Vec2 xL(distribution(random_generator), distribution(random_generator));
+    Vec2 xR(distribution(random_generator), distribution(random_generator));
+    if (i < nb_regions / 2)
+    {
+      // Move xR on the epipolar line
+      const Vec3 line = F * xL.homogeneous();
+      const Vec2 n = line.head<2>() / line.head<2>().norm();
+      xR -= n * (line.dot(xR.homogeneous()) / line.head<2>().norm());
+    }
+    regionsL.Features().emplace_back(xL(0), xL(1));
+    regionsR.Features().emplace_back(xR(0), xR(1));
+  }
+  MakeDescriptors(nb_regions, regionsL, regionsR, random_generator);
+
+  for (const double error : {1.0, 4.0, 16.0})
+  {
+    matching::IndMatches matches, matches_grid;
+    GuidedMatching<Mat3, fundamental::kernel::EpipolarDistanceError>(
+      F, nullptr, regionsL, nullptr, regionsR, Square(error), Square(0.8), matches);
+    GuidedMatching_Fundamental_Grid<fundamental::kernel::EpipolarDistanceError>(
+      F, nullptr, regionsL, nullptr, regionsR, Square(error), Square(0.8), matches_grid);
+    EXPECT_TRUE(!matches.empty());
+    EXPECT_TRUE(Sorted(matches) == Sorted(matches_grid));
+  }
+}
+
+TEST(GuidedMatching_Grid, Essential_Angular) {
+
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::uniform_real_distribution<double> distribution(0.0, 1.0);
+
+  const cameras::Intrinsic_Spherical camera(2000, 1000);
+  const Mat3 R = RotationAroundZ(0.2);
+  const Vec3 t(1.0, 0.5, 0.0);
+  const Mat3 E = CrossProductMatrix(t) * R;
+
+  // The first half of the right bearings are on the epipolar great circle
+  const int nb_regions = 2000;
+  SIFT_Regions regionsL, regionsR;
+  for (int i = 0; i < nb_regions; ++i)
+  {
+    const Vec2 xL(distribution(random_generator) * 2000, distribution(random_generator) * 1000);
+    Vec2 xR(distribution(random_generator) * 2000, distribution(random_generator) * 1000);
+    if (i < nb_regions / 2)
+    {
+      // Project the right bearing on the epipolar plane
+      const Vec3 n = (E * Bearing(camera, xL)).normalized();
+      const Vec3 bR = Bearing(camera, xR);
+      xR = camera.project(bR - n * n.dot(bR));
+    }
+    regionsL.Features().emplace_back(xL(0), xL(1));
+    regionsR.Features().emplace_back(xR(0), xR(1));
+  }
+  MakeDescriptors(nb_regions, regionsL, regionsR, random_generator);
+
+  const double angularTh = D2R(0.5);
+  matching::IndMatches matches_grid;
+  GuidedMatching_Essential_Angular_Grid(
+    E, &camera, regionsL, &camera, regionsR, angularTh, Square(0.8), matches_grid);
+
+  // Exhaustive search
+  matching::IndMatches matches;
+  for (int i = 0; i < nb_regions; ++i)
+  {
+    const Vec3 n = (E * Bearing(camera, regionsL.GetRegionPosition(i))).normalized();
+    distanceRatio<double> dR;
+    for (int j = 0; j < nb_regions; ++j)
+    {
+      if (std::abs(std::asin(n.dot(Bearing(camera, regionsR.GetRegionPosition(j))))) < angularTh)
+        dR.update(j, regionsL.SquaredDescriptorDistance(i, &regionsR, j));
+    }
+    if (dR.isValid(Square(0.8)))
+      matches.emplace_back(i, dR.idx);
+  }
+  EXPECT_TRUE(matches.size() >= nb_regions / 4);
+  EXPECT_TRUE(Sorted(matches) == Sorted(matches_grid));
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
@@ -318,6 +318,7 @@ NFA_Interface<Kernel>::ComputeNFA_and_inliers
  * @param[out] model returned model if found
  * @param[in] precision upper bound of the precision (squared error)
  * @param[in] bVerbose display console log
+ * @param[out] performed_iteration_count (optional) number of performed iterations
  *
  * @return (errorMax, minNFA)
  */
@@ -329,10 +330,13 @@ std::pair<double, double> ACRANSAC
   const unsigned int num_max_iteration = 1024,
   typename Kernel::Model * model = nullptr,
   double precision = std::numeric_limits<double>::infinity(),
-  bool bVerbose = false
+  bool bVerbose = false,
+  unsigned int * performed_iteration_count = nullptr
 )
 {
   vec_inliers.clear();
+  if (performed_iteration_count)
+    *performed_iteration_count = 0;
 
   const unsigned int sizeSample = Kernel::MINIMUM_SAMPLES;
   const unsigned int nData = kernel.NumSamples();
@@ -381,6 +385,9 @@ std::pair<double, double> ACRANSAC
   // Main estimation loop.
   for (unsigned int iter = 0; iter < nIter && iter < num_max_iteration; ++iter)
   {
+    if (performed_iteration_count)
+      *performed_iteration_count = iter + 1;
+
     // Get random samples
     if (bACRansacMode)
       UniformSample(sizeSample, random_generator, &vec_index, &vec_sample);
@@ -45,13 +45,10 @@ bool GlobalSfM_Rotation_AveragingSolver::Run(
       //-------------------
       // Triplet inference (test over the composition error)
       //-------------------
-      Pair_Set pairs = getPairs(relativeRotations);
-      std::vector<graph::Triplet> vec_triplets = graph::TripletListing(pairs);
-
       //-- Rejection triplet that are 'not' identity rotation (error to identity > 5°)
-      TripletRotationRejection(5.0f, vec_triplets, relativeRotations);
+      TripletRotationRejection(5.0f, relativeRotations);
 
-      pairs = getPairs(relativeRotations);
+      Pair_Set pairs = getPairs(relativeRotations);
       const std::set<IndexT> set_remainingIds = graph::CleanGraph_KeepLargestBiEdge_Nodes<Pair_Set, IndexT>(pairs);
       if (set_remainingIds.empty())
         return false;
@@ -156,7 +153,6 @@ bool GlobalSfM_Rotation_AveragingSolver::Run(
 ///  angular error once rotation composition have been computed.
 void GlobalSfM_Rotation_AveragingSolver::TripletRotationRejection(
   const double max_angular_error,
-  std::vector<graph::Triplet> & vec_triplets,
   RelativeRotations & relativeRotations) const
 {
   const size_t edges_start_count = relativeRotations.size();
@@ -168,52 +164,71 @@ void GlobalSfM_Rotation_AveragingSolver::TripletRotationRejection(
   // ROTATION OUTLIERS DETECTION
   //--
 
-  std::vector<graph::Triplet> vec_triplets_validated;
-  vec_triplets_validated.reserve(vec_triplets.size());
+  // The triplets are streamed from the forward adjacency of the view graph
+  // (they are not stored, only their composition error is kept)
+  const graph::Forward_Adjacency adjacency(getPairs(relativeRotations));
 
+  size_t triplet_count = 0, triplet_validated_count = 0;
   std::vector<float> vec_errToIdentityPerTriplet;
-  vec_errToIdentityPerTriplet.reserve(vec_triplets.size());
-  // Compute the composition error for each length 3 cycles
-  for (size_t i = 0; i < vec_triplets.size(); ++i)
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel
+#endif
   {
-    const graph::Triplet & triplet = vec_triplets[i];
-    const IndexT I = triplet.i, J = triplet.j , K = triplet.k;
+    // Thread local results
+    std::vector<float> errToIdentityPerTriplet;
+    std::vector<Pair> validated_pairs;
+    size_t validated_count = 0;
 
-    //-- Find the three relative rotations
-    const Pair ij(I,J), ji(J,I);
-    const Mat3 RIJ = (map_relatives.count(ij)) ?
-      map_relatives.at(ij).Rij : Mat3(map_relatives.at(ji).Rij.transpose());
+    // Compute the composition error for each length 3 cycles
+    auto triplet_rejection = [&](const graph::Triplet & triplet)
+    {
+      const IndexT I = triplet.i, J = triplet.j , K = triplet.k;
 
-    const Pair jk(J,K), kj(K,J);
-    const Mat3 RJK = (map_relatives.count(jk)) ?
-      map_relatives.at(jk).Rij : Mat3(map_relatives.at(kj).Rij.transpose());
+      //-- Find the three relative rotations
+      const Pair ij(I,J), ji(J,I);
+      const bool b_ij = map_relatives.count(ij) != 0;
+      const Mat3 RIJ = b_ij ?
+        map_relatives.at(ij).Rij : Mat3(map_relatives.at(ji).Rij.transpose());
 
-    const Pair ki(K,I), ik(I,K);
-    const Mat3 RKI = (map_relatives.count(ki)) ?
-      map_relatives.at(ki).Rij : Mat3(map_relatives.at(ik).Rij.transpose());
+      const Pair jk(J,K), kj(K,J);
+      const bool b_jk = map_relatives.count(jk) != 0;
+      const Mat3 RJK = b_jk ?
+        map_relatives.at(jk).Rij : Mat3(map_relatives.at(kj).Rij.transpose());
 
-    const Mat3 Rot_To_Identity = RIJ * RJK * RKI; // motion composition
-    const float angularErrorDegree = static_cast<float>(R2D(getRotationMagnitude(Rot_To_Identity)));
-    vec_errToIdentityPerTriplet.push_back(angularErrorDegree);
+      const Pair ki(K,I), ik(I,K);
+      const bool b_ki = map_relatives.count(ki) != 0;
+      const Mat3 RKI = b_ki ?
+        map_relatives.at(ki).Rij : Mat3(map_relatives.at(ik).Rij.transpose());
 
-    if (angularErrorDegree < max_angular_error)
+      const Mat3 Rot_To_Identity = RIJ * RJK * RKI; // motion composition
+      const float angularErrorDegree = static_cast<float>(R2D(getRotationMagnitude(Rot_To_Identity)));
+      errToIdentityPerTriplet.push_back(angularErrorDegree);
+
+      if (angularErrorDegree < max_angular_error)
+      {
+        ++validated_count;
+        validated_pairs.push_back(b_ij ? ij : ji);
+        validated_pairs.push_back(b_jk ? jk : kj);
+        validated_pairs.push_back(b_ki ? ki : ik);
+      }
+    };
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp for schedule(dynamic, 64) nowait
+#endif
+    for (int rank = 0; rank < static_cast<int>(adjacency.NodeCount()); ++rank)
     {
-      vec_triplets_validated.push_back(triplet);
-
-      if (map_relatives.count(ij))
-        map_relatives_validated[ij] = map_relatives.at(ij);
-      else
-        map_relatives_validated[ji] = map_relatives.at(ji);
-
-      if (map_relatives.count(jk))
-        map_relatives_validated[jk] = map_relatives.at(jk);
-      else
-        map_relatives_validated[kj] = map_relatives.at(kj);
-
-      if (map_relatives.count(ki))
-        map_relatives_validated[ki] = map_relatives.at(ki);
-      else
-        map_relatives_validated[ik] = map_relatives.at(ik);
+      adjacency.ListNodeTriplets(static_cast<IndexT>(rank), triplet_rejection);
+    }
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp critical
+#endif
+    {
+      triplet_count += errToIdentityPerTriplet.size();
+      triplet_validated_count += validated_count;
+      vec_errToIdentityPerTriplet.insert(vec_errToIdentityPerTriplet.end(),
+        errToIdentityPerTriplet.cbegin(), errToIdentityPerTriplet.cend());
+      for (const Pair & pair : validated_pairs)
+        map_relatives_validated[pair] = map_relatives.at(pair);
     }
   }
   map_relatives = std::move(map_relatives_validated);
@@ -225,11 +240,12 @@ void GlobalSfM_Rotation_AveragingSolver::TripletRotationRejection(
   std::transform(map_relatives.cbegin(), map_relatives.cend(), std::inserter(used_pairs, used_pairs.begin()), stl::RetrieveKey());
 
   // Display statistics about rotation triplets error:
+  // (sorted first, the statistics do not depend on the thread scheduling)
+  std::sort(vec_errToIdentityPerTriplet.begin(), vec_errToIdentityPerTriplet.end());
+
   std::cout << "\nStatistics about rotation triplets:" << std::endl;
   minMaxMeanMedian<float>(vec_errToIdentityPerTriplet.cbegin(), vec_errToIdentityPerTriplet.cend());
 
-  std::sort(vec_errToIdentityPerTriplet.begin(), vec_errToIdentityPerTriplet.end());
-
   if (!vec_errToIdentityPerTriplet.empty())
   {
     Histogram<float> histo(0.0f, *max_element(vec_errToIdentityPerTriplet.cbegin(), vec_errToIdentityPerTriplet.cend()), 20);
@@ -239,12 +255,10 @@ void GlobalSfM_Rotation_AveragingSolver::TripletRotationRejection(
 
   {
     std::cout << "\nTriplets filtering based on composition error on unit cycles\n";
-    std::cout << "#Triplets before: " << vec_triplets.size() << "\n"
-    << "#Triplets after: " << vec_triplets_validated.size() << std::endl;
+    std::cout << "#Triplets before: " << triplet_count << "\n"
+    << "#Triplets after: " << triplet_validated_count << std::endl;
   }
 
-  vec_triplets = std::move(vec_triplets_validated);
-
   const size_t edges_end_count = relativeRotations.size();
   std::cout << "\n #Edges removed by triplet inference: " << edges_start_count - edges_end_count << std::endl;
 }
@@ -29,7 +29,6 @@ enum ERelativeRotationInferenceMethod
 } // namespace sfm
 } // namespace openMVG
 
-namespace openMVG { namespace graph { struct Triplet; } }
 #include "openMVG/types.hpp"
 #include "openMVG/multiview/rotation_averaging_common.hpp"
 
@@ -53,7 +52,6 @@ public:
   ///  angular error once rotation composition have been computed.
   void TripletRotationRejection(
     const double max_angular_error,
-    std::vector<graph::Triplet> & vec_triplets,
     rotation_averaging::RelativeRotations & relativeRotations) const;
 
   /// Return the pairs validated by the GlobalRotation routine (inference can remove some)
@@ -21,8 +21,8 @@
 #include "openMVG/multiview/translation_averaging_common.hpp"
 #include "openMVG/multiview/translation_averaging_solver.hpp"
 #include "openMVG/robust_estimation/robust_estimator_ACRansac.hpp"
-#include "openMVG/sfm/pipelines/global/mutexSet.hpp"
 #include "openMVG/sfm/pipelines/global/sfm_global_reindex.hpp"
+#include "openMVG/sfm/pipelines/global/tripletEdgeCoverage.hpp"
 #include "openMVG/sfm/pipelines/global/triplet_t_ACRansac_kernelAdaptator.hpp"
 #include "openMVG/sfm/pipelines/sfm_features_provider.hpp"
 #include "openMVG/sfm/pipelines/sfm_matches_provider.hpp"
@@ -31,6 +31,8 @@
 #include "openMVG/stl/stl.hpp"
 #include "openMVG/system/timer.hpp"
 
+#include <array>
+#include <atomic>
 #include <vector>
 
 namespace openMVG{
@@ -341,9 +343,10 @@ void GlobalSfM_Translation_AveragingSolver::ComputePutativeTranslation_EdgesCove
   std::transform(map_globalR.cbegin(), map_globalR.cend(),
     std::inserter(set_pose_ids, set_pose_ids.begin()), stl::RetrieveKey());
   // List shared correspondences (pairs) between poses
-  for (const auto & match_iterator : matches_provider->pairWise_matches_)
+  // and the view pairs of every pose pair (ordered pose ids)
+  Hash_Map<Pair, Pair_Set> posewise_view_pairs;
+  for (const Pair & pair : matches_provider->getPairs())
   {
-    const Pair pair = match_iterator.first;
     const View * v1 = sfm_data.GetViews().at(pair.first).get();
     const View * v2 = sfm_data.GetViews().at(pair.second).get();
 
@@ -353,9 +356,13 @@ void GlobalSfM_Translation_AveragingSolver::ComputePutativeTranslation_EdgesCove
         && set_pose_ids.count(v2->id_pose))
     {
       rotation_pose_id_graph.insert({v1->id_pose, v2->id_pose});
+      posewise_view_pairs[{std::min(v1->id_pose, v2->id_pose),
+                           std::max(v1->id_pose, v2->id_pose)}].insert(pair);
     }
   }
   // List putative triplets (from global rotations Ids)
+  // The triplets are stored, not streamed (graph::ForEachTriplet): the edge
+  // coverage refers to them by index (triplet ids per edge, covered triplets).
   const std::vector<graph::Triplet> vec_triplets =
     graph::TripletListing(rotation_pose_id_graph);
   std::cout << "#Triplets: " << vec_triplets.size() << std::endl;
@@ -378,9 +385,8 @@ void GlobalSfM_Translation_AveragingSolver::ComputePutativeTranslation_EdgesCove
 
     //-- precompute the visibility count per triplets (sum of their 2 view matches)
     Hash_Map<IndexT, IndexT> map_tracksPerTriplets;
-    for (const auto & match_iterator : matches_provider->pairWise_matches_)
+    for (const Pair & pair : matches_provider->getPairs())
     {
-      const Pair pair = match_iterator.first;
       const View * v1 = sfm_data.GetViews().at(pair.first).get();
       const View * v2 = sfm_data.GetViews().at(pair.second).get();
       if (v1->id_pose != v2->id_pose)
@@ -393,9 +399,9 @@ void GlobalSfM_Translation_AveragingSolver::ComputePutativeTranslation_EdgesCove
           for (const auto & triplet_id : edge_tripletIds)
           {
             if (map_tracksPerTriplets.count(triplet_id) == 0)
-              map_tracksPerTriplets[triplet_id] = match_iterator.second.size();
+              map_tracksPerTriplets[triplet_id] = matches_provider->getMatchCount(pair);
             else
-              map_tracksPerTriplets[triplet_id] += match_iterator.second.size();
+              map_tracksPerTriplets[triplet_id] += matches_provider->getMatchCount(pair);
           }
         }
       }
@@ -407,7 +413,23 @@ void GlobalSfM_Translation_AveragingSolver::ComputePutativeTranslation_EdgesCove
                    std::back_inserter(vec_edges),
                    stl::RetrieveKey());
 
-    openMVG::sfm::MutexSet<myEdge> m_mutexSet;
+    // Dense edge ids & the edge ids of every triplet
+    Hash_Map<myEdge, uint32_t> map_edge_ids;
+    for (uint32_t edge_id = 0; edge_id < vec_edges.size(); ++edge_id)
+      map_edge_ids[vec_edges[edge_id]] = edge_id;
+    std::vector<Triplet_Edge_Coverage::Triplet_Edges> vec_triplet_edges(vec_triplets.size());
+    for (size_t i = 0; i < vec_triplets.size(); ++i)
+    {
+      const graph::Triplet & triplet = vec_triplets[i];
+      vec_triplet_edges[i] = {{
+        map_edge_ids.at({triplet.i, triplet.j}),
+        map_edge_ids.at({triplet.i, triplet.k}),
+        map_edge_ids.at({triplet.j, triplet.k})}};
+    }
+    Triplet_Edge_Coverage edge_coverage(vec_edges.size(), vec_triplet_edges);
+    std::atomic<uint32_t>
+      triplet_estimation_count(0), // successful first claims (a triplet is estimated once)
+      triplet_failure_count(0);
 
     C_Progress_display my_progress_bar(
       vec_edges.size(),
@@ -428,7 +450,7 @@ void GlobalSfM_Translation_AveragingSolver::ComputePutativeTranslation_EdgesCove
       const myEdge & edge = vec_edges[k];
       ++my_progress_bar;
 
-      if (m_mutexSet.count(edge) == 0 && m_mutexSet.size() != vec_edges.size())
+      if (!edge_coverage.IsEdgeCovered(k) && !edge_coverage.AllEdgesCovered())
       {
         // Find the triplets that are supporting the given edge
         const auto & vec_possibleTripletIndexes = map_tripletIds_perEdge.at(edge);
@@ -454,13 +476,17 @@ void GlobalSfM_Translation_AveragingSolver::ComputePutativeTranslation_EdgesCove
         {
           const graph::Triplet & triplet = vec_triplets[triplet_index];
 
-          // If the triplet is already estimated by another thread; try the next one
-          if (m_mutexSet.count(Pair(triplet.i, triplet.j)) &&
-              m_mutexSet.count(Pair(triplet.i, triplet.k)) &&
-              m_mutexSet.count(Pair(triplet.j, triplet.k)))
+          // If the triplet is already estimated; try the next one
+          if (edge_coverage.IsTripletCovered(triplet_index))
           {
             continue;
           }
+          // If the triplet is (being) estimated by another thread; try the next one
+          if (!edge_coverage.ClaimTriplet(triplet_index))
+          {
+            continue;
+          }
+          ++triplet_estimation_count;
 
           //--
           // Try to estimate this triplet of translations
@@ -478,6 +504,7 @@ void GlobalSfM_Translation_AveragingSolver::ComputePutativeTranslation_EdgesCove
               map_globalR,
               features_provider,
               matches_provider,
+              posewise_view_pairs,
               triplet,
               vec_tis,
               dPrecision,
@@ -485,17 +512,14 @@ void GlobalSfM_Translation_AveragingSolver::ComputePutativeTranslation_EdgesCove
               pose_triplet_tracks,
               sOutDirectory);
 
-          if (bTriplet_estimation)
+          if (!bTriplet_estimation)
+          {
+            ++triplet_failure_count;
+          }
+          else
           {
             // Since new translation edges have been computed, mark their corresponding edges as estimated
-            #ifdef OPENMVG_USE_OPENMP
-              #pragma omp critical
-            #endif
-            {
-              m_mutexSet.insert({triplet.i, triplet.j});
-              m_mutexSet.insert({triplet.j, triplet.k});
-              m_mutexSet.insert({triplet.i, triplet.k});
-            }
+            edge_coverage.CoverTriplet(triplet_index);
 
             // Compute the triplet relative motions (IJ, JK, IK)
             {
@@ -568,6 +592,12 @@ void GlobalSfM_Translation_AveragingSolver::ComputePutativeTranslation_EdgesCove
         }
       }
     }
+    std::cout << "\n"
+      << "-- #Triplet estimations: " << triplet_estimation_count
+      << " (" << triplet_failure_count << " failures)\n"
+      << "-- #Covered edges: " << edge_coverage.CoveredEdgeCount() << "/" << vec_edges.size()
+      << std::endl;
+
     // Merge thread(s) estimates
     for (auto & vec : initial_estimates)
     {
@@ -593,6 +623,7 @@ bool GlobalSfM_Translation_AveragingSolver::Estimate_T_triplet
   const Hash_Map<IndexT, Mat3> & map_globalR,
   const sfm::Features_Provider * features_provider,
   const sfm::Matches_Provider * matches_provider,
+  const Hash_Map<Pair, Pair_Set> & posewise_view_pairs,
   const graph::Triplet & poses_id,
   std::vector<Vec3> & vec_tis,
   double & dPrecision, // UpperBound of the precision found by the AContrario estimator
@@ -601,26 +632,26 @@ bool GlobalSfM_Translation_AveragingSolver::Estimate_T_triplet
   const std::string & sOutDirectory
 ) const
 {
-  // List matches that belong to the triplet of poses
-  PairWiseMatches map_triplet_matches;
-  const std::set<IndexT> set_pose_ids {poses_id.i, poses_id.j, poses_id.k};
-  // List shared correspondences (pairs) between poses
-  for (const auto & match_iterator : matches_provider->pairWise_matches_)
+  // List the view pairs that belong to the triplet of poses
+  Pair_Set triplet_pairs;
+  const std::array<Pair, 3> pose_pairs {{
+    {poses_id.i, poses_id.j}, {poses_id.i, poses_id.k}, {poses_id.j, poses_id.k}}};
+  for (const Pair & pose_pair : pose_pairs)
   {
-    const Pair & pair = match_iterator.first;
-    const View * v1 = sfm_data.GetViews().at(pair.first).get();
-    const View * v2 = sfm_data.GetViews().at(pair.second).get();
-    if (// Consider the pair iff it is supported by the triplet graph & 2 different pose id
-        (v1->id_pose != v2->id_pose)
-        && set_pose_ids.count(v1->id_pose)
-        && set_pose_ids.count(v2->id_pose))
-    {
-      map_triplet_matches.insert( match_iterator );
-    }
+    const auto it = posewise_view_pairs.find(
+      {std::min(pose_pair.first, pose_pair.second),
+       std::max(pose_pair.first, pose_pair.second)});
+    if (it != posewise_view_pairs.end())
+      triplet_pairs.insert(it->second.cbegin(), it->second.cend());
   }
 
+  // Build the triplet tracks (the matches are read pair by pair from the provider)
   openMVG::tracks::TracksBuilder tracksBuilder;
-  tracksBuilder.Build(map_triplet_matches);
+  tracksBuilder.Build(triplet_pairs,
+    [&](const Pair & pair, matching::IndMatches & buffer)
+    {
+      return matches_provider->getMatches(pair, buffer);
+    });
   tracksBuilder.Filter(3);
   tracksBuilder.ExportToSTL(tracks);
 
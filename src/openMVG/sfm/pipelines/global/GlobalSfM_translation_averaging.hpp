@@ -81,6 +81,8 @@ private:
     const Hash_Map<IndexT, Mat3> & map_globalR,
     const sfm::Features_Provider * features_provider,
     const sfm::Matches_Provider * matches_provider,
+    // view pairs of every pose pair (ordered pose ids)
+    const Hash_Map<Pair, Pair_Set> & posewise_view_pairs,
     const graph::Triplet & poses_id,
     std::vector<Vec3> & vec_tis,
     double & dPrecision, // UpperBound of the precision found by the AContrario estimator
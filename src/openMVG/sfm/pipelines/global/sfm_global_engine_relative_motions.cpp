@@ -33,6 +33,7 @@
 
 #include <ceres/types.h>
 
+#include <algorithm>
 #include <iostream>
 
 #ifdef _MSC_VER
@@ -120,7 +121,7 @@ bool GlobalSfMReconstructionEngine_RelativeMotions::Process() {
       std::cout << "Invalid input image graph for global SfM" << std::endl;
       return false;
     }
-    KeepOnlyReferencedElement(set_remainingIds, matches_provider_->pairWise_matches_);
+    matches_provider_->keepOnlyReferencedViews(set_remainingIds);
   }
 
   openMVG::rotation_averaging::RelativeRotations relatives_R;
@@ -321,17 +322,21 @@ bool GlobalSfMReconstructionEngine_RelativeMotions::Compute_Initial_Structure
     using namespace openMVG::tracks;
     TracksBuilder tracksBuilder;
 #if defined USE_ALL_VALID_MATCHES // not used by default
-    matching::PairWiseMatches pose_supported_matches;
-    for (const std::pair<Pair, IndMatches> & match_info :  matches_provider_->pairWise_matches_)
+    Pair_Set pose_supported_pairs;
+    for (const Pair & pair : matches_provider_->getPairs())
     {
-      const View * vI = sfm_data_.GetViews().at(match_info.first.first).get();
-      const View * vJ = sfm_data_.GetViews().at(match_info.first.second).get();
+      const View * vI = sfm_data_.GetViews().at(pair.first).get();
+      const View * vJ = sfm_data_.GetViews().at(pair.second).get();
       if (sfm_data_.IsPoseAndIntrinsicDefined(vI) && sfm_data_.IsPoseAndIntrinsicDefined(vJ))
       {
-        pose_supported_matches.insert(match_info);
+        pose_supported_pairs.insert(pair);
       }
     }
-    tracksBuilder.Build(pose_supported_matches);
+    tracksBuilder.Build(pose_supported_pairs,
+      [&](const Pair & pair, matching::IndMatches & buffer)
+      {
+        return matches_provider_->getMatches(pair, buffer);
+      });
 #else
     // Use triplet validated matches
     tracksBuilder.Build(tripletWise_matches);
@@ -532,27 +537,32 @@ void GlobalSfMReconstructionEngine_RelativeMotions::Compute_Relative_Rotations
   rotation_averaging::RelativeRotations & vec_relatives_R
 )
 {
-  // Compute a relative pose for each edge of the pose pair graph
-  const Relative_Pose_Engine::Relative_Pair_Poses relative_poses = [&]
+  // Compute a relative pose for each edge of the pose pair graph and
+  // export the rotation component as soon as a relative pose is computed
   {
     Relative_Pose_Engine relative_pose_engine;
+    relative_pose_engine.SetRelativePoseCallback(
+      [&vec_relatives_R](const Pair & pose_pair, const geometry::Pose3 & relative_pose)
+      {
+        // Add the relative rotation to the relative 'rotation' pose graph
+        vec_relatives_R.emplace_back(
+          pose_pair.first, pose_pair.second,
+          relative_pose.rotation(),
+          1.f);
+      });
     if (!relative_pose_engine.Process(sfm_data_,
         matches_provider_,
         features_provider_))
-      return Relative_Pose_Engine::Relative_Pair_Poses();
-    else
-      return relative_pose_engine.Get_Relative_Poses();
-  }();
-
-  // Export the rotation component from the computed relative poses
-  for (const auto & relative_pose : relative_poses)
-  {
-    // Add the relative rotation to the relative 'rotation' pose graph
-    vec_relatives_R.emplace_back(
-      relative_pose.first.first, relative_pose.first.second,
-      relative_pose.second.rotation(),
-      1.f);
+      vec_relatives_R.clear();
   }
+  // The completion order depends on the thread scheduling: keep a
+  // deterministic pose pair ordering
+  std::sort(vec_relatives_R.begin(), vec_relatives_R.end(),
+    [](const rotation_averaging::RelativeRotation & a,
+       const rotation_averaging::RelativeRotation & b)
+    {
+      return std::make_pair(a.i, a.j) < std::make_pair(b.i, b.j);
+    });
 
   // Log input graph to the HTML report
   if (!sLogging_file_.empty() && !sOut_directory_.empty())
@@ -562,7 +572,7 @@ void GlobalSfMReconstructionEngine_RelativeMotions::Compute_Relative_Rotations
       std::set<IndexT> set_ViewIds;
       std::transform(sfm_data_.GetViews().cbegin(), sfm_data_.GetViews().cend(),
         std::inserter(set_ViewIds, set_ViewIds.begin()), stl::RetrieveKey());
-      graph::indexedGraph putativeGraph(set_ViewIds, getPairs(matches_provider_->pairWise_matches_));
+      graph::indexedGraph putativeGraph(set_ViewIds, matches_provider_->getPairs());
       graph::exportToGraphvizData(
         stlplus::create_filespec(sOut_directory_, "global_relative_rotation_view_graph"),
         putativeGraph);
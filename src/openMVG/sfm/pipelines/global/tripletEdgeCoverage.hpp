@@ -0,0 +1,87 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SFM_PIPELINES_TRIPLET_EDGE_COVERAGE_HPP
+#define OPENMVG_SFM_PIPELINES_TRIPLET_EDGE_COVERAGE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace openMVG {
+namespace sfm{
+
+/// Lock free bookkeeping of the triplet edge coverage algorithm:
+/// - the edges are identified by a dense id and flagged as covered by atomics,
+/// - a triplet must be claimed before its estimation, so that a triplet is
+///   estimated at most once (even if the estimation fails).
+class Triplet_Edge_Coverage {
+
+public:
+    using Triplet_Edges = std::array<uint32_t, 3>; // The edge ids of a triplet
+
+    Triplet_Edge_Coverage
+    (
+      const size_t nb_edges,
+      const std::vector<Triplet_Edges> & triplet_edges
+    ):
+      triplet_edges_(triplet_edges),
+      covered_edges_(nb_edges),
+      claimed_triplets_(triplet_edges.size()),
+      covered_count_(0)
+    {
+      for (auto & covered : covered_edges_)
+        covered.store(false, std::memory_order_relaxed);
+      for (auto & claimed : claimed_triplets_)
+        claimed.store(false, std::memory_order_relaxed);
+    }
+
+    bool IsEdgeCovered(const uint32_t edge_id) const {
+      return covered_edges_[edge_id].load(std::memory_order_relaxed);
+    }
+
+    bool AllEdgesCovered() const {
+      return covered_count_.load(std::memory_order_relaxed) == covered_edges_.size();
+    }
+
+    bool IsTripletCovered(const uint32_t triplet_id) const {
+      for (const uint32_t edge_id : triplet_edges_[triplet_id])
+        if (!IsEdgeCovered(edge_id))
+          return false;
+      return true;
+    }
+
+    /// Return true if the calling thread is the first one to claim the triplet
+    bool ClaimTriplet(const uint32_t triplet_id) {
+      return !claimed_triplets_[triplet_id].exchange(true, std::memory_order_relaxed);
+    }
+
+    /// Mark the edges of an estimated triplet as covered
+    void CoverTriplet(const uint32_t triplet_id) {
+      for (const uint32_t edge_id : triplet_edges_[triplet_id])
+        if (!covered_edges_[edge_id].exchange(true, std::memory_order_relaxed))
+          covered_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    size_t CoveredEdgeCount() const {
+      return covered_count_.load(std::memory_order_relaxed);
+    }
+
+private:
+    const std::vector<Triplet_Edges> triplet_edges_;
+    std::vector<std::atomic<bool>> covered_edges_;
+    std::vector<std::atomic<bool>> claimed_triplets_;
+    std::atomic<size_t> covered_count_;
+};
+
+} // namespace sfm
+} // namespace openMVG
+
+#endif // OPENMVG_SFM_PIPELINES_TRIPLET_EDGE_COVERAGE_HPP
@@ -0,0 +1,260 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/sfm/pipelines/global/tripletEdgeCoverage.hpp"
+#include "openMVG/types.hpp"
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <set>
+
+#ifdef OPENMVG_USE_OPENMP
+#include <omp.h>
+#endif
+
+using namespace openMVG;
+using namespace openMVG::sfm;
+
+// A small pose graph: a ring of poses with chords, and all its triplets.
+struct Triplet_Graph
+{
+  std::vector<Pair> edges;
+  std::vector<std::array<IndexT, 3>> triplets;   // the poses (i < j < k)
+  std::vector<Triplet_Edge_Coverage::Triplet_Edges> triplet_edges;
+  std::vector<std::vector<uint32_t>> triplets_per_edge; // ordered by preference
+};
+
+Triplet_Graph MakeTripletGraph(const IndexT nb_poses)
+{
+  std::set<Pair> edge_set;
+  for (IndexT i = 0; i < nb_poses; ++i)
+  {
+    edge_set.insert({i, (i + 1) % nb_poses});
+    edge_set.insert({i, (i + 2) % nb_poses});
+    if (i % 2 == 0)
+      edge_set.insert({i, (i + 3) % nb_poses});
+  }
+  Triplet_Graph graph;
+  for (const Pair & edge : edge_set)
+    graph.edges.emplace_back(std::min(edge.first, edge.second),
+                             std::max(edge.first, edge.second));
+  std::sort(graph.edges.begin(), graph.edges.end());
+  graph.edges.erase(std::unique(graph.edges.begin(), graph.edges.end()),
+                    graph.edges.end());
+
+  const auto edge_id = [&](const IndexT a, const IndexT b) {
+    return static_cast<uint32_t>(
+      std::lower_bound(graph.edges.begin(), graph.edges.end(), Pair(a, b))
+      - graph.edges.begin());
+  };
+  const auto has_edge = [&](const IndexT a, const IndexT b) {
+    return std::binary_search(graph.edges.begin(), graph.edges.end(), Pair(a, b));
+  };
+
+  graph.triplets_per_edge.resize(graph.edges.size());
+  for (IndexT i = 0; i < nb_poses; ++i)
+    for (IndexT j = i + 1; j < nb_poses; ++j)
+      for (IndexT k = j + 1; k < nb_poses; ++k)
+        if (has_edge(i, j) && has_edge(i, k) && has_edge(j, k))
+        {
+          const uint32_t triplet_id = graph.triplets.size();
+          graph.triplets.push_back({{i, j, k}});
+          graph.triplet_edges.push_back({{edge_id(i, j), edge_id(i, k), edge_id(j, k)}});
+          for (const uint32_t id : graph.triplet_edges.back())
+            graph.triplets_per_edge[id].push_back(triplet_id);
+        }
+
+  // Mimic the "sort by number of common tracks" ordering with a fixed weight
+  const auto weight = [](const uint32_t triplet_id) { return (triplet_id * 7) % 5; };
+  for (auto & triplet_ids : graph.triplets_per_edge)
+    std::stable_sort(triplet_ids.begin(), triplet_ids.end(),
+      [&](const uint32_t a, const uint32_t b) { return weight(a) > weight(b); });
+  return graph;
+}
+
+// Some triplet estimations fail (deterministically)
+bool IsTripletEstimated(const uint32_t triplet_id)
+{
+  return triplet_id % 4 != 3;
+}
+
+// The former selection: the covered edges are kept in a set of pose pairs
+std::set<uint32_t> SetBasedSelection
+(
+  const Triplet_Graph & graph,
+  std::set<Pair> & covered_edges
+)
+{
+  std::set<uint32_t> estimated_triplets;
+  for (size_t k = 0; k < graph.edges.size(); ++k)
+  {
+    if (covered_edges.count(graph.edges[k]) == 0 &&
+        covered_edges.size() != graph.edges.size())
+    {
+      for (const uint32_t triplet_id : graph.triplets_per_edge[k])
+      {
+        const auto & triplet = graph.triplets[triplet_id];
+        if (covered_edges.count(Pair(triplet[0], triplet[1])) &&
+            covered_edges.count(Pair(triplet[0], triplet[2])) &&
+            covered_edges.count(Pair(triplet[1], triplet[2])))
+        {
+          continue;
+        }
+        if (IsTripletEstimated(triplet_id))
+        {
+          covered_edges.insert({triplet[0], triplet[1]});
+          covered_edges.insert({triplet[1], triplet[2]});
+          covered_edges.insert({triplet[0], triplet[2]});
+          estimated_triplets.insert(triplet_id);
+        }
+      }
+    }
+  }
+  return estimated_triplets;
+}
+
+// The current selection, as done by the translation averaging
+std::set<uint32_t> CoverageBasedSelection
+(
+  const Triplet_Graph & graph,
+  Triplet_Edge_Coverage & edge_coverage,
+  const bool use_threads
+)
+{
+  std::vector<uint8_t> estimated(graph.triplets.size(), 0);
+  #ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(dynamic) if (use_threads)
+  #endif
+  for (int k = 0; k < static_cast<int>(graph.edges.size()); ++k)
+  {
+    if (!edge_coverage.IsEdgeCovered(k) && !edge_coverage.AllEdgesCovered())
+    {
+      for (const uint32_t triplet_id : graph.triplets_per_edge[k])
+      {
+        if (edge_coverage.IsTripletCovered(triplet_id) ||
+            !edge_coverage.ClaimTriplet(triplet_id))
+        {
+          continue;
+        }
+        if (IsTripletEstimated(triplet_id))
+        {
+          edge_coverage.CoverTriplet(triplet_id);
+          estimated[triplet_id] = 1;
+        }
+      }
+    }
+  }
+  std::set<uint32_t> estimated_triplets;
+  for (uint32_t triplet_id = 0; triplet_id < estimated.size(); ++triplet_id)
+    if (estimated[triplet_id])
+      estimated_triplets.insert(triplet_id);
+  return estimated_triplets;
+}
+
+TEST(Triplet_Edge_Coverage, ClaimIsExclusive) {
+
+  const Triplet_Graph graph = MakeTripletGraph(12);
+  Triplet_Edge_Coverage edge_coverage(graph.edges.size(), graph.triplet_edges);
+
+  // Every thread tries to claim every triplet
+  std::vector<int> claim_count(graph.triplets.size(), 0);
+  #ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel num_threads(4)
+  #endif
+  {
+    for (uint32_t triplet_id = 0; triplet_id < graph.triplets.size(); ++triplet_id)
+    {
+      if (edge_coverage.ClaimTriplet(triplet_id))
+      {
+        #ifdef OPENMVG_USE_OPENMP
+        #pragma omp atomic
+        #endif
+        ++claim_count[triplet_id];
+      }
+    }
+  }
+  for (const int count : claim_count)
+    EXPECT_EQ(1, count);
+
+  // A claim does not cover anything
+  EXPECT_EQ(0, edge_coverage.CoveredEdgeCount());
+  for (uint32_t triplet_id = 0; triplet_id < graph.triplets.size(); ++triplet_id)
+  {
+    EXPECT_FALSE(edge_coverage.IsTripletCovered(triplet_id));
+    EXPECT_FALSE(edge_coverage.ClaimTriplet(triplet_id));
+  }
+}
+
+TEST(Triplet_Edge_Coverage, CoverTriplet) {
+
+  const Triplet_Graph graph = MakeTripletGraph(6);
+  Triplet_Edge_Coverage edge_coverage(graph.edges.size(), graph.triplet_edges);
+
+  edge_coverage.CoverTriplet(0);
+  EXPECT_EQ(3, edge_coverage.CoveredEdgeCount());
+  EXPECT_TRUE(edge_coverage.IsTripletCovered(0));
+  for (const uint32_t edge_id : graph.triplet_edges[0])
+    EXPECT_TRUE(edge_coverage.IsEdgeCovered(edge_id));
+
+  // Covering a triplet twice does not count its edges twice
+  edge_coverage.CoverTriplet(0);
+  EXPECT_EQ(3, edge_coverage.CoveredEdgeCount());
+
+  for (uint32_t triplet_id = 0; triplet_id < graph.triplets.size(); ++triplet_id)
+    edge_coverage.CoverTriplet(triplet_id);
+  EXPECT_TRUE(edge_coverage.AllEdgesCovered());
+  EXPECT_EQ(graph.edges.size(), edge_coverage.CoveredEdgeCount());
+}
+
+TEST(Triplet_Edge_Coverage, SameSelectionAsSetBasedCoverage) {
+
+  const Triplet_Graph graph = MakeTripletGraph(12);
+  EXPECT_TRUE(graph.triplets.size() > 10);
+
+  std::set<Pair> covered_edges;
+  const std::set<uint32_t> expected_triplets = SetBasedSelection(graph, covered_edges);
+
+  Triplet_Edge_Coverage edge_coverage(graph.edges.size(), graph.triplet_edges);
+  const std::set<uint32_t> estimated_triplets =
+    CoverageBasedSelection(graph, edge_coverage, false);
+
+  EXPECT_TRUE(expected_triplets == estimated_triplets);
+  EXPECT_EQ(covered_edges.size(), edge_coverage.CoveredEdgeCount());
+  for (uint32_t edge_id = 0; edge_id < graph.edges.size(); ++edge_id)
+  {
+    EXPECT_EQ(covered_edges.count(graph.edges[edge_id]) == 1,
+              edge_coverage.IsEdgeCovered(edge_id));
+  }
+}
+
+TEST(Triplet_Edge_Coverage, ThreadedCoverageMatchesSetBasedCoverage) {
+
+  const Triplet_Graph graph = MakeTripletGraph(40);
+
+  std::set<Pair> covered_edges;
+  SetBasedSelection(graph, covered_edges);
+
+  // The selected triplets depend on the thread scheduling, but not the covered edges
+  for (int run = 0; run < 10; ++run)
+  {
+    Triplet_Edge_Coverage edge_coverage(graph.edges.size(), graph.triplet_edges);
+    CoverageBasedSelection(graph, edge_coverage, true);
+
+    EXPECT_EQ(covered_edges.size(), edge_coverage.CoveredEdgeCount());
+    for (uint32_t edge_id = 0; edge_id < graph.edges.size(); ++edge_id)
+    {
+      EXPECT_EQ(covered_edges.count(graph.edges[edge_id]) == 1,
+                edge_coverage.IsEdgeCovered(edge_id));
+    }
+  }
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
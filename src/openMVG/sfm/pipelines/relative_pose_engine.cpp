@@ -21,6 +21,8 @@
 
 #include "ceres/ceres.h"
 
+#include <algorithm>
+
 namespace openMVG {
 namespace sfm {
 
@@ -36,9 +38,8 @@ bool Relative_Pose_Engine::Process(
 )
 {
   Pair_Set relative_pose_pairs;
-  for (const auto & iterMatches : matches_provider_->pairWise_matches_)
+  for (const Pair & pair : matches_provider_->getPairs())
   {
-    const Pair pair = iterMatches.first;
     const View * v1 = sfm_data_.GetViews().at(pair.first).get();
     const View * v2 = sfm_data_.GetViews().at(pair.second).get();
     if (v1->id_pose != v2->id_pose)
@@ -65,9 +66,8 @@ bool Relative_Pose_Engine::Relative_Pose_Engine::Process(
   //
   using PoseWiseMatches = Hash_Map<Pair, Pair_Set>;
   PoseWiseMatches posewise_matches;
-  for (const auto & iterMatches : matches_provider_->pairWise_matches_)
+  for (const Pair & pair : matches_provider_->getPairs())
   {
-    const Pair pair = iterMatches.first;
     const View * v1 = sfm_data_.GetViews().at(pair.first).get();
     const View * v2 = sfm_data_.GetViews().at(pair.second).get();
     if (v1->id_pose != v2->id_pose
@@ -75,23 +75,44 @@ bool Relative_Pose_Engine::Relative_Pose_Engine::Process(
       posewise_matches[{v1->id_pose, v2->id_pose}].insert(pair);
   }
 
+  //
+  // Sort the pose pairs by decreasing estimation cost (the match count):
+  //  the largest jobs are scheduled first, so the threads are not left idle
+  //  waiting for a large job started at the end.
+  //
+  std::vector<std::pair<size_t, PoseWiseMatches::const_iterator>> scheduled_pairs;
+  scheduled_pairs.reserve(posewise_matches.size());
+  for (auto iter = posewise_matches.cbegin(); iter != posewise_matches.cend(); ++iter)
+  {
+    size_t match_count = 0;
+    for (const Pair & match_pair : iter->second)
+      match_count += matches_provider_->getMatchCount(match_pair);
+    scheduled_pairs.emplace_back(match_count, iter);
+  }
+  std::stable_sort(scheduled_pairs.begin(), scheduled_pairs.end(),
+    [](const std::pair<size_t, PoseWiseMatches::const_iterator> & a,
+       const std::pair<size_t, PoseWiseMatches::const_iterator> & b)
+    {
+      return a.first > b.first;
+    });
+
   system::Timer t;
+  statistics_ = Statistics();
+  statistics_.pair_count = scheduled_pairs.size();
 
   std::unique_ptr<C_Progress> progress_status
     (new C_Progress_display(posewise_matches.size(),
       std::cout, "\n- Relative pose computation -\n" ));
 
   #ifdef OPENMVG_USE_OPENMP
-    #pragma omp parallel for schedule(dynamic)
+    #pragma omp parallel for schedule(dynamic, 1)
   #endif
   // Compute the relative pose from pairwise point matches:
-  for (int i = 0; i < static_cast<int>(posewise_matches.size()); ++i)
+  for (int i = 0; i < static_cast<int>(scheduled_pairs.size()); ++i)
   {
     ++(*progress_status);
     {
-      PoseWiseMatches::const_iterator iter (posewise_matches.begin());
-      std::advance(iter, i);
-      const auto & relative_pose_iterator(*iter);
+      const auto & relative_pose_iterator(*scheduled_pairs[i].second);
       const Pair relative_pose_pair = relative_pose_iterator.first;
       const Pair_Set & match_pairs = relative_pose_iterator.second;
 
@@ -127,26 +148,42 @@ bool Relative_Pose_Engine::Relative_Pose_Engine::Process(
         * cam_I = sfm_data_.GetIntrinsics().at(view_I->id_intrinsic).get(),
         * cam_J = sfm_data_.GetIntrinsics().at(view_J->id_intrinsic).get();
 
+      const auto
+        feats_I = features_provider_->get(I),
+        feats_J = features_provider_->get(J);
+      if (!feats_I || !feats_J)
+        continue;
+
       // Compute for each feature the un-distorted camera coordinates
-      const matching::IndMatches & matches = matches_provider_->pairWise_matches_.at(current_pair);
+      matching::IndMatches matches_buffer;
+      const matching::IndMatches * pair_matches =
+        matches_provider_->getMatches(current_pair, matches_buffer);
+      if (!pair_matches)
+        continue;
+      const matching::IndMatches & matches = *pair_matches;
       size_t number_matches = matches.size();
       Mat2X x1(2, number_matches), x2(2, number_matches);
       number_matches = 0;
       for (const auto & match : matches)
       {
         x1.col(number_matches) = cam_I->get_ud_pixel(
-          features_provider_->feats_per_view.at(I)[match.i_].coords().cast<double>());
+          (*feats_I)[match.i_].coords().cast<double>());
         x2.col(number_matches++) = cam_J->get_ud_pixel(
-          features_provider_->feats_per_view.at(J)[match.j_].coords().cast<double>());
+          (*feats_J)[match.j_].coords().cast<double>());
       }
 
       RelativePose_Info relativePose_info;
       relativePose_info.initial_residual_tolerance = Square(2.5);
-      if (!robustRelativePose(cam_I, cam_J,
+      const bool b_relative_pose = robustRelativePose(cam_I, cam_J,
                               x1, x2, relativePose_info,
                               {cam_I->w(), cam_I->h()},
                               {cam_J->w(), cam_J->h()},
-                              256))
+                              256);
+#ifdef OPENMVG_USE_OPENMP
+      #pragma omp atomic
+#endif
+      statistics_.ransac_iteration_count += relativePose_info.ransac_iteration_count;
+      if (!b_relative_pose)
       {
         continue;
       }
@@ -178,8 +215,8 @@ bool Relative_Pose_Engine::Relative_Pose_Engine::Process(
           ))
           {
             Observations obs;
-            const Vec2 obs_I = features_provider_->feats_per_view.at(I)[matches[k].i_].coords().cast<double>();
-            const Vec2 obs_J = features_provider_->feats_per_view.at(J)[matches[k].j_].coords().cast<double>();
+            const Vec2 obs_I = (*feats_I)[matches[k].i_].coords().cast<double>();
+            const Vec2 obs_J = (*feats_J)[matches[k].j_].coords().cast<double>();
             obs[view_I->id_view] = {obs_I, matches[k].i_};
             obs[view_J->id_view] = {obs_J, matches[k].j_};
             landmarks[k].obs = obs;
@@ -219,10 +256,19 @@ bool Relative_Pose_Engine::Relative_Pose_Engine::Process(
       {
         // Add the relative pose to the relative 'rotation' pose graph
         relative_poses_[relative_pose_pair] = relativePose_info.relativePose;
+        ++statistics_.estimated_pair_count;
+        if (relative_pose_callback_)
+          relative_pose_callback_(relative_pose_pair, relativePose_info.relativePose);
       }
     }
   }
-  std::cout << "Relative motion computation took: " << t.elapsedMs() << "(ms)" << std::endl;
+  statistics_.elapsed_seconds = t.elapsedMs() / 1000.0;
+  std::cout
+    << "Relative motion computation took: " << t.elapsedMs() << "(ms)\n"
+    << " #pose pairs: " << statistics_.pair_count
+    << ", #relative poses: " << statistics_.estimated_pair_count << "\n"
+    << " throughput: " << statistics_.PairsPerSecond() << " pairs/s, "
+    << statistics_.RansacIterationsPerPair() << " ACRANSAC iterations/pair" << std::endl;
   return !relative_poses_.empty();
 }
 
@@ -233,5 +279,12 @@ Relative_Pose_Engine::Get_Relative_Poses() const
   return relative_poses_;
 }
 
+// Statistics accessor
+const Relative_Pose_Engine::Statistics&
+Relative_Pose_Engine::Get_Statistics() const
+{
+  return statistics_;
+}
+
 } // namespace sfm
 } // namespace openMVG
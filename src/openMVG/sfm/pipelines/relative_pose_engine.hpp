@@ -13,6 +13,8 @@
 #include "openMVG/geometry/pose3.hpp"
 #include "openMVG/multiview/triangulation_method.hpp"
 
+#include <functional>
+
 namespace openMVG {
 namespace sfm {
 
@@ -20,12 +22,36 @@ struct SfM_Data;
 struct Matches_Provider;
 struct Features_Provider;
 
-/// An engine to compute relative pose
+/// An engine to compute relative pose.
+/// The pose pairs are processed in parallel, the most expensive ones (the pairs
+/// with the largest match count) first, in order to balance the thread load.
 class Relative_Pose_Engine
 {
 public:
   using Relative_Pair_Poses = Hash_Map<Pair, geometry::Pose3>;
 
+  /// Function called (sequentially) as soon as a relative pose is computed
+  using Relative_Pose_Callback =
+    std::function<void(const Pair & pose_pair, const geometry::Pose3 & relative_pose)>;
+
+  /// Throughput statistics of the last Process call
+  struct Statistics
+  {
+    size_t pair_count = 0;           // Number of processed pose pairs
+    size_t estimated_pair_count = 0; // Number of computed relative poses
+    size_t ransac_iteration_count = 0; // Robust estimation iterations (all pairs)
+    double elapsed_seconds = 0.0;
+
+    double PairsPerSecond() const
+    {
+      return elapsed_seconds > 0.0 ? pair_count / elapsed_seconds : 0.0;
+    }
+    double RansacIterationsPerPair() const
+    {
+      return pair_count > 0 ? ransac_iteration_count / static_cast<double>(pair_count) : 0.0;
+    }
+  };
+
   Relative_Pose_Engine () = default;
 
   // Try to compute all the possible relative pose.
@@ -46,6 +72,15 @@ public:
   // Relative poses accessor
   const Relative_Pair_Poses& Get_Relative_Poses() const;
 
+  // Statistics of the last Process call
+  const Statistics& Get_Statistics() const;
+
+  /// Stream the relative poses as they are computed
+  void SetRelativePoseCallback(const Relative_Pose_Callback & callback)
+  {
+    relative_pose_callback_ = callback;
+  }
+
   /// Configure the 2view triangulation method used by the RelativePose computing engine
   void SetTriangulationMethod(const ETriangulationMethod method)
   {
@@ -54,6 +89,8 @@ public:
 
 private:
   Relative_Pair_Poses relative_poses_;
+  Statistics statistics_;
+  Relative_Pose_Callback relative_pose_callback_;
 
   ETriangulationMethod triangulation_method_ = ETriangulationMethod::DEFAULT;
 };
@@ -42,11 +42,13 @@ bool SfMSceneInitializerMaxPair::Process()
   // Sort the PairWiseMatches by matches count.
   // Keep the first pair that provides a valid relative pose.
   //
+  const Pair_Set pairs = matches_provider_->getPairs();
+  const std::vector<Pair> pair_vec(pairs.cbegin(), pairs.cend());
   std::vector<IndexT> matches_count_per_pair;
-  matches_count_per_pair.reserve(matches_provider_->pairWise_matches_.size());
-  std::transform(matches_provider_->pairWise_matches_.cbegin(), matches_provider_->pairWise_matches_.cend(),
+  matches_count_per_pair.reserve(pair_vec.size());
+  std::transform(pair_vec.cbegin(), pair_vec.cend(),
     std::back_inserter(matches_count_per_pair),
-    [](const std::pair<Pair, IndMatches> & match_pair) -> IndexT { return match_pair.second.size(); });
+    [&](const Pair & pair) -> IndexT { return matches_provider_->getMatchCount(pair); });
 
   // sort the Pairs in descending order according their matches count
   using namespace stl::indexed_sort;
@@ -57,15 +59,14 @@ bool SfMSceneInitializerMaxPair::Process()
   for (size_t i = 0; i < matches_count_per_pair.size(); ++i)
   {
     const IndexT index = packet_vec[i].index;
-    openMVG::matching::PairWiseMatches::const_iterator iter = matches_provider_->pairWise_matches_.cbegin();
-    std::advance(iter, index);
+    const Pair & pair = pair_vec[index];
 
-    std::cout << "(" << iter->first.first << "," << iter->first.second <<"): "
-      << iter->second.size() << " matches" << std::endl;
+    std::cout << "(" << pair.first << "," << pair.second <<"): "
+      << matches_count_per_pair[index] << " matches" << std::endl;
 
     const IndexT
-      I = iter->first.first,
-      J = iter->first.second;
+      I = pair.first,
+      J = pair.second;
 
     const View
       * view_I = sfm_data_.views[I].get(),
@@ -80,15 +81,26 @@ bool SfMSceneInitializerMaxPair::Process()
       * cam_I = sfm_data_.GetIntrinsics().at(view_I->id_intrinsic).get(),
       * cam_J = sfm_data_.GetIntrinsics().at(view_J->id_intrinsic).get();
 
+    const auto
+      feats_I = features_provider_->get(I),
+      feats_J = features_provider_->get(J);
+    if (!feats_I || !feats_J)
+      continue;
+
     // Compute for each feature the un-distorted camera coordinates
-    const matching::IndMatches & matches = matches_provider_->pairWise_matches_.at(iter->first);
+    matching::IndMatches matches_buffer;
+    const matching::IndMatches * pair_matches =
+      matches_provider_->getMatches(pair, matches_buffer);
+    if (!pair_matches)
+      continue;
+    const matching::IndMatches & matches = *pair_matches;
     size_t number_matches = matches.size();
     Mat2X x1(2, number_matches), x2(2, number_matches);
     number_matches = 0;
     for (const auto & match : matches)
     {
-      x1.col(number_matches) = cam_I->get_ud_pixel(features_provider_->feats_per_view.at(I)[match.i_].coords().cast<double>());
-      x2.col(number_matches) = cam_J->get_ud_pixel(features_provider_->feats_per_view.at(J)[match.j_].coords().cast<double>());
+      x1.col(number_matches) = cam_I->get_ud_pixel((*feats_I)[match.i_].coords().cast<double>());
+      x2.col(number_matches) = cam_J->get_ud_pixel((*feats_J)[match.j_].coords().cast<double>());
       ++number_matches;
     }
 
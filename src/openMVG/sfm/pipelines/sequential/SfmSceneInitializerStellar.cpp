@@ -54,8 +54,7 @@ bool find_largest_stellar_configuration
     const Pair_Set & pairs = stellar_pod_it.second;
     for (const auto & pair_it : pairs)
     {
-      const matching::IndMatches & matches = matches_provider->pairWise_matches_.at(pair_it);
-      matches_count_per_stellar_pod[id] += matches.size();
+      matches_count_per_stellar_pod[id] += matches_provider->getMatchCount(pair_it);
     }
     matches_count_per_stellar_pod[id] /= pairs.size();
     ++id;
@@ -136,7 +136,7 @@ bool SequentialSfMReconstructionEngine::Process() {
       // Scene logging as ply for visual debug
       std::ostringstream os;
       os << std::setw(8) << std::setfill('0') << resectionGroupIndex << "_Resection";
-      Save(sfm_data_, stlplus::create_filespec(sOut_directory_, os.str(), ".ply"), ESfM_Data(ALL));
+      SaveSnapshot(sfm_data_, os.str());
 
       // Perform BA until all point are under the given precision
       do
@@ -154,6 +154,17 @@ bool SequentialSfMReconstructionEngine::Process() {
     eraseUnstablePosesAndObservations(sfm_data_);
   }
 
+  //-- Wait for the last intermediate scene export
+  if (snapshot_writer_)
+  {
+    snapshot_writer_->Flush();
+    std::cout << "Scene snapshots: " << snapshot_writer_->WrittenCount() << " written, "
+      << snapshot_writer_->FailedCount() << " failed, "
+      << snapshot_writer_->CoalescedCount() << " coalesced, "
+      << snapshot_writer_->ThrottledCount() << " throttled." << std::endl;
+    snapshot_writer_.reset();
+  }
+
   //-- Reconstruction done.
   //-- Display some statistics
   std::cout << "\n\n-------------------------------" << "\n"
@@ -200,6 +211,19 @@ bool SequentialSfMReconstructionEngine::Process() {
   return true;
 }
 
+void SequentialSfMReconstructionEngine::SaveSnapshot
+(
+  const SfM_Data & sfm_data,
+  const std::string & name,
+  const bool b_force
+)
+{
+  if (!snapshot_writer_)
+    snapshot_writer_.reset(new SfM_Data_Snapshot_Writer(snapshot_options_));
+  snapshot_writer_->Push(sfm_data,
+    stlplus::create_filespec(sOut_directory_, name, ".ply"), ESfM_Data(ALL), b_force);
+}
+
 /// Select a candidate initial pair
 bool SequentialSfMReconstructionEngine::ChooseInitialPair(Pair & initialPairIndex) const
 {
@@ -240,18 +264,14 @@ bool SequentialSfMReconstructionEngine::ChooseInitialPair(Pair & initialPairInde
     //  - valid intrinsics,
     //  - valid estimated Fundamental matrix.
     std::vector<uint32_t > vec_NbMatchesPerPair;
-    std::vector<openMVG::matching::PairWiseMatches::const_iterator> vec_MatchesIterator;
-    const openMVG::matching::PairWiseMatches & map_Matches = matches_provider_->pairWise_matches_;
-    for (openMVG::matching::PairWiseMatches::const_iterator
-      iter = map_Matches.begin();
-      iter != map_Matches.end(); ++iter)
+    std::vector<Pair> vec_Pairs;
+    for (const Pair & current_pair : matches_provider_->getPairs())
     {
-      const Pair current_pair = iter->first;
       if (valid_views.count(current_pair.first) &&
         valid_views.count(current_pair.second) )
       {
-        vec_NbMatchesPerPair.push_back(iter->second.size());
-        vec_MatchesIterator.push_back(iter);
+        vec_NbMatchesPerPair.push_back(matches_provider_->getMatchCount(current_pair));
+        vec_Pairs.push_back(current_pair);
       }
     }
     // sort the Pairs in descending order according their correspondences count
@@ -261,9 +281,8 @@ bool SequentialSfMReconstructionEngine::ChooseInitialPair(Pair & initialPairInde
 
     for (size_t i = 0; i < std::min((size_t)10, vec_NbMatchesPerPair.size()); ++i) {
       const uint32_t index = packet_vec[i].index;
-      openMVG::matching::PairWiseMatches::const_iterator iter = vec_MatchesIterator[index];
-      std::cout << "(" << iter->first.first << "," << iter->first.second <<")\t\t"
-        << iter->second.size() << " matches" << std::endl;
+      std::cout << "(" << vec_Pairs[index].first << "," << vec_Pairs[index].second <<")\t\t"
+        << vec_NbMatchesPerPair[index] << " matches" << std::endl;
     }
 
     // Ask the user to choose an initial pair (by set some view ids)
@@ -296,10 +315,14 @@ bool SequentialSfMReconstructionEngine::InitLandmarkTracks()
 
   {
     // List of features matches for each couple of images
-    const openMVG::matching::PairWiseMatches & map_Matches = matches_provider_->pairWise_matches_;
+    // (read pair by pair from the provider)
     std::cout << "\n" << "Track building" << std::endl;
 
-    tracksBuilder.Build(map_Matches);
+    tracksBuilder.Build(matches_provider_->getPairs(),
+      [&](const Pair & pair, matching::IndMatches & buffer)
+      {
+        return matches_provider_->getMatches(pair, buffer);
+      });
     std::cout << "\n" << "Track filtering" << std::endl;
     tracksBuilder.Filter();
     std::cout << "\n" << "Track export to internal struct" << std::endl;
@@ -364,13 +387,14 @@ bool SequentialSfMReconstructionEngine::AutomaticInitialPairChoice(Pair & initia
   std::vector<std::pair<double, Pair>> scoring_per_pair;
 
   // Compute the relative pose & the 'baseline score'
-  C_Progress_display my_progress_bar( matches_provider_->pairWise_matches_.size(),
+  const Pair_Set pairs = matches_provider_->getPairs();
+  C_Progress_display my_progress_bar( pairs.size(),
     std::cout,
     "Automatic selection of an initial pair:\n" );
 #ifdef OPENMVG_USE_OPENMP
   #pragma omp parallel
 #endif
-  for (const std::pair<Pair, IndMatches> & match_pair : matches_provider_->pairWise_matches_)
+  for (const Pair & current_pair : pairs)
   {
 #ifdef OPENMVG_USE_OPENMP
   #pragma omp single nowait
@@ -378,8 +402,6 @@ bool SequentialSfMReconstructionEngine::AutomaticInitialPairChoice(Pair & initia
     {
       ++my_progress_bar;
 
-      const Pair current_pair = match_pair.first;
-
       const uint32_t I = std::min(current_pair.first, current_pair.second);
       const uint32_t J = std::max(current_pair.first, current_pair.second);
       if (valid_views.count(I) && valid_views.count(J))
@@ -599,7 +621,7 @@ bool SequentialSfMReconstructionEngine::MakeInitialPair3D(const Pair & current_p
         landmarks[track_iterator.first].X = X;
       }
     }
-    Save(tiny_scene, stlplus::create_filespec(sOut_directory_, "initialPair.ply"), ESfM_Data(ALL));
+    SaveSnapshot(tiny_scene, "initialPair", true);
 
     // - refine only Structure and Rotations & translations (keep intrinsic constant)
     Bundle_Adjustment_Ceres::BA_Ceres_options options(true, true);
@@ -1222,7 +1244,11 @@ bool SequentialSfMReconstructionEngine::BundleAdjustment()
   {
     options.linear_solver_type_ = ceres::DENSE_SCHUR;
   }
-  Bundle_Adjustment_Ceres bundle_adjustment_obj(options);
+  // Reuse the problem built by the previous calls (only the scene changes are added)
+  if (!bundle_adjustment_)
+    bundle_adjustment_.reset(new Bundle_Adjustment_Ceres_Persistent(options));
+  else
+    bundle_adjustment_->ceres_options() = options;
   const Optimize_Options ba_refine_options
     ( ReconstructionEngine::intrinsic_refinement_options_,
       Extrinsic_Parameter_Type::ADJUST_ALL, // Adjust camera motion
@@ -1230,7 +1256,7 @@ bool SequentialSfMReconstructionEngine::BundleAdjustment()
       Control_Point_Parameter(),
       this->b_use_motion_prior_
     );
-  return bundle_adjustment_obj.Adjust(sfm_data_, ba_refine_options);
+  return bundle_adjustment_->Adjust(sfm_data_, ba_refine_options);
 }
 
 /**
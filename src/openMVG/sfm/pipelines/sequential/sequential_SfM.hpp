@@ -9,11 +9,13 @@
 #ifndef OPENMVG_SFM_LOCALIZATION_SEQUENTIAL_SFM_HPP
 #define OPENMVG_SFM_LOCALIZATION_SEQUENTIAL_SFM_HPP
 
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
 
 #include "openMVG/sfm/pipelines/sfm_engine.hpp"
+#include "openMVG/sfm/pipelines/sfm_snapshot_writer.hpp"
 #include "openMVG/cameras/cameras.hpp"
 #include "openMVG/multiview/solver_resection.hpp"
 #include "openMVG/multiview/triangulation_method.hpp"
@@ -25,6 +27,7 @@ namespace { template <typename T> class Histogram; }
 namespace openMVG {
 namespace sfm {
 
+class Bundle_Adjustment_Ceres_Persistent;
 struct Features_Provider;
 struct Matches_Provider;
 
@@ -85,6 +88,12 @@ public:
     resection_method_ = method;
   }
 
+  /// Configure the intermediate scene snapshots (written in a background thread)
+  void SetSnapshotOptions(const Snapshot_Options & options)
+  {
+    snapshot_options_ = options;
+  }
+
 protected:
 
 
@@ -105,6 +114,9 @@ private:
   /// Discard track with too large residual error
   bool badTrackRejector(double dPrecision, size_t count = 0);
 
+  /// Queue an intermediate scene export to the snapshot writer
+  void SaveSnapshot(const SfM_Data & sfm_data, const std::string & name, const bool b_force = false);
+
   //----
   //-- Data
   //----
@@ -131,9 +143,15 @@ private:
 
   std::set<uint32_t> set_remaining_view_id_;     // Remaining camera index that can be used for resection
 
+  // Bundle adjustment problem kept alive between the resection rounds
+  std::unique_ptr<Bundle_Adjustment_Ceres_Persistent> bundle_adjustment_;
+
   ETriangulationMethod triangulation_method_ = ETriangulationMethod::DEFAULT;
 
   resection::SolverType resection_method_ = resection::SolverType::DEFAULT;
+
+  Snapshot_Options snapshot_options_;
+  std::unique_ptr<SfM_Data_Snapshot_Writer> snapshot_writer_;
 };
 
 } // namespace sfm
@@ -27,6 +27,7 @@
 #include <ceres/types.h>
 #include <functional>
 #include <iostream>
+#include <sstream>
 
 namespace openMVG {
 namespace sfm {
@@ -114,7 +115,7 @@ bool SequentialSfMReconstructionEngine2::Process() {
     if (!sfm_data_.GetPoses().empty())
     {
       const bool bTriangulation = Triangulation();
-      Save(sfm_data_, stlplus::create_filespec(sOut_directory_, "Initialization", ".ply"), ESfM_Data(ALL));
+      SaveSnapshot("Initialization", true);
       RemoveOutliers_AngleError(sfm_data_, Square(2.0));
       RemoveOutliers_PixelResidualError(sfm_data_, Square(4.0));
 
@@ -168,7 +169,7 @@ bool SequentialSfMReconstructionEngine2::Process() {
 
       std::ostringstream os;
       os << std::setw(8) << std::setfill('0') << resection_round << "_Resection";
-      Save(sfm_data_, stlplus::create_filespec(sOut_directory_, os.str(), ".ply"), ESfM_Data(ALL));
+      SaveSnapshot(os.str());
       ++resection_round;
 
       // Stop if no cameras have been added
@@ -187,6 +188,17 @@ bool SequentialSfMReconstructionEngine2::Process() {
   //--
   BundleAdjustment();
 
+  //-- Wait for the last intermediate scene export
+  if (snapshot_writer_)
+  {
+    snapshot_writer_->Flush();
+    std::cout << "Scene snapshots: " << snapshot_writer_->WrittenCount() << " written, "
+      << snapshot_writer_->FailedCount() << " failed, "
+      << snapshot_writer_->CoalescedCount() << " coalesced, "
+      << snapshot_writer_->ThrottledCount() << " throttled." << std::endl;
+    snapshot_writer_.reset();
+  }
+
   //-- Reconstruction done.
   //-- Display some statistics
   std::cout << "\n\n-------------------------------" << "\n"
@@ -200,12 +212,29 @@ bool SequentialSfMReconstructionEngine2::Process() {
   return true;
 }
 
+void SequentialSfMReconstructionEngine2::SaveSnapshot
+(
+  const std::string & name,
+  const bool b_force
+)
+{
+  if (!snapshot_writer_)
+    snapshot_writer_.reset(new SfM_Data_Snapshot_Writer(snapshot_options_));
+  snapshot_writer_->Push(sfm_data_,
+    stlplus::create_filespec(sOut_directory_, name, ".ply"), ESfM_Data(ALL), b_force);
+}
+
 bool SequentialSfMReconstructionEngine2::InitTracksAndLandmarks()
 {
   // Compute tracks from matches
   tracks::TracksBuilder tracksBuilder;
   {
-    tracksBuilder.Build(matches_provider_->pairWise_matches_);
+    // The matches are read pair by pair from the provider
+    tracksBuilder.Build(matches_provider_->getPairs(),
+      [&](const Pair & pair, matching::IndMatches & buffer)
+      {
+        return matches_provider_->getMatches(pair, buffer);
+      });
     tracksBuilder.Filter();
     tracksBuilder.ExportToSTL(map_tracks_);
 
@@ -238,37 +267,131 @@ bool SequentialSfMReconstructionEngine2::InitTracksAndLandmarks()
     }
   }
 
+  // Initialize the per view {FeatureId, TrackId} lookup (sorted by FeatureId)
+  view_feature_tracks_.clear();
+  for (const auto & iterT : map_tracks_)
+  {
+    for (const auto & track_ids : iterT.second) // {ViewId, FeatureId}
+      view_feature_tracks_[track_ids.first].emplace_back(track_ids.second, iterT.first);
+  }
+  for (auto & view_tracks_it : view_feature_tracks_)
+    std::sort(view_tracks_it.second.begin(), view_tracks_it.second.end());
+
   // Init the putative landmarks
   {
     // For every track add the obervations:
     // - views and feature positions that see this landmark
-    for ( const auto & iterT : map_tracks_ )
+    // (view by view, the features of a view are accessed once)
+    for (const auto & iterT : map_tracks_)
+      landmarks_[iterT.first];
+    for (const auto & view_tracks_it : view_feature_tracks_)
     {
-      Observations obs;
-      const size_t track_Length = iterT.second.size();
-      for (const auto & track_ids : iterT.second) // {ViewId, FeatureId}
+      const IndexT view_id = view_tracks_it.first;
+      const auto view_features = features_provider_->get(view_id);
+      if (!view_features)
+      {
+        std::cerr << "Cannot load the features of the view: " << view_id << std::endl;
+        return false;
+      }
+      for (const auto & feat_track : view_tracks_it.second) // {FeatureId, TrackId}
       {
-        const auto & view_id = track_ids.first;
-        const auto & feat_id = track_ids.second;
-        const Vec2 x = features_provider_->feats_per_view[view_id][feat_id].coords().cast<double>();
-        obs.insert({view_id, Observation(x, feat_id)});
+        const Vec2 x = (*view_features)[feat_track.first].coords().cast<double>();
+        landmarks_.at(feat_track.second).obs.insert({view_id, Observation(x, feat_track.first)});
       }
-      landmarks_[iterT.first].obs = std::move(obs);
     }
   }
-
-  // Initialize the shared track visibility helper
-  shared_track_visibility_helper_.reset(new openMVG::tracks::SharedTrackVisibilityHelper(map_tracks_));
   return map_tracks_.size() > 0;
 }
 
 bool SequentialSfMReconstructionEngine2::Triangulation()
 {
-  sfm_data_.structure = landmarks_;
+  //--
+  // List the tracks to triangulate:
+  // - all the tracks for a full triangulation,
+  // - else the tracks observed by the views of the new poses (the other
+  //   landmarks are kept as is, even if the cleaning removed some of their
+  //   observations). A rejected track is retried only once it gained a posed
+  //   observation since its rejection.
+  //--
+  std::set<IndexT> pose_ids, new_pose_ids;
+  for (const auto & pose_it : sfm_data_.GetPoses())
+  {
+    pose_ids.insert(pose_ids.end(), pose_it.first);
+    if (triangulated_pose_ids_.count(pose_it.first) == 0)
+      new_pose_ids.insert(pose_it.first);
+  }
+
+  // Number of observations of a track seen by the given poses
+  const auto posed_observation_count = [&](const IndexT track_id, const std::set<IndexT> & pose_ids)
+  {
+    IndexT count = 0;
+    for (const auto & obs_it : landmarks_.at(track_id).obs)
+      count += pose_ids.count(sfm_data_.GetViews().at(obs_it.first)->id_pose);
+    return count;
+  };
+
+  const bool b_full_triangulation =
+    b_full_triangulation_ || triangulated_pose_ids_.empty();
+  Landmarks landmarks_to_triangulate;
+  if (b_full_triangulation)
+  {
+    landmarks_to_triangulate = landmarks_;
+    rejected_tracks_.clear();
+  }
+  else
+  {
+    // The landmarks removed by the cleaning since the previous triangulation
+    // are rejected (with their posed observation count at that time)
+    for (auto track_it = triangulated_track_ids_.begin(); track_it != triangulated_track_ids_.end();)
+    {
+      if (sfm_data_.structure.count(*track_it) == 0)
+      {
+        rejected_tracks_[*track_it] = posed_observation_count(*track_it, triangulated_pose_ids_);
+        track_it = triangulated_track_ids_.erase(track_it);
+      }
+      else
+        ++track_it;
+    }
+
+    std::set<IndexT> new_pose_track_ids;
+    for (const auto & view_it : sfm_data_.GetViews())
+    {
+      if (new_pose_ids.count(view_it.second->id_pose) == 0)
+        continue;
+      const auto view_tracks_it = view_feature_tracks_.find(view_it.first);
+      if (view_tracks_it == view_feature_tracks_.end())
+        continue;
+      for (const auto & feat_track : view_tracks_it->second) // {FeatureId, TrackId}
+        new_pose_track_ids.insert(feat_track.second);
+    }
+
+    for (const IndexT track_id : new_pose_track_ids)
+    {
+      const auto rejected_it = rejected_tracks_.find(track_id);
+      if (rejected_it != rejected_tracks_.end())
+      {
+        if (posed_observation_count(track_id, pose_ids) <= rejected_it->second)
+          continue;
+        rejected_tracks_.erase(rejected_it);
+      }
+      landmarks_to_triangulate.insert(*landmarks_.find(track_id));
+    }
+  }
 
   //--
   // Triangulation
   //--
+  // The tracks are triangulated in place of the structure (the kept
+  // landmarks are not moved in memory, so the persistent BA can reuse them).
+  std::vector<IndexT> track_ids_to_triangulate;
+  track_ids_to_triangulate.reserve(landmarks_to_triangulate.size());
+  for (const auto & landmark_it : landmarks_to_triangulate)
+    track_ids_to_triangulate.push_back(landmark_it.first);
+
+  Landmarks kept_structure;
+  std::swap(kept_structure, sfm_data_.structure);
+  std::swap(landmarks_to_triangulate, sfm_data_.structure);
+
   // Clean the structure:
   //  - keep observations that are linked to valid pose and intrinsic data.
 
@@ -284,6 +407,41 @@ bool SequentialSfMReconstructionEngine2::Triangulation()
 
   triangulation_engine.triangulate(sfm_data_);
 
+  // Merge the new triangulations with the kept landmarks
+  std::swap(landmarks_to_triangulate, sfm_data_.structure);
+  std::swap(kept_structure, sfm_data_.structure);
+  if (b_full_triangulation)
+  {
+    sfm_data_.structure.clear();
+    triangulated_track_ids_.clear();
+  }
+  for (const IndexT track_id : track_ids_to_triangulate)
+  {
+    sfm_data_.structure.erase(track_id);
+    triangulated_track_ids_.erase(track_id);
+  }
+  for (auto & landmark_it : landmarks_to_triangulate)
+  {
+    triangulated_track_ids_.insert(landmark_it.first);
+    sfm_data_.structure.insert(std::move(landmark_it));
+  }
+  // The tracks that cannot be triangulated are rejected
+  for (const IndexT track_id : track_ids_to_triangulate)
+  {
+    if (triangulated_track_ids_.count(track_id) == 0)
+      rejected_tracks_[track_id] = posed_observation_count(track_id, pose_ids);
+  }
+
+  triangulated_pose_ids_.clear();
+  for (const auto & pose_it : sfm_data_.GetPoses())
+    triangulated_pose_ids_.insert(pose_it.first);
+
+  std::cout
+    << "Triangulation: " << landmarks_to_triangulate.size()
+    << " landmarks triangulated from "
+    << track_ids_to_triangulate.size() << " updated tracks, "
+    << sfm_data_.structure.size() << " landmarks in the scene." << std::endl;
+
   return !sfm_data_.structure.empty();
 }
 
@@ -296,207 +454,219 @@ bool SequentialSfMReconstructionEngine2::AddingMissingView
     return false;
 
   // Collect the views that does not have any 3D pose
-  const std::set<IndexT> view_with_no_pose = [&]
+  const std::vector<IndexT> view_with_no_pose = [&]
   {
-    std::set<IndexT> idx;
+    std::vector<IndexT> idx;
     for (const auto & view_it : sfm_data_.GetViews())
     {
       const View * v = view_it.second.get();
       const IndexT id_pose = v->id_pose;
       if (sfm_data_.GetPoses().count(id_pose) == 0)
-        idx.insert(view_it.first);
+        idx.push_back(view_it.first);
     }
     return idx;
   }();
 
   const IndexT pose_before = sfm_data_.GetPoses().size();
 
-  // Get the track ids of the reconstructed landmarks
-  const std::vector<IndexT> reconstructed_trackId = [&]
-  {
-    std::vector<IndexT> tracks_ids;
-    tracks_ids.reserve(sfm_data_.GetLandmarks().size());
-    std::transform(sfm_data_.GetLandmarks().cbegin(), sfm_data_.GetLandmarks().cend(),
-      std::back_inserter(tracks_ids),
-      stl::RetrieveKey());
-    std::sort(tracks_ids.begin(), tracks_ids.end());
-    return tracks_ids;
-  }();
-
-  // List the view that have a sufficient 2D-3D coverage for robust pose estimation
-#pragma omp parallel
-  for (const auto & view_id : view_with_no_pose)
+  // Resection result of a candidate view
+  struct Resection_Result
   {
+    bool b_valid = false;
+    geometry::Pose3 pose;
+    // The intrinsic estimated from the projection matrix (if the view had none)
+    std::shared_ptr<cameras::IntrinsicBase> new_intrinsic;
+    std::ostringstream log;
+  };
+  std::vector<Resection_Result> resection_results(view_with_no_pose.size());
+
+  // Try to localize the views that have a sufficient 2D-3D coverage
+  // (each candidate view writes in its own result slot, so the scene is only
+  //  updated once all the candidates are processed)
 #ifdef OPENMVG_USE_OPENMP
-  #pragma omp single nowait
+  #pragma omp parallel for schedule(dynamic)
 #endif
+  for (int i = 0; i < static_cast<int>(view_with_no_pose.size()); ++i)
+  {
+    const IndexT view_id = view_with_no_pose[i];
+    Resection_Result & result = resection_results[i];
+
+    // Collect the 2D-3D correspondences: the view features that belong to a
+    // reconstructed track
+    std::vector<const Landmark *> landmark_for_resection;
+    std::vector<IndexT> feature_id_for_resection;
+    size_t view_track_count = 0;
+    const auto view_tracks_it = view_feature_tracks_.find(view_id);
+    if (view_tracks_it != view_feature_tracks_.end())
     {
-      // List the track related to the current view_id
-      openMVG::tracks::STLMAPTracks view_tracks;
-      shared_track_visibility_helper_->GetTracksInImages({view_id}, view_tracks);
-      std::set<IndexT> view_tracks_ids;
-      tracks::TracksUtilsMap::GetTracksIdVector(view_tracks, &view_tracks_ids);
-
-      // Get the ids of the already reconstructed tracks
-      const std::set<IndexT> track_id_for_resection = [&]
-      {
-        std::set<IndexT> track_id;
-        std::set_intersection(view_tracks_ids.cbegin(), view_tracks_ids.cend(),
-          reconstructed_trackId.cbegin(), reconstructed_trackId.cend(),
-          std::inserter(track_id, track_id.begin()));
-        return track_id;
-      }();
-
-      const double track_ratio = track_id_for_resection.size() / static_cast<float>(view_tracks_ids.size() + 1);
-      std::cout
-        << "ViewId: " << view_id
-        << "; #number of 2D-3D matches: " << track_id_for_resection.size()
-        << "; " << track_ratio * 100 << " % of the view track coverage."
-        << std::endl;
-
-      if (!track_id_for_resection.empty() && track_ratio > track_inlier_ratio)
+      view_track_count = view_tracks_it->second.size();
+      for (const auto & feat_track : view_tracks_it->second) // {FeatureId, TrackId}
       {
-        // Get feat_id for the 2D/3D associations
-        std::vector<IndexT> feature_id_for_resection;
-        tracks::TracksUtilsMap::GetFeatIndexPerViewAndTrackId(
-          view_tracks,
-          track_id_for_resection,
-          view_id,
-          &feature_id_for_resection);
-
-        // Localize the image inside the SfM reconstruction
-        Image_Localizer_Match_Data resection_data;
-        resection_data.pt2D.resize(2, track_id_for_resection.size());
-        resection_data.pt3D.resize(3, track_id_for_resection.size());
-
-        // Look if the intrinsic data is known or not
-        const View * view = sfm_data_.GetViews().at(view_id).get();
-        std::shared_ptr<cameras::IntrinsicBase> intrinsic;
-        if (sfm_data_.GetIntrinsics().count(view->id_intrinsic))
+        const auto landmark_it = sfm_data_.GetLandmarks().find(feat_track.second);
+        if (landmark_it != sfm_data_.GetLandmarks().end())
         {
-          intrinsic = sfm_data_.GetIntrinsics().at(view->id_intrinsic);
+          landmark_for_resection.push_back(&landmark_it->second);
+          feature_id_for_resection.push_back(feat_track.first);
         }
+      }
+    }
 
-        // Collect the feature observation
-        Mat2X pt2D_original(2, track_id_for_resection.size());
-        auto track_it = track_id_for_resection.cbegin();
-        auto feat_it = feature_id_for_resection.cbegin();
-        for (size_t cpt = 0; cpt < track_id_for_resection.size(); ++cpt, ++track_it, ++feat_it)
-        {
-          resection_data.pt3D.col(cpt) = sfm_data_.GetLandmarks().at(*track_it).X;
-          resection_data.pt2D.col(cpt) = pt2D_original.col(cpt) =
-            features_provider_->feats_per_view.at(view_id)[*feat_it].coords().cast<double>();
-          // Handle image distortion if intrinsic is known (to ease the resection)
-          if (intrinsic && intrinsic->have_disto())
-          {
-            resection_data.pt2D.col(cpt) = intrinsic->get_ud_pixel(resection_data.pt2D.col(cpt));
-          }
-        }
+    const double track_ratio = feature_id_for_resection.size() / static_cast<float>(view_track_count + 1);
+    result.log
+      << "ViewId: " << view_id
+      << "; #number of 2D-3D matches: " << feature_id_for_resection.size()
+      << "; " << track_ratio * 100 << " % of the view track coverage."
+      << std::endl;
+
+    if (feature_id_for_resection.empty() || track_ratio <= track_inlier_ratio)
+      continue;
+
+    // Localize the image inside the SfM reconstruction
+    Image_Localizer_Match_Data resection_data;
+    resection_data.pt2D.resize(2, feature_id_for_resection.size());
+    resection_data.pt3D.resize(3, feature_id_for_resection.size());
+
+    // Look if the intrinsic data is known or not
+    const View * view = sfm_data_.GetViews().at(view_id).get();
+    std::shared_ptr<cameras::IntrinsicBase> intrinsic;
+    if (sfm_data_.GetIntrinsics().count(view->id_intrinsic))
+    {
+      intrinsic = sfm_data_.GetIntrinsics().at(view->id_intrinsic);
+    }
 
-        geometry::Pose3 pose;
-        const bool bResection = sfm::SfM_Localizer::Localize
-        (
-          intrinsic ? resection_method_ : resection::SolverType::DLT_6POINTS,
-          {view->ui_width, view->ui_height},
-          intrinsic ? intrinsic.get() : nullptr,
-          resection_data,
-          pose
-        );
-        resection_data.pt2D = std::move(pt2D_original); // restore original image domain points
-
-        const float inlier_ratio = resection_data.vec_inliers.size()/static_cast<float>(feature_id_for_resection.size());
-        std::cout
-          << std::endl
-          << "-------------------------------" << "\n"
-          << "-- Robust Resection of camera index: <" << view_id << "> image: "
-          <<  view->s_Img_path <<"\n"
-          << "-- Threshold: " << resection_data.error_max << "\n"
-          << "-- Resection status: " << (bResection ? "OK" : "FAILED") << "\n"
-          << "-- Nb points used for Resection: " << feature_id_for_resection.size() << "\n"
-          << "-- Nb points validated by robust estimation: " << resection_data.vec_inliers.size() << "\n"
-          << "-- % points validated: "
-          << inlier_ratio * 100 << "\n"
-          << "-------------------------------" << std::endl;
-
-        // Refine the pose of the found camera pose by using a BA and fix 3D points.
-        if (bResection && inlier_ratio > 0.5)
+    // Collect the feature observation
+    const auto view_features = features_provider_->get(view_id);
+    if (!view_features)
+    {
+      result.log << "Cannot load the features of the view: " << view_id << std::endl;
+      continue;
+    }
+    Mat2X pt2D_original(2, feature_id_for_resection.size());
+    for (size_t cpt = 0; cpt < feature_id_for_resection.size(); ++cpt)
+    {
+      resection_data.pt3D.col(cpt) = landmark_for_resection[cpt]->X;
+      resection_data.pt2D.col(cpt) = pt2D_original.col(cpt) =
+        (*view_features)[feature_id_for_resection[cpt]].coords().cast<double>();
+      // Handle image distortion if intrinsic is known (to ease the resection)
+      if (intrinsic && intrinsic->have_disto())
+      {
+        resection_data.pt2D.col(cpt) = intrinsic->get_ud_pixel(resection_data.pt2D.col(cpt));
+      }
+    }
+
+    geometry::Pose3 pose;
+    const bool bResection = sfm::SfM_Localizer::Localize
+    (
+      intrinsic ? resection_method_ : resection::SolverType::DLT_6POINTS,
+      {view->ui_width, view->ui_height},
+      intrinsic ? intrinsic.get() : nullptr,
+      resection_data,
+      pose
+    );
+    resection_data.pt2D = std::move(pt2D_original); // restore original image domain points
+
+    const float inlier_ratio = resection_data.vec_inliers.size()/static_cast<float>(feature_id_for_resection.size());
+    result.log
+      << std::endl
+      << "-------------------------------" << "\n"
+      << "-- Robust Resection of camera index: <" << view_id << "> image: "
+      <<  view->s_Img_path <<"\n"
+      << "-- Threshold: " << resection_data.error_max << "\n"
+      << "-- Resection status: " << (bResection ? "OK" : "FAILED") << "\n"
+      << "-- Nb points used for Resection: " << feature_id_for_resection.size() << "\n"
+      << "-- Nb points validated by robust estimation: " << resection_data.vec_inliers.size() << "\n"
+      << "-- % points validated: "
+      << inlier_ratio * 100 << "\n"
+      << "-------------------------------" << std::endl;
+
+    // Refine the pose of the found camera pose by using a BA and fix 3D points.
+    if (bResection && inlier_ratio > 0.5)
+    {
+      // A valid pose has been found (try to refine it):
+      // If no valid intrinsic as input:
+      //  init a new one from the projection matrix decomposition
+      // Else use the existing one and consider it as constant.
+      if (!intrinsic)
+      {
+        // setup a default camera model from the found projection matrix
+        Mat3 K, R;
+        Vec3 t;
+        KRt_From_P(resection_data.projection_matrix, &K, &R, &t);
+
+        const double focal = (K(0,0) + K(1,1))/2.0;
+        const Vec2 principal_point(K(0,2), K(1,2));
+
+        // Create the new camera intrinsic
+        switch (cam_type_)
         {
-          // A valid pose has been found (try to refine it):
-          // If no valid intrinsic as input:
-          //  init a new one from the projection matrix decomposition
-          // Else use the existing one and consider it as constant.
-          if (!intrinsic)
-          {
-            // setup a default camera model from the found projection matrix
-            Mat3 K, R;
-            Vec3 t;
-            KRt_From_P(resection_data.projection_matrix, &K, &R, &t);
-
-            const double focal = (K(0,0) + K(1,1))/2.0;
-            const Vec2 principal_point(K(0,2), K(1,2));
-
-            // Create the new camera intrinsic
-            switch (cam_type_)
-            {
-              case PINHOLE_CAMERA:
-                intrinsic = std::make_shared<Pinhole_Intrinsic>
-                  (view->ui_width, view->ui_height, focal, principal_point(0), principal_point(1));
-              break;
-              case PINHOLE_CAMERA_RADIAL1:
-                intrinsic = std::make_shared<Pinhole_Intrinsic_Radial_K1>
-                  (view->ui_width, view->ui_height, focal, principal_point(0), principal_point(1));
-              break;
-              case PINHOLE_CAMERA_RADIAL3:
-                intrinsic = std::make_shared<Pinhole_Intrinsic_Radial_K3>
-                  (view->ui_width, view->ui_height, focal, principal_point(0), principal_point(1));
-              break;
-              case PINHOLE_CAMERA_BROWN:
-                intrinsic = std::make_shared<Pinhole_Intrinsic_Brown_T2>
-                  (view->ui_width, view->ui_height, focal, principal_point(0), principal_point(1));
-              break;
-              case PINHOLE_CAMERA_FISHEYE:
-                intrinsic = std::make_shared<Pinhole_Intrinsic_Fisheye>
-                  (view->ui_width, view->ui_height, focal, principal_point(0), principal_point(1));
-              break;
-              default:
-                std::cerr << "Try to create an unknown camera type." << std::endl;
-            }
-          }
-          const bool b_refine_pose = true;
-          const bool b_refine_intrinsics = false;
-          if (intrinsic && sfm::SfM_Localizer::RefinePose(
-              intrinsic.get(), pose,
-              resection_data, b_refine_pose, b_refine_intrinsics))
-          {
-            // - intrinsic parameters (if the view has no intrinsic group add a new one)
-            if (sfm_data_.intrinsics.count(sfm_data_.views.at(view_id)->id_intrinsic) == 0)
-            {
-              // Since the view have not yet an intrinsic group before, create a new one
-              IndexT new_intrinsic_id = 0;
-              if (!sfm_data_.GetIntrinsics().empty())
-              {
-                // Since some intrinsic Id already exists,
-                //  we have to create a new unique identifier following the existing one
-                std::set<IndexT> existing_intrinsic_id;
-                  std::transform(sfm_data_.GetIntrinsics().cbegin(), sfm_data_.GetIntrinsics().cend(),
-                  std::inserter(existing_intrinsic_id, existing_intrinsic_id.begin()),
-                  stl::RetrieveKey());
-                new_intrinsic_id = (*existing_intrinsic_id.rbegin()) + 1;
-              }
-              #pragma omp critical
-              {
-                sfm_data_.views.at(view_id)->id_intrinsic = new_intrinsic_id;
-                sfm_data_.intrinsics[new_intrinsic_id] = intrinsic;
-              }
-            }
-
-            // Update the found camera pose
-            #pragma omp critical
-            sfm_data_.poses[view->id_pose] = pose;
-          }
+          case PINHOLE_CAMERA:
+            intrinsic = std::make_shared<Pinhole_Intrinsic>
+              (view->ui_width, view->ui_height, focal, principal_point(0), principal_point(1));
+          break;
+          case PINHOLE_CAMERA_RADIAL1:
+            intrinsic = std::make_shared<Pinhole_Intrinsic_Radial_K1>
+              (view->ui_width, view->ui_height, focal, principal_point(0), principal_point(1));
+          break;
+          case PINHOLE_CAMERA_RADIAL3:
+            intrinsic = std::make_shared<Pinhole_Intrinsic_Radial_K3>
+              (view->ui_width, view->ui_height, focal, principal_point(0), principal_point(1));
+          break;
+          case PINHOLE_CAMERA_BROWN:
+            intrinsic = std::make_shared<Pinhole_Intrinsic_Brown_T2>
+              (view->ui_width, view->ui_height, focal, principal_point(0), principal_point(1));
+          break;
+          case PINHOLE_CAMERA_FISHEYE:
+            intrinsic = std::make_shared<Pinhole_Intrinsic_Fisheye>
+              (view->ui_width, view->ui_height, focal, principal_point(0), principal_point(1));
+          break;
+          default:
+            result.log << "Try to create an unknown camera type." << std::endl;
         }
+        result.new_intrinsic = intrinsic;
       }
+      const bool b_refine_pose = true;
+      const bool b_refine_intrinsics = false;
+      if (intrinsic && sfm::SfM_Localizer::RefinePose(
+          intrinsic.get(), pose,
+          resection_data, b_refine_pose, b_refine_intrinsics))
+      {
+        result.b_valid = true;
+        result.pose = pose;
+      }
+    }
+  }
+
+  // Update the scene with the localized views (in the candidate order)
+  for (size_t i = 0; i < view_with_no_pose.size(); ++i)
+  {
+    const IndexT view_id = view_with_no_pose[i];
+    const Resection_Result & result = resection_results[i];
+    std::cout << result.log.str();
+    if (!result.b_valid)
+      continue;
+
+    View * view = sfm_data_.views.at(view_id).get();
+    // - intrinsic parameters (if the view has no intrinsic group add a new one)
+    if (result.new_intrinsic && sfm_data_.intrinsics.count(view->id_intrinsic) == 0)
+    {
+      // Since the view have not yet an intrinsic group before, create a new one
+      IndexT new_intrinsic_id = 0;
+      if (!sfm_data_.GetIntrinsics().empty())
+      {
+        // Since some intrinsic Id already exists,
+        //  we have to create a new unique identifier following the existing one
+        std::set<IndexT> existing_intrinsic_id;
+          std::transform(sfm_data_.GetIntrinsics().cbegin(), sfm_data_.GetIntrinsics().cend(),
+          std::inserter(existing_intrinsic_id, existing_intrinsic_id.begin()),
+          stl::RetrieveKey());
+        new_intrinsic_id = (*existing_intrinsic_id.rbegin()) + 1;
+      }
+      view->id_intrinsic = new_intrinsic_id;
+      sfm_data_.intrinsics[new_intrinsic_id] = result.new_intrinsic;
     }
+
+    // Update the found camera pose
+    sfm_data_.poses[view->id_pose] = result.pose;
   }
 
   const IndexT pose_after = sfm_data_.GetPoses().size();
@@ -520,7 +690,11 @@ bool SequentialSfMReconstructionEngine2::BundleAdjustment()
   {
     options.linear_solver_type_ = ceres::DENSE_SCHUR;
   }
-  Bundle_Adjustment_Ceres bundle_adjustment_obj(options);
+  // Reuse the problem built by the previous calls (only the scene changes are added)
+  if (!bundle_adjustment_)
+    bundle_adjustment_.reset(new Bundle_Adjustment_Ceres_Persistent(options));
+  else
+    bundle_adjustment_->ceres_options() = options;
   const Optimize_Options ba_refine_options
     ( ReconstructionEngine::intrinsic_refinement_options_,
       Extrinsic_Parameter_Type::ADJUST_ALL, // Adjust camera motion
@@ -528,7 +702,7 @@ bool SequentialSfMReconstructionEngine2::BundleAdjustment()
       Control_Point_Parameter(),
       this->b_use_motion_prior_
     );
-  return bundle_adjustment_obj.Adjust(sfm_data_, ba_refine_options);
+  return bundle_adjustment_->Adjust(sfm_data_, ba_refine_options);
 }
 
 } // namespace sfm
@@ -9,11 +9,14 @@
 #ifndef OPENMVG_SFM_LOCALIZATION_SEQUENTIAL2_SFM_HPP
 #define OPENMVG_SFM_LOCALIZATION_SEQUENTIAL2_SFM_HPP
 
+#include <memory>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "openMVG/sfm/pipelines/sfm_engine.hpp"
+#include "openMVG/sfm/pipelines/sfm_snapshot_writer.hpp"
 #include "openMVG/cameras/cameras.hpp"
 #include "openMVG/multiview/solver_resection.hpp"
 #include "openMVG/multiview/triangulation_method.hpp"
@@ -24,6 +27,7 @@ namespace htmlDocument { class htmlDocumentStream; }
 namespace openMVG {
 namespace sfm {
 
+class Bundle_Adjustment_Ceres_Persistent;
 struct Features_Provider;
 struct Matches_Provider;
 class SfMSceneInitializer;
@@ -51,6 +55,11 @@ public:
   bool InitTracksAndLandmarks();
 
   /// Triangulate tracks
+  /// Only the tracks observed by a new pose since the previous call are
+  /// triangulated (the other 3D points are kept as is), unless the full
+  /// triangulation is enabled (see SetFullTriangulation). A track rejected by
+  /// the triangulation or by the cleaning is retried only once it gained a
+  /// posed observation.
   bool Triangulation();
 
   /// Adding missing view (Try to find the pose of the missing camera)
@@ -59,6 +68,9 @@ public:
   /// Adjust intrinsics, landmark and extrinsics according the user config.
   bool BundleAdjustment();
 
+  /// Queue an intermediate scene export to the snapshot writer
+  void SaveSnapshot(const std::string & name, const bool b_force = false);
+
   /**
    * Set the default lens distortion type to use if it is declared unknown
    * in the intrinsics camera parameters by the previous steps.
@@ -82,6 +94,19 @@ public:
     resection_method_ = method;
   }
 
+  /// Re-triangulate every track at every round (i.e. to validate the
+  /// incremental triangulation)
+  void SetFullTriangulation(const bool b_full_triangulation)
+  {
+    b_full_triangulation_ = b_full_triangulation;
+  }
+
+  /// Configure the intermediate scene snapshots (written in a background thread)
+  void SetSnapshotOptions(const Snapshot_Options & options)
+  {
+    snapshot_options_ = options;
+  }
+
 private:
 
   //----
@@ -106,13 +131,28 @@ private:
   Landmarks landmarks_;
   /// Tracking (used to build landmark visibility and compute 2D-3D visibility)
   openMVG::tracks::STLMAPTracks map_tracks_;
-  /// Helper to compute fast 2D-3D visibility
-  std::unique_ptr<openMVG::tracks::SharedTrackVisibilityHelper> shared_track_visibility_helper_;
+  /// Per view {FeatureId, TrackId} lookup (used to compute fast 2D-3D visibility)
+  Hash_Map<IndexT, std::vector<std::pair<IndexT, IndexT>>> view_feature_tracks_;
+
+  /// Bundle adjustment problem kept alive between the resection rounds
+  std::unique_ptr<Bundle_Adjustment_Ceres_Persistent> bundle_adjustment_;
 
   /// 2View triangulation method used in the robust triangulation engine
   ETriangulationMethod triangulation_method_ = ETriangulationMethod::DEFAULT;
 
   resection::SolverType resection_method_ = resection::SolverType::DEFAULT;
+
+  //-- Incremental triangulation
+  bool b_full_triangulation_ = false;
+  /// Poses used by the previous triangulation
+  std::set<IndexT> triangulated_pose_ids_;
+  /// Landmarks added to the structure by the previous triangulations
+  std::set<IndexT> triangulated_track_ids_;
+  /// Rejected tracks and their posed observation count at the rejection
+  Hash_Map<IndexT, IndexT> rejected_tracks_;
+
+  Snapshot_Options snapshot_options_;
+  std::unique_ptr<SfM_Data_Snapshot_Writer> snapshot_writer_;
 };
 
 } // namespace sfm
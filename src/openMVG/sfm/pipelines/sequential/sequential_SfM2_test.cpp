@@ -20,10 +20,14 @@
 
 #include "openMVG/sfm/pipelines/pipelines_test.hpp"
 
+#include "openMVG/geometry/rigid_transformation3D_srt.hpp"
+#include "openMVG/matching/indMatch_store.hpp"
 #include "openMVG/sfm/pipelines/sequential/sequential_SfM2.hpp"
 #include "openMVG/sfm/pipelines/sequential/SfmSceneInitializerMaxPair.hpp"
 #include "openMVG/sfm/pipelines/sequential/SfmSceneInitializerStellar.hpp"
 
+#include "openMVG/sfm/pipelines/sfm_matches_provider_store.hpp"
+
 #include "testing/testing.h"
 
 #include <cmath>
@@ -91,6 +95,169 @@ TEST(SEQUENTIAL_SFM2_STELLAR, Known_Intrinsics) {
   EXPECT_TRUE( IsTracksOneCC(sfmEngine.Get_SfM_Data()));
 }
 
+// Test a scene where the matches are read on demand from an indexed match file
+TEST(SEQUENTIAL_SFM2_STELLAR, Known_Intrinsics_Matches_Store) {
+
+  const int nviews = 6;
+  const int npoints = 32;
+  const nViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfM_Data scene
+  const SfM_Data sfm_data = getInputScene(d, config, PINHOLE_CAMERA);
+
+  // Remove poses and structure
+  SfM_Data sfm_data_2 = sfm_data;
+  sfm_data_2.poses.clear();
+  sfm_data_2.structure.clear();
+
+  std::shared_ptr<Features_Provider> feats_provider =
+    std::make_shared<Synthetic_Features_Provider>();
+  std::normal_distribution<double> distribution(0.0, 0.5);
+  dynamic_cast<Synthetic_Features_Provider*>(feats_provider.get())->load(d,distribution);
+
+  // Save the synthetic matches as an indexed match file
+  Synthetic_Matches_Provider synthetic_matches;
+  synthetic_matches.load(d);
+  const std::string sMatchesFile = "sequential_sfm2_matches.mstore";
+  EXPECT_TRUE(matching::Save_Matches_Store(synthetic_matches.pairWise_matches_, sMatchesFile));
+
+  std::shared_ptr<Matches_Provider> matches_provider =
+    std::make_shared<Matches_Provider_Store>();
+  EXPECT_TRUE(matches_provider->load(sfm_data_2, sMatchesFile));
+
+  // Only the index is resident: the matches are decoded on demand
+  EXPECT_TRUE(matches_provider->pairWise_matches_.empty());
+  EXPECT_EQ(synthetic_matches.pairWise_matches_.size(), matches_provider->getPairs().size());
+  for (const auto & matches_it : synthetic_matches.pairWise_matches_)
+  {
+    matching::IndMatches buffer;
+    const matching::IndMatches * matches =
+      matches_provider->getMatches(matches_it.first, buffer);
+    EXPECT_TRUE(matches != nullptr);
+    EXPECT_TRUE(*matches == matches_it.second);
+    EXPECT_EQ(matches_it.second.size(), matches_provider->getMatchCount(matches_it.first));
+  }
+
+  std::unique_ptr<SfMSceneInitializer> scene_initializer;
+  scene_initializer.reset(new SfMSceneInitializerStellar(sfm_data_2,
+    feats_provider.get(),
+    matches_provider.get()));
+
+  SequentialSfMReconstructionEngine2 sfmEngine(
+    scene_initializer.get(),
+    sfm_data_2,
+    "./",
+    stlplus::create_filespec("./", "Reconstruction_Report.html"));
+
+  sfmEngine.SetFeaturesProvider(feats_provider.get());
+  sfmEngine.SetMatchesProvider(matches_provider.get());
+  sfmEngine.Set_Intrinsics_Refinement_Type(cameras::Intrinsic_Parameter_Type::NONE);
+
+  EXPECT_TRUE (sfmEngine.Process());
+  EXPECT_TRUE(matches_provider->pairWise_matches_.empty());
+
+  const double dResidual = RMSE(sfmEngine.Get_SfM_Data());
+  std::cout << "RMSE residual: " << dResidual << std::endl;
+  EXPECT_TRUE( dResidual < 0.5);
+  EXPECT_TRUE( sfmEngine.Get_SfM_Data().GetPoses().size() == nviews);
+  EXPECT_TRUE( sfmEngine.Get_SfM_Data().GetLandmarks().size() == npoints);
+  EXPECT_TRUE( IsTracksOneCC(sfmEngine.Get_SfM_Data()));
+
+  std::remove(sMatchesFile.c_str());
+}
+
+// The incremental triangulation must give the same structure as the
+// triangulation of all the tracks at every resection round
+TEST(SEQUENTIAL_SFM2_STELLAR, Incremental_Triangulation) {
+
+  const int nviews = 12;
+  const int npoints = 192;
+  const nViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfM_Data scene
+  const SfM_Data sfm_data = getInputScene(d, config, PINHOLE_CAMERA);
+
+  // Remove poses and structure
+  SfM_Data sfm_data_2 = sfm_data;
+  sfm_data_2.poses.clear();
+  sfm_data_2.structure.clear();
+
+  std::shared_ptr<Features_Provider> feats_provider =
+    std::make_shared<Synthetic_Features_Provider>();
+  std::normal_distribution<double> distribution(0.0, 0.5);
+  dynamic_cast<Synthetic_Features_Provider*>(feats_provider.get())->load(d,distribution);
+
+  // Each point is matched in 5 consecutive views only, so a resection round
+  // extends some tracks and leaves the others unchanged
+  std::shared_ptr<Matches_Provider> matches_provider =
+    std::make_shared<Synthetic_Matches_Provider>();
+  for (IndexT point = 0; point < npoints; ++point)
+  {
+    for (IndexT k = 0; k < 4; ++k)
+    {
+      for (IndexT kk = k + 1; kk < 5; ++kk)
+      {
+        const IndexT view_a = (point + k) % nviews, view_b = (point + kk) % nviews;
+        matches_provider->pairWise_matches_[
+          Pair(std::min(view_a, view_b), std::max(view_a, view_b))].emplace_back(point, point);
+      }
+    }
+  }
+
+  // Run the reconstruction with the incremental and the full triangulation
+  std::vector<SfM_Data> reconstructions;
+  for (const bool b_full_triangulation : {false, true})
+  {
+    SfMSceneInitializerStellar scene_initializer(sfm_data_2,
+      feats_provider.get(),
+      matches_provider.get());
+
+    SequentialSfMReconstructionEngine2 sfmEngine(
+      &scene_initializer,
+      sfm_data_2,
+      "./",
+      stlplus::create_filespec("./", "Reconstruction_Report.html"));
+
+    sfmEngine.SetFeaturesProvider(feats_provider.get());
+    sfmEngine.SetMatchesProvider(matches_provider.get());
+    sfmEngine.Set_Intrinsics_Refinement_Type(cameras::Intrinsic_Parameter_Type::NONE);
+    sfmEngine.SetFullTriangulation(b_full_triangulation);
+
+    EXPECT_TRUE (sfmEngine.Process());
+    reconstructions.push_back(sfmEngine.Get_SfM_Data());
+  }
+
+  // Same landmarks & observations
+  const SfM_Data & incremental = reconstructions[0], & full = reconstructions[1];
+  EXPECT_EQ(nviews, incremental.GetPoses().size());
+  EXPECT_EQ(full.GetPoses().size(), incremental.GetPoses().size());
+  EXPECT_EQ(full.GetLandmarks().size(), incremental.GetLandmarks().size());
+  Mat3X points(3, full.GetLandmarks().size()), points_full(3, full.GetLandmarks().size());
+  Mat::Index i = 0;
+  for (const auto & landmark_it : full.GetLandmarks())
+  {
+    const auto incremental_it = incremental.GetLandmarks().find(landmark_it.first);
+    EXPECT_TRUE(incremental_it != incremental.GetLandmarks().end());
+    EXPECT_EQ(landmark_it.second.obs.size(), incremental_it->second.obs.size());
+    points.col(i) = incremental_it->second.X;
+    points_full.col(i) = landmark_it.second.X;
+    ++i;
+  }
+
+  // Same geometry up to the gauge & the BA convergence
+  double S;
+  Vec3 t;
+  Mat3 R;
+  EXPECT_TRUE(geometry::FindRTS(points, points_full, &S, &t, &R));
+  for (i = 0; i < points.cols(); ++i)
+  {
+    const Vec3 point = S * R * points.col(i) + t;
+    EXPECT_MATRIX_NEAR(points_full.col(i), point, 1e-5);
+  }
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
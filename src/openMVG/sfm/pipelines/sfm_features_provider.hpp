@@ -9,8 +9,10 @@
 #ifndef OPENMVG_SFM_SFM_FEATURES_PROVIDER_HPP
 #define OPENMVG_SFM_SFM_FEATURES_PROVIDER_HPP
 
+#include <atomic>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "openMVG/features/feature.hpp"
 #include "openMVG/features/feature_container.hpp"
@@ -26,6 +28,8 @@ namespace sfm {
 
 /// Abstract PointFeature provider (read some feature and store them as PointFeature).
 /// Allow to load and return the features related to a view
+/// (all the view features are loaded in memory, see Features_Provider_Cache
+///  for an on demand loading).
 struct Features_Provider
 {
   /// PointFeature array per ViewId of the considered SfM_Data container
@@ -38,46 +42,65 @@ struct Features_Provider
     const std::string & feat_directory,
     std::unique_ptr<features::Regions>& region_type)
   {
-    C_Progress_display my_progress_bar( sfm_data.GetViews().size(),
+    // Create the feature slot of each view (filled concurrently below)
+    std::vector<const View *> views;
+    std::vector<features::PointFeatures *> view_features;
+    views.reserve(sfm_data.GetViews().size());
+    view_features.reserve(sfm_data.GetViews().size());
+    for (const auto & view_it : sfm_data.GetViews())
+    {
+      views.push_back(view_it.second.get());
+      view_features.push_back(&feats_per_view[view_it.second->id_view]);
+    }
+
+    C_Progress_display my_progress_bar( views.size(),
       std::cout, "\n- Features Loading -\n" );
     // Read for each view the corresponding features and store them as PointFeatures
-    bool bContinue = true;
+    std::atomic<bool> bContinue(true);
 #ifdef OPENMVG_USE_OPENMP
-    #pragma omp parallel
+    #pragma omp parallel for schedule(dynamic)
 #endif
-    for (Views::const_iterator iter = sfm_data.GetViews().begin();
-      iter != sfm_data.GetViews().end() && bContinue; ++iter)
+    for (int i = 0; i < static_cast<int>(views.size()); ++i)
     {
-#ifdef OPENMVG_USE_OPENMP
-    #pragma omp single nowait
-#endif
+      if (!bContinue)
+        continue;
+
+      const std::string sImageName = stlplus::create_filespec(sfm_data.s_root_path, views[i]->s_Img_path);
+      const std::string basename = stlplus::basename_part(sImageName);
+      const std::string featFile = stlplus::create_filespec(feat_directory, basename, ".feat");
+
+      std::unique_ptr<features::Regions> regions(region_type->EmptyClone());
+      if (!stlplus::file_exists(featFile) || !regions->LoadFeatures(featFile))
       {
-        const std::string sImageName = stlplus::create_filespec(sfm_data.s_root_path, iter->second->s_Img_path);
-        const std::string basename = stlplus::basename_part(sImageName);
-        const std::string featFile = stlplus::create_filespec(feat_directory, basename, ".feat");
-
-        std::unique_ptr<features::Regions> regions(region_type->EmptyClone());
-        if (!stlplus::file_exists(featFile) || !regions->LoadFeatures(featFile))
-        {
-          std::cerr << "Invalid feature files for the view: " << sImageName << std::endl;
-#ifdef OPENMVG_USE_OPENMP
-      #pragma omp critical
-#endif
-          bContinue = false;
-        }
-#ifdef OPENMVG_USE_OPENMP
-      #pragma omp critical
-#endif
-        {
-          // save loaded Features as PointFeature
-          feats_per_view[iter->second->id_view] = regions->GetRegionsPositions();
-        }
-        ++my_progress_bar;
+        std::cerr << "Invalid feature files for the view: " << sImageName << std::endl;
+        bContinue = false;
+        continue;
       }
+      // save loaded Features as PointFeature
+      *view_features[i] = regions->GetRegionsPositions();
+      ++my_progress_bar;
     }
     return bContinue;
   }
 
+  /// Return the PointFeatures of a view (an empty pointer if the view has no
+  ///  features). The returned pointer keeps the features alive while it is
+  ///  used: a provider can load and release the features on demand.
+  /// The engines access the features with this method: they can be used with
+  ///  a provider that does not fill feats_per_view.
+  virtual std::shared_ptr<const features::PointFeatures> get
+  (
+    const IndexT id_view
+  ) const
+  {
+    const auto it = feats_per_view.find(id_view);
+    if (it == feats_per_view.end())
+      return nullptr;
+    // Non owning pointer (the features are owned by feats_per_view)
+    return std::shared_ptr<const features::PointFeatures>(
+      std::shared_ptr<const features::PointFeatures>(), &it->second);
+  }
+
   /// Return the PointFeatures belonging to the View, if the view does not exist
   ///  it returns an empty PointFeature array.
   const features::PointFeatures & getFeatures(const IndexT & id_view) const
@@ -0,0 +1,171 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SFM_SFM_FEATURES_PROVIDER_CACHE_HPP
+#define OPENMVG_SFM_SFM_FEATURES_PROVIDER_CACHE_HPP
+
+#include "openMVG/sfm/pipelines/sfm_features_provider.hpp"
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace openMVG {
+namespace sfm {
+
+/// Features provider Cache
+/// The view features are loaded on demand (by get) and only a given count of
+/// views is kept in memory, the least recently used views are released first.
+/// Only the feature positions are stored (PointFeatures: float (x,y) arrays),
+/// the scale and orientation of the regions are not kept.
+///
+/// feats_per_view is not filled: use this provider with the engines that
+///  access the features with get (i.e. the sequential SfM v2 engine).
+/// The feature files are validated by load, get still returns an empty
+///  pointer if a file cannot be read later on (the engines check it).
+struct Features_Provider_Cache : public Features_Provider
+{
+public:
+
+  explicit Features_Provider_Cache
+  (
+    const unsigned int max_cache_size
+  ): Features_Provider(),
+     max_cache_size_(max_cache_size)
+  {
+  }
+
+  std::shared_ptr<const features::PointFeatures> get
+  (
+    const IndexT id_view
+  ) const override
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      const auto it = cache_.find(id_view);
+      if (it != cache_.end())
+      {
+        // Mark the view as the most recently used one
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return it->second->second;
+      }
+    }
+
+    // Load the resource linked to this ID (outside of the lock to allow
+    //  concurrent loading of different views)
+    const auto filename_it = map_id_string_.find(id_view);
+    if (filename_it == map_id_string_.end())
+      return nullptr;
+    std::unique_ptr<features::Regions> regions(region_type_->EmptyClone());
+    if (!stlplus::file_exists(filename_it->second) ||
+        !regions->LoadFeatures(filename_it->second))
+    {
+      std::cerr << "Invalid feature files for the view: " << id_view << std::endl;
+      return nullptr;
+    }
+    const std::shared_ptr<const features::PointFeatures> features =
+      std::make_shared<features::PointFeatures>(regions->GetRegionsPositions());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = cache_.find(id_view);
+    if (it != cache_.end()) // Loaded concurrently by another thread
+    {
+      lru_.splice(lru_.begin(), lru_, it->second);
+      return it->second->second;
+    }
+    lru_.emplace_front(id_view, features);
+    cache_[id_view] = lru_.begin();
+    // Release the least recently used views
+    // (the features that are still used are released by their last user)
+    while (lru_.size() > max_cache_size_)
+    {
+      cache_.erase(lru_.back().first);
+      lru_.pop_back();
+    }
+    return features;
+  }
+
+  // Initialize the features_provider_cache
+  // The feature files are validated (read once) as by the Features_Provider,
+  //  but no features are kept in memory.
+  bool load
+  (
+    const SfM_Data & sfm_data,
+    const std::string & feat_directory,
+    std::unique_ptr<features::Regions>& region_type
+  ) override
+  {
+    std::cout << "Initialization of the Features_Provider_Cache. #Elements in the cache: "<< max_cache_size_ << std::endl;
+
+    region_type_.reset(region_type->EmptyClone());
+
+    // Build an association table from view id to feature file
+    std::vector<const std::string *> filenames;
+    filenames.reserve(sfm_data.GetViews().size());
+    for (const auto & iterViews : sfm_data.GetViews())
+    {
+      const openMVG::IndexT id = iterViews.second->id_view;
+      assert( id == iterViews.first);
+      std::string & filename = map_id_string_[id];
+      filename = stlplus::create_filespec(feat_directory,
+        stlplus::basename_part(iterViews.second->s_Img_path), ".feat");
+      filenames.push_back(&filename);
+    }
+
+    C_Progress_display my_progress_bar( filenames.size(),
+      std::cout, "\n- Features Validation -\n" );
+    std::atomic<bool> bContinue(true);
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int i = 0; i < static_cast<int>(filenames.size()); ++i)
+    {
+      if (!bContinue)
+        continue;
+      std::unique_ptr<features::Regions> regions(region_type_->EmptyClone());
+      if (!stlplus::file_exists(*filenames[i]) || !regions->LoadFeatures(*filenames[i]))
+      {
+        std::cerr << "Invalid feature files: " << *filenames[i] << std::endl;
+        bContinue = false;
+        continue;
+      }
+      ++my_progress_bar;
+    }
+    return bContinue;
+  }
+
+  /// Return the number of views that are kept in memory
+  std::size_t size() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lru_.size();
+  }
+
+private:
+
+  using LRU_List =
+    std::list<std::pair<IndexT, std::shared_ptr<const features::PointFeatures>>>;
+
+  mutable std::mutex mutex_; // To deal with multithread concurrent access
+  mutable LRU_List lru_; // Cached features, most recently used first
+  mutable std::map<IndexT, LRU_List::iterator> cache_; // view id -> lru_ entry
+
+  std::unique_ptr<features::Regions> region_type_;
+  std::map<openMVG::IndexT, std::string> map_id_string_; // association of the view id & its feature file
+  const unsigned int max_cache_size_;
+
+}; // Features_Provider_Cache
+
+} // namespace sfm
+} // namespace openMVG
+
+#endif // OPENMVG_SFM_SFM_FEATURES_PROVIDER_CACHE_HPP
@@ -0,0 +1,132 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/features/regions_factory.hpp"
+#include "openMVG/sfm/pipelines/sfm_features_provider_cache.hpp"
+
+#include "testing/testing.h"
+
+#include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
+using namespace openMVG;
+using namespace openMVG::features;
+using namespace openMVG::sfm;
+
+// Create nb_views views, the feature files are written in feat_directory
+// (the view i has i+1 features, the feature j is at (i, j))
+SfM_Data MakeScene(const int nb_views, const std::string & feat_directory)
+{
+  SfM_Data sfm_data;
+  for (int i = 0; i < nb_views; ++i)
+  {
+    const std::string basename = "view_" + std::to_string(i);
+    sfm_data.views[i] = std::make_shared<View>(basename + ".jpg", i, 0, i, 100, 100);
+    SIFT_Regions regions;
+    for (int j = 0; j <= i; ++j)
+      regions.Features().emplace_back(i, j, 1.0f, 0.0f);
+    regions.Save(
+      stlplus::create_filespec(feat_directory, basename, ".feat"),
+      stlplus::create_filespec(feat_directory, basename, ".desc"));
+  }
+  return sfm_data;
+}
+
+TEST(Features_Provider_Cache, LoadOnDemand) {
+
+  const std::string feat_directory = "features_provider_cache_test";
+  stlplus::folder_create(feat_directory);
+  const int nb_views = 6;
+  const SfM_Data sfm_data = MakeScene(nb_views, feat_directory);
+
+  std::unique_ptr<Regions> regions_type(new SIFT_Regions);
+  Features_Provider_Cache features_provider(2);
+  EXPECT_TRUE(features_provider.load(sfm_data, feat_directory, regions_type));
+  // No features are loaded up front
+  EXPECT_EQ(0, features_provider.size());
+  EXPECT_TRUE(features_provider.feats_per_view.empty());
+
+  for (int i = 0; i < nb_views; ++i)
+  {
+    const auto features = features_provider.get(i);
+    EXPECT_TRUE(features != nullptr);
+    EXPECT_EQ(i + 1, features->size());
+    EXPECT_EQ(i, features->back().x());
+    EXPECT_EQ(i, features->back().y());
+    // Only the max_cache_size most recently used views are kept
+    EXPECT_TRUE(features_provider.size() <= 2);
+  }
+
+  // The features that are still used survive their removal from the cache
+  const auto features_0 = features_provider.get(0);
+  features_provider.get(1);
+  features_provider.get(2);
+  EXPECT_EQ(1, features_0->size());
+  EXPECT_EQ(2, features_provider.size());
+
+  // Unknown view
+  EXPECT_TRUE(features_provider.get(nb_views) == nullptr);
+
+  stlplus::folder_delete(feat_directory, true);
+}
+
+TEST(Features_Provider_Cache, InvalidFiles) {
+
+  const std::string feat_directory = "features_provider_cache_invalid_test";
+  stlplus::folder_create(feat_directory);
+  const int nb_views = 3;
+  const SfM_Data sfm_data = MakeScene(nb_views, feat_directory);
+  std::unique_ptr<Regions> regions_type(new SIFT_Regions);
+
+  // A missing feature file is reported by load
+  const std::string feat_file = stlplus::create_filespec(feat_directory, "view_1", ".feat");
+  stlplus::file_delete(feat_file);
+  {
+    Features_Provider_Cache features_provider(2);
+    EXPECT_FALSE(features_provider.load(sfm_data, feat_directory, regions_type));
+  }
+
+  // A file that disappears after load gives an empty pointer
+  MakeScene(nb_views, feat_directory);
+  {
+    Features_Provider_Cache features_provider(2);
+    EXPECT_TRUE(features_provider.load(sfm_data, feat_directory, regions_type));
+    stlplus::file_delete(feat_file);
+    EXPECT_TRUE(features_provider.get(0) != nullptr);
+    EXPECT_TRUE(features_provider.get(1) == nullptr);
+  }
+
+  stlplus::folder_delete(feat_directory, true);
+}
+
+TEST(Features_Provider, Get) {
+
+  const std::string feat_directory = "features_provider_test";
+  stlplus::folder_create(feat_directory);
+  const int nb_views = 4;
+  const SfM_Data sfm_data = MakeScene(nb_views, feat_directory);
+
+  std::unique_ptr<Regions> regions_type(new SIFT_Regions);
+  Features_Provider features_provider;
+  EXPECT_TRUE(features_provider.load(sfm_data, feat_directory, regions_type));
+  EXPECT_EQ(nb_views, features_provider.feats_per_view.size());
+
+  for (int i = 0; i < nb_views; ++i)
+  {
+    // get and feats_per_view give the same features
+    const auto features = features_provider.get(i);
+    EXPECT_TRUE(features.get() == &features_provider.feats_per_view.at(i));
+    EXPECT_EQ(i + 1, features->size());
+  }
+  EXPECT_TRUE(features_provider.get(nb_views) == nullptr);
+
+  stlplus::folder_delete(feat_directory, true);
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
@@ -9,6 +9,7 @@
 #ifndef OPENMVG_SFM_SFM_MATCHES_PROVIDER_HPP
 #define OPENMVG_SFM_SFM_MATCHES_PROVIDER_HPP
 
+#include <set>
 #include <string>
 
 #include "openMVG/matching/indMatch.hpp"
@@ -63,6 +64,40 @@ struct Matches_Provider
   {
     return matching::getPairs(pairWise_matches_);
   }
+
+  /// Return the matches of a pair (nullptr if the pair is unknown).
+  /// The matches kept in memory are returned without copy, a provider that
+  /// reads them on demand decodes them in buffer (the returned matches are
+  /// then valid as long as the buffer is left untouched).
+  /// Use this accessor (and not pairWise_matches_) to support every provider.
+  virtual const matching::IndMatches * getMatches
+  (
+    const Pair & pair,
+    matching::IndMatches & buffer
+  ) const
+  {
+    const auto it = pairWise_matches_.find(pair);
+    return (it == pairWise_matches_.end()) ? nullptr : &it->second;
+  }
+
+  /// Return the number of matches of a pair (0 if the pair is unknown)
+  virtual size_t getMatchCount(const Pair & pair) const
+  {
+    const auto it = pairWise_matches_.find(pair);
+    return (it == pairWise_matches_.end()) ? 0 : it->second.size();
+  }
+
+  /// Keep only the pairs whose two views are in view_ids
+  virtual void keepOnlyReferencedViews(const std::set<IndexT> & view_ids)
+  {
+    for (auto it = pairWise_matches_.begin(); it != pairWise_matches_.end();)
+    {
+      if (view_ids.count(it->first.first) && view_ids.count(it->first.second))
+        ++it;
+      else
+        it = pairWise_matches_.erase(it);
+    }
+  }
 }; // Features_Provider
 
 } // namespace sfm
@@ -0,0 +1,95 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SFM_SFM_MATCHES_PROVIDER_STORE_HPP
+#define OPENMVG_SFM_SFM_MATCHES_PROVIDER_STORE_HPP
+
+#include <iostream>
+#include <set>
+#include <string>
+
+#include "openMVG/matching/indMatch_store.hpp"
+#include "openMVG/sfm/pipelines/sfm_matches_provider.hpp"
+
+namespace openMVG {
+namespace sfm {
+
+/// Matches provider that reads an indexed match file (".mstore").
+/// Only the index of the file is kept in memory: the matches of a pair are
+/// decoded on demand by getMatches, from the memory mapped file.
+/// The match counts are read from the index without decoding the matches.
+/// pairWise_matches_ is left empty: use the getPairs, getMatches &
+/// getMatchCount accessors to read the matches.
+struct Matches_Provider_Store : public Matches_Provider
+{
+  // Open the indexed match file and list the pairs defined in SfM_Data
+  bool load(const SfM_Data & sfm_data, const std::string & matchesfile) override
+  {
+    pairWise_matches_.clear();
+    pairs_.clear();
+    if (!store_.Open(matchesfile))
+    {
+      std::cerr<< "Unable to read the indexed matches file:" << matchesfile << std::endl;
+      return false;
+    }
+    const Views & views = sfm_data.GetViews();
+    for (const auto & entry_it : store_.GetIndex())
+    {
+      if (views.count(entry_it.first.first) && views.count(entry_it.first.second))
+        pairs_.insert(pairs_.end(), entry_it.first);
+    }
+    return true;
+  }
+
+  Pair_Set getPairs() const override
+  {
+    return pairs_;
+  }
+
+  const matching::IndMatches * getMatches
+  (
+    const Pair & pair,
+    matching::IndMatches & buffer
+  ) const override
+  {
+    if (pairs_.count(pair) == 0)
+      return nullptr;
+    if (!store_.Get(pair, buffer))
+    {
+      std::cerr << "Invalid matches in the indexed matches file for the pair: ("
+        << pair.first << "," << pair.second << ")" << std::endl;
+      return nullptr;
+    }
+    return &buffer;
+  }
+
+  size_t getMatchCount(const Pair & pair) const override
+  {
+    return pairs_.count(pair) ? store_.MatchCount(pair) : 0;
+  }
+
+  void keepOnlyReferencedViews(const std::set<IndexT> & view_ids) override
+  {
+    for (auto it = pairs_.begin(); it != pairs_.end();)
+    {
+      if (view_ids.count(it->first) && view_ids.count(it->second))
+        ++it;
+      else
+        it = pairs_.erase(it);
+    }
+  }
+
+private:
+  matching::Matches_Store store_;
+  Pair_Set pairs_; // The pairs of the SfM_Data views
+}; // Matches_Provider_Store
+
+} // namespace sfm
+} // namespace openMVG
+
+#endif // OPENMVG_SFM_SFM_MATCHES_PROVIDER_STORE_HPP
@@ -63,7 +63,8 @@ bool robustRelativePose
     const auto ac_ransac_output = robust::ACRANSAC(
       kernel, relativePose_info.vec_inliers,
       max_iteration_count, &relativePose_info.essential_matrix,
-      relativePose_info.initial_residual_tolerance, false);
+      relativePose_info.initial_residual_tolerance, false,
+      &relativePose_info.ransac_iteration_count);
 
     relativePose_info.found_residual_precision = ac_ransac_output.first;
 
@@ -93,7 +94,8 @@ bool robustRelativePose
     const auto ac_ransac_output =
       ACRANSAC(kernel, relativePose_info.vec_inliers,
         max_iteration_count, &relativePose_info.essential_matrix,
-        upper_bound_precision, false);
+        upper_bound_precision, false,
+        &relativePose_info.ransac_iteration_count);
 
     const double & threshold = ac_ransac_output.first;
     relativePose_info.found_residual_precision = R2D(threshold); // Degree
@@ -28,10 +28,12 @@ struct RelativePose_Info
   std::vector<uint32_t> vec_inliers;
   double initial_residual_tolerance;
   double found_residual_precision;
+  unsigned int ransac_iteration_count; // performed robust estimation iterations
 
   RelativePose_Info()
     :initial_residual_tolerance(std::numeric_limits<double>::infinity()),
-    found_residual_precision(std::numeric_limits<double>::infinity())
+    found_residual_precision(std::numeric_limits<double>::infinity()),
+    ransac_iteration_count(0)
   {}
 };
 
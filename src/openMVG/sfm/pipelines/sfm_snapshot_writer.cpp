@@ -0,0 +1,216 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/sfm/pipelines/sfm_snapshot_writer.hpp"
+#include "openMVG/sfm/sfm_view_priors.hpp"
+
+#include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
+#include <exception>
+#include <iostream>
+
+namespace openMVG {
+namespace sfm {
+
+namespace {
+
+// Copy the part of the scene that is exported with the given flags.
+// The copy is linear in the scene size (no copy-on-write sharing with the live
+// scene, whose views, intrinsics and landmarks are modified in place).
+void CopyScene
+(
+  const SfM_Data & sfm_data,
+  const std::string & filename,
+  const ESfM_Data flags_part,
+  SfM_Data & snapshot
+)
+{
+  // The PLY format only stores the landmark positions
+  const bool b_observations =
+    stlplus::extension_part(filename) != "ply"
+    && (flags_part & STRUCTURE) == STRUCTURE;
+
+  snapshot.s_root_path = sfm_data.s_root_path;
+  // Views and intrinsics are modified by the reconstruction (i.e intrinsic
+  // assignment or refinement), so they are deep copied.
+  for (const auto & view_it : sfm_data.GetViews())
+  {
+    const View * view = view_it.second.get();
+    const ViewPriors * prior = dynamic_cast<const ViewPriors *>(view);
+    if (prior)
+      snapshot.views[view_it.first] = std::make_shared<ViewPriors>(*prior);
+    else
+      snapshot.views[view_it.first] = std::make_shared<View>(*view);
+  }
+  for (const auto & intrinsic_it : sfm_data.GetIntrinsics())
+  {
+    snapshot.intrinsics[intrinsic_it.first] =
+      std::shared_ptr<cameras::IntrinsicBase>(intrinsic_it.second->clone());
+  }
+  snapshot.poses = sfm_data.GetPoses();
+  if (b_observations)
+  {
+    snapshot.structure = sfm_data.GetLandmarks();
+  }
+  else
+  {
+    for (const auto & landmark_it : sfm_data.GetLandmarks())
+      snapshot.structure[landmark_it.first].X = landmark_it.second.X;
+  }
+  snapshot.control_points = sfm_data.GetControl_Points();
+}
+
+} // namespace
+
+SfM_Data_Snapshot_Writer::SfM_Data_Snapshot_Writer
+(
+  const Snapshot_Options & options
+):
+  options_(options)
+{
+  if (options_.enabled_)
+    thread_ = std::thread(&SfM_Data_Snapshot_Writer::Run, this);
+}
+
+SfM_Data_Snapshot_Writer::~SfM_Data_Snapshot_Writer()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    b_stop_ = true;
+  }
+  condition_.notify_all();
+  if (thread_.joinable())
+    thread_.join();
+}
+
+bool SfM_Data_Snapshot_Writer::Push
+(
+  const SfM_Data & sfm_data,
+  const std::string & filename,
+  const ESfM_Data flags_part,
+  const bool b_force
+)
+{
+  if (!options_.enabled_)
+    return false;
+
+  //-- Throttling
+  const auto now = std::chrono::steady_clock::now();
+  const size_t pose_count = sfm_data.GetPoses().size();
+  const size_t landmark_count = sfm_data.GetLandmarks().size();
+  if (!b_force && !b_first_snapshot_)
+  {
+    const double elapsed =
+      std::chrono::duration<double>(now - last_snapshot_time_).count();
+    const bool b_grown =
+      pose_count >= last_pose_count_ * (1.0 + options_.min_growth_ratio_)
+      || landmark_count >= last_landmark_count_ * (1.0 + options_.min_growth_ratio_);
+    if (elapsed < options_.min_period_
+        || (options_.min_growth_ratio_ > 0.0 && !b_grown))
+    {
+      ++throttled_count_;
+      return false;
+    }
+  }
+  b_first_snapshot_ = false;
+  last_snapshot_time_ = now;
+  last_pose_count_ = pose_count;
+  last_landmark_count_ = landmark_count;
+
+  //-- Copy the scene (outside of the lock, the writer thread is not blocked)
+  std::unique_ptr<Snapshot> snapshot(new Snapshot);
+  CopyScene(sfm_data, filename, flags_part, snapshot->sfm_data);
+  snapshot->filename = filename;
+  snapshot->flags_part = flags_part;
+
+  //-- Queue the snapshot (replace the one that is not yet written)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_)
+      ++coalesced_count_;
+    pending_ = std::move(snapshot);
+  }
+  condition_.notify_all();
+  return true;
+}
+
+void SfM_Data_Snapshot_Writer::Flush()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  condition_.wait(lock, [this]{ return !pending_ && !b_writing_; });
+}
+
+size_t SfM_Data_Snapshot_Writer::WrittenCount() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return written_count_;
+}
+
+size_t SfM_Data_Snapshot_Writer::FailedCount() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return failed_count_;
+}
+
+size_t SfM_Data_Snapshot_Writer::CoalescedCount() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return coalesced_count_;
+}
+
+size_t SfM_Data_Snapshot_Writer::ThrottledCount() const
+{
+  return throttled_count_;
+}
+
+void SfM_Data_Snapshot_Writer::Run()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true)
+  {
+    condition_.wait(lock, [this]{ return pending_ || b_stop_; });
+    if (!pending_) // Stop once the last snapshot is written
+      break;
+
+    std::unique_ptr<Snapshot> snapshot = std::move(pending_);
+    b_writing_ = true;
+    lock.unlock();
+
+    // An exception must not escape the thread (std::terminate)
+    bool b_saved = false;
+    try
+    {
+      b_saved =
+        Save(snapshot->sfm_data, snapshot->filename, snapshot->flags_part);
+      if (!b_saved)
+      {
+        std::cerr << "Cannot save the scene snapshot: " << snapshot->filename << std::endl;
+      }
+    }
+    catch (const std::exception & e)
+    {
+      std::cerr << "Cannot save the scene snapshot: " << snapshot->filename
+        << " (" << e.what() << ")" << std::endl;
+    }
+    catch (...)
+    {
+      std::cerr << "Cannot save the scene snapshot: " << snapshot->filename
+        << " (unknown exception)" << std::endl;
+    }
+    snapshot.reset();
+
+    lock.lock();
+    b_writing_ = false;
+    written_count_ += b_saved;
+    failed_count_ += !b_saved;
+    condition_.notify_all();
+  }
+}
+
+} // namespace sfm
+} // namespace openMVG
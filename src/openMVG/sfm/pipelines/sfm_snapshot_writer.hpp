@@ -0,0 +1,112 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SFM_PIPELINES_SFM_SNAPSHOT_WRITER_HPP
+#define OPENMVG_SFM_PIPELINES_SFM_SNAPSHOT_WRITER_HPP
+
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_data_io.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace openMVG {
+namespace sfm {
+
+struct Snapshot_Options
+{
+  bool enabled_ = true;
+  // Minimal wall time between two snapshots (seconds, 0: no limit)
+  double min_period_ = 0.0;
+  // Minimal relative growth of the pose or the landmark count between two
+  // snapshots (i.e 0.1 for 10%, 0: no limit)
+  double min_growth_ratio_ = 0.0;
+};
+
+/// Write the intermediate scenes of a reconstruction in a background thread.
+/// - A snapshot is a copy of the scene taken on the calling thread: the
+///   landmark observations (the bulk of the scene) are copied only if the
+///   output format stores them (i.e not for PLY).
+///   Nothing is shared with the live scene, so Push costs O(#views +
+///   #intrinsics + #poses + #landmarks) time and memory on the calling thread
+///   (plus the observations for the formats that store them): use the
+///   throttling options to bound this cost on large scenes.
+/// - If the writer falls behind, a pending snapshot is replaced by the newest
+///   one (only the last state is written).
+/// - Snapshots can be throttled by wall time and by scene growth.
+/// - A snapshot that cannot be saved (Save returns false or throws) is
+///   reported on std::cerr and counted by FailedCount, the writer goes on.
+class SfM_Data_Snapshot_Writer
+{
+public:
+  explicit SfM_Data_Snapshot_Writer
+  (
+    const Snapshot_Options & options = Snapshot_Options()
+  );
+
+  /// Write the pending snapshot and stop the writer thread
+  ~SfM_Data_Snapshot_Writer();
+
+  /// Queue a snapshot of the scene.
+  /// Return false if the snapshot is throttled (or the writer is disabled).
+  /// b_force bypasses the throttling (i.e for the final or the initial scene).
+  bool Push
+  (
+    const SfM_Data & sfm_data,
+    const std::string & filename,
+    const ESfM_Data flags_part = ESfM_Data(ALL),
+    const bool b_force = false
+  );
+
+  /// Wait until the queued snapshot is written
+  void Flush();
+
+  size_t WrittenCount() const;
+  size_t FailedCount() const;
+  size_t CoalescedCount() const;
+  size_t ThrottledCount() const;
+
+private:
+  struct Snapshot
+  {
+    SfM_Data sfm_data;
+    std::string filename;
+    ESfM_Data flags_part;
+  };
+
+  void Run();
+
+  Snapshot_Options options_;
+
+  // Throttling state (only accessed by the pushing thread)
+  bool b_first_snapshot_ = true;
+  std::chrono::steady_clock::time_point last_snapshot_time_;
+  size_t last_pose_count_ = 0;
+  size_t last_landmark_count_ = 0;
+  size_t throttled_count_ = 0;
+
+  // Writer state
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  std::unique_ptr<Snapshot> pending_;
+  bool b_writing_ = false;
+  bool b_stop_ = false;
+  size_t written_count_ = 0;
+  size_t failed_count_ = 0;
+  size_t coalesced_count_ = 0;
+  std::thread thread_;
+};
+
+} // namespace sfm
+} // namespace openMVG
+
+#endif // OPENMVG_SFM_PIPELINES_SFM_SNAPSHOT_WRITER_HPP
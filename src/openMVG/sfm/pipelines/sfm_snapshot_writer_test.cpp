@@ -0,0 +1,131 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/cameras/cameras.hpp"
+#include "openMVG/sfm/pipelines/sfm_snapshot_writer.hpp"
+
+#include "testing/testing.h"
+
+#include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
+#include <fstream>
+
+using namespace openMVG;
+using namespace openMVG::sfm;
+
+// Create a scene with nb_poses posed views and nb_landmarks landmarks
+SfM_Data MakeScene(const int nb_poses, const int nb_landmarks)
+{
+  SfM_Data sfm_data;
+  sfm_data.intrinsics[0] = std::make_shared<cameras::Pinhole_Intrinsic>(1000, 1000, 1000, 500, 500);
+  for (int i = 0; i < nb_poses; ++i)
+  {
+    sfm_data.views[i] = std::make_shared<View>("", i, 0, i, 1000, 1000);
+    sfm_data.poses[i] = geometry::Pose3(Mat3::Identity(), Vec3(i, 0, 0));
+  }
+  for (int i = 0; i < nb_landmarks; ++i)
+  {
+    sfm_data.structure[i].X = Vec3(i, 1, 2);
+    sfm_data.structure[i].obs[0] = Observation(Vec2(0, 0), i);
+  }
+  return sfm_data;
+}
+
+TEST(SfM_Data_Snapshot_Writer, Write) {
+
+  const std::string filename = "snapshot_writer_test.ply";
+  {
+    SfM_Data_Snapshot_Writer writer;
+    SfM_Data sfm_data = MakeScene(4, 16);
+    EXPECT_TRUE(writer.Push(sfm_data, filename));
+    // The snapshot is a copy: the scene can be modified while it is written
+    sfm_data.structure.clear();
+    writer.Flush();
+    EXPECT_EQ(1, writer.WrittenCount());
+  }
+  EXPECT_TRUE(stlplus::file_exists(filename));
+
+  // 4 poses + 16 landmarks
+  std::ifstream stream(filename);
+  std::string line;
+  bool b_found = false;
+  while (std::getline(stream, line))
+    b_found |= (line == "element vertex 20");
+  EXPECT_TRUE(b_found);
+  stream.close();
+  stlplus::file_delete(filename);
+}
+
+TEST(SfM_Data_Snapshot_Writer, Throttle_Growth) {
+
+  const std::string filename = "snapshot_writer_test.ply";
+  Snapshot_Options options;
+  options.min_growth_ratio_ = 0.5;
+  SfM_Data_Snapshot_Writer writer(options);
+
+  EXPECT_TRUE(writer.Push(MakeScene(4, 16), filename));
+  // Not enough growth
+  EXPECT_FALSE(writer.Push(MakeScene(5, 20), filename));
+  // Forced snapshot
+  EXPECT_TRUE(writer.Push(MakeScene(5, 20), filename, ESfM_Data(ALL), true));
+  // 50% more poses
+  EXPECT_TRUE(writer.Push(MakeScene(8, 20), filename));
+  writer.Flush();
+
+  EXPECT_EQ(1, writer.ThrottledCount());
+  EXPECT_EQ(3, writer.WrittenCount() + writer.CoalescedCount());
+  stlplus::file_delete(filename);
+}
+
+TEST(SfM_Data_Snapshot_Writer, Throttle_Period) {
+
+  const std::string filename = "snapshot_writer_test.ply";
+  Snapshot_Options options;
+  options.min_period_ = 3600.0;
+  SfM_Data_Snapshot_Writer writer(options);
+
+  EXPECT_TRUE(writer.Push(MakeScene(4, 16), filename));
+  for (int i = 0; i < 10; ++i)
+    EXPECT_FALSE(writer.Push(MakeScene(5 + i, 16), filename));
+  writer.Flush();
+
+  EXPECT_EQ(10, writer.ThrottledCount());
+  EXPECT_EQ(1, writer.WrittenCount());
+  stlplus::file_delete(filename);
+}
+
+TEST(SfM_Data_Snapshot_Writer, Failure) {
+
+  // The failed snapshots are counted, the writer keeps running
+  SfM_Data_Snapshot_Writer writer;
+  EXPECT_TRUE(writer.Push(MakeScene(4, 16), "not_a_directory/snapshot_writer_test.ply"));
+  writer.Flush();
+  EXPECT_EQ(1, writer.FailedCount());
+  EXPECT_EQ(0, writer.WrittenCount());
+
+  const std::string filename = "snapshot_writer_test.ply";
+  EXPECT_TRUE(writer.Push(MakeScene(4, 16), filename, ESfM_Data(ALL), true));
+  writer.Flush();
+  EXPECT_EQ(1, writer.FailedCount());
+  EXPECT_EQ(1, writer.WrittenCount());
+  stlplus::file_delete(filename);
+}
+
+TEST(SfM_Data_Snapshot_Writer, Disabled) {
+
+  Snapshot_Options options;
+  options.enabled_ = false;
+  SfM_Data_Snapshot_Writer writer(options);
+  EXPECT_FALSE(writer.Push(MakeScene(4, 16), "snapshot_writer_test.ply"));
+  writer.Flush();
+  EXPECT_EQ(0, writer.WrittenCount());
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
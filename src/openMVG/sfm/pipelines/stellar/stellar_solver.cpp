@@ -25,12 +25,45 @@
 #include "openMVG/types.hpp"
 
 #include <algorithm>
+#include <iostream>
+#include <map>
+#include <memory>
 
 #include "ceres/ceres.h"
 
 namespace openMVG {
 namespace sfm {
 
+using View_Features_Map = std::map<IndexT, std::shared_ptr<const features::PointFeatures>>;
+
+/// Fetch the features of the views observing the tracks, once per view
+/// (a provider can load the features on demand).
+/// Return false if the features of a view cannot be loaded.
+static bool GetTracksFeatures
+(
+  const Features_Provider * features_provider,
+  const tracks::STLMAPTracks & tracks,
+  View_Features_Map & view_features
+)
+{
+  for (const auto & tracks_it : tracks)
+  {
+    for (const auto & track_it : tracks_it.second)
+    {
+      if (view_features.count(track_it.first))
+        continue;
+      const auto features = features_provider->get(track_it.first);
+      if (!features)
+      {
+        std::cerr << "Cannot load the features of the view: " << track_it.first << std::endl;
+        return false;
+      }
+      view_features[track_it.first] = features;
+    }
+  }
+  return true;
+}
+
 /// Function that estimate the relative scale of a triplet of pose.
 /// Since a triplet is made of two edges, we list the 3 view tracks
 /// Then compute the median depth for each pair and save the depth ratio
@@ -86,12 +119,10 @@ bool EstimateTripletRelativeScale
   //
   openMVG::tracks::STLMAPTracks map_tracksCommon;
   {
-    matching::PairWiseMatches matches;
+    Pair_Set pairs;
     //-- List all view that shared some content with the used poses
-    for (const auto & matches_it : matches_provider->pairWise_matches_)
+    for (const Pair & pair : matches_provider->getPairs())
     {
-      const Pair & pair = matches_it.first;
-
       const View
         * view_I = sfm_data.GetViews().find(pair.first)->second.get(),
         * view_J = sfm_data.GetViews().find(pair.second)->second.get();
@@ -99,14 +130,17 @@ bool EstimateTripletRelativeScale
       if (set_pose.count(view_I->id_pose)
           && set_pose.count(view_J->id_pose))
       {
-        const matching::IndMatches & pair_matches = matches_it.second;
-        matches[pair] = pair_matches;
+        pairs.insert(pairs.end(), pair);
       }
     }
 
-    // Computing tracks
+    // Computing tracks (the matches are read pair by pair from the provider)
     openMVG::tracks::TracksBuilder tracksBuilder;
-    tracksBuilder.Build(matches);
+    tracksBuilder.Build(pairs,
+      [&](const Pair & pair, matching::IndMatches & buffer)
+      {
+        return matches_provider->getMatches(pair, buffer);
+      });
     tracksBuilder.Filter(3);
 
     // If there is insufficient 3-view track count,
@@ -119,6 +153,12 @@ bool EstimateTripletRelativeScale
     tracksBuilder.ExportToSTL(map_tracksCommon);
   }
 
+  View_Features_Map view_features;
+  if (!GetTracksFeatures(features_provider, map_tracksCommon, view_features))
+  {
+    return false;
+  }
+
   //
   // Triangulate observations for each pose pair
   // Store track depth per pose pair
@@ -170,7 +210,7 @@ bool EstimateTripletRelativeScale
 
           vec_poses.emplace_back(pose.asMatrix());
           const size_t feat_idx = track_it.second;
-          const Vec2 feat_pos = features_provider->feats_per_view.at(view_idx)[feat_idx].coords().cast<double>();
+          const Vec2 feat_pos = (*view_features.at(view_idx))[feat_idx].coords().cast<double>();
           bearing.emplace_back((*cam)(cam->get_ud_pixel(feat_pos)));
         }
       }
@@ -274,7 +314,7 @@ bool EstimateTripletRelativeScale
       {
         const IndexT I = track_it.first;
         const size_t featIndexI = track_it.second;
-        const Vec2 x = features_provider->feats_per_view.at(I)[featIndexI].coords().cast<double>();
+        const Vec2 x = (*view_features.at(I))[featIndexI].coords().cast<double>();
 
         obs[I] = std::move(Observation(x, featIndexI));
       }
@@ -479,11 +519,9 @@ bool Stellar_Solver::Optimize
   // Collect, matches, intrinsics and views data linked to the poses ids
   openMVG::tracks::STLMAPTracks tracks;
   {
-    matching::PairWiseMatches matches;
-    for (const auto & matches_it : matches_provider_->pairWise_matches_)
+    Pair_Set pairs;
+    for (const Pair & pair : matches_provider_->getPairs())
     {
-      const Pair & pair = matches_it.first;
-
       const View * view_I = sfm_data_.GetViews().find(pair.first)->second.get();
       const View * view_J = sfm_data_.GetViews().find(pair.second)->second.get();
 
@@ -493,17 +531,16 @@ bool Stellar_Solver::Optimize
         // Collect matches
         const Pair pose_pair(std::min(view_I->id_pose,view_J->id_pose),
                              std::max(view_I->id_pose,view_J->id_pose));
-        const matching::IndMatches & pair_matches = matches_it.second;
         if (!use_all_matches_)
         {
           if (used_pairs.count(pose_pair))
-            matches[pair] = pair_matches;
+            pairs.insert(pairs.end(), pair);
           else
             continue; // This pair is ignored
         }
         else
         {
-          matches[pair] = pair_matches;
+          pairs.insert(pairs.end(), pair);
         }
 
         // Add view information and related intrinsic data
@@ -520,7 +557,11 @@ bool Stellar_Solver::Optimize
     // Computing tracks
     {
       openMVG::tracks::TracksBuilder tracksBuilder;
-      tracksBuilder.Build(matches);
+      tracksBuilder.Build(pairs,
+        [&](const Pair & pair, matching::IndMatches & buffer)
+        {
+          return matches_provider_->getMatches(pair, buffer);
+        });
       tracksBuilder.Filter(2); // [2-n] view based matches
       tracksBuilder.ExportToSTL(tracks);
     }
@@ -528,6 +569,12 @@ bool Stellar_Solver::Optimize
 
   // Fill the sfm_data landmark observations and 3d initial position (triangulation):
   {
+    View_Features_Map view_features;
+    if (!GetTracksFeatures(features_provider_, tracks, view_features))
+    {
+      return false;
+    }
+
     // Add the track observations to the sfm_data
     Landmarks & landmarks = stellar_pod_reconstruction.structure;
     for (const auto & tracks_it : tracks)
@@ -555,7 +602,7 @@ bool Stellar_Solver::Optimize
         {
           const IndexT view_idx = track_it.first;
           const IndexT feat_idx = track_it.second;
-          const Vec2 x = features_provider_->feats_per_view.at(view_idx)[feat_idx].coords().cast<double>();
+          const Vec2 x = (*view_features.at(view_idx))[feat_idx].coords().cast<double>();
 
           obs[view_idx] = {x, feat_idx};
         }
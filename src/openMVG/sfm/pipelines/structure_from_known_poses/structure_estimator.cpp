@@ -23,6 +23,11 @@
 
 #include "third_party/progress/progress_display.hpp"
 
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <mutex>
+
 namespace openMVG {
 namespace sfm {
 
@@ -174,6 +179,93 @@ void SfM_Data_Structure_Estimation_From_Known_Poses::match(
   }
 }
 
+/// Data of a view that is shared by the triplets that use it
+struct Triplet_View_Data
+{
+  const IntrinsicBase * cam;
+  Pose3 pose;
+  std::shared_ptr<features::Regions> regions;
+  Mat3X bearings; // Bearing vectors of the (undistorted) regions positions
+};
+
+/// Per view data of the triplets, with a bounded lifetime:
+/// - the data of a view is computed by the first triplet that uses it,
+/// - it is released once the last triplet that uses it is validated.
+/// Only the views of the triplets in progress are kept in memory.
+class Triplet_View_Data_Cache
+{
+public:
+  Triplet_View_Data_Cache
+  (
+    const SfM_Data & sfm_data,
+    const std::shared_ptr<Regions_Provider> & regions_provider,
+    const graph::Forward_Adjacency & adjacency
+  ):sfm_data_(sfm_data),
+    regions_provider_(regions_provider)
+  {
+    // Count the triplets of each view (the triplets are streamed, not stored)
+    auto count_callback = [this](const graph::Triplet & triplet)
+    {
+      ++triplet_count_;
+      ++entries_[triplet.i].use_count;
+      ++entries_[triplet.j].use_count;
+      ++entries_[triplet.k].use_count;
+    };
+    for (IndexT rank = 0; rank < adjacency.NodeCount(); ++rank)
+      adjacency.ListNodeTriplets(rank, count_callback);
+  }
+
+  /// Number of triplets of the graph
+  size_t TripletCount() const
+  {
+    return triplet_count_;
+  }
+
+  /// Return the data of a view (computed if it is not in memory)
+  std::shared_ptr<const Triplet_View_Data> Acquire(const IndexT view_id)
+  {
+    Entry & entry = entries_.at(view_id);
+    std::lock_guard<std::mutex> lock(entry.mutex);
+    if (!entry.data)
+    {
+      std::shared_ptr<Triplet_View_Data> data = std::make_shared<Triplet_View_Data>();
+      const View * view = sfm_data_.GetViews().at(view_id).get();
+      data->cam = sfm_data_.GetIntrinsics().at(view->id_intrinsic).get();
+      data->pose = sfm_data_.GetPoseOrDie(view);
+      data->regions = regions_provider_->get(view_id);
+      const size_t nb_regions = data->regions->RegionCount();
+      Mat2X ud_positions(2, nb_regions);
+      for (size_t r = 0; r < nb_regions; ++r)
+        ud_positions.col(r) = data->cam->get_ud_pixel(data->regions->GetRegionPosition(r));
+      data->bearings = (*data->cam)(ud_positions);
+      entry.data = data;
+    }
+    return entry.data;
+  }
+
+  /// Tell that a triplet no longer uses the data of a view
+  void Release(const IndexT view_id)
+  {
+    Entry & entry = entries_.at(view_id);
+    std::lock_guard<std::mutex> lock(entry.mutex);
+    if (--entry.use_count == 0)
+      entry.data.reset();
+  }
+
+private:
+  struct Entry
+  {
+    std::mutex mutex;
+    size_t use_count = 0; // Number of triplets that have not released the view yet
+    std::shared_ptr<const Triplet_View_Data> data;
+  };
+
+  const SfM_Data & sfm_data_;
+  const std::shared_ptr<Regions_Provider> & regions_provider_;
+  std::map<IndexT, Entry> entries_;
+  size_t triplet_count_ = 0;
+};
+
 /// Filter inconsistent correspondences by using 3-view correspondences on view triplets
 void SfM_Data_Structure_Estimation_From_Known_Poses::filter(
   const SfM_Data & sfm_data,
@@ -184,23 +276,30 @@ void SfM_Data_Structure_Estimation_From_Known_Poses::filter(
   // Triangulate triplet tracks
   //  - keep valid one
 
-  using Triplets = std::vector<graph::Triplet>;
-  const Triplets triplets = graph::TripletListing(pairs);
+  // The triplets are streamed from the forward adjacency of the view graph
+  // (they are not stored, the memory usage is linear in the pair count)
+  const graph::Forward_Adjacency adjacency(pairs);
+
+  // The view data (regions & bearing vectors) is shared by the triplets that
+  // use the view, it is kept in memory only while these triplets are processed
+  // (the triplets of a view are listed together: close triplets share views)
+  Triplet_View_Data_Cache view_data(sfm_data, regions_provider, adjacency);
 
-  C_Progress_display my_progress_bar( triplets.size(), std::cout,
+  C_Progress_display my_progress_bar( view_data.TripletCount(), std::cout,
     "Per triplet tracks validation (discard spurious correspondences):\n" );
+
+  // The triplets are processed per view, each thread collects its validated
+  // matches (without synchronization) and they are merged at the end.
 #ifdef OPENMVG_USE_OPENMP
   #pragma omp parallel
 #endif // OPENMVG_USE_OPENMP
-  for (Triplets::const_iterator it = triplets.begin(); it != triplets.end(); ++it)
   {
-#ifdef OPENMVG_USE_OPENMP
-    #pragma omp single nowait
-#endif // OPENMVG_USE_OPENMP
+    PairWiseMatches thread_triplets_matches;
+
+    auto validate_triplet = [&](const graph::Triplet & triplet)
     {
       ++my_progress_bar;
 
-      const graph::Triplet & triplet = *it;
       const IndexT I = triplet.i, J = triplet.j , K = triplet.k;
 
       openMVG::tracks::STLMAPTracks map_tracksCommon;
@@ -221,73 +320,101 @@ void SfM_Data_Structure_Estimation_From_Known_Poses::filter(
           tracksBuilder.Filter(3);
           tracksBuilder.ExportToSTL(map_tracksCommon);
         }
+      }
+
+      const std::map<IndexT, std::shared_ptr<const Triplet_View_Data>> triplet_data =
+      {{I, view_data.Acquire(I)},
+       {J, view_data.Acquire(J)},
+       {K, view_data.Acquire(K)},
+      };
+
+      // Triangulate the tracks
+      std::vector<Mat34> poses(3);
+      Mat3X bearing_matrix(3, 3);
+      for (const auto & track_it : map_tracksCommon)
+      {
+        const tracks::submapTrack & subTrack = track_it.second;
+        int i(0);
+        for (const auto & observation_it : subTrack) {
+          const Triplet_View_Data & data = *triplet_data.at(observation_it.first);
+          bearing_matrix.col(i) = data.bearings.col(observation_it.second);
+          poses[i] = data.pose.asMatrix();
+          ++i;
+        }
+        Vec4 Xhomogeneous;
+        TriangulateNViewAlgebraic(bearing_matrix, poses, &Xhomogeneous);
+        const Vec3 X = Xhomogeneous.hnormalized();
+
+        // Test validity of the hypothesis:
+        // - residual error
+        // - cheirality
+        bool bCheirality = true;
+        bool bReprojection_error = true;
+        i = 0;
+        for (tracks::submapTrack::const_iterator obs_it = subTrack.begin();
+          obs_it != subTrack.end() && bCheirality && bReprojection_error; ++obs_it, ++i)
+        {
+          const Triplet_View_Data & data = *triplet_data.at(obs_it->first);
+          bCheirality &= CheiralityTest(bearing_matrix.col(i), data.pose, X);
+
+          const Vec2 pt = data.regions->GetRegionPosition(obs_it->second);
+          const Vec2 residual = data.cam->residual(data.pose(X), pt);
+          bReprojection_error &= residual.squaredNorm() < max_reprojection_error_;
+        }
+        if (bCheirality && bReprojection_error)
+        // TODO: Add an angular check ?
+        {
+          openMVG::tracks::submapTrack::const_iterator iterI, iterJ, iterK;
+          iterI = iterJ = iterK = subTrack.begin();
+          std::advance(iterJ,1);
+          std::advance(iterK,2);
+
+          thread_triplets_matches[{I,J}].emplace_back(iterI->second, iterJ->second);
+          thread_triplets_matches[{J,K}].emplace_back(iterJ->second, iterK->second);
+        }
+      }
+      view_data.Release(I);
+      view_data.Release(J);
+      view_data.Release(K);
+    };
 
-        const std::map<IndexT, std::shared_ptr<openMVG::features::Regions>> regions =
-        {{I, regions_provider->get(I)},
-         {J, regions_provider->get(J)},
-         {K, regions_provider->get(K)},
-        };
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp for schedule(dynamic)
+#endif // OPENMVG_USE_OPENMP
+    for (int rank = 0; rank < static_cast<int>(adjacency.NodeCount()); ++rank)
+    {
+      adjacency.ListNodeTriplets(static_cast<IndexT>(rank), validate_triplet);
+    }
+
+    // A pair is shared by many triplets: keep its validated matches once
+    for (auto & pair_matches : thread_triplets_matches)
+    {
+      std::sort(pair_matches.second.begin(), pair_matches.second.end());
+      pair_matches.second.erase(
+        std::unique(pair_matches.second.begin(), pair_matches.second.end()),
+        pair_matches.second.end());
+    }
 
-        // Triangulate the tracks
-        for (const auto & track_it : map_tracksCommon)
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp critical
+#endif // OPENMVG_USE_OPENMP
+    {
+      for (auto & pair_matches : thread_triplets_matches)
+      {
+        IndMatches & matches = triplets_matches[pair_matches.first];
+        if (matches.empty())
+        {
+          matches.swap(pair_matches.second);
+        }
+        else
         {
-          const tracks::submapTrack & subTrack = track_it.second;
-          std::vector<Vec3> bearing;
-          std::vector<Mat34> poses;
-          bearing.reserve(subTrack.size());
-          poses.reserve(subTrack.size());
-          for (const auto & observation_it : subTrack) {
-            const size_t imaIndex = observation_it.first;
-            const size_t featIndex = observation_it.second;
-            const View * view = sfm_data.GetViews().at(imaIndex).get();
-            const IntrinsicBase * cam = sfm_data.GetIntrinsics().at(view->id_intrinsic).get();
-            const Pose3 pose = sfm_data.GetPoseOrDie(view);
-            const Vec2 pt = regions.at(imaIndex)->GetRegionPosition(featIndex);
-            bearing.emplace_back((*cam)(cam->get_ud_pixel(pt)));
-            poses.emplace_back(pose.asMatrix());
-          }
-          const Eigen::Map<const Mat3X> bearing_matrix(bearing[0].data(), 3, bearing.size());
-          Vec4 Xhomogeneous;
-          TriangulateNViewAlgebraic(bearing_matrix, poses, &Xhomogeneous);
-          const Vec3 X = Xhomogeneous.hnormalized();
-
-          // Test validity of the hypothesis:
-          // - residual error
-          // - cheirality
-          bool bCheirality = true;
-          bool bReprojection_error = true;
-          int i(0);
-          for (tracks::submapTrack::const_iterator obs_it = subTrack.begin();
-            obs_it != subTrack.end() && bCheirality && bReprojection_error; ++obs_it, ++i)
-          {
-            const View * view = sfm_data.views.at(obs_it->first).get();
-
-            const Pose3 pose = sfm_data.GetPoseOrDie(view);
-            bCheirality &= CheiralityTest(bearing[i], pose, X);
-
-            const size_t imaIndex = obs_it->first;
-            const size_t featIndex = obs_it->second;
-            const Vec2 pt = regions.at(imaIndex)->GetRegionPosition(featIndex);
-            const IntrinsicBase * cam = sfm_data.intrinsics.at(view->id_intrinsic).get();
-            const Vec2 residual = cam->residual(pose(X), pt);
-            bReprojection_error &= residual.squaredNorm() < max_reprojection_error_;
-          }
-          if (bCheirality && bReprojection_error)
-          // TODO: Add an angular check ?
-          {
-            #ifdef OPENMVG_USE_OPENMP
-            #pragma omp critical
-            #endif // OPENMVG_USE_OPENMP
-            {
-              openMVG::tracks::submapTrack::const_iterator iterI, iterJ, iterK;
-              iterI = iterJ = iterK = subTrack.begin();
-              std::advance(iterJ,1);
-              std::advance(iterK,2);
-
-              triplets_matches[{I,J}].emplace_back(iterI->second, iterJ->second);
-              triplets_matches[{J,K}].emplace_back(iterJ->second, iterK->second);
-            }
-          }
+          // Merge the sorted & unique matches of the threads
+          IndMatches merged_matches;
+          merged_matches.reserve(matches.size() + pair_matches.second.size());
+          std::set_union(matches.cbegin(), matches.cend(),
+            pair_matches.second.cbegin(), pair_matches.second.cend(),
+            std::back_inserter(merged_matches));
+          matches.swap(merged_matches);
         }
       }
     }
@@ -0,0 +1,115 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+//-----------------
+// Test summary:
+//-----------------
+// - Create SIFT regions from the synthetic dataset (one random descriptor
+//   per 3D point, the features of a view are shuffled)
+// - Compute the structure from the known poses (the triplets are listed and
+//   validated per graph node, the nodes are shared by the threads)
+// - Assert that:
+//   - most of the points are found,
+//   - the observations of a landmark are the images of the same point,
+//   - the regions are no longer used once the structure is computed.
+//-----------------
+
+#include "openMVG/features/regions_factory.hpp"
+#include "openMVG/sfm/pipelines/pipelines_test.hpp"
+#include "openMVG/sfm/pipelines/sfm_regions_provider.hpp"
+#include "openMVG/sfm/pipelines/structure_from_known_poses/structure_estimator.hpp"
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+using namespace openMVG;
+using namespace openMVG::features;
+using namespace openMVG::sfm;
+
+// Regions provider that serves the synthetic regions
+struct Synthetic_Regions_Provider : public Regions_Provider
+{
+  void set(const IndexT view_id, const std::shared_ptr<Regions> & regions)
+  {
+    cache_[view_id] = regions;
+  }
+  const std::shared_ptr<Regions> & at(const IndexT view_id) const
+  {
+    return cache_.at(view_id);
+  }
+};
+
+TEST(STRUCTURE_FROM_KNOWN_POSES, PerNode_Triplet_Validation) {
+
+  // 10 views, all the pairs: 120 triplets. The threads take the graph nodes
+  // one at a time (schedule(dynamic)) and each node lists the triplets of
+  // which it is the lowest ranked node: 36, 28, 21, ..., 1 triplets for the
+  // first 8 nodes, none for the last 2.
+  const int nviews = 10;
+  const int npoints = 200;
+  const nViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  SfM_Data sfm_data = getInputScene(d, config, cameras::PINHOLE_CAMERA);
+  sfm_data.structure.clear();
+
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::uniform_int_distribution<int> descriptor_distribution(0, 255);
+  std::vector<SIFT_Regions::DescriptorT> descriptors(npoints);
+  for (auto & descriptor : descriptors)
+    for (int c = 0; c < descriptor.static_size; ++c)
+      descriptor[c] = descriptor_distribution(random_generator);
+
+  // point_ids[view][feature]: id of the 3D point of a feature
+  std::vector<std::vector<int>> point_ids(nviews, std::vector<int>(npoints));
+  auto regions_provider = std::make_shared<Synthetic_Regions_Provider>();
+  for (int view = 0; view < nviews; ++view)
+  {
+    std::iota(point_ids[view].begin(), point_ids[view].end(), 0);
+    std::shuffle(point_ids[view].begin(), point_ids[view].end(), random_generator);
+    auto regions = std::make_shared<SIFT_Regions>();
+    for (const int point_id : point_ids[view])
+    {
+      regions->Features().emplace_back(d._x[view](0, point_id), d._x[view](1, point_id));
+      regions->Descriptors().push_back(descriptors[point_id]);
+    }
+    regions_provider->set(view, regions);
+  }
+
+  Pair_Set pairs;
+  for (int i = 0; i < nviews; ++i)
+    for (int j = i + 1; j < nviews; ++j)
+      pairs.insert({i, j});
+
+  SfM_Data_Structure_Estimation_From_Known_Poses structure_estimator(4.0);
+  structure_estimator.run(sfm_data, pairs,
+    std::static_pointer_cast<Regions_Provider>(regions_provider),
+    ETriangulationMethod::DEFAULT);
+
+  EXPECT_TRUE(sfm_data.structure.size() >= 0.9 * npoints);
+  for (const auto & landmark_it : sfm_data.structure)
+  {
+    const Observations & obs = landmark_it.second.obs;
+    EXPECT_TRUE(obs.size() >= 3);
+    const int point_id = point_ids[obs.cbegin()->first][obs.cbegin()->second.id_feat];
+    for (const auto & obs_it : obs)
+      EXPECT_EQ(point_id, point_ids[obs_it.first][obs_it.second.id_feat]);
+    EXPECT_TRUE((landmark_it.second.X - d._X.col(point_id)).norm() < 1e-6);
+  }
+
+  // The view data of the triplets was released
+  for (int view = 0; view < nviews; ++view)
+    EXPECT_EQ(1, regions_provider->at(view).use_count());
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
@@ -12,6 +12,7 @@
 #include <omp.h>
 #endif
 
+#include "ceres/ordered_groups.h"
 #include "ceres/problem.h"
 #include "ceres/solver.h"
 #include "openMVG/cameras/Camera_Common.hpp"
@@ -21,6 +22,8 @@
 //- Robust estimation - LMeds (since no threshold can be defined)
 #include "openMVG/robust_estimation/robust_estimator_LMeds.hpp"
 #include "openMVG/sfm/sfm_data_BA_ceres_camera_functor.hpp"
+#include "openMVG/sfm/sfm_data_BA_ceres_io.hpp"
+#include "openMVG/sfm/sfm_data_BA_ceres_utils.hpp"
 #include "openMVG/sfm/sfm_data_transform.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
 #include "openMVG/types.hpp"
@@ -28,8 +31,16 @@
 #include <ceres/rotation.h>
 #include <ceres/types.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
 #include <iostream>
 #include <limits>
+#include <set>
+#include <sstream>
+#include <utility>
 
 namespace openMVG {
 namespace sfm {
@@ -104,6 +115,209 @@ ceres::CostFunction * IntrinsicsToCostFunction
   }
 }
 
+/// Convert a pose to a [angleAxis, translation] parameter block
+void PoseToParameterBlock
+(
+  const Pose3 & pose,
+  double * parameter_block
+)
+{
+  const Mat3 R = pose.rotation();
+  const Vec3 t = pose.translation();
+  ceres::RotationMatrixToAngleAxis((const double*)R.data(), parameter_block);
+  parameter_block[3] = t(0);
+  parameter_block[4] = t(1);
+  parameter_block[5] = t(2);
+}
+
+/// Convert a [angleAxis, translation] parameter block to a pose
+Pose3 ParameterBlockToPose
+(
+  const double * parameter_block
+)
+{
+  Mat3 R_refined;
+  ceres::AngleAxisToRotationMatrix(parameter_block, R_refined.data());
+  const Vec3 t_refined(parameter_block[3], parameter_block[4], parameter_block[5]);
+  return Pose3(R_refined, -R_refined.transpose() * t_refined);
+}
+
+/// Add a pose parameter block and configure its subset parametrization
+void AddPoseParameterBlock
+(
+  ceres::Problem & problem,
+  double * parameter_block,
+  const Extrinsic_Parameter_Type extrinsics_opt
+)
+{
+  problem.AddParameterBlock(parameter_block, 6);
+  if (extrinsics_opt == Extrinsic_Parameter_Type::NONE)
+  {
+    // set the whole parameter block as constant for best performance
+    problem.SetParameterBlockConstant(parameter_block);
+  }
+  else  // Subset parametrization
+  {
+    std::vector<int> vec_constant_extrinsic;
+    // If we adjust only the translation, we must set ROTATION as constant
+    if (extrinsics_opt == Extrinsic_Parameter_Type::ADJUST_TRANSLATION)
+    {
+      // Subset rotation parametrization
+      vec_constant_extrinsic.insert(vec_constant_extrinsic.end(), {0,1,2});
+    }
+    // If we adjust only the rotation, we must set TRANSLATION as constant
+    if (extrinsics_opt == Extrinsic_Parameter_Type::ADJUST_ROTATION)
+    {
+      // Subset translation parametrization
+      vec_constant_extrinsic.insert(vec_constant_extrinsic.end(), {3,4,5});
+    }
+    if (!vec_constant_extrinsic.empty())
+    {
+      ceres::SubsetParameterization *subset_parameterization =
+        new ceres::SubsetParameterization(6, vec_constant_extrinsic);
+      problem.SetParameterization(parameter_block, subset_parameterization);
+    }
+  }
+}
+
+/// Add an intrinsic parameter block and configure its subset parametrization
+void AddIntrinsicParameterBlock
+(
+  ceres::Problem & problem,
+  std::vector<double> & parameters,
+  const IntrinsicBase & intrinsic,
+  const Intrinsic_Parameter_Type intrinsics_opt
+)
+{
+  double * parameter_block = &parameters[0];
+  problem.AddParameterBlock(parameter_block, parameters.size());
+  if (intrinsics_opt == Intrinsic_Parameter_Type::NONE)
+  {
+    // set the whole parameter block as constant for best performance
+    problem.SetParameterBlockConstant(parameter_block);
+  }
+  else
+  {
+    const std::vector<int> vec_constant_intrinsic =
+      intrinsic.subsetParameterization(intrinsics_opt);
+    if (!vec_constant_intrinsic.empty())
+    {
+      ceres::SubsetParameterization *subset_parameterization =
+        new ceres::SubsetParameterization(
+          parameters.size(), vec_constant_intrinsic);
+      problem.SetParameterization(parameter_block, subset_parameterization);
+    }
+  }
+}
+
+/// Configure the solver according the user options and the problem size.
+/// Return true if the large scene mode is used.
+bool ConfigureSolver
+(
+  const Bundle_Adjustment_Ceres::BA_Ceres_options & ba_options,
+  const std::size_t nb_poses,
+  const std::set<double*> & camera_blocks, // poses & intrinsics parameter blocks
+  ceres::Problem & problem,
+  ceres::Solver::Options & ceres_config_options
+)
+{
+  ceres_config_options.max_num_iterations = ba_options.max_num_iterations_;
+  if (ba_options.max_solver_time_ > 0.0)
+    ceres_config_options.max_solver_time_in_seconds = ba_options.max_solver_time_;
+  ceres_config_options.preconditioner_type =
+    static_cast<ceres::PreconditionerType>(ba_options.preconditioner_type_);
+  ceres_config_options.linear_solver_type =
+    static_cast<ceres::LinearSolverType>(ba_options.linear_solver_type_);
+  ceres_config_options.sparse_linear_algebra_library_type =
+    static_cast<ceres::SparseLinearAlgebraLibraryType>(ba_options.sparse_linear_algebra_library_type_);
+
+  const bool b_large_scene = ba_options.IsLargeScene(nb_poses);
+  if (b_large_scene)
+  {
+    // Do not build & factorize the reduced camera matrix:
+    //  solve the Schur complement system with a preconditioned conjugate gradient
+    ceres_config_options.linear_solver_type = ceres::ITERATIVE_SCHUR;
+    ceres_config_options.preconditioner_type =
+      static_cast<ceres::PreconditionerType>(ba_options.large_scene_preconditioner_type_);
+    ceres_config_options.visibility_clustering_type =
+      static_cast<ceres::VisibilityClusteringType>(ba_options.visibility_clustering_type_);
+  }
+
+  const bool b_schur_solver =
+    ceres_config_options.linear_solver_type == ceres::DENSE_SCHUR ||
+    ceres_config_options.linear_solver_type == ceres::SPARSE_SCHUR ||
+    ceres_config_options.linear_solver_type == ceres::ITERATIVE_SCHUR;
+  if (b_schur_solver && ba_options.bUse_explicit_schur_ordering_)
+  {
+    // Eliminate the landmarks first (group 0), then the cameras (group 1).
+    // Any parameter block that is not a camera block (structure, GCP) is a point.
+    std::vector<double*> parameter_blocks;
+    problem.GetParameterBlocks(&parameter_blocks);
+
+    ceres::ParameterBlockOrdering * ordering = new ceres::ParameterBlockOrdering;
+    for (double * parameter_block : parameter_blocks)
+    {
+      ordering->AddElementToGroup(parameter_block,
+        camera_blocks.count(parameter_block) ? 1 : 0);
+    }
+    ceres_config_options.linear_solver_ordering.reset(ordering);
+  }
+  //  else Ceres automatically detects the bundle structure.
+
+  ceres_config_options.use_inner_iterations = ba_options.bUse_inner_iterations_;
+  ceres_config_options.minimizer_progress_to_stdout = ba_options.bVerbose_;
+  ceres_config_options.logging_type = ceres::SILENT;
+  ceres_config_options.num_threads = ba_options.nb_threads_;
+#if CERES_VERSION_MAJOR < 2
+  ceres_config_options.num_linear_solver_threads = ba_options.nb_threads_;
+#endif
+  ceres_config_options.parameter_tolerance = ba_options.parameter_tolerance_;
+  return b_large_scene;
+}
+
+/// Save the input of an Adjust call if the user asked for it
+static void DumpProblem
+(
+  const SfM_Data & sfm_data,
+  const Optimize_Options & options,
+  const Bundle_Adjustment_Ceres::BA_Ceres_options & ba_options
+)
+{
+  if (ba_options.problem_dump_prefix_.empty())
+    return;
+
+  // Shared by all the BA objects, so the successive dumps are never overwritten
+  static std::atomic<unsigned int> dump_index(0);
+  std::ostringstream os;
+  os << ba_options.problem_dump_prefix_
+    << std::setw(8) << std::setfill('0') << dump_index++ << ".bin";
+  if (!Save_BA_Problem(sfm_data, options, ba_options, os.str()))
+  {
+    std::cerr << "Cannot save the Bundle Adjustment problem to: " << os.str() << std::endl;
+  }
+}
+
+/// Collect the statistics of a solver run
+void FillStatistics
+(
+  const ceres::Solver::Summary & summary,
+  Bundle_Adjustment_Ceres::BA_Ceres_statistics & statistics
+)
+{
+  statistics.num_iterations = summary.iterations.size();
+  statistics.num_residuals = summary.num_residuals;
+  statistics.initial_cost = summary.initial_cost;
+  statistics.final_cost = summary.final_cost;
+  statistics.total_time = summary.total_time_in_seconds;
+  statistics.preprocessor_time = summary.preprocessor_time_in_seconds;
+  statistics.minimizer_time = summary.minimizer_time_in_seconds;
+  statistics.residual_evaluation_time = summary.residual_evaluation_time_in_seconds;
+  statistics.jacobian_evaluation_time = summary.jacobian_evaluation_time_in_seconds;
+  statistics.linear_solver_time = summary.linear_solver_time_in_seconds;
+  statistics.linear_solver_type =
+    ceres::LinearSolverTypeToString(summary.linear_solver_type_used);
+}
+
 Bundle_Adjustment_Ceres::BA_Ceres_options::BA_Ceres_options
 (
   const bool bVerbose,
@@ -112,7 +326,14 @@ Bundle_Adjustment_Ceres::BA_Ceres_options::BA_Ceres_options
 : bVerbose_(bVerbose),
   nb_threads_(1),
   parameter_tolerance_(1e-8), //~= numeric_limits<float>::epsilon()
-  bUse_loss_function_(true)
+  bUse_loss_function_(true),
+  max_num_iterations_(500),
+  max_solver_time_(0.0),
+  large_scene_pose_threshold_(10000),
+  large_scene_preconditioner_type_(ceres::SCHUR_JACOBI),
+  visibility_clustering_type_(ceres::SINGLE_LINKAGE),
+  bUse_explicit_schur_ordering_(true),
+  bUse_inner_iterations_(false)
 {
   #ifdef OPENMVG_USE_OPENMP
     nb_threads_ = omp_get_max_threads();
@@ -120,6 +341,11 @@ Bundle_Adjustment_Ceres::BA_Ceres_options::BA_Ceres_options
   if (!bmultithreaded)
     nb_threads_ = 1;
 
+  // Let the user save the problems of any pipeline without rebuilding it
+  const char * problem_dump_prefix = std::getenv("OPENMVG_BA_PROBLEM_DUMP_PREFIX");
+  if (problem_dump_prefix)
+    problem_dump_prefix_ = problem_dump_prefix;
+
   bCeres_summary_ = false;
 
   // Default configuration use a DENSE representation
@@ -146,6 +372,21 @@ Bundle_Adjustment_Ceres::BA_Ceres_options::BA_Ceres_options
       linear_solver_type_ = ceres::SPARSE_SCHUR;
     }
   }
+
+  // The visibility based preconditioners are only available with SuiteSparse
+  if (ceres::IsSparseLinearAlgebraLibraryTypeAvailable(ceres::SUITE_SPARSE))
+  {
+    large_scene_preconditioner_type_ = ceres::CLUSTER_JACOBI;
+  }
+}
+
+bool Bundle_Adjustment_Ceres::BA_Ceres_options::IsLargeScene
+(
+  const std::size_t nb_poses
+) const
+{
+  return large_scene_pose_threshold_ > 0
+    && nb_poses >= large_scene_pose_threshold_;
 }
 
 
@@ -162,12 +403,21 @@ Bundle_Adjustment_Ceres::ceres_options()
   return ceres_options_;
 }
 
+const Bundle_Adjustment_Ceres::BA_Ceres_statistics &
+Bundle_Adjustment_Ceres::statistics() const
+{
+  return statistics_;
+}
+
 bool Bundle_Adjustment_Ceres::Adjust
 (
   SfM_Data & sfm_data,     // the SfM scene to refine
   const Optimize_Options & options
 )
 {
+  DumpProblem(sfm_data, options, ceres_options_);
+  statistics_ = BA_Ceres_statistics();
+
   //----------
   // Add camera parameters
   // - intrinsics
@@ -246,44 +496,10 @@ bool Bundle_Adjustment_Ceres::Adjust
   {
     const IndexT indexPose = pose_it.first;
 
-    const Pose3 & pose = pose_it.second;
-    const Mat3 R = pose.rotation();
-    const Vec3 t = pose.translation();
-
-    double angleAxis[3];
-    ceres::RotationMatrixToAngleAxis((const double*)R.data(), angleAxis);
     // angleAxis + translation
-    map_poses[indexPose] = {angleAxis[0], angleAxis[1], angleAxis[2], t(0), t(1), t(2)};
-
-    double * parameter_block = &map_poses.at(indexPose)[0];
-    problem.AddParameterBlock(parameter_block, 6);
-    if (options.extrinsics_opt == Extrinsic_Parameter_Type::NONE)
-    {
-      // set the whole parameter block as constant for best performance
-      problem.SetParameterBlockConstant(parameter_block);
-    }
-    else  // Subset parametrization
-    {
-      std::vector<int> vec_constant_extrinsic;
-      // If we adjust only the translation, we must set ROTATION as constant
-      if (options.extrinsics_opt == Extrinsic_Parameter_Type::ADJUST_TRANSLATION)
-      {
-        // Subset rotation parametrization
-        vec_constant_extrinsic.insert(vec_constant_extrinsic.end(), {0,1,2});
-      }
-      // If we adjust only the rotation, we must set TRANSLATION as constant
-      if (options.extrinsics_opt == Extrinsic_Parameter_Type::ADJUST_ROTATION)
-      {
-        // Subset translation parametrization
-        vec_constant_extrinsic.insert(vec_constant_extrinsic.end(), {3,4,5});
-      }
-      if (!vec_constant_extrinsic.empty())
-      {
-        ceres::SubsetParameterization *subset_parameterization =
-          new ceres::SubsetParameterization(6, vec_constant_extrinsic);
-        problem.SetParameterization(parameter_block, subset_parameterization);
-      }
-    }
+    map_poses[indexPose].resize(6);
+    PoseToParameterBlock(pose_it.second, &map_poses.at(indexPose)[0]);
+    AddPoseParameterBlock(problem, &map_poses.at(indexPose)[0], options.extrinsics_opt);
   }
 
   // Setup Intrinsics data & subparametrization
@@ -296,25 +512,8 @@ bool Bundle_Adjustment_Ceres::Adjust
       map_intrinsics[indexCam] = intrinsic_it.second->getParams();
       if (!map_intrinsics.at(indexCam).empty())
       {
-        double * parameter_block = &map_intrinsics.at(indexCam)[0];
-        problem.AddParameterBlock(parameter_block, map_intrinsics.at(indexCam).size());
-        if (options.intrinsics_opt == Intrinsic_Parameter_Type::NONE)
-        {
-          // set the whole parameter block as constant for best performance
-          problem.SetParameterBlockConstant(parameter_block);
-        }
-        else
-        {
-          const std::vector<int> vec_constant_intrinsic =
-            intrinsic_it.second->subsetParameterization(options.intrinsics_opt);
-          if (!vec_constant_intrinsic.empty())
-          {
-            ceres::SubsetParameterization *subset_parameterization =
-              new ceres::SubsetParameterization(
-                map_intrinsics.at(indexCam).size(), vec_constant_intrinsic);
-            problem.SetParameterization(parameter_block, subset_parameterization);
-          }
-        }
+        AddIntrinsicParameterBlock(problem, map_intrinsics.at(indexCam),
+          *intrinsic_it.second, options.intrinsics_opt);
       }
     }
     else
@@ -453,26 +652,21 @@ bool Bundle_Adjustment_Ceres::Adjust
   }
 
   // Configure a BA engine and run it
-  //  Make Ceres automatically detect the bundle structure.
+  std::set<double*> camera_blocks;
+  for (auto & pose_it : map_poses)
+    camera_blocks.insert(&pose_it.second[0]);
+  for (auto & intrinsic_it : map_intrinsics)
+    if (!intrinsic_it.second.empty())
+      camera_blocks.insert(&intrinsic_it.second[0]);
+
   ceres::Solver::Options ceres_config_options;
-  ceres_config_options.max_num_iterations = 500;
-  ceres_config_options.preconditioner_type =
-    static_cast<ceres::PreconditionerType>(ceres_options_.preconditioner_type_);
-  ceres_config_options.linear_solver_type =
-    static_cast<ceres::LinearSolverType>(ceres_options_.linear_solver_type_);
-  ceres_config_options.sparse_linear_algebra_library_type =
-    static_cast<ceres::SparseLinearAlgebraLibraryType>(ceres_options_.sparse_linear_algebra_library_type_);
-  ceres_config_options.minimizer_progress_to_stdout = ceres_options_.bVerbose_;
-  ceres_config_options.logging_type = ceres::SILENT;
-  ceres_config_options.num_threads = ceres_options_.nb_threads_;
-#if CERES_VERSION_MAJOR < 2
-  ceres_config_options.num_linear_solver_threads = ceres_options_.nb_threads_;
-#endif
-  ceres_config_options.parameter_tolerance = ceres_options_.parameter_tolerance_;
+  const bool b_large_scene = ConfigureSolver(
+    ceres_options_, sfm_data.poses.size(), camera_blocks, problem, ceres_config_options);
 
   // Solve BA
   ceres::Solver::Summary summary;
   ceres::Solve(ceres_config_options, &problem, &summary);
+  FillStatistics(summary, statistics_);
   if (ceres_options_.bCeres_summary_)
     std::cout << summary.FullReport() << std::endl;
 
@@ -498,6 +692,9 @@ bool Bundle_Adjustment_Ceres::Adjust
         << " Initial RMSE: " << std::sqrt( summary.initial_cost / summary.num_residuals) << "\n"
         << " Final RMSE: " << std::sqrt( summary.final_cost / summary.num_residuals) << "\n"
         << " Time (s): " << summary.total_time_in_seconds << "\n"
+        << " Linear solver: "
+        << ceres::LinearSolverTypeToString(summary.linear_solver_type_used)
+        << (b_large_scene ? " (large scene mode)" : "") << "\n"
         << std::endl;
       if (options.use_motion_priors_opt)
         std::cout << "Usable motion priors: " << (int)b_usable_prior << std::endl;
@@ -510,12 +707,8 @@ bool Bundle_Adjustment_Ceres::Adjust
       {
         const IndexT indexPose = pose_it.first;
 
-        Mat3 R_refined;
-        ceres::AngleAxisToRotationMatrix(&map_poses.at(indexPose)[0], R_refined.data());
-        Vec3 t_refined(map_poses.at(indexPose)[3], map_poses.at(indexPose)[4], map_poses.at(indexPose)[5]);
         // Update the pose
-        Pose3 & pose = pose_it.second;
-        pose = Pose3(R_refined, -R_refined.transpose() * t_refined);
+        pose_it.second = ParameterBlockToPose(&map_poses.at(indexPose)[0]);
       }
     }
 
@@ -569,5 +762,347 @@ bool Bundle_Adjustment_Ceres::Adjust
   }
 }
 
+/// Parameter & residual blocks kept alive between two Adjust calls
+struct Bundle_Adjustment_Ceres_Persistent::Problem_State
+{
+  Problem_State
+  (
+    const SfM_Data & sfm_data,
+    const Optimize_Options & options,
+    const bool b_use_loss_function
+  )
+  : problem(ProblemOptions()),
+    loss_function(b_use_loss_function ? new ceres::HuberLoss(Square(4.0)) : nullptr),
+    scene(&sfm_data),
+    optimize_options(options),
+    b_use_loss_function(b_use_loss_function)
+  {}
+
+  static ceres::Problem::Options ProblemOptions()
+  {
+    ceres::Problem::Options problem_options;
+    // Blocks are removed when the scene is cleaned between two adjustments
+    problem_options.enable_fast_removal = true;
+    // The loss function is shared by all the residuals
+    problem_options.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+    return problem_options;
+  }
+
+  // Tell if the problem structure can be reused for this scene & options
+  bool IsCompatible
+  (
+    const SfM_Data & sfm_data,
+    const Optimize_Options & options,
+    const bool b_use_loss
+  ) const
+  {
+    if (scene != &sfm_data
+        || optimize_options.intrinsics_opt != options.intrinsics_opt
+        || optimize_options.extrinsics_opt != options.extrinsics_opt
+        || optimize_options.structure_opt != options.structure_opt
+        || b_use_loss_function != b_use_loss)
+      return false;
+
+    // Removing a camera block would leave dangling residuals, rebuild instead
+    for (const auto & pose_it : poses)
+      if (sfm_data.poses.count(pose_it.first) == 0)
+        return false;
+    for (const auto & intrinsic_it : intrinsics)
+    {
+      const auto it = sfm_data.intrinsics.find(intrinsic_it.first);
+      if (it == sfm_data.intrinsics.end()
+          || it->second->getParams().size() != intrinsic_it.second.size())
+        return false;
+    }
+    return true;
+  }
+
+  struct Pose_Block
+  {
+    std::array<double, 6> parameters; // angleAxis + translation
+    Pose3 synced_pose; // The pose the parameter block was computed from
+  };
+
+  struct Landmark_Block
+  {
+    double * X = nullptr; // Landmark position used in place as the parameter block
+    // Reprojection residuals: {view id, {feature id, residual block id}}
+    Hash_Map<IndexT, std::pair<IndexT, ceres::ResidualBlockId>> residuals;
+  };
+
+  ceres::Problem problem;
+  std::unique_ptr<ceres::LossFunction> loss_function;
+  const SfM_Data * scene;
+  Optimize_Options optimize_options;
+  bool b_use_loss_function;
+
+  // Hash_Map nodes are stable in memory, so the parameter blocks addresses are.
+  Hash_Map<IndexT, Pose_Block> poses;
+  Hash_Map<IndexT, std::vector<double>> intrinsics;
+  Hash_Map<IndexT, Landmark_Block> landmarks;
+};
+
+Bundle_Adjustment_Ceres_Persistent::Bundle_Adjustment_Ceres_Persistent
+(
+  const Bundle_Adjustment_Ceres::BA_Ceres_options & options
+)
+: Bundle_Adjustment_Ceres(options)
+{}
+
+Bundle_Adjustment_Ceres_Persistent::~Bundle_Adjustment_Ceres_Persistent() = default;
+
+void Bundle_Adjustment_Ceres_Persistent::Reset()
+{
+  state_.reset();
+}
+
+bool Bundle_Adjustment_Ceres_Persistent::Adjust
+(
+  SfM_Data & sfm_data,     // the SfM scene to refine
+  const Optimize_Options & options
+)
+{
+  // The motion prior mode moves the whole scene & GCP are not part of the
+  // structure: let the one shot BA handle those cases.
+  if (options.use_motion_priors_opt || options.control_point_opt.bUse_control_points)
+  {
+    return Bundle_Adjustment_Ceres::Adjust(sfm_data, options);
+  }
+
+  const BA_Ceres_options & ceres_options = this->ceres_options();
+  DumpProblem(sfm_data, options, ceres_options);
+  statistics_ = BA_Ceres_statistics();
+
+  if (state_ &&
+      !state_->IsCompatible(sfm_data, options, ceres_options.bUse_loss_function_))
+  {
+    state_.reset();
+  }
+  if (!state_)
+  {
+    state_.reset(new Problem_State(sfm_data, options, ceres_options.bUse_loss_function_));
+  }
+  ceres::Problem & problem = state_->problem;
+
+  //----------
+  // Sync the camera parameters
+  // - poses [R|t] (converted only if they were updated outside of the BA)
+  // - intrinsics
+  //----------
+  for (const auto & pose_it : sfm_data.poses)
+  {
+    auto block_it = state_->poses.find(pose_it.first);
+    if (block_it == state_->poses.end())
+    {
+      block_it = state_->poses.insert({pose_it.first, Problem_State::Pose_Block()}).first;
+      PoseToParameterBlock(pose_it.second, block_it->second.parameters.data());
+      block_it->second.synced_pose = pose_it.second;
+      AddPoseParameterBlock(problem, block_it->second.parameters.data(), options.extrinsics_opt);
+    }
+    else
+    {
+      Problem_State::Pose_Block & block = block_it->second;
+      if (block.synced_pose.rotation() != pose_it.second.rotation()
+          || block.synced_pose.center() != pose_it.second.center())
+      {
+        PoseToParameterBlock(pose_it.second, block.parameters.data());
+        block.synced_pose = pose_it.second;
+      }
+    }
+  }
+
+  for (const auto & intrinsic_it : sfm_data.intrinsics)
+  {
+    if (!isValid(intrinsic_it.second->getType()))
+    {
+      std::cerr << "Unsupported camera type." << std::endl;
+      continue;
+    }
+    auto block_it = state_->intrinsics.find(intrinsic_it.first);
+    if (block_it == state_->intrinsics.end())
+    {
+      block_it = state_->intrinsics.insert(
+        {intrinsic_it.first, intrinsic_it.second->getParams()}).first;
+      if (!block_it->second.empty())
+      {
+        AddIntrinsicParameterBlock(problem, block_it->second,
+          *intrinsic_it.second, options.intrinsics_opt);
+      }
+    }
+    else
+    {
+      // Copy in place (the parameter block address must not change)
+      const std::vector<double> params = intrinsic_it.second->getParams();
+      std::copy(params.cbegin(), params.cend(), block_it->second.begin());
+    }
+  }
+
+  //----------
+  // Sync the structure
+  //----------
+
+  // 1. Drop the landmarks that have been removed or reallocated.
+  //    It must be done before any addition since a reallocated landmark
+  //    can take the address of a dropped one.
+  for (auto it = state_->landmarks.begin(); it != state_->landmarks.end(); )
+  {
+    const auto landmark_it = sfm_data.structure.find(it->first);
+    if (landmark_it == sfm_data.structure.end()
+        || landmark_it->second.X.data() != it->second.X)
+    {
+      if (problem.HasParameterBlock(it->second.X))
+        problem.RemoveParameterBlock(it->second.X); // remove its residuals too
+      it = state_->landmarks.erase(it);
+    }
+    else
+      ++it;
+  }
+
+  // 2. Update the observations of the landmarks & add the new ones
+  for (auto & structure_landmark_it : sfm_data.structure)
+  {
+    const Observations & obs = structure_landmark_it.second.obs;
+    double * X = structure_landmark_it.second.X.data();
+
+    Problem_State::Landmark_Block & block = state_->landmarks[structure_landmark_it.first];
+    const bool b_new_landmark = (block.X == nullptr);
+    block.X = X;
+
+    // Drop the residuals of the removed observations
+    for (auto residual_it = block.residuals.begin(); residual_it != block.residuals.end(); )
+    {
+      const auto obs_it = obs.find(residual_it->first);
+      if (obs_it == obs.end() || obs_it->second.id_feat != residual_it->second.first)
+      {
+        problem.RemoveResidualBlock(residual_it->second.second);
+        residual_it = block.residuals.erase(residual_it);
+      }
+      else
+        ++residual_it;
+    }
+
+    // Add the residuals of the new observations
+    for (const auto & obs_it : obs)
+    {
+      if (block.residuals.count(obs_it.first))
+        continue;
+
+      const View * view = sfm_data.views.at(obs_it.first).get();
+      // The observations of an unsupported camera model are skipped
+      const auto intrinsic_block_it = state_->intrinsics.find(view->id_intrinsic);
+      if (intrinsic_block_it == state_->intrinsics.end())
+        continue;
+
+      ceres::CostFunction* cost_function =
+        IntrinsicsToCostFunction(sfm_data.intrinsics.at(view->id_intrinsic).get(),
+                                 obs_it.second.x);
+      if (!cost_function)
+      {
+        std::cerr << "Cannot create a CostFunction for this camera model." << std::endl;
+        Reset();
+        return false;
+      }
+
+      std::vector<double> & intrinsic_block = intrinsic_block_it->second;
+      double * pose_block = state_->poses.at(view->id_pose).parameters.data();
+      const ceres::ResidualBlockId residual_id = intrinsic_block.empty() ?
+        problem.AddResidualBlock(cost_function,
+          state_->loss_function.get(),
+          pose_block,
+          X)
+        : problem.AddResidualBlock(cost_function,
+          state_->loss_function.get(),
+          &intrinsic_block[0],
+          pose_block,
+          X);
+      block.residuals[obs_it.first] = {obs_it.second.id_feat, residual_id};
+    }
+
+    if (block.residuals.empty())
+    {
+      // A landmark without observation is not part of the problem
+      if (problem.HasParameterBlock(X))
+        problem.RemoveParameterBlock(X);
+      state_->landmarks.erase(structure_landmark_it.first);
+    }
+    else if (b_new_landmark && options.structure_opt == Structure_Parameter_Type::NONE)
+    {
+      problem.SetParameterBlockConstant(X);
+    }
+  }
+
+  //----------
+  // Configure a BA engine and run it
+  //----------
+  std::set<double*> camera_blocks;
+  for (auto & pose_it : state_->poses)
+    camera_blocks.insert(pose_it.second.parameters.data());
+  for (auto & intrinsic_it : state_->intrinsics)
+    if (!intrinsic_it.second.empty())
+      camera_blocks.insert(&intrinsic_it.second[0]);
+
+  ceres::Solver::Options ceres_config_options;
+  const bool b_large_scene = ConfigureSolver(
+    ceres_options, sfm_data.poses.size(), camera_blocks, problem, ceres_config_options);
+
+  ceres::Solver::Summary summary;
+  ceres::Solve(ceres_config_options, &problem, &summary);
+  FillStatistics(summary, statistics_);
+  if (ceres_options.bCeres_summary_)
+    std::cout << summary.FullReport() << std::endl;
+
+  if (!summary.IsSolutionUsable())
+  {
+    if (ceres_options.bVerbose_)
+      std::cout << "Bundle Adjustment failed." << std::endl;
+    // The parameter blocks may hold an unusable solution
+    Reset();
+    return false;
+  }
+
+  if (ceres_options.bVerbose_)
+  {
+    // Display statistics about the minimization
+    std::cout << std::endl
+      << "Bundle Adjustment statistics (approximated RMSE):\n"
+      << " #views: " << sfm_data.views.size() << "\n"
+      << " #poses: " << sfm_data.poses.size() << "\n"
+      << " #intrinsics: " << sfm_data.intrinsics.size() << "\n"
+      << " #tracks: " << sfm_data.structure.size() << "\n"
+      << " #residuals: " << summary.num_residuals << "\n"
+      << " Initial RMSE: " << std::sqrt( summary.initial_cost / summary.num_residuals) << "\n"
+      << " Final RMSE: " << std::sqrt( summary.final_cost / summary.num_residuals) << "\n"
+      << " Time (s): " << summary.total_time_in_seconds << "\n"
+      << " Linear solver: "
+      << ceres::LinearSolverTypeToString(summary.linear_solver_type_used)
+      << (b_large_scene ? " (large scene mode)" : "") << "\n"
+      << std::endl;
+  }
+
+  // Update camera poses with refined data
+  if (options.extrinsics_opt != Extrinsic_Parameter_Type::NONE)
+  {
+    for (auto & pose_it : sfm_data.poses)
+    {
+      Problem_State::Pose_Block & block = state_->poses.at(pose_it.first);
+      pose_it.second = block.synced_pose = ParameterBlockToPose(block.parameters.data());
+    }
+  }
+
+  // Update camera intrinsics with refined data
+  if (options.intrinsics_opt != Intrinsic_Parameter_Type::NONE)
+  {
+    for (auto & intrinsic_it : sfm_data.intrinsics)
+    {
+      const auto block_it = state_->intrinsics.find(intrinsic_it.first);
+      if (block_it != state_->intrinsics.end())
+        intrinsic_it.second->updateFromParams(block_it->second);
+    }
+  }
+
+  // Structure is already updated directly (no data wrapping)
+  return true;
+}
+
 } // namespace sfm
 } // namespace openMVG
@@ -12,6 +12,9 @@
 #include "openMVG/numeric/eigen_alias_definition.hpp"
 #include "openMVG/sfm/sfm_data_BA.hpp"
 
+#include <memory>
+#include <string>
+
 namespace ceres { class CostFunction; }
 namespace openMVG { namespace cameras { struct IntrinsicBase; } }
 namespace openMVG { namespace sfm { struct SfM_Data; } }
@@ -41,12 +44,56 @@ class Bundle_Adjustment_Ceres : public Bundle_Adjustment
     int sparse_linear_algebra_library_type_;
     double parameter_tolerance_;
     bool bUse_loss_function_;
+    // Bound the cost of an Adjust call (i.e for real-time local adjustments)
+    int max_num_iterations_;
+    double max_solver_time_; // seconds (0: no limit)
+
+    // Large scene mode:
+    // Once the number of poses reaches large_scene_pose_threshold_ (0 disables
+    // the mode), the reduced camera matrix is no longer factorized
+    // (SPARSE_SCHUR memory grows too fast) and an ITERATIVE_SCHUR solver with
+    // the large_scene_preconditioner_type_ preconditioner is used instead.
+    unsigned int large_scene_pose_threshold_;
+    int large_scene_preconditioner_type_;
+    int visibility_clustering_type_; // used by the CLUSTER_* preconditioners
+    // Provide an explicit elimination ordering (landmarks first, then the
+    // camera blocks) for the Schur based solvers, instead of letting Ceres
+    // compute an independent set on the whole problem.
+    bool bUse_explicit_schur_ordering_;
+    // Run a non-linear block coordinate descent after each LM step
+    bool bUse_inner_iterations_;
+    // If not empty, the input of each Adjust call is saved to the
+    // "<problem_dump_prefix_><call index>.bin" file (see Save_BA_Problem).
+    // Default: the OPENMVG_BA_PROBLEM_DUMP_PREFIX environment variable.
+    std::string problem_dump_prefix_;
 
     BA_Ceres_options(const bool bVerbose = true, bool bmultithreaded = true);
+
+    // Tell if the large scene mode must be used for a scene with nb_poses poses
+    bool IsLargeScene(const std::size_t nb_poses) const;
+  };
+
+  /// Statistics of the last Adjust call (times are expressed in seconds)
+  struct BA_Ceres_statistics
+  {
+    int num_iterations = 0;
+    int num_residuals = 0;
+    double initial_cost = 0.0;
+    double final_cost = 0.0;
+    double total_time = 0.0;
+    double preprocessor_time = 0.0;
+    double minimizer_time = 0.0;
+    double residual_evaluation_time = 0.0;
+    double jacobian_evaluation_time = 0.0;
+    double linear_solver_time = 0.0;
+    std::string linear_solver_type; // linear solver that was used
   };
   private:
     BA_Ceres_options ceres_options_;
 
+  protected:
+    BA_Ceres_statistics statistics_;
+
   public:
   explicit Bundle_Adjustment_Ceres
   (
@@ -56,6 +103,39 @@ class Bundle_Adjustment_Ceres : public Bundle_Adjustment
 
   BA_Ceres_options & ceres_options();
 
+  const BA_Ceres_statistics & statistics() const;
+
+  bool Adjust
+  (
+    // the SfM scene to refine
+    sfm::SfM_Data & sfm_data,
+    // tell which parameter needs to be adjusted
+    const Optimize_Options & options
+  ) override;
+};
+
+/// Bundle Adjustment that keeps its ceres problem alive across the Adjust calls.
+/// An incremental pipeline adjusts a growing scene many times: only the
+/// parameter & residual blocks of the new poses, intrinsics, landmarks and
+/// observations are added to the problem (the removed ones are dropped).
+/// - Landmarks are adjusted in place (the landmark position is the parameter block).
+/// - Poses and intrinsics are converted again only if they were modified
+///   outside of the adjustment since the last call.
+/// The problem is rebuilt from scratch if the Optimize_Options change or if
+/// some poses or intrinsics are removed from the scene.
+/// Note: Motion priors and control points are handled by the one shot
+///  Bundle_Adjustment_Ceres::Adjust.
+class Bundle_Adjustment_Ceres_Persistent : public Bundle_Adjustment_Ceres
+{
+  public:
+  explicit Bundle_Adjustment_Ceres_Persistent
+  (
+    const Bundle_Adjustment_Ceres::BA_Ceres_options & options =
+    std::move(BA_Ceres_options())
+  );
+
+  ~Bundle_Adjustment_Ceres_Persistent() override;
+
   bool Adjust
   (
     // the SfM scene to refine
@@ -63,6 +143,13 @@ class Bundle_Adjustment_Ceres : public Bundle_Adjustment
     // tell which parameter needs to be adjusted
     const Optimize_Options & options
   ) override;
+
+  /// Release the persistent problem (the next Adjust call will rebuild it)
+  void Reset();
+
+  private:
+    struct Problem_State;
+    std::unique_ptr<Problem_State> state_;
 };
 
 } // namespace sfm
@@ -0,0 +1,151 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+// The <cereal/archives> headers are special and must be included first.
+#include <cereal/archives/portable_binary.hpp>
+
+#include "openMVG/sfm/sfm_data_BA_ceres_io.hpp"
+
+#include "openMVG/cameras/cameras_io.hpp"
+#include "openMVG/geometry/pose3_io.hpp"
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_landmark_io.hpp"
+#include "openMVG/sfm/sfm_view_io.hpp"
+#include "openMVG/sfm/sfm_view_priors_io.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <cereal/types/map.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/unordered_map.hpp>
+#include <cereal/types/vector.hpp>
+
+namespace openMVG {
+namespace sfm {
+
+// File signature & version of the Bundle Adjustment problem files
+static const std::string kBA_Problem_Signature = "openMVG_BA_problem";
+static const std::string kBA_Problem_Version = "0.2";
+
+template <class Archive>
+void serialize_BA_Options
+(
+  Archive & ar,
+  Optimize_Options & optimize_options,
+  Bundle_Adjustment_Ceres::BA_Ceres_options & ceres_options
+)
+{
+  // Enum classes are stored as their underlying integer values
+  int intrinsics_opt = static_cast<int>(optimize_options.intrinsics_opt);
+  int extrinsics_opt = static_cast<int>(optimize_options.extrinsics_opt);
+  bool structure_opt = static_cast<bool>(optimize_options.structure_opt);
+  ar(intrinsics_opt,
+     extrinsics_opt,
+     structure_opt,
+     optimize_options.control_point_opt.weight,
+     optimize_options.control_point_opt.bUse_control_points,
+     optimize_options.use_motion_priors_opt);
+  optimize_options.intrinsics_opt = static_cast<cameras::Intrinsic_Parameter_Type>(intrinsics_opt);
+  optimize_options.extrinsics_opt = static_cast<Extrinsic_Parameter_Type>(extrinsics_opt);
+  optimize_options.structure_opt = static_cast<Structure_Parameter_Type>(structure_opt);
+
+  ar(ceres_options.nb_threads_,
+     ceres_options.linear_solver_type_,
+     ceres_options.preconditioner_type_,
+     ceres_options.sparse_linear_algebra_library_type_,
+     ceres_options.parameter_tolerance_,
+     ceres_options.bUse_loss_function_,
+     ceres_options.max_num_iterations_,
+     ceres_options.max_solver_time_,
+     ceres_options.large_scene_pose_threshold_,
+     ceres_options.large_scene_preconditioner_type_,
+     ceres_options.visibility_clustering_type_,
+     ceres_options.bUse_explicit_schur_ordering_,
+     ceres_options.bUse_inner_iterations_);
+}
+
+bool Save_BA_Problem
+(
+  const SfM_Data & sfm_data,
+  const Optimize_Options & optimize_options,
+  const Bundle_Adjustment_Ceres::BA_Ceres_options & ceres_options,
+  const std::string & filename
+)
+{
+  std::ofstream stream(filename.c_str(), std::ios::binary | std::ios::out);
+  if (!stream.is_open())
+    return false;
+
+  try
+  {
+    cereal::PortableBinaryOutputArchive archive(stream);
+    archive(kBA_Problem_Signature, kBA_Problem_Version);
+
+    // The scene (the root path is not needed to replay the problem)
+    archive(sfm_data.views,
+            sfm_data.intrinsics,
+            sfm_data.poses,
+            sfm_data.structure,
+            sfm_data.control_points);
+
+    // The options are copied since the serialization function is shared
+    Optimize_Options optimize_options_copy = optimize_options;
+    Bundle_Adjustment_Ceres::BA_Ceres_options ceres_options_copy = ceres_options;
+    serialize_BA_Options(archive, optimize_options_copy, ceres_options_copy);
+  }
+  catch (const cereal::Exception & e)
+  {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+  return stream.good();
+}
+
+bool Load_BA_Problem
+(
+  SfM_Data & sfm_data,
+  Optimize_Options & optimize_options,
+  Bundle_Adjustment_Ceres::BA_Ceres_options & ceres_options,
+  const std::string & filename
+)
+{
+  std::ifstream stream(filename.c_str(), std::ios::binary | std::ios::in);
+  if (!stream.is_open())
+    return false;
+
+  try
+  {
+    cereal::PortableBinaryInputArchive archive(stream);
+    std::string signature, version;
+    archive(signature, version);
+    if (signature != kBA_Problem_Signature || version != kBA_Problem_Version)
+    {
+      std::cerr << "Invalid Bundle Adjustment problem file: " << filename << std::endl;
+      return false;
+    }
+
+    archive(sfm_data.views,
+            sfm_data.intrinsics,
+            sfm_data.poses,
+            sfm_data.structure,
+            sfm_data.control_points);
+
+    serialize_BA_Options(archive, optimize_options, ceres_options);
+  }
+  catch (const cereal::Exception & e)
+  {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+} // namespace sfm
+} // namespace openMVG
@@ -0,0 +1,44 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SFM_SFM_DATA_BA_CERES_IO_HPP
+#define OPENMVG_SFM_SFM_DATA_BA_CERES_IO_HPP
+
+#include "openMVG/sfm/sfm_data_BA_ceres.hpp"
+
+#include <string>
+
+namespace openMVG {
+namespace sfm {
+
+/// Save the input of a Bundle_Adjustment_Ceres::Adjust call to a portable
+/// binary file, in order to replay it offline (see openMVG_main_BA_Benchmark):
+/// - the scene (views, intrinsics, poses, structure and control points),
+/// - the parameters that must be refined,
+/// - the solver configuration.
+bool Save_BA_Problem
+(
+  const SfM_Data & sfm_data,
+  const Optimize_Options & optimize_options,
+  const Bundle_Adjustment_Ceres::BA_Ceres_options & ceres_options,
+  const std::string & filename
+);
+
+/// Load a Bundle Adjustment problem saved by Save_BA_Problem
+bool Load_BA_Problem
+(
+  SfM_Data & sfm_data,
+  Optimize_Options & optimize_options,
+  Bundle_Adjustment_Ceres::BA_Ceres_options & ceres_options,
+  const std::string & filename
+);
+
+} // namespace sfm
+} // namespace openMVG
+
+#endif // OPENMVG_SFM_SFM_DATA_BA_CERES_IO_HPP
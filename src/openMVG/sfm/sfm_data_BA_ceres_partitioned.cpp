@@ -0,0 +1,917 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/sfm/sfm_data_BA_ceres_partitioned.hpp"
+
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_data_BA_ceres_utils.hpp"
+#include "openMVG/system/timer.hpp"
+
+#include <ceres/ceres.h>
+#include <ceres/rotation.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <utility>
+
+namespace openMVG {
+namespace sfm {
+
+using namespace openMVG::cameras;
+using namespace openMVG::geometry;
+
+/// Consensus penalty of a shared variable: residual = weight * (x - target)
+/// with weight = sqrt(rho * scale) and target = z - u.
+class ConsensusCostFunction : public ceres::CostFunction
+{
+public:
+  ConsensusCostFunction
+  (
+    const std::vector<double> & target,
+    const double weight
+  )
+  : target_(target), weight_(weight)
+  {
+    set_num_residuals(target_.size());
+    mutable_parameter_block_sizes()->push_back(target_.size());
+  }
+
+  bool Evaluate
+  (
+    double const* const* parameters,
+    double* residuals,
+    double** jacobians
+  ) const override
+  {
+    const int size = target_.size();
+    for (int i = 0; i < size; ++i)
+      residuals[i] = weight_ * (parameters[0][i] - target_[i]);
+    if (jacobians != nullptr && jacobians[0] != nullptr)
+    {
+      Eigen::Map<Mat> jacobian(jacobians[0], size, size);
+      jacobian = weight_ * Mat::Identity(size, size);
+    }
+    return true;
+  }
+
+private:
+  const std::vector<double> target_;
+  const double weight_;
+};
+
+/// Consensus penalty of a shared pose [angleAxis, translation]:
+/// - the rotation residual is the angle axis of target_R^T * R,
+/// - the translation residual is (t - target_t),
+/// both weighted by sqrt(rho * scale).
+struct PoseConsensusFunctor
+{
+  PoseConsensusFunctor
+  (
+    const std::array<double, 6> & target,
+    const double weight
+  )
+  : weight_(weight)
+  {
+    ceres::AngleAxisToQuaternion(target.data(), target_rotation_inverse_.data());
+    for (int i = 1; i < 4; ++i)
+      target_rotation_inverse_[i] = -target_rotation_inverse_[i];
+    std::copy(target.cbegin() + 3, target.cend(), target_translation_.begin());
+  }
+
+  template <typename T>
+  bool operator()
+  (
+    const T* const pose,
+    T* residuals
+  ) const
+  {
+    const T target_rotation_inverse[4] = {
+      T(target_rotation_inverse_[0]), T(target_rotation_inverse_[1]),
+      T(target_rotation_inverse_[2]), T(target_rotation_inverse_[3])};
+    T rotation[4], delta_rotation[4];
+    ceres::AngleAxisToQuaternion(pose, rotation);
+    ceres::QuaternionProduct(target_rotation_inverse, rotation, delta_rotation);
+    ceres::QuaternionToAngleAxis(delta_rotation, residuals);
+    for (int i = 0; i < 3; ++i)
+    {
+      residuals[i] *= T(weight_);
+      residuals[3 + i] = T(weight_) * (pose[3 + i] - T(target_translation_[i]));
+    }
+    return true;
+  }
+
+  static ceres::CostFunction * Create
+  (
+    const std::array<double, 6> & target,
+    const double weight
+  )
+  {
+    return new ceres::AutoDiffCostFunction<PoseConsensusFunctor, 6, 6>(
+      new PoseConsensusFunctor(target, weight));
+  }
+
+  std::array<double, 4> target_rotation_inverse_;
+  std::array<double, 3> target_translation_;
+  double weight_;
+};
+
+/// Local copy of a shared variable in a cluster
+struct Consensus_Term
+{
+  int cluster_id;
+  std::vector<double> x; // last local value
+  std::vector<double> u; // scaled dual variable
+  // Stiffness of the variable in the cluster (mean of the diagonal of J^T J of
+  // its reprojection residuals, 0: not yet computed). The penalty of the term
+  // is rho * scale: rho is dimensionless (see Bundle_Adjustment_Ceres_Partitioned).
+  double scale = 0.0;
+};
+
+/// Consensus value of a variable shared by several clusters
+struct Consensus_Variable
+{
+  std::vector<double> z;
+  std::vector<double> z_previous;
+  std::vector<Consensus_Term> terms; // one per cluster that shares the variable
+
+  Consensus_Term & Term(const int cluster_id)
+  {
+    return *std::find_if(terms.begin(), terms.end(),
+      [cluster_id](const Consensus_Term & term) { return term.cluster_id == cluster_id; });
+  }
+  const Consensus_Term & Term(const int cluster_id) const
+  {
+    return const_cast<Consensus_Variable*>(this)->Term(cluster_id);
+  }
+};
+
+using Consensus_Variables = Hash_Map<IndexT, Consensus_Variable>;
+
+/// Rotation matrix of an angle axis vector
+static Mat3 AngleAxisToRotation(const double * angle_axis)
+{
+  Mat3 R;
+  ceres::AngleAxisToRotationMatrix(angle_axis, R.data());
+  return R;
+}
+
+/// Angle axis vector of a rotation matrix
+static Vec3 RotationToAngleAxis(const Mat3 & R)
+{
+  Vec3 angle_axis;
+  ceres::RotationMatrixToAngleAxis(R.data(), angle_axis.data());
+  return angle_axis;
+}
+
+/// Difference a - b of two values of a variable.
+/// For a pose, the rotation part is the angle axis of Rb^T * Ra (the
+/// difference in the tangent space of the rotation b).
+static std::vector<double> Difference
+(
+  const std::vector<double> & a,
+  const std::vector<double> & b,
+  const bool b_pose
+)
+{
+  std::vector<double> difference(a.size());
+  for (size_t i = 0; i < a.size(); ++i)
+    difference[i] = a[i] - b[i];
+  if (b_pose)
+  {
+    const Vec3 delta = RotationToAngleAxis(
+      AngleAxisToRotation(b.data()).transpose() * AngleAxisToRotation(a.data()));
+    std::copy(delta.data(), delta.data() + 3, difference.begin());
+  }
+  return difference;
+}
+
+/// Consensus step: z = mean(x + u), weighted by the term penalties.
+/// The rotation of a pose is the chordal L2 mean of the rotations R(x) * exp(u)
+/// (the weighted sum of the rotation matrices projected on SO(3)).
+static void UpdateConsensus
+(
+  Consensus_Variable & variable,
+  const bool b_pose
+)
+{
+  variable.z_previous = variable.z;
+  std::fill(variable.z.begin(), variable.z.end(), 0.0);
+  double scale_sum = 0.0;
+  for (const Consensus_Term & term : variable.terms)
+    scale_sum += term.scale;
+  for (const Consensus_Term & term : variable.terms)
+    for (size_t i = 0; i < term.x.size(); ++i)
+      variable.z[i] += term.scale * (term.x[i] + term.u[i]) / scale_sum;
+
+  if (b_pose)
+  {
+    Mat3 rotation_sum = Mat3::Zero();
+    for (const Consensus_Term & term : variable.terms)
+      rotation_sum += term.scale *
+        AngleAxisToRotation(term.x.data()) * AngleAxisToRotation(term.u.data());
+    const Eigen::JacobiSVD<Mat3> svd(rotation_sum, Eigen::ComputeFullU | Eigen::ComputeFullV);
+    Mat3 D = Mat3::Identity();
+    D(2, 2) = (svd.matrixU() * svd.matrixV().transpose()).determinant();
+    const Vec3 angle_axis =
+      RotationToAngleAxis(svd.matrixU() * D * svd.matrixV().transpose());
+    std::copy(angle_axis.data(), angle_axis.data() + 3, variable.z.begin());
+  }
+}
+
+/// Target of the consensus penalty of a local copy: z - u.
+/// For a pose, the target rotation is R(z) * exp(-u).
+static std::vector<double> ConsensusTarget
+(
+  const Consensus_Variable & variable,
+  const Consensus_Term & term,
+  const bool b_pose
+)
+{
+  std::vector<double> target(variable.z.size());
+  for (size_t i = 0; i < target.size(); ++i)
+    target[i] = variable.z[i] - term.u[i];
+  if (b_pose)
+  {
+    const Vec3 u(term.u[0], term.u[1], term.u[2]);
+    const Vec3 angle_axis = RotationToAngleAxis(
+      AngleAxisToRotation(variable.z.data()) * AngleAxisToRotation(Vec3(-u).data()));
+    std::copy(angle_axis.data(), angle_axis.data() + 3, target.begin());
+  }
+  return target;
+}
+
+Bundle_Adjustment_Ceres_Partitioned::BA_Partition_options::BA_Partition_options
+(
+  const bool bVerbose
+)
+: bVerbose_(bVerbose),
+  max_admm_iterations_(50),
+  rho_(1.0),
+  absolute_tolerance_(1e-6),
+  relative_tolerance_(1e-4),
+  local_max_iterations_(20),
+  local_function_tolerance_(1e-12)
+{
+}
+
+Bundle_Adjustment_Ceres_Partitioned::Bundle_Adjustment_Ceres_Partitioned
+(
+  const std::vector<std::set<IndexT>> & view_clusters,
+  const BA_Partition_options & partition_options,
+  const Bundle_Adjustment_Ceres::BA_Ceres_options & ceres_options
+)
+: view_clusters_(view_clusters),
+  partition_options_(partition_options),
+  ceres_options_(ceres_options)
+{}
+
+Bundle_Adjustment_Ceres_Partitioned::BA_Partition_options &
+Bundle_Adjustment_Ceres_Partitioned::partition_options()
+{
+  return partition_options_;
+}
+
+Bundle_Adjustment_Ceres::BA_Ceres_options &
+Bundle_Adjustment_Ceres_Partitioned::ceres_options()
+{
+  return ceres_options_;
+}
+
+const Bundle_Adjustment_Ceres_Partitioned::BA_Partition_statistics &
+Bundle_Adjustment_Ceres_Partitioned::statistics() const
+{
+  return statistics_;
+}
+
+/// Register the clusters that share a variable
+static void AddConsensusVariable
+(
+  Consensus_Variables & variables,
+  const IndexT id,
+  const std::vector<double> & value,
+  const std::set<int> & clusters
+)
+{
+  // The consensus starts from the input scene value
+  Consensus_Variable & variable = variables[id];
+  variable.z = value;
+  variable.z_previous = value;
+  for (const int cluster_id : clusters)
+  {
+    Consensus_Term term;
+    term.cluster_id = cluster_id;
+    term.x = value;
+    term.u.assign(value.size(), 0.0);
+    variable.terms.push_back(term);
+  }
+}
+
+bool Bundle_Adjustment_Ceres_Partitioned::Adjust
+(
+  SfM_Data & sfm_data,     // the SfM scene to refine
+  const Optimize_Options & options
+)
+{
+  statistics_ = BA_Partition_statistics();
+  if (options.use_motion_priors_opt)
+  {
+    std::cerr
+      << "Motion priors are not supported by the partitioned Bundle Adjustment,"
+      << " the whole scene is adjusted at once." << std::endl;
+    Bundle_Adjustment_Ceres bundle_adjustment_obj(ceres_options_);
+    return bundle_adjustment_obj.Adjust(sfm_data, options);
+  }
+
+  openMVG::system::Timer timer;
+  const int nb_clusters = view_clusters_.size();
+
+  //----------
+  // 1. Partition the scene:
+  // - List the clusters of each view,
+  // - List the landmarks (and control points) seen by each cluster,
+  // - Create the consensus variables (the variables seen by several clusters).
+  //----------
+  Hash_Map<IndexT, std::vector<int>> view_clusters; // view id -> cluster ids
+  Hash_Map<IndexT, std::set<int>> pose_clusters, intrinsic_clusters;
+  for (int cluster_id = 0; cluster_id < nb_clusters; ++cluster_id)
+  {
+    for (const IndexT view_id : view_clusters_[cluster_id])
+    {
+      const auto view_it = sfm_data.views.find(view_id);
+      if (view_it == sfm_data.views.end()
+          || !sfm_data.IsPoseAndIntrinsicDefined(view_it->second.get())
+          || !isValid(sfm_data.intrinsics.at(view_it->second->id_intrinsic)->getType()))
+        continue;
+      view_clusters[view_id].push_back(cluster_id);
+      pose_clusters[view_it->second->id_pose].insert(cluster_id);
+      intrinsic_clusters[view_it->second->id_intrinsic].insert(cluster_id);
+    }
+  }
+
+  // Ids of the landmarks observed by each cluster
+  const auto list_cluster_landmarks = [&]
+  (
+    const Landmarks & landmarks,
+    std::vector<std::vector<IndexT>> & cluster_landmarks,
+    Hash_Map<IndexT, std::set<int>> & landmark_clusters
+  )
+  {
+    cluster_landmarks.resize(nb_clusters);
+    for (const auto & landmark_it : landmarks)
+    {
+      std::set<int> & clusters = landmark_clusters[landmark_it.first];
+      for (const auto & obs_it : landmark_it.second.obs)
+      {
+        const auto it = view_clusters.find(obs_it.first);
+        if (it != view_clusters.end())
+          clusters.insert(it->second.cbegin(), it->second.cend());
+      }
+      for (const int cluster_id : clusters)
+        cluster_landmarks[cluster_id].push_back(landmark_it.first);
+    }
+  };
+  std::vector<std::vector<IndexT>> cluster_landmarks, cluster_control_points;
+  Hash_Map<IndexT, std::set<int>> landmark_clusters, control_point_clusters;
+  list_cluster_landmarks(sfm_data.structure, cluster_landmarks, landmark_clusters);
+  if (options.control_point_opt.bUse_control_points)
+    list_cluster_landmarks(sfm_data.control_points, cluster_control_points, control_point_clusters);
+  else
+    cluster_control_points.resize(nb_clusters);
+
+  Consensus_Variables pose_variables, intrinsic_variables, landmark_variables;
+  if (options.extrinsics_opt != Extrinsic_Parameter_Type::NONE)
+  {
+    for (const auto & it : pose_clusters)
+    {
+      if (it.second.size() > 1)
+      {
+        std::vector<double> pose_block(6);
+        PoseToParameterBlock(sfm_data.poses.at(it.first), pose_block.data());
+        AddConsensusVariable(pose_variables, it.first, pose_block, it.second);
+      }
+    }
+  }
+  if (options.intrinsics_opt != Intrinsic_Parameter_Type::NONE)
+  {
+    for (const auto & it : intrinsic_clusters)
+    {
+      const std::vector<double> params = sfm_data.intrinsics.at(it.first)->getParams();
+      if (it.second.size() > 1 && !params.empty())
+        AddConsensusVariable(intrinsic_variables, it.first, params, it.second);
+    }
+  }
+  if (options.structure_opt != Structure_Parameter_Type::NONE)
+  {
+    for (const auto & it : landmark_clusters)
+    {
+      if (it.second.size() > 1)
+      {
+        const Vec3 & X = sfm_data.structure.at(it.first).X;
+        AddConsensusVariable(landmark_variables, it.first, {X(0), X(1), X(2)}, it.second);
+      }
+    }
+  }
+  Hash_Map<IndexT, std::set<int>>().swap(landmark_clusters);
+  Hash_Map<IndexT, std::set<int>>().swap(control_point_clusters);
+
+  if (partition_options_.bVerbose_)
+  {
+    std::cout << "\n"
+      << "Partitioned Bundle Adjustment:\n"
+      << " #clusters: " << nb_clusters << "\n"
+      << " #shared poses: " << pose_variables.size() << "\n"
+      << " #shared intrinsics: " << intrinsic_variables.size() << "\n"
+      << " #shared landmarks: " << landmark_variables.size() << "\n"
+      << " Partitioning time (s): " << timer.elapsed() << "\n"
+      << std::endl;
+  }
+
+  //----------
+  // 2. Local step of a cluster:
+  // - build the cluster problem (the shared variables start from their last
+  //   local value, the other ones from the scene),
+  // - solve it,
+  // - keep the local values of the shared variables & write the other ones
+  //   in the scene (they belong to this cluster only),
+  // - free the problem.
+  //----------
+  // Every local problem is solved on a single thread, the clusters are solved in parallel.
+  Bundle_Adjustment_Ceres::BA_Ceres_options local_ceres_options = ceres_options_;
+  local_ceres_options.bVerbose_ = false;
+  local_ceres_options.problem_dump_prefix_.clear();
+#ifdef OPENMVG_USE_OPENMP
+  local_ceres_options.nb_threads_ = 1;
+#endif
+
+  double rho = partition_options_.rho_;
+  const auto solve_cluster = [&]
+  (
+    const int cluster_id,
+    double & final_cost
+  ) -> bool
+  {
+    // The loss functions are owned here, not by the problem (a loss function
+    // that is used by no residual block would leak otherwise).
+    // A view shared by m clusters sees its residuals weighted by 1/m: its
+    // loss is scaled by 1/m (the robust threshold stays the same).
+    std::unique_ptr<ceres::LossFunction> huber_loss(
+      ceres_options_.bUse_loss_function_ ?
+        new ceres::HuberLoss(Square(4.0))
+        : nullptr);
+    std::map<std::pair<const ceres::LossFunction*, size_t>,
+             std::unique_ptr<ceres::LossFunction>> scaled_losses;
+    const auto get_loss = [&]
+    (
+      const ceres::LossFunction * loss_function,
+      const size_t view_multiplicity
+    ) -> ceres::LossFunction *
+    {
+      if (view_multiplicity == 1)
+        return const_cast<ceres::LossFunction*>(loss_function);
+      std::unique_ptr<ceres::LossFunction> & scaled_loss =
+        scaled_losses[{loss_function, view_multiplicity}];
+      if (!scaled_loss)
+        scaled_loss.reset(new ceres::ScaledLoss(
+          loss_function, 1.0 / view_multiplicity, ceres::DO_NOT_TAKE_OWNERSHIP));
+      return scaled_loss.get();
+    };
+
+    ceres::Problem::Options problem_options;
+    problem_options.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+    ceres::Problem problem(problem_options);
+    Hash_Map<IndexT, std::array<double, 6>> poses;
+    Hash_Map<IndexT, std::vector<double>> intrinsics;
+    Hash_Map<IndexT, Vec3> landmarks, control_points;
+
+    // Cameras
+    for (const IndexT view_id : view_clusters_[cluster_id])
+    {
+      if (view_clusters.count(view_id) == 0)
+        continue;
+      const View * view = sfm_data.views.at(view_id).get();
+      if (poses.count(view->id_pose) == 0)
+      {
+        double * pose_block = poses[view->id_pose].data();
+        const auto it = pose_variables.find(view->id_pose);
+        if (it != pose_variables.end())
+        {
+          const std::vector<double> & x = it->second.Term(cluster_id).x;
+          std::copy(x.cbegin(), x.cend(), pose_block);
+        }
+        else
+          PoseToParameterBlock(sfm_data.poses.at(view->id_pose), pose_block);
+        AddPoseParameterBlock(problem, pose_block, options.extrinsics_opt);
+      }
+      if (intrinsics.count(view->id_intrinsic) == 0)
+      {
+        const IntrinsicBase & intrinsic = *sfm_data.intrinsics.at(view->id_intrinsic);
+        std::vector<double> & params = intrinsics[view->id_intrinsic];
+        const auto it = intrinsic_variables.find(view->id_intrinsic);
+        params = (it != intrinsic_variables.end()) ?
+          it->second.Term(cluster_id).x : intrinsic.getParams();
+        if (!params.empty())
+          AddIntrinsicParameterBlock(problem, params, intrinsic, options.intrinsics_opt);
+      }
+    }
+
+    // Reprojection residuals of the cluster observations
+    const auto add_observations = [&]
+    (
+      const Landmarks & scene_landmarks,
+      const std::vector<IndexT> & landmark_ids,
+      const Consensus_Variables & variables,
+      Hash_Map<IndexT, Vec3> & local_landmarks,
+      const double observation_weight,
+      const ceres::LossFunction * loss_function
+    ) -> bool
+    {
+      for (const IndexT landmark_id : landmark_ids)
+      {
+        const Landmark & landmark = scene_landmarks.at(landmark_id);
+        for (const auto & obs_it : landmark.obs)
+        {
+          const auto clusters_it = view_clusters.find(obs_it.first);
+          if (clusters_it == view_clusters.end()
+              || std::find(clusters_it->second.cbegin(), clusters_it->second.cend(), cluster_id)
+                 == clusters_it->second.cend())
+            continue;
+
+          auto local_landmark_it = local_landmarks.find(landmark_id);
+          if (local_landmark_it == local_landmarks.end())
+          {
+            const auto it = variables.find(landmark_id);
+            local_landmark_it = local_landmarks.insert({landmark_id,
+              (it != variables.end()) ?
+                Vec3(Eigen::Map<const Vec3>(it->second.Term(cluster_id).x.data()))
+                : landmark.X}).first;
+          }
+
+          const View * view = sfm_data.views.at(obs_it.first).get();
+          ceres::CostFunction* cost_function =
+            IntrinsicsToCostFunction(sfm_data.intrinsics.at(view->id_intrinsic).get(),
+                                     obs_it.second.x, observation_weight);
+          if (!cost_function)
+          {
+            std::cerr << "Cannot create a CostFunction for this camera model." << std::endl;
+            return false;
+          }
+          ceres::LossFunction * view_loss_function =
+            get_loss(loss_function, clusters_it->second.size());
+          std::vector<double> & intrinsic_block = intrinsics.at(view->id_intrinsic);
+          double * pose_block = poses.at(view->id_pose).data();
+          if (!intrinsic_block.empty())
+          {
+            problem.AddResidualBlock(cost_function, view_loss_function,
+              &intrinsic_block[0], pose_block, local_landmark_it->second.data());
+          }
+          else
+          {
+            problem.AddResidualBlock(cost_function, view_loss_function,
+              pose_block, local_landmark_it->second.data());
+          }
+        }
+      }
+      return true;
+    };
+
+    if (!add_observations(sfm_data.structure, cluster_landmarks[cluster_id],
+                          landmark_variables, landmarks, 0.0, huber_loss.get()))
+      return false;
+    if (options.structure_opt == Structure_Parameter_Type::NONE)
+    {
+      for (auto & landmark_it : landmarks)
+        problem.SetParameterBlockConstant(landmark_it.second.data());
+    }
+
+    if (options.control_point_opt.bUse_control_points)
+    {
+      // Ground Control Points: fixed 3D points with weighted observations
+      if (!add_observations(sfm_data.control_points, cluster_control_points[cluster_id],
+                            Consensus_Variables(), control_points,
+                            options.control_point_opt.weight, nullptr))
+        return false;
+      for (auto & gcp_it : control_points)
+        problem.SetParameterBlockConstant(gcp_it.second.data());
+    }
+
+    // Shared parameter blocks of the cluster
+    std::vector<std::pair<double*, Consensus_Term*>> shared_blocks;
+    for (auto & pose_it : poses)
+    {
+      const auto it = pose_variables.find(pose_it.first);
+      if (it != pose_variables.end())
+        shared_blocks.emplace_back(pose_it.second.data(), &it->second.Term(cluster_id));
+    }
+    for (auto & intrinsic_it : intrinsics)
+    {
+      const auto it = intrinsic_variables.find(intrinsic_it.first);
+      if (it != intrinsic_variables.end())
+        shared_blocks.emplace_back(&intrinsic_it.second[0], &it->second.Term(cluster_id));
+    }
+    for (auto & landmark_it : landmarks)
+    {
+      const auto it = landmark_variables.find(landmark_it.first);
+      if (it != landmark_variables.end())
+        shared_blocks.emplace_back(landmark_it.second.data(), &it->second.Term(cluster_id));
+    }
+
+    // Stiffness of the shared variables (computed at the first local step):
+    // mean of the diagonal of J^T J over the variable coordinates.
+    std::vector<double*> evaluated_blocks;
+    std::vector<Consensus_Term*> evaluated_terms;
+    for (const auto & block : shared_blocks)
+    {
+      if (block.second->scale > 0.0)
+        continue;
+      block.second->scale = 1.0; // For the constant blocks
+      if (!problem.IsParameterBlockConstant(block.first))
+      {
+        evaluated_blocks.push_back(block.first);
+        evaluated_terms.push_back(block.second);
+      }
+    }
+    if (!evaluated_blocks.empty())
+    {
+      ceres::Problem::EvaluateOptions evaluate_options;
+      evaluate_options.parameter_blocks = evaluated_blocks;
+      ceres::CRSMatrix jacobian;
+      problem.Evaluate(evaluate_options, nullptr, nullptr, nullptr, &jacobian);
+
+      std::vector<int> column_blocks;
+      for (size_t i = 0; i < evaluated_blocks.size(); ++i)
+        column_blocks.resize(column_blocks.size() +
+          problem.ParameterBlockLocalSize(evaluated_blocks[i]), i);
+      std::vector<double> squared_sums(evaluated_blocks.size(), 0.0);
+      for (size_t i = 0; i < jacobian.values.size(); ++i)
+        squared_sums[column_blocks[jacobian.cols[i]]] += Square(jacobian.values[i]);
+      for (size_t i = 0; i < evaluated_blocks.size(); ++i)
+      {
+        const double scale =
+          squared_sums[i] / problem.ParameterBlockLocalSize(evaluated_blocks[i]);
+        if (scale > 0.0)
+          evaluated_terms[i]->scale = scale;
+      }
+    }
+
+    // Consensus terms: rho * scale / 2 * ||x - z + u||^2
+    for (auto & pose_it : poses)
+    {
+      const auto it = pose_variables.find(pose_it.first);
+      if (it == pose_variables.end())
+        continue;
+      const Consensus_Term & term = it->second.Term(cluster_id);
+      const std::vector<double> target = ConsensusTarget(it->second, term, true);
+      std::array<double, 6> pose_target;
+      std::copy(target.cbegin(), target.cend(), pose_target.begin());
+      problem.AddResidualBlock(
+        PoseConsensusFunctor::Create(pose_target, std::sqrt(rho * term.scale)),
+        nullptr, pose_it.second.data());
+    }
+    for (auto & intrinsic_it : intrinsics)
+    {
+      const auto it = intrinsic_variables.find(intrinsic_it.first);
+      if (it == intrinsic_variables.end())
+        continue;
+      const Consensus_Term & term = it->second.Term(cluster_id);
+      problem.AddResidualBlock(
+        new ConsensusCostFunction(
+          ConsensusTarget(it->second, term, false), std::sqrt(rho * term.scale)),
+        nullptr, &intrinsic_it.second[0]);
+    }
+    for (auto & landmark_it : landmarks)
+    {
+      const auto it = landmark_variables.find(landmark_it.first);
+      if (it == landmark_variables.end())
+        continue;
+      const Consensus_Term & term = it->second.Term(cluster_id);
+      problem.AddResidualBlock(
+        new ConsensusCostFunction(
+          ConsensusTarget(it->second, term, false), std::sqrt(rho * term.scale)),
+        nullptr, landmark_it.second.data());
+    }
+
+    // Solve
+    final_cost = 0.0;
+    if (problem.NumResidualBlocks() == 0)
+      return true;
+
+    std::set<double*> camera_blocks;
+    for (auto & pose_it : poses)
+      camera_blocks.insert(pose_it.second.data());
+    for (auto & intrinsic_it : intrinsics)
+      if (!intrinsic_it.second.empty())
+        camera_blocks.insert(&intrinsic_it.second[0]);
+
+    ceres::Solver::Options ceres_config_options;
+    ConfigureSolver(local_ceres_options, poses.size(),
+      camera_blocks, problem, ceres_config_options);
+    ceres_config_options.max_num_iterations = partition_options_.local_max_iterations_;
+    ceres_config_options.function_tolerance = partition_options_.local_function_tolerance_;
+
+    ceres::Solver::Summary summary;
+    ceres::Solve(ceres_config_options, &problem, &summary);
+    if (!summary.IsSolutionUsable())
+      return false;
+    final_cost = summary.final_cost;
+
+    // Keep the local values of the shared variables, update the scene with
+    // the other ones.
+    if (options.extrinsics_opt != Extrinsic_Parameter_Type::NONE)
+    {
+      for (const auto & pose_it : poses)
+      {
+        const auto it = pose_variables.find(pose_it.first);
+        if (it != pose_variables.end())
+          it->second.Term(cluster_id).x.assign(pose_it.second.cbegin(), pose_it.second.cend());
+        else
+          sfm_data.poses.at(pose_it.first) = ParameterBlockToPose(pose_it.second.data());
+      }
+    }
+    if (options.intrinsics_opt != Intrinsic_Parameter_Type::NONE)
+    {
+      for (const auto & intrinsic_it : intrinsics)
+      {
+        const auto it = intrinsic_variables.find(intrinsic_it.first);
+        if (it != intrinsic_variables.end())
+          it->second.Term(cluster_id).x = intrinsic_it.second;
+        else
+          sfm_data.intrinsics.at(intrinsic_it.first)->updateFromParams(intrinsic_it.second);
+      }
+    }
+    if (options.structure_opt != Structure_Parameter_Type::NONE)
+    {
+      for (const auto & landmark_it : landmarks)
+      {
+        const auto it = landmark_variables.find(landmark_it.first);
+        if (it != landmark_variables.end())
+          it->second.Term(cluster_id).x.assign(
+            landmark_it.second.data(), landmark_it.second.data() + 3);
+        else
+          sfm_data.structure.at(landmark_it.first).X = landmark_it.second;
+      }
+    }
+    return true;
+  };
+
+  //----------
+  // 3. ADMM iterations
+  //----------
+  // The shared variables of each kind (poses use a rotation aware consensus)
+  const std::array<std::pair<Consensus_Variables *, bool>, 3> all_variables = {{
+    {&pose_variables, true}, {&intrinsic_variables, false}, {&landmark_variables, false}}};
+
+  bool b_converged = false;
+  unsigned int iteration = 0;
+  for (; iteration < partition_options_.max_admm_iterations_ && !b_converged; ++iteration)
+  {
+    // Local step
+    std::vector<double> final_costs(nb_clusters, 0.0);
+    std::vector<unsigned char> usable(nb_clusters, 0);
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int cluster_id = 0; cluster_id < nb_clusters; ++cluster_id)
+    {
+      usable[cluster_id] = solve_cluster(cluster_id, final_costs[cluster_id]);
+    }
+
+    double local_cost = 0.0;
+    for (int cluster_id = 0; cluster_id < nb_clusters; ++cluster_id)
+    {
+      if (!usable[cluster_id])
+      {
+        std::cerr << "Partitioned Bundle Adjustment: a local problem failed." << std::endl;
+        return false;
+      }
+      local_cost += final_costs[cluster_id];
+    }
+
+    // Consensus step (z = mean(x + u)), dual step (u += x - z) & primal/dual residuals
+    double primal_residual = 0.0, dual_residual = 0.0;
+    double x_norm = 0.0, z_norm = 0.0, u_norm = 0.0;
+    size_t nb_consensus_values = 0;
+    BA_Partition_statistics deviations;
+    for (const auto & variables : all_variables)
+    {
+      const bool b_pose = variables.second;
+      for (auto & variable_it : *variables.first)
+      {
+        Consensus_Variable & variable = variable_it.second;
+        UpdateConsensus(variable, b_pose);
+        const std::vector<double> s = Difference(variable.z, variable.z_previous, b_pose);
+        for (Consensus_Term & term : variable.terms)
+        {
+          const std::vector<double> r = Difference(term.x, variable.z, b_pose);
+          // The residuals are measured in the scaled variables sqrt(scale) * x
+          for (size_t i = 0; i < r.size(); ++i)
+          {
+            term.u[i] += r[i];
+            primal_residual += term.scale * r[i] * r[i];
+            dual_residual += term.scale * s[i] * s[i];
+            x_norm += term.scale * term.x[i] * term.x[i];
+            z_norm += term.scale * variable.z[i] * variable.z[i];
+            u_norm += term.scale * term.u[i] * term.u[i];
+          }
+          nb_consensus_values += r.size();
+
+          const Eigen::Map<const Vec> r_map(r.data(), r.size());
+          if (b_pose)
+          {
+            deviations.max_rotation_deviation =
+              std::max(deviations.max_rotation_deviation, r_map.head<3>().norm());
+            deviations.max_translation_deviation =
+              std::max(deviations.max_translation_deviation, r_map.tail<3>().norm());
+          }
+          else if (variables.first == &intrinsic_variables)
+          {
+            deviations.max_intrinsic_deviation =
+              std::max(deviations.max_intrinsic_deviation, r_map.lpNorm<Eigen::Infinity>());
+          }
+          else
+          {
+            deviations.max_landmark_deviation =
+              std::max(deviations.max_landmark_deviation, r_map.norm());
+          }
+        }
+      }
+    }
+    primal_residual = std::sqrt(primal_residual);
+    dual_residual = rho * std::sqrt(dual_residual);
+
+    // Stopping criteria
+    const double eps_primal =
+      std::sqrt(nb_consensus_values) * partition_options_.absolute_tolerance_
+      + partition_options_.relative_tolerance_ * std::max(std::sqrt(x_norm), std::sqrt(z_norm));
+    const double eps_dual =
+      std::sqrt(nb_consensus_values) * partition_options_.absolute_tolerance_
+      + partition_options_.relative_tolerance_ * rho * std::sqrt(u_norm);
+    b_converged = (iteration > 0 || nb_consensus_values == 0)
+      && primal_residual <= eps_primal && dual_residual <= eps_dual;
+
+    statistics_ = deviations;
+    statistics_.primal_residual = primal_residual;
+    statistics_.dual_residual = dual_residual;
+
+    if (partition_options_.bVerbose_)
+    {
+      std::cout
+        << "ADMM iteration: " << iteration
+        << " local cost: " << local_cost
+        << " primal residual: " << primal_residual
+        << " dual residual: " << dual_residual
+        << " rho: " << rho
+        << " time (s): " << timer.elapsed() << std::endl;
+    }
+
+    // Residual balancing (the scaled dual variable is rescaled accordingly)
+    const double kMu = 10.0, kTau = 2.0;
+    double rho_scale = 1.0;
+    if (primal_residual > kMu * dual_residual)
+      rho_scale = kTau;
+    else if (dual_residual > kMu * primal_residual)
+      rho_scale = 1.0 / kTau;
+    if (rho_scale != 1.0)
+    {
+      rho *= rho_scale;
+      for (const auto & variables : all_variables)
+        for (auto & variable_it : *variables.first)
+          for (Consensus_Term & term : variable_it.second.terms)
+            for (double & u : term.u)
+              u /= rho_scale;
+    }
+  }
+  statistics_.num_iterations = iteration;
+  statistics_.b_converged = b_converged;
+
+  //----------
+  // 4. Merge the consensus values of the shared variables in the scene
+  // (the other ones are updated by the local steps)
+  //----------
+  for (const auto & pose_it : pose_variables)
+    sfm_data.poses.at(pose_it.first) = ParameterBlockToPose(pose_it.second.z.data());
+  for (const auto & intrinsic_it : intrinsic_variables)
+    sfm_data.intrinsics.at(intrinsic_it.first)->updateFromParams(intrinsic_it.second.z);
+  for (const auto & landmark_it : landmark_variables)
+    sfm_data.structure.at(landmark_it.first).X = Eigen::Map<const Vec3>(landmark_it.second.z.data());
+
+  if (partition_options_.bVerbose_)
+  {
+    std::cout
+      << "Partitioned Bundle Adjustment "
+      << (b_converged ? "converged" : "reached the max number of iterations")
+      << ", time (s): " << timer.elapsed() << std::endl;
+  }
+  return true;
+}
+
+} // namespace sfm
+} // namespace openMVG
@@ -0,0 +1,126 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SFM_SFM_DATA_BA_CERES_PARTITIONED_HPP
+#define OPENMVG_SFM_SFM_DATA_BA_CERES_PARTITIONED_HPP
+
+#include "openMVG/sfm/sfm_data_BA.hpp"
+#include "openMVG/sfm/sfm_data_BA_ceres.hpp"
+#include "openMVG/types.hpp"
+
+#include <set>
+#include <vector>
+
+namespace openMVG {
+namespace sfm {
+
+/// Partitioned Bundle Adjustment for the scenes that do not fit in a single
+/// problem.
+/// The scene is split into (possibly overlapping) view clusters. Each cluster
+/// is adjusted independently (the clusters are solved in parallel) and the
+/// variables shared by several clusters (poses, intrinsics and landmarks) are
+/// brought to a consensus by ADMM iterations:
+///  - local step: each cluster minimizes its reprojection errors plus a
+///    quadratic penalty rho/2 * ||x - z + u||^2 on its shared variables,
+///  - consensus step: z is the average of the local values (x + u),
+///  - dual step: u += x - z.
+/// The rho penalty is adapted to balance the primal and dual residuals.
+/// (See "Distributed optimization and statistical learning via the alternating
+///  direction method of multipliers", S. Boyd et al., 2011, Section 7.1.)
+///
+/// The consensus of a pose rotation is the chordal L2 mean of the local
+/// rotations (the penalty is expressed in the tangent space of the rotation).
+/// The penalty of a shared variable in a cluster is rho times its stiffness in
+/// this cluster (mean of the diagonal of J^T J of its observations), so rho
+/// does not depend on the units of the variables. The primal & dual residuals
+/// are measured with the same weights.
+///
+/// The observations of a view that belongs to m clusters are weighted by
+/// 1/m in each cluster (their loss function is scaled by 1/m), so the sum of
+/// the local problems is the original one.
+/// The views that do not belong to any cluster (and their observations) are
+/// left untouched.
+///
+/// Memory: a cluster problem is built, solved and freed at each local step
+/// (at most one problem per thread is alive). Between the iterations only the
+/// consensus state of the shared variables (z, and the local value x and the
+/// dual variable u of each cluster) is kept, the other variables are written
+/// in the scene by their cluster. If a local step fails, Adjust returns false
+/// and the scene may be partially refined.
+/// Note: Motion priors are not supported, in this case the whole scene is
+///  adjusted with Bundle_Adjustment_Ceres.
+class Bundle_Adjustment_Ceres_Partitioned : public Bundle_Adjustment
+{
+  public:
+  struct BA_Partition_options
+  {
+    bool bVerbose_;
+    unsigned int max_admm_iterations_;
+    double rho_; // initial consensus penalty (relative to the variable stiffness)
+    // Stopping criteria on the primal & dual residuals (see Boyd et al. 3.3.1)
+    double absolute_tolerance_;
+    double relative_tolerance_;
+    // Max number of Levenberg-Marquardt iterations of a local step
+    unsigned int local_max_iterations_;
+    // Relative cost decrease that stops a local step. The consensus penalty
+    // is a tiny part of the local cost: a loose tolerance stops the local
+    // steps before the shared variables move to their consensus value.
+    double local_function_tolerance_;
+
+    BA_Partition_options(const bool bVerbose = true);
+  };
+
+  /// Statistics of the last Adjust call
+  struct BA_Partition_statistics
+  {
+    unsigned int num_iterations = 0;
+    bool b_converged = false;
+    double primal_residual = 0.0;
+    double dual_residual = 0.0;
+    // Largest deviation between the local value of a shared variable and its
+    // consensus value after the last local step
+    double max_rotation_deviation = 0.0; // angle in radians
+    double max_translation_deviation = 0.0;
+    double max_intrinsic_deviation = 0.0; // largest parameter difference
+    double max_landmark_deviation = 0.0;
+  };
+
+  Bundle_Adjustment_Ceres_Partitioned
+  (
+    // the view ids of every cluster
+    const std::vector<std::set<IndexT>> & view_clusters,
+    const BA_Partition_options & partition_options = BA_Partition_options(),
+    // the solver options used by the local problems
+    const Bundle_Adjustment_Ceres::BA_Ceres_options & ceres_options =
+      Bundle_Adjustment_Ceres::BA_Ceres_options()
+  );
+
+  BA_Partition_options & partition_options();
+  Bundle_Adjustment_Ceres::BA_Ceres_options & ceres_options();
+
+  const BA_Partition_statistics & statistics() const;
+
+  bool Adjust
+  (
+    // the SfM scene to refine
+    sfm::SfM_Data & sfm_data,
+    // tell which parameter needs to be adjusted
+    const Optimize_Options & options
+  ) override;
+
+  private:
+    std::vector<std::set<IndexT>> view_clusters_;
+    BA_Partition_options partition_options_;
+    Bundle_Adjustment_Ceres::BA_Ceres_options ceres_options_;
+    BA_Partition_statistics statistics_;
+};
+
+} // namespace sfm
+} // namespace openMVG
+
+#endif // OPENMVG_SFM_SFM_DATA_BA_CERES_PARTITIONED_HPP
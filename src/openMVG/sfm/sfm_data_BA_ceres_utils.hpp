@@ -0,0 +1,79 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SFM_SFM_DATA_BA_CERES_UTILS_HPP
+#define OPENMVG_SFM_SFM_DATA_BA_CERES_UTILS_HPP
+
+//--
+//- Helpers shared by the ceres based Bundle Adjustment implementations
+//--
+
+#include <set>
+#include <vector>
+
+#include <ceres/ceres.h>
+
+#include "openMVG/cameras/Camera_Intrinsics.hpp"
+#include "openMVG/geometry/pose3.hpp"
+#include "openMVG/sfm/sfm_data_BA_ceres.hpp"
+
+namespace openMVG {
+namespace sfm {
+
+/// Convert a pose to a [angleAxis, translation] parameter block
+void PoseToParameterBlock
+(
+  const geometry::Pose3 & pose,
+  double * parameter_block
+);
+
+/// Convert a [angleAxis, translation] parameter block to a pose
+geometry::Pose3 ParameterBlockToPose
+(
+  const double * parameter_block
+);
+
+/// Add a pose parameter block and configure its subset parametrization
+void AddPoseParameterBlock
+(
+  ceres::Problem & problem,
+  double * parameter_block,
+  const Extrinsic_Parameter_Type extrinsics_opt
+);
+
+/// Add an intrinsic parameter block and configure its subset parametrization
+void AddIntrinsicParameterBlock
+(
+  ceres::Problem & problem,
+  std::vector<double> & parameters,
+  const cameras::IntrinsicBase & intrinsic,
+  const cameras::Intrinsic_Parameter_Type intrinsics_opt
+);
+
+/// Configure the solver according the user options and the problem size.
+/// Return true if the large scene mode is used.
+bool ConfigureSolver
+(
+  const Bundle_Adjustment_Ceres::BA_Ceres_options & ba_options,
+  const std::size_t nb_poses,
+  const std::set<double*> & camera_blocks, // poses & intrinsics parameter blocks
+  ceres::Problem & problem,
+  ceres::Solver::Options & ceres_config_options
+);
+
+/// Collect the statistics of a solver run
+void FillStatistics
+(
+  const ceres::Solver::Summary & summary,
+  Bundle_Adjustment_Ceres::BA_Ceres_statistics & statistics
+);
+
+} // namespace sfm
+} // namespace openMVG
+
+#endif // OPENMVG_SFM_SFM_DATA_BA_CERES_UTILS_HPP
@@ -17,6 +17,7 @@
 //-----------------
 
 #include "openMVG/cameras/Camera_Common.hpp"
+#include "openMVG/geometry/rigid_transformation3D_srt.hpp"
 #include "openMVG/multiview/test_data_sets.hpp"
 #include "openMVG/sfm/sfm.hpp"
 
@@ -184,6 +185,249 @@ TEST(BUNDLE_ADJUSTMENT, EffectiveMinimization_Pinhole_Intrinsic_Fisheye) {
   EXPECT_TRUE( dResidual_before > dResidual_after);
 }
 
+//-- Test the large scene mode (ITERATIVE_SCHUR + explicit landmarks first ordering)
+TEST(BUNDLE_ADJUSTMENT, EffectiveMinimization_Pinhole_LargeSceneMode) {
+
+  const int nviews = 12;
+  const int npoints = 32;
+  const nViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfM_Data scene
+  SfM_Data sfm_data = getInputScene(d, config, PINHOLE_CAMERA);
+
+  const double dResidual_before = RMSE(sfm_data);
+
+  // Force the large scene mode for this small scene
+  const bool bVerbose = true;
+  const bool bMultithread = false;
+  Bundle_Adjustment_Ceres::BA_Ceres_options options(bVerbose, bMultithread);
+  options.large_scene_pose_threshold_ = 1;
+  options.bUse_inner_iterations_ = true;
+  EXPECT_TRUE( options.IsLargeScene(sfm_data.GetPoses().size()) );
+
+  std::shared_ptr<Bundle_Adjustment> ba_object =
+    std::make_shared<Bundle_Adjustment_Ceres>(options);
+  EXPECT_TRUE( ba_object->Adjust(sfm_data,
+    Optimize_Options(
+      Intrinsic_Parameter_Type::ADJUST_ALL,
+      Extrinsic_Parameter_Type::ADJUST_ALL,
+      Structure_Parameter_Type::ADJUST_ALL)) );
+
+  const double dResidual_after = RMSE(sfm_data);
+  EXPECT_TRUE( dResidual_before > dResidual_after);
+}
+
+//-- Test that a persistent BA problem follows the scene changes between two calls
+TEST(BUNDLE_ADJUSTMENT, EffectiveMinimization_Pinhole_Persistent) {
+
+  const int nviews = 6;
+  const int npoints = 32;
+  const nViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfM_Data scene
+  SfM_Data sfm_data = getInputScene(d, config, PINHOLE_CAMERA);
+
+  const bool bVerbose = true;
+  const bool bMultithread = false;
+  Bundle_Adjustment_Ceres_Persistent ba_object(
+    Bundle_Adjustment_Ceres::BA_Ceres_options(bVerbose, bMultithread));
+  const Optimize_Options ba_refine_options(
+    Intrinsic_Parameter_Type::ADJUST_ALL,
+    Extrinsic_Parameter_Type::ADJUST_ALL,
+    Structure_Parameter_Type::ADJUST_ALL);
+
+  const double dResidual_before = RMSE(sfm_data);
+  EXPECT_TRUE( ba_object.Adjust(sfm_data, ba_refine_options) );
+  const double dResidual_after = RMSE(sfm_data);
+  EXPECT_TRUE( dResidual_before > dResidual_after);
+
+  // Modify the scene:
+  // - remove a landmark and an observation,
+  // - move a pose outside of the BA.
+  sfm_data.structure.erase(0);
+  sfm_data.structure.at(1).obs.erase(0);
+  sfm_data.poses.at(1) = Pose3(RotationAroundX(D2R(3)) * sfm_data.poses.at(1).rotation(),
+                               sfm_data.poses.at(1).center());
+
+  const double dResidual_before_update = RMSE(sfm_data);
+  EXPECT_TRUE( ba_object.Adjust(sfm_data, ba_refine_options) );
+  const double dResidual_after_update = RMSE(sfm_data);
+  EXPECT_TRUE( dResidual_before_update > dResidual_after_update);
+  EXPECT_NEAR( dResidual_after, dResidual_after_update, 1e-2);
+}
+
+//-- A camera model unknown by the BA: its observations are skipped
+class Unsupported_Intrinsic : public Pinhole_Intrinsic
+{
+public:
+  using Pinhole_Intrinsic::Pinhole_Intrinsic;
+  EINTRINSIC getType() const override { return PINHOLE_CAMERA_END; }
+};
+
+TEST(BUNDLE_ADJUSTMENT, EffectiveMinimization_Pinhole_Persistent_UnsupportedIntrinsic) {
+
+  const int nviews = 6;
+  const int npoints = 32;
+  const nViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfM_Data scene,
+  // the last two views use an unsupported camera model
+  SfM_Data sfm_data = getInputScene(d, config, PINHOLE_CAMERA);
+  sfm_data.intrinsics[1] = std::make_shared<Unsupported_Intrinsic>
+    (config._cx * 2, config._cy * 2, config._fx, config._cx, config._cy);
+  sfm_data.views.at(4)->id_intrinsic = 1;
+  sfm_data.views.at(5)->id_intrinsic = 1;
+
+  Bundle_Adjustment_Ceres_Persistent ba_object(
+    Bundle_Adjustment_Ceres::BA_Ceres_options(false, false));
+  const Optimize_Options ba_refine_options(
+    Intrinsic_Parameter_Type::ADJUST_ALL,
+    Extrinsic_Parameter_Type::ADJUST_ALL,
+    Structure_Parameter_Type::ADJUST_ALL);
+
+  const Pose3 pose_4 = sfm_data.poses.at(4);
+  const double dResidual_before = RMSE(sfm_data);
+  EXPECT_TRUE( ba_object.Adjust(sfm_data, ba_refine_options) );
+  // The update of the problem must skip them too
+  sfm_data.structure.erase(0);
+  EXPECT_TRUE( ba_object.Adjust(sfm_data, ba_refine_options) );
+  // The pose of a view without residual is unchanged
+  EXPECT_MATRIX_NEAR( pose_4.rotation(), sfm_data.poses.at(4).rotation(), 1e-8);
+  EXPECT_TRUE( dResidual_before > RMSE(sfm_data));
+}
+
+// Partitioned BA of a ring of 8 views split in two clusters sharing the
+// views 3 & 4 (and so one intrinsic and most of the landmarks)
+static bool Adjust_Partitioned
+(
+  SfM_Data & sfm_data,
+  const Optimize_Options & ba_refine_options,
+  Bundle_Adjustment_Ceres_Partitioned::BA_Partition_statistics & statistics
+)
+{
+  const std::vector<std::set<IndexT>> view_clusters = {
+    {0, 1, 2, 3, 4},
+    {3, 4, 5, 6, 7}};
+
+  const bool bVerbose = true;
+  const bool bMultithread = false;
+  Bundle_Adjustment_Ceres_Partitioned::BA_Partition_options partition_options(bVerbose);
+  partition_options.max_admm_iterations_ = 500;
+  Bundle_Adjustment_Ceres_Partitioned ba_object(
+    view_clusters,
+    partition_options,
+    Bundle_Adjustment_Ceres::BA_Ceres_options(bVerbose, bMultithread));
+  const bool b_adjusted = ba_object.Adjust(sfm_data, ba_refine_options);
+  statistics = ba_object.statistics();
+  return b_adjusted;
+}
+
+//-- Partitioned BA: the overlapping view clusters must reach a consensus
+//   (the shared variables agree across the clusters) with the residual of the
+//   monolithic BA.
+TEST(BUNDLE_ADJUSTMENT, EffectiveMinimization_Pinhole_Partitioned) {
+
+  const int nviews = 8;
+  const int npoints = 32;
+  const nViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfM_Data scene
+  SfM_Data sfm_data = getInputScene(d, config, PINHOLE_CAMERA);
+  SfM_Data sfm_data_monolithic = getInputScene(d, config, PINHOLE_CAMERA);
+
+  const double dResidual_before = RMSE(sfm_data);
+
+  const Optimize_Options ba_refine_options(
+    Intrinsic_Parameter_Type::ADJUST_ALL,
+    Extrinsic_Parameter_Type::ADJUST_ALL,
+    Structure_Parameter_Type::ADJUST_ALL);
+
+  Bundle_Adjustment_Ceres_Partitioned::BA_Partition_statistics statistics;
+  EXPECT_TRUE( Adjust_Partitioned(sfm_data, ba_refine_options, statistics) );
+
+  const double dResidual_after = RMSE(sfm_data);
+  EXPECT_TRUE( dResidual_before > dResidual_after);
+
+  // The local values of the shared variables agree
+  EXPECT_TRUE( statistics.b_converged );
+  EXPECT_NEAR( 0.0, statistics.max_rotation_deviation, 1e-5 );
+  EXPECT_NEAR( 0.0, statistics.max_translation_deviation, 1e-5 );
+  EXPECT_NEAR( 0.0, statistics.max_intrinsic_deviation, 1e-4 );
+  EXPECT_NEAR( 0.0, statistics.max_landmark_deviation, 1e-5 );
+
+  // Same residual as the monolithic BA
+  // (the focal length and the scene depth are weakly constrained by this
+  //  narrow field of view: the solutions differ along this valley)
+  Bundle_Adjustment_Ceres ba_monolithic(
+    Bundle_Adjustment_Ceres::BA_Ceres_options(false, false));
+  EXPECT_TRUE( ba_monolithic.Adjust(sfm_data_monolithic, ba_refine_options) );
+  EXPECT_NEAR( RMSE(sfm_data_monolithic), dResidual_after, 1e-3 );
+}
+
+//-- Partitioned BA with fixed intrinsics: the refined scene must match the one
+//   of the monolithic BA, up to the similarity of the BA gauge.
+TEST(BUNDLE_ADJUSTMENT, EffectiveMinimization_Pinhole_Partitioned_Monolithic) {
+
+  const int nviews = 8;
+  const int npoints = 32;
+  const nViewDatasetConfigurator config;
+  const NViewDataSet d = NRealisticCamerasRing(nviews, npoints, config);
+
+  // Translate the input dataset to a SfM_Data scene
+  SfM_Data sfm_data = getInputScene(d, config, PINHOLE_CAMERA);
+  SfM_Data sfm_data_monolithic = getInputScene(d, config, PINHOLE_CAMERA);
+
+  const Optimize_Options ba_refine_options(
+    Intrinsic_Parameter_Type::NONE,
+    Extrinsic_Parameter_Type::ADJUST_ALL,
+    Structure_Parameter_Type::ADJUST_ALL);
+
+  Bundle_Adjustment_Ceres_Partitioned::BA_Partition_statistics statistics;
+  EXPECT_TRUE( Adjust_Partitioned(sfm_data, ba_refine_options, statistics) );
+  EXPECT_TRUE( statistics.b_converged );
+
+  Bundle_Adjustment_Ceres ba_monolithic(
+    Bundle_Adjustment_Ceres::BA_Ceres_options(false, false));
+  EXPECT_TRUE( ba_monolithic.Adjust(sfm_data_monolithic, ba_refine_options) );
+  EXPECT_NEAR( RMSE(sfm_data_monolithic), RMSE(sfm_data), 1e-6 );
+
+  // Align both solutions on the camera centers and the landmarks
+  Mat points(3, sfm_data.GetPoses().size() + sfm_data.GetLandmarks().size());
+  Mat points_monolithic(3, points.cols());
+  Mat::Index point_index = 0;
+  for (const auto & pose_it : sfm_data.GetPoses())
+  {
+    points.col(point_index) = pose_it.second.center();
+    points_monolithic.col(point_index++) =
+      sfm_data_monolithic.poses.at(pose_it.first).center();
+  }
+  for (const auto & landmark_it : sfm_data.GetLandmarks())
+  {
+    points.col(point_index) = landmark_it.second.X;
+    points_monolithic.col(point_index++) =
+      sfm_data_monolithic.structure.at(landmark_it.first).X;
+  }
+  double S;
+  Vec3 t;
+  Mat3 R;
+  EXPECT_TRUE( geometry::FindRTS(points, points_monolithic, &S, &t, &R) );
+  for (Mat::Index i = 0; i < points.cols(); ++i)
+  {
+    const Vec3 point = S * R * points.col(i) + t;
+    EXPECT_MATRIX_NEAR( points_monolithic.col(i), point, 1e-5 );
+  }
+  for (const auto & pose_it : sfm_data.GetPoses())
+  {
+    const Mat3 rotation = pose_it.second.rotation() * R.transpose();
+    EXPECT_MATRIX_NEAR( sfm_data_monolithic.poses.at(pose_it.first).rotation(),
+      rotation, 1e-5 );
+  }
+}
+
 //-- Test with GCP - Camera position once BA done must be the same as the GT
 TEST(BUNDLE_ADJUSTMENT, EffectiveMinimization_Pinhole_GCP) {
 
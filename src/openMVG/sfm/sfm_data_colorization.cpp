@@ -13,11 +13,13 @@
 #include "openMVG/image/image_io.hpp"
 #include "openMVG/image/pixel_types.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
-#include "openMVG/stl/stl.hpp"
+#include "openMVG/sfm/sfm_landmark_columnar.hpp"
 
 #include "third_party/progress/progress_display.hpp"
 #include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
 
+#include <algorithm>
+
 namespace openMVG {
 namespace sfm {
 
@@ -39,57 +41,38 @@ bool ColorizeTracks(
     vec_tracksColor.resize(sfm_data.GetLandmarks().size());
     vec_3dPoints.resize(sfm_data.GetLandmarks().size());
 
-    //Build a list of contiguous index for the trackIds
-    std::map<IndexT, IndexT> trackIds_to_contiguousIndexes;
+    // Columnar copy of the structure: it lists the observations of each view
+    const Columnar_Landmarks columnar_landmarks(sfm_data.GetLandmarks());
+
+    // The output follows the Landmarks container order:
+    //  keep the output index of each columnar landmark index
+    std::vector<IndexT> output_indexes(columnar_landmarks.LandmarkCount());
     IndexT cpt = 0;
     for (Landmarks::const_iterator it = sfm_data.GetLandmarks().begin();
       it != sfm_data.GetLandmarks().end(); ++it, ++cpt)
     {
-      trackIds_to_contiguousIndexes[it->first] = cpt;
+      output_indexes[columnar_landmarks.FindLandmark(it->first)] = cpt;
       vec_3dPoints[cpt] = it->second.X;
     }
 
-    // The track list that will be colored (point removed during the process)
-    std::set<IndexT> remainingTrackToColor;
-    std::transform(sfm_data.GetLandmarks().begin(), sfm_data.GetLandmarks().end(),
-      std::inserter(remainingTrackToColor, remainingTrackToColor.begin()),
-      stl::RetrieveKey());
+    // Number of observations of the remaining tracks to color, per view
+    //  (indexed as columnar_landmarks.ViewIds())
+    const std::vector<IndexT> & view_ids = columnar_landmarks.ViewIds();
+    const std::vector<IndexT> & observation_view_ids = columnar_landmarks.ObservationViewIds();
+    std::vector<size_t> view_cardinals(view_ids.size());
+    for (size_t i = 0; i < view_ids.size(); ++i)
+      view_cardinals[i] = columnar_landmarks.ViewObservations(view_ids[i]).size();
 
-    while ( !remainingTrackToColor.empty() )
+    std::vector<bool> colored(columnar_landmarks.LandmarkCount(), false);
+    while (true)
     {
       // Find the most representative image (for the remaining 3D points)
-      //  a. Count the number of observation per view for each 3Dpoint Index
-      //  b. Sort to find the most representative view index
-
-      std::map<IndexT, IndexT> map_IndexCardinal; // ViewId, Cardinal
-      for (const auto & track_to_color_it : remainingTrackToColor)
-      {
-        const auto trackId = track_to_color_it;
-        const Observations & obs = sfm_data.GetLandmarks().at(trackId).obs;
-        for (const auto & obs_it : obs)
-        {
-          const auto viewId = obs_it.first;
-          if (map_IndexCardinal.find(viewId) == map_IndexCardinal.end())
-            map_IndexCardinal[viewId] = 1;
-          else
-            ++map_IndexCardinal[viewId];
-        }
-      }
+      const auto max_cardinal_it =
+        std::max_element(view_cardinals.cbegin(), view_cardinals.cend());
+      if (max_cardinal_it == view_cardinals.cend() || *max_cardinal_it == 0)
+        break;
 
-      // Find the View index that is the most represented
-      std::vector<IndexT> vec_cardinal;
-      std::transform(map_IndexCardinal.begin(),
-        map_IndexCardinal.end(),
-        std::back_inserter(vec_cardinal),
-        stl::RetrieveValue());
-      using namespace stl::indexed_sort;
-      std::vector<sort_index_packet_descend<IndexT, IndexT>> packet_vec(vec_cardinal.size());
-      sort_index_helper(packet_vec, &vec_cardinal[0], 1);
-
-      // First image index with the most of occurence
-      std::map<IndexT, IndexT>::const_iterator iterTT = map_IndexCardinal.begin();
-      std::advance(iterTT, packet_vec[0].index);
-      const size_t view_index = iterTT->first;
+      const IndexT view_index = view_ids[max_cardinal_it - view_cardinals.cbegin()];
       const View * view = sfm_data.GetViews().at(view_index).get();
       const std::string sView_filename = stlplus::create_filespec(sfm_data.s_root_path,
         view->s_Img_path);
@@ -106,35 +89,33 @@ bool ColorizeTracks(
         }
       }
 
-      // Iterate through the remaining track to color
-      // - look if the current view is present to color the track
-      std::set<IndexT> set_toRemove;
-      for (const auto & track_to_color_it : remainingTrackToColor)
+      // Color the remaining tracks seen by the current view
+      for (const size_t observation_index : columnar_landmarks.ViewObservations(view_index))
       {
-        const auto trackId = track_to_color_it;
-        const Observations & obs = sfm_data.GetLandmarks().at(trackId).obs;
-        Observations::const_iterator it = obs.find(view_index);
-
-        if (it != obs.end())
+        const IndexT landmark_index =
+          columnar_landmarks.ObservationLandmarkIndices()[observation_index];
+        if (colored[landmark_index])
+          continue;
+
+        const Vec2 pt = columnar_landmarks.ObservationCoordinates().col(observation_index);
+        const image::RGBColor color =
+          b_rgb_image
+          ? image_rgb(pt.y(), pt.x())
+          : image::RGBColor(image_gray(pt.y(), pt.x()));
+
+        vec_tracksColor[output_indexes[landmark_index]] =
+          Vec3(color.r(), color.g(), color.b());
+        colored[landmark_index] = true;
+        ++my_progress_bar;
+
+        // The track is colored: remove its observations from the view cardinals
+        for (size_t i = columnar_landmarks.ObservationBegin(landmark_index);
+          i < columnar_landmarks.ObservationEnd(landmark_index); ++i)
         {
-          // Color the track
-          const Vec2 & pt = it->second.x;
-          const image::RGBColor color =
-            b_rgb_image
-            ? image_rgb(pt.y(), pt.x())
-            : image::RGBColor(image_gray(pt.y(), pt.x()));
-
-          vec_tracksColor[trackIds_to_contiguousIndexes.at(trackId)] =
-            Vec3(color.r(), color.g(), color.b());
-          set_toRemove.insert(trackId);
-          ++my_progress_bar;
+          --view_cardinals[std::lower_bound(view_ids.cbegin(), view_ids.cend(),
+            observation_view_ids[i]) - view_ids.cbegin()];
         }
       }
-      // Remove colored track
-      for (const auto & to_remove_it : set_toRemove)
-      {
-        remainingTrackToColor.erase(to_remove_it);
-      }
     }
   }
   return true;
@@ -9,6 +9,7 @@
 #include "openMVG/sfm/sfm_data_filters_frustum.hpp"
 
 #include "openMVG/cameras/Camera_Pinhole.hpp"
+#include "openMVG/geometry/aabb_tree.hpp"
 #include "openMVG/geometry/pose3.hpp"
 #include "openMVG/image/pixel_types.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
@@ -16,6 +17,7 @@
 
 #include "third_party/progress/progress_display.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <iomanip>
 #include <iterator>
@@ -96,38 +98,104 @@ const
   viewIds.reserve(z_near_z_far_perView.size());
   std::transform(z_near_z_far_perView.cbegin(), z_near_z_far_perView.cend(),
     std::back_inserter(viewIds), stl::RetrieveKey());
+  // Keep only the views with a defined frustum
+  viewIds.erase(
+    std::remove_if(viewIds.begin(), viewIds.end(),
+      [&](const IndexT view_id) { return frustum_perView.count(view_id) == 0; }),
+    viewIds.end());
+
+  std::vector<const Frustum *> frustums(viewIds.size());
+  for (size_t i = 0; i < viewIds.size(); ++i)
+    frustums[i] = &frustum_perView.at(viewIds[i]);
+
+  //-- Broad phase:
+  // Index the bounding boxes of the truncated frustums in a tree.
+  // The infinite frustums are unbounded: they are tested against all the views.
+  std::vector<AABB_Tree::AABB> boxes;
+  std::vector<int> box_view_index;   // box index -> view index
+  std::vector<int> unbounded_view_index;
+  std::vector<AABB_Tree::AABB> view_boxes(viewIds.size());
+  std::vector<bool> is_bounded(viewIds.size());
+  for (int i = 0; i < static_cast<int>(viewIds.size()); ++i)
+  {
+    is_bounded[i] = frustums[i]->bounding_box(view_boxes[i]);
+    if (is_bounded[i])
+    {
+      boxes.push_back(view_boxes[i]);
+      box_view_index.push_back(i);
+    }
+    else
+    {
+      unbounded_view_index.push_back(i);
+    }
+  }
+  const AABB_Tree tree(boxes);
 
   C_Progress_display my_progress_bar(
-    viewIds.size() * (viewIds.size()-1)/2,
+    viewIds.size(),
     std::cout, "\nCompute frustum intersection\n");
 
-  // Exhaustive comparison (use the fact that the intersect function is symmetric)
+  //-- Narrow phase:
+  // Exact frustum/frustum test (separating axis theorem), then the linear
+  // program test with the optional bounding volume.
+  // (use the fact that the intersect function is symmetric)
 #ifdef OPENMVG_USE_OPENMP
-  #pragma omp parallel for
+  #pragma omp parallel
 #endif
-  for (int i = 0; i < (int)viewIds.size(); ++i)
   {
     // Prepare vector of intersecting objects (within loop to keep it
     // thread-safe)
     std::vector<HalfPlaneObject> objects = bounding_volume;
-    objects.insert(objects.end(),
-                   { frustum_perView.at(viewIds[i]), HalfPlaneObject() });
+    objects.insert(objects.end(), { HalfPlaneObject(), HalfPlaneObject() });
 
-    for (size_t j = i+1; j < viewIds.size(); ++j)
-    {
-      objects.back() = frustum_perView.at(viewIds[j]);
-      if (intersect(objects))
-      {
+    std::vector<int> candidates;
+    std::vector<Pair> thread_pairs;
 #ifdef OPENMVG_USE_OPENMP
-        #pragma omp critical
+    #pragma omp for schedule(dynamic)
 #endif
+    for (int i = 0; i < (int)viewIds.size(); ++i)
+    {
+      // List the candidate views j > i
+      candidates.clear();
+      if (is_bounded[i])
+      {
+        tree.Query(view_boxes[i], [&](const uint32_t box_index)
         {
-          pairs.insert({viewIds[i], viewIds[j]});
+          if (box_view_index[box_index] > i)
+            candidates.push_back(box_view_index[box_index]);
+        });
+        for (const int j : unbounded_view_index)
+          if (j > i)
+            candidates.push_back(j);
+      }
+      else
+      {
+        for (int j = i + 1; j < (int)viewIds.size(); ++j)
+          candidates.push_back(j);
+      }
+
+      for (const int j : candidates)
+      {
+        if (!frustums[i]->intersect_SAT(*frustums[j]))
+          continue;
+        if (!bounding_volume.empty())
+        {
+          objects[objects.size() - 2] = *frustums[i];
+          objects.back() = *frustums[j];
+          if (!intersect(objects))
+            continue;
         }
+        thread_pairs.emplace_back(viewIds[i], viewIds[j]);
       }
       // Progress bar update
       ++my_progress_bar;
     }
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp critical
+#endif
+    {
+      pairs.insert(thread_pairs.cbegin(), thread_pairs.cend());
+    }
   }
   return pairs;
 }
@@ -0,0 +1,590 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+// The <cereal/archives> headers are special and must be included first.
+#include <cereal/archives/portable_binary.hpp>
+
+#include "openMVG/sfm/sfm_data_io_chunked.hpp"
+
+#include "openMVG/cameras/cameras_io.hpp"
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_view_io.hpp"
+#include "openMVG/sfm/sfm_view_priors_io.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <cereal/types/map.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/unordered_map.hpp>
+#include <cereal/types/vector.hpp>
+
+namespace openMVG {
+namespace sfm {
+
+namespace {
+
+// File signature, version & byte order mark
+const char kChunked_Signature[8] = {'o', 'M', 'V', 'G', 's', 'f', 'm', 'c'};
+const uint32_t kChunked_Version = 1;
+const uint32_t kByte_Order_Mark = 0x01020304;
+const size_t kHeader_Size = sizeof(kChunked_Signature) + 2 * sizeof(uint32_t) + sizeof(uint64_t);
+
+// Section kinds (the scene parts use their ESfM_Data value)
+const uint64_t kRoot_Path_Section = 0;
+
+// Number of structure chunks that are read (and decoded in parallel) at once
+const size_t kChunk_Batch_Size = 16;
+
+template <typename T>
+void Append(std::vector<char> & buffer, const T & value)
+{
+  const char * bytes = reinterpret_cast<const char *>(&value);
+  buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+T Read(const char *& it)
+{
+  T value;
+  std::memcpy(&value, it, sizeof(T));
+  it += sizeof(T);
+  return value;
+}
+
+// Pad the buffer to a multiple of 8 bytes
+void Align(std::vector<char> & buffer)
+{
+  buffer.resize((buffer.size() + 7) / 8 * 8, 0);
+}
+
+// Landmark record: id, #obs, X, [view id, feature id, x]...
+void AppendLandmark
+(
+  std::vector<char> & buffer,
+  const IndexT landmark_id,
+  const Landmark & landmark
+)
+{
+  Append<uint32_t>(buffer, landmark_id);
+  Append<uint32_t>(buffer, static_cast<uint32_t>(landmark.obs.size()));
+  Append<double>(buffer, landmark.X(0));
+  Append<double>(buffer, landmark.X(1));
+  Append<double>(buffer, landmark.X(2));
+  for (const auto & obs_it : landmark.obs)
+  {
+    Append<uint32_t>(buffer, obs_it.first);
+    Append<uint32_t>(buffer, obs_it.second.id_feat);
+    Append<double>(buffer, obs_it.second.x(0));
+    Append<double>(buffer, obs_it.second.x(1));
+  }
+}
+
+// Size of a landmark record without its observations
+const size_t kLandmark_Record_Size = 2 * sizeof(uint32_t) + 3 * sizeof(double);
+// Size of a pose record: id, padding, rotation, center
+const size_t kPose_Record_Size = 2 * sizeof(uint32_t) + 12 * sizeof(double);
+
+// Decode the landmark records of a chunk
+bool DecodeLandmarks
+(
+  const std::vector<char> & chunk,
+  const uint64_t landmark_count,
+  std::vector<std::pair<IndexT, Landmark>> & landmarks
+)
+{
+  // Check the count before allocating the landmarks
+  if (landmark_count > chunk.size() / kLandmark_Record_Size)
+    return false;
+  landmarks.resize(landmark_count);
+  const char * it = chunk.data();
+  const char * end = chunk.data() + chunk.size();
+  for (auto & landmark_it : landmarks)
+  {
+    if (end - it < static_cast<std::ptrdiff_t>(kLandmark_Record_Size))
+      return false;
+    landmark_it.first = Read<uint32_t>(it);
+    const uint32_t obs_count = Read<uint32_t>(it);
+    Landmark & landmark = landmark_it.second;
+    landmark.X(0) = Read<double>(it);
+    landmark.X(1) = Read<double>(it);
+    landmark.X(2) = Read<double>(it);
+    if (static_cast<uint64_t>(end - it) < obs_count * (2 * sizeof(uint32_t) + 2 * sizeof(double)))
+      return false;
+    for (uint32_t i = 0; i < obs_count; ++i)
+    {
+      const IndexT view_id = Read<uint32_t>(it);
+      Observation & obs = landmark.obs[view_id];
+      obs.id_feat = Read<uint32_t>(it);
+      obs.x(0) = Read<double>(it);
+      obs.x(1) = Read<double>(it);
+    }
+  }
+  return it == end;
+}
+
+// Read a whole section
+bool ReadSection
+(
+  std::ifstream & stream,
+  const uint64_t offset,
+  const uint64_t size,
+  std::vector<char> & buffer
+)
+{
+  buffer.resize(size);
+  stream.seekg(offset);
+  stream.read(buffer.data(), size);
+  return static_cast<bool>(stream);
+}
+
+template <typename T>
+bool Save_Cereal_Section(const T & data, std::vector<char> & buffer)
+{
+  std::ostringstream stream(std::ios::binary | std::ios::out);
+  try
+  {
+    cereal::PortableBinaryOutputArchive archive(stream);
+    archive(data);
+  }
+  catch (const cereal::Exception & e)
+  {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+  const std::string bytes = stream.str();
+  buffer.assign(bytes.cbegin(), bytes.cend());
+  return true;
+}
+
+template <typename T>
+bool Load_Cereal_Section(const std::vector<char> & buffer, T & data)
+{
+  std::istringstream stream(std::string(buffer.cbegin(), buffer.cend()),
+    std::ios::binary | std::ios::in);
+  try
+  {
+    cereal::PortableBinaryInputArchive archive(stream);
+    archive(data);
+  }
+  catch (const cereal::Exception & e)
+  {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// Load a STRUCTURE or CONTROL_POINTS section
+bool Load_Landmarks_Section
+(
+  std::ifstream & stream,
+  const uint64_t offset,
+  const uint64_t size,
+  Landmarks & landmarks
+)
+{
+  //-- Chunk table (at the end of the section)
+  if (size < sizeof(uint64_t))
+    return false;
+  std::vector<char> buffer;
+  if (!ReadSection(stream, offset + size - sizeof(uint64_t), sizeof(uint64_t), buffer))
+    return false;
+  const char * it = buffer.data();
+  const uint64_t chunk_count = Read<uint64_t>(it);
+  // Check the count before computing the table size (overflow) & allocating it
+  if (chunk_count > (size - sizeof(uint64_t)) / (2 * sizeof(uint64_t)))
+    return false;
+  const uint64_t chunk_table_size = chunk_count * 2 * sizeof(uint64_t);
+  const uint64_t chunk_table_offset = size - sizeof(uint64_t) - chunk_table_size;
+  if (!ReadSection(stream, offset + chunk_table_offset, chunk_table_size, buffer))
+    return false;
+  std::vector<std::pair<uint64_t, uint64_t>> chunks(chunk_count);
+  it = buffer.data();
+  uint64_t previous_chunk_offset = 0;
+  for (auto & chunk : chunks)
+  {
+    chunk.first = Read<uint64_t>(it);
+    chunk.second = Read<uint64_t>(it);
+    // The chunks are stored in order before the chunk table
+    if (chunk.first < previous_chunk_offset || chunk.first > chunk_table_offset)
+      return false;
+    previous_chunk_offset = chunk.first;
+  }
+
+  //-- Read the chunks by batches and decode them in parallel
+  for (size_t batch_begin = 0; batch_begin < chunks.size(); batch_begin += kChunk_Batch_Size)
+  {
+    const size_t batch_end = std::min(chunks.size(), batch_begin + kChunk_Batch_Size);
+    std::vector<std::vector<char>> chunk_buffers(batch_end - batch_begin);
+    for (size_t i = batch_begin; i < batch_end; ++i)
+    {
+      const uint64_t chunk_end = (i + 1 < chunks.size()) ? chunks[i + 1].first : chunk_table_offset;
+      if (!ReadSection(stream, offset + chunks[i].first, chunk_end - chunks[i].first,
+            chunk_buffers[i - batch_begin]))
+        return false;
+    }
+
+    std::vector<std::vector<std::pair<IndexT, Landmark>>> chunk_landmarks(chunk_buffers.size());
+    bool b_valid = true;
+#ifdef OPENMVG_USE_OPENMP
+    #pragma omp parallel for schedule(dynamic) reduction(&&:b_valid)
+#endif
+    for (int i = 0; i < static_cast<int>(chunk_buffers.size()); ++i)
+    {
+      b_valid = DecodeLandmarks(chunk_buffers[i], chunks[batch_begin + i].second,
+        chunk_landmarks[i]) && b_valid;
+      // Release the raw chunk as soon as it is decoded
+      std::vector<char>().swap(chunk_buffers[i]);
+    }
+    if (!b_valid)
+      return false;
+
+    for (auto & landmarks_chunk : chunk_landmarks)
+    {
+      for (auto & landmark_it : landmarks_chunk)
+      {
+        // Landmarks are written by ascending id: insert at the end
+        landmarks.emplace_hint(landmarks.end(),
+          landmark_it.first, std::move(landmark_it.second));
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+SfM_Data_Chunked_Writer::SfM_Data_Chunked_Writer
+(
+  const std::string & filename,
+  const size_t chunk_size
+):
+  stream_(filename.c_str(), std::ios::binary | std::ios::out),
+  chunk_size_(std::max(chunk_size, size_t(1)))
+{
+  if (!stream_.is_open())
+    return;
+
+  // Header (the table of contents offset is written by Close)
+  std::vector<char> header;
+  header.insert(header.end(), kChunked_Signature, kChunked_Signature + sizeof(kChunked_Signature));
+  Append<uint32_t>(header, kChunked_Version);
+  Append<uint32_t>(header, kByte_Order_Mark);
+  Append<uint64_t>(header, 0);
+  stream_.write(header.data(), header.size());
+}
+
+SfM_Data_Chunked_Writer::~SfM_Data_Chunked_Writer()
+{
+  if (IsOpen())
+    Close();
+}
+
+bool SfM_Data_Chunked_Writer::IsOpen() const
+{
+  return stream_.is_open();
+}
+
+bool SfM_Data_Chunked_Writer::WriteScene
+(
+  const SfM_Data & sfm_data,
+  ESfM_Data flags_part
+)
+{
+  if (!IsOpen() || b_structure_started_)
+    return false;
+
+  const auto write_section = [&](const uint64_t kind, std::vector<char> & buffer)
+  {
+    Align(buffer);
+    sections_.push_back({{kind, static_cast<uint64_t>(stream_.tellp()),
+      static_cast<uint64_t>(buffer.size())}});
+    stream_.write(buffer.data(), buffer.size());
+  };
+
+  std::vector<char> buffer;
+  // Root path
+  Append<uint64_t>(buffer, sfm_data.s_root_path.size());
+  buffer.insert(buffer.end(), sfm_data.s_root_path.cbegin(), sfm_data.s_root_path.cend());
+  write_section(kRoot_Path_Section, buffer);
+
+  if ((flags_part & VIEWS) == VIEWS)
+  {
+    if (!Save_Cereal_Section(sfm_data.views, buffer))
+      return false;
+    write_section(VIEWS, buffer);
+  }
+
+  if ((flags_part & INTRINSICS) == INTRINSICS)
+  {
+    if (!Save_Cereal_Section(sfm_data.intrinsics, buffer))
+      return false;
+    write_section(INTRINSICS, buffer);
+  }
+
+  if ((flags_part & EXTRINSICS) == EXTRINSICS)
+  {
+    // Pose records: id, padding, rotation (column major), center
+    buffer.clear();
+    Append<uint64_t>(buffer, sfm_data.poses.size());
+    for (const auto & pose_it : sfm_data.poses)
+    {
+      Append<uint32_t>(buffer, pose_it.first);
+      Append<uint32_t>(buffer, 0);
+      const Mat3 & rotation = pose_it.second.rotation();
+      for (int i = 0; i < 9; ++i)
+        Append<double>(buffer, rotation.data()[i]);
+      const Vec3 & center = pose_it.second.center();
+      for (int i = 0; i < 3; ++i)
+        Append<double>(buffer, center(i));
+    }
+    write_section(EXTRINSICS, buffer);
+  }
+
+  if ((flags_part & CONTROL_POINTS) == CONTROL_POINTS)
+  {
+    // Control points are stored as a single chunk
+    buffer.clear();
+    for (const auto & landmark_it : sfm_data.control_points)
+      AppendLandmark(buffer, landmark_it.first, landmark_it.second);
+    Append<uint64_t>(buffer, 0);
+    Append<uint64_t>(buffer, sfm_data.control_points.size());
+    Append<uint64_t>(buffer, 1);
+    write_section(CONTROL_POINTS, buffer);
+  }
+  return static_cast<bool>(stream_);
+}
+
+bool SfM_Data_Chunked_Writer::AddLandmark
+(
+  const IndexT landmark_id,
+  const Landmark & landmark
+)
+{
+  if (!IsOpen())
+    return false;
+  if (!b_structure_started_)
+  {
+    b_structure_started_ = true;
+    structure_offset_ = stream_.tellp();
+  }
+  AppendLandmark(chunk_, landmark_id, landmark);
+  if (++chunk_landmark_count_ == chunk_size_)
+    return FlushChunk();
+  return true;
+}
+
+bool SfM_Data_Chunked_Writer::FlushChunk()
+{
+  if (chunk_landmark_count_ == 0)
+    return true;
+  chunks_.emplace_back(
+    static_cast<uint64_t>(stream_.tellp()) - structure_offset_, chunk_landmark_count_);
+  stream_.write(chunk_.data(), chunk_.size());
+  chunk_.clear();
+  chunk_landmark_count_ = 0;
+  return static_cast<bool>(stream_);
+}
+
+void SfM_Data_Chunked_Writer::EndStructure()
+{
+  FlushChunk();
+  std::vector<char> chunk_table;
+  for (const auto & chunk : chunks_)
+  {
+    Append<uint64_t>(chunk_table, chunk.first);
+    Append<uint64_t>(chunk_table, chunk.second);
+  }
+  Append<uint64_t>(chunk_table, chunks_.size());
+  stream_.write(chunk_table.data(), chunk_table.size());
+  sections_.push_back({{STRUCTURE, structure_offset_,
+    static_cast<uint64_t>(stream_.tellp()) - structure_offset_}});
+  b_structure_started_ = false;
+  chunks_.clear();
+}
+
+bool SfM_Data_Chunked_Writer::Close()
+{
+  if (!IsOpen())
+    return false;
+  if (b_structure_started_)
+    EndStructure();
+
+  // Table of contents
+  std::vector<char> toc;
+  const uint64_t toc_offset = stream_.tellp();
+  Append<uint64_t>(toc, sections_.size());
+  for (const auto & section : sections_)
+    for (const uint64_t value : section)
+      Append<uint64_t>(toc, value);
+  stream_.write(toc.data(), toc.size());
+
+  // Update the header
+  stream_.seekp(kHeader_Size - sizeof(uint64_t));
+  stream_.write(reinterpret_cast<const char *>(&toc_offset), sizeof(uint64_t));
+  stream_.flush();
+  const bool b_ok = static_cast<bool>(stream_);
+  stream_.close();
+  return b_ok;
+}
+
+bool Save_Chunked
+(
+  const SfM_Data & sfm_data,
+  const std::string & filename,
+  ESfM_Data flags_part
+)
+{
+  SfM_Data_Chunked_Writer writer(filename);
+  if (!writer.IsOpen())
+    return false;
+  bool b_ok = writer.WriteScene(sfm_data, flags_part);
+  if (b_ok && (flags_part & STRUCTURE) == STRUCTURE)
+  {
+    // Landmarks are written by ascending id (fast insertion at load time)
+    std::vector<IndexT> landmark_ids;
+    landmark_ids.reserve(sfm_data.structure.size());
+    for (const auto & landmark_it : sfm_data.structure)
+      landmark_ids.push_back(landmark_it.first);
+    std::sort(landmark_ids.begin(), landmark_ids.end());
+    for (const IndexT landmark_id : landmark_ids)
+    {
+      if (!writer.AddLandmark(landmark_id, sfm_data.structure.at(landmark_id)))
+      {
+        b_ok = false;
+        break;
+      }
+    }
+  }
+  return writer.Close() && b_ok;
+}
+
+bool Load_Chunked
+(
+  SfM_Data & sfm_data,
+  const std::string & filename,
+  ESfM_Data flags_part
+)
+{
+  std::ifstream stream(filename.c_str(), std::ios::binary | std::ios::in);
+  if (!stream.is_open())
+    return false;
+  // The sizes & counts read from the file are checked against the file size
+  //  before any allocation
+  stream.seekg(0, std::ios::end);
+  const uint64_t file_size = static_cast<uint64_t>(stream.tellg());
+  stream.seekg(0);
+
+  //-- Header
+  std::vector<char> buffer;
+  if (!ReadSection(stream, 0, kHeader_Size, buffer)
+      || !std::equal(kChunked_Signature, kChunked_Signature + sizeof(kChunked_Signature),
+            buffer.cbegin()))
+  {
+    std::cerr << "Invalid chunked sfm_data file: " << filename << std::endl;
+    return false;
+  }
+  const char * it = buffer.data() + sizeof(kChunked_Signature);
+  const uint32_t version = Read<uint32_t>(it);
+  const uint32_t byte_order_mark = Read<uint32_t>(it);
+  const uint64_t toc_offset = Read<uint64_t>(it);
+  if (version != kChunked_Version || byte_order_mark != kByte_Order_Mark)
+  {
+    std::cerr << "Unsupported chunked sfm_data file version or byte order: "
+      << filename << std::endl;
+    return false;
+  }
+
+  //-- Table of contents
+  if (file_size < sizeof(uint64_t) || toc_offset > file_size - sizeof(uint64_t)
+      || !ReadSection(stream, toc_offset, sizeof(uint64_t), buffer))
+  {
+    std::cerr << "Invalid chunked sfm_data table of contents: " << filename << std::endl;
+    return false;
+  }
+  it = buffer.data();
+  const uint64_t section_count = Read<uint64_t>(it);
+  if (section_count > (file_size - toc_offset - sizeof(uint64_t)) / (3 * sizeof(uint64_t))
+      || !ReadSection(stream, toc_offset + sizeof(uint64_t),
+        section_count * 3 * sizeof(uint64_t), buffer))
+  {
+    std::cerr << "Invalid chunked sfm_data table of contents: " << filename << std::endl;
+    return false;
+  }
+  std::vector<std::array<uint64_t, 3>> sections(section_count);
+  it = buffer.data();
+  for (auto & section : sections)
+    for (uint64_t & value : section)
+      value = Read<uint64_t>(it);
+
+  //-- Load the requested sections
+  for (const auto & section : sections)
+  {
+    const uint64_t kind = section[0], offset = section[1], size = section[2];
+    bool b_ok = offset <= file_size && size <= file_size - offset;
+    if (b_ok && kind == kRoot_Path_Section)
+    {
+      b_ok = ReadSection(stream, offset, size, buffer) && size >= sizeof(uint64_t);
+      if (b_ok)
+      {
+        it = buffer.data();
+        const uint64_t length = Read<uint64_t>(it);
+        b_ok = length <= size - sizeof(uint64_t);
+        if (b_ok)
+          sfm_data.s_root_path.assign(it, length);
+      }
+    }
+    else if (b_ok && (kind == STRUCTURE || kind == CONTROL_POINTS))
+    {
+      if ((flags_part & kind) == kind)
+      {
+        b_ok = Load_Landmarks_Section(stream, offset, size,
+          kind == STRUCTURE ? sfm_data.structure : sfm_data.control_points);
+      }
+    }
+    else if (b_ok && (flags_part & kind) == kind)
+    {
+      b_ok = ReadSection(stream, offset, size, buffer);
+      if (b_ok && kind == VIEWS)
+        b_ok = Load_Cereal_Section(buffer, sfm_data.views);
+      else if (b_ok && kind == INTRINSICS)
+        b_ok = Load_Cereal_Section(buffer, sfm_data.intrinsics);
+      else if (b_ok && kind == EXTRINSICS)
+      {
+        b_ok = size >= sizeof(uint64_t);
+        it = buffer.data();
+        const uint64_t pose_count = b_ok ? Read<uint64_t>(it) : 0;
+        b_ok = b_ok && pose_count <= (size - sizeof(uint64_t)) / kPose_Record_Size;
+        for (uint64_t i = 0; b_ok && i < pose_count; ++i)
+        {
+          const IndexT pose_id = Read<uint32_t>(it);
+          Read<uint32_t>(it); // padding
+          Mat3 rotation;
+          for (int j = 0; j < 9; ++j)
+            rotation.data()[j] = Read<double>(it);
+          Vec3 center;
+          for (int j = 0; j < 3; ++j)
+            center(j) = Read<double>(it);
+          sfm_data.poses[pose_id] = geometry::Pose3(rotation, center);
+        }
+      }
+    }
+    if (!b_ok)
+    {
+      std::cerr << "Cannot read the section " << kind << " of: " << filename << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace sfm
+} // namespace openMVG
@@ -0,0 +1,112 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SFM_SFM_DATA_IO_CHUNKED_HPP
+#define OPENMVG_SFM_SFM_DATA_IO_CHUNKED_HPP
+
+#include "openMVG/numeric/eigen_alias_definition.hpp"
+#include "openMVG/sfm/sfm_data_io.hpp"
+#include "openMVG/sfm/sfm_landmark.hpp"
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace openMVG {
+namespace sfm {
+
+struct SfM_Data;
+
+/// Chunked binary SfM_Data file (".sfmc").
+///
+/// The scene parts are stored in independent sections listed by a table of
+/// contents, so a part can be loaded without parsing the others (i.e. the
+/// poses and the intrinsics of a large reconstruction).
+/// - Header: signature (8 bytes), version (uint32), byte order mark (uint32),
+///   table of contents offset (uint64).
+/// - Sections (8 bytes aligned, in the host byte order):
+///   - root path,
+///   - VIEWS, INTRINSICS: portable binary cereal archives (polymorphic data),
+///   - EXTRINSICS: fixed size pose records {id, rotation, center},
+///   - STRUCTURE, CONTROL_POINTS: chunks of landmark records
+///     {id, #obs, X, [view id, feature id, x]...} followed by the chunk table.
+///     The chunks are decoded in parallel.
+/// - Table of contents: section count, {kind, offset, size}...
+/// All the records are 8 bytes aligned raw arrays: a section can be used from
+/// a memory mapped file.
+
+/// Save a SfM_Data scene to a chunked binary file
+bool Save_Chunked
+(
+  const SfM_Data & sfm_data,
+  const std::string & filename,
+  ESfM_Data flags_part
+);
+
+/// Load the given parts of a SfM_Data scene from a chunked binary file
+bool Load_Chunked
+(
+  SfM_Data & sfm_data,
+  const std::string & filename,
+  ESfM_Data flags_part
+);
+
+/// Write a chunked binary file with a streamed structure: the landmarks are
+/// written chunk by chunk as they are added, the whole structure is never
+/// held in memory.
+class SfM_Data_Chunked_Writer
+{
+public:
+  /// Open the file, landmarks are written by chunks of chunk_size landmarks
+  explicit SfM_Data_Chunked_Writer
+  (
+    const std::string & filename,
+    const size_t chunk_size = 65536
+  );
+
+  /// Close the file (if not done yet)
+  ~SfM_Data_Chunked_Writer();
+
+  bool IsOpen() const;
+
+  /// Write the root path and the VIEWS, INTRINSICS, EXTRINSICS and
+  /// CONTROL_POINTS sections selected by flags_part (the structure is
+  /// written with AddLandmark).
+  bool WriteScene(const SfM_Data & sfm_data, ESfM_Data flags_part);
+
+  /// Append a landmark to the STRUCTURE section
+  bool AddLandmark(const IndexT landmark_id, const Landmark & landmark);
+
+  /// Write the pending landmarks and the table of contents
+  bool Close();
+
+private:
+  bool FlushChunk();
+  void EndStructure();
+
+  std::ofstream stream_;
+  size_t chunk_size_;
+  // Table of contents {kind, offset, size}
+  std::vector<std::array<uint64_t, 3>> sections_;
+
+  // STRUCTURE section state
+  bool b_structure_started_ = false;
+  uint64_t structure_offset_ = 0;
+  std::vector<char> chunk_;
+  uint64_t chunk_landmark_count_ = 0;
+  // Chunk table {offset in section, landmark count}
+  std::vector<std::pair<uint64_t, uint64_t>> chunks_;
+};
+
+} // namespace sfm
+} // namespace openMVG
+
+#endif // OPENMVG_SFM_SFM_DATA_IO_CHUNKED_HPP
@@ -8,12 +8,17 @@
 
 #include "openMVG/cameras/Camera_Pinhole.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_data_BA_ceres_io.hpp"
 #include "openMVG/sfm/sfm_data_io.hpp"
+#include "openMVG/sfm/sfm_data_io_chunked.hpp"
 #include "openMVG/cameras/Camera_Intrinsics.hpp"
 
 #include "testing/testing.h"
 #include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
 
+#include <cstring>
+#include <fstream>
+#include <iterator>
 #include <sstream>
 
 using namespace openMVG;
@@ -63,7 +68,7 @@ SfM_Data create_test_scene(IndexT viewsCount, bool bSharedIntrinsic)
 
 TEST(SfM_Data_IO, SAVE_LOAD_JSON) {
 
-  const std::vector<std::string> ext_Type = {"json", "bin", "xml"};
+  const std::vector<std::string> ext_Type = {"json", "bin", "xml", "sfmc"};
 
   for (size_t i=0; i < ext_Type.size(); ++i)
   {
@@ -164,6 +169,169 @@ TEST(SfM_Data_IO, SAVE_LOAD_JSON) {
   }
 }
 
+TEST(SfM_Data_IO, SAVE_LOAD_CHUNKED_STRUCTURE) {
+
+  const std::string filename = "SAVE_LOAD_CHUNKED.sfmc";
+
+  // A scene with a structure split in several chunks
+  SfM_Data sfm_data = create_test_scene(4, false);
+  sfm_data.poses[2] = Pose3(RotationAroundZ(0.5), Vec3(1, 2, 3));
+  for (IndexT i = 0; i < 100; ++i)
+  {
+    Landmark & landmark = sfm_data.structure[i];
+    landmark.X = Vec3(i, 2 * i, 3 * i);
+    for (IndexT j = 0; j < 1 + i % 4; ++j)
+      landmark.obs[j] = Observation(Vec2(i, j), 10 * i + j);
+  }
+  sfm_data.control_points[7].X = Vec3(1, 1, 1);
+  sfm_data.control_points[7].obs[1] = Observation(Vec2(5, 5), UndefinedIndexT);
+  {
+    SfM_Data_Chunked_Writer writer(filename, 16);
+    EXPECT_TRUE( writer.WriteScene(sfm_data, ALL) );
+    for (const auto & landmark_it : sfm_data.structure)
+      EXPECT_TRUE( writer.AddLandmark(landmark_it.first, landmark_it.second) );
+    EXPECT_TRUE( writer.Close() );
+  }
+
+  SfM_Data sfm_data_load;
+  EXPECT_TRUE( Load(sfm_data_load, filename, ALL) );
+  EXPECT_EQ( sfm_data.s_root_path, sfm_data_load.s_root_path );
+  EXPECT_EQ( sfm_data.views.size(), sfm_data_load.views.size() );
+  EXPECT_EQ( sfm_data.intrinsics.size(), sfm_data_load.intrinsics.size() );
+  EXPECT_EQ( sfm_data.poses.size(), sfm_data_load.poses.size() );
+  EXPECT_MATRIX_NEAR( sfm_data.poses.at(2).rotation(), sfm_data_load.poses.at(2).rotation(), 1e-8 );
+  EXPECT_MATRIX_NEAR( sfm_data.poses.at(2).center(), sfm_data_load.poses.at(2).center(), 1e-8 );
+  EXPECT_EQ( sfm_data.structure.size(), sfm_data_load.structure.size() );
+  for (const auto & landmark_it : sfm_data.structure)
+  {
+    const Landmark & landmark = sfm_data_load.structure.at(landmark_it.first);
+    EXPECT_MATRIX_NEAR( landmark_it.second.X, landmark.X, 1e-8 );
+    EXPECT_EQ( landmark_it.second.obs.size(), landmark.obs.size() );
+    for (const auto & obs_it : landmark_it.second.obs)
+    {
+      EXPECT_EQ( obs_it.second.id_feat, landmark.obs.at(obs_it.first).id_feat );
+      EXPECT_MATRIX_NEAR( obs_it.second.x, landmark.obs.at(obs_it.first).x, 1e-8 );
+    }
+  }
+  EXPECT_EQ( 1, sfm_data_load.control_points.size() );
+  EXPECT_EQ( 1, sfm_data_load.control_points.at(7).obs.size() );
+
+  // Partial loading: only the structure
+  SfM_Data sfm_data_structure;
+  EXPECT_TRUE( Load(sfm_data_structure, filename, STRUCTURE) );
+  EXPECT_EQ( 0, sfm_data_structure.views.size() );
+  EXPECT_EQ( 0, sfm_data_structure.poses.size() );
+  EXPECT_EQ( sfm_data.structure.size(), sfm_data_structure.structure.size() );
+  EXPECT_EQ( 0, sfm_data_structure.control_points.size() );
+
+  // A cereal binary file is not a chunked file
+  EXPECT_TRUE( Save(sfm_data, "SAVE_LOAD.bin", ALL) );
+  EXPECT_FALSE( Load_Chunked(sfm_data_structure, "SAVE_LOAD.bin", ALL) );
+}
+
+// Read & write a 64 bit value of a chunked file
+uint64_t Get_Chunked_Value(const std::string & bytes, const uint64_t offset)
+{
+  uint64_t value;
+  std::memcpy(&value, bytes.data() + offset, sizeof(value));
+  return value;
+}
+
+void Set_Chunked_Value(std::string & bytes, const uint64_t offset, const uint64_t value)
+{
+  std::memcpy(&bytes[offset], &value, sizeof(value));
+}
+
+TEST(SfM_Data_IO, LOAD_CHUNKED_CORRUPTED) {
+
+  const std::string filename = "LOAD_CHUNKED_CORRUPTED.sfmc";
+
+  SfM_Data sfm_data = create_test_scene(4, false);
+  for (IndexT i = 0; i < 100; ++i)
+  {
+    sfm_data.structure[i].X = Vec3(i, 2 * i, 3 * i);
+    sfm_data.structure[i].obs[0] = Observation(Vec2(i, i), i);
+  }
+  {
+    SfM_Data_Chunked_Writer writer(filename, 16);
+    EXPECT_TRUE( writer.WriteScene(sfm_data, ALL) );
+    for (const auto & landmark_it : sfm_data.structure)
+      EXPECT_TRUE( writer.AddLandmark(landmark_it.first, landmark_it.second) );
+    EXPECT_TRUE( writer.Close() );
+  }
+  std::string bytes;
+  {
+    std::ifstream stream(filename.c_str(), std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+  }
+  const auto Load_Bytes = [&](const std::string & file_bytes)
+  {
+    {
+      std::ofstream stream(filename.c_str(), std::ios::binary);
+      stream.write(file_bytes.data(), file_bytes.size());
+    }
+    SfM_Data sfm_data_load;
+    return Load_Chunked(sfm_data_load, filename, ALL);
+  };
+  EXPECT_TRUE( Load_Bytes(bytes) );
+
+  // Header: signature, version, byte order mark, table of contents offset
+  const uint64_t toc_offset = Get_Chunked_Value(bytes, 16);
+  const uint64_t section_count = Get_Chunked_Value(bytes, toc_offset);
+  const uint64_t huge_count = uint64_t(1) << 60;
+
+  // Truncated files
+  for (const uint64_t size : {uint64_t(10), toc_offset, uint64_t(bytes.size() - 8)})
+    EXPECT_FALSE( Load_Bytes(bytes.substr(0, size)) );
+
+  // Invalid table of contents
+  {
+    std::string corrupted = bytes;
+    Set_Chunked_Value(corrupted, 16, bytes.size());
+    EXPECT_FALSE( Load_Bytes(corrupted) );
+    corrupted = bytes;
+    Set_Chunked_Value(corrupted, toc_offset, huge_count);
+    EXPECT_FALSE( Load_Bytes(corrupted) );
+  }
+
+  // Invalid sections & counts
+  for (uint64_t i = 0; i < section_count; ++i)
+  {
+    const uint64_t entry = toc_offset + sizeof(uint64_t) + i * 3 * sizeof(uint64_t);
+    const uint64_t kind = Get_Chunked_Value(bytes, entry);
+    const uint64_t offset = Get_Chunked_Value(bytes, entry + 8);
+    const uint64_t size = Get_Chunked_Value(bytes, entry + 16);
+
+    std::string corrupted = bytes;
+    Set_Chunked_Value(corrupted, entry + 16, bytes.size());
+    EXPECT_FALSE( Load_Bytes(corrupted) );
+
+    if (kind == EXTRINSICS)
+    {
+      // Pose count
+      corrupted = bytes;
+      Set_Chunked_Value(corrupted, offset, huge_count);
+      EXPECT_FALSE( Load_Bytes(corrupted) );
+    }
+    else if (kind == STRUCTURE)
+    {
+      // Chunk count
+      corrupted = bytes;
+      Set_Chunked_Value(corrupted, offset + size - 8, huge_count);
+      EXPECT_FALSE( Load_Bytes(corrupted) );
+      // Landmark count & offset of the first chunk
+      const uint64_t chunk_count = Get_Chunked_Value(bytes, offset + size - 8);
+      const uint64_t chunk_table = offset + size - 8 - chunk_count * 16;
+      corrupted = bytes;
+      Set_Chunked_Value(corrupted, chunk_table + 8, huge_count);
+      EXPECT_FALSE( Load_Bytes(corrupted) );
+      corrupted = bytes;
+      Set_Chunked_Value(corrupted, chunk_table, huge_count);
+      EXPECT_FALSE( Load_Bytes(corrupted) );
+    }
+  }
+}
+
 TEST(SfM_Data_IO, SAVE_PLY) {
 
   // SAVE as PLY
@@ -180,6 +348,50 @@ TEST(SfM_Data_IO, SAVE_PLY) {
   }
 }
 
+TEST(SfM_Data_IO, SAVE_LOAD_BA_PROBLEM) {
+
+  const std::string filename = "BA_problem.bin";
+
+  // SAVE
+  const SfM_Data sfm_data = create_test_scene(2, true);
+  const Optimize_Options optimize_options(
+    Intrinsic_Parameter_Type::ADJUST_FOCAL_LENGTH,
+    Extrinsic_Parameter_Type::ADJUST_ROTATION,
+    Structure_Parameter_Type::NONE);
+  Bundle_Adjustment_Ceres::BA_Ceres_options ceres_options(false, false);
+  ceres_options.large_scene_pose_threshold_ = 42;
+  ceres_options.bUse_inner_iterations_ = true;
+  ceres_options.max_num_iterations_ = 7;
+  ceres_options.max_solver_time_ = 0.25;
+  EXPECT_TRUE( Save_BA_Problem(sfm_data, optimize_options, ceres_options, filename) );
+
+  // LOAD
+  SfM_Data sfm_data_load;
+  Optimize_Options optimize_options_load;
+  Bundle_Adjustment_Ceres::BA_Ceres_options ceres_options_load;
+  EXPECT_TRUE( Load_BA_Problem(sfm_data_load, optimize_options_load, ceres_options_load, filename) );
+
+  EXPECT_EQ( sfm_data_load.views.size(), sfm_data.views.size());
+  EXPECT_EQ( sfm_data_load.poses.size(), sfm_data.poses.size());
+  EXPECT_EQ( sfm_data_load.intrinsics.size(), sfm_data.intrinsics.size());
+  EXPECT_EQ( sfm_data_load.structure.size(), sfm_data.structure.size());
+  EXPECT_EQ( sfm_data_load.structure.at(0).obs.size(), sfm_data.structure.at(0).obs.size());
+  EXPECT_MATRIX_NEAR( sfm_data_load.structure.at(0).X, sfm_data.structure.at(0).X, 1e-8);
+
+  EXPECT_TRUE( optimize_options_load.intrinsics_opt == optimize_options.intrinsics_opt);
+  EXPECT_TRUE( optimize_options_load.extrinsics_opt == optimize_options.extrinsics_opt);
+  EXPECT_TRUE( optimize_options_load.structure_opt == optimize_options.structure_opt);
+  EXPECT_EQ( ceres_options_load.nb_threads_, 1);
+  EXPECT_EQ( ceres_options_load.large_scene_pose_threshold_, 42);
+  EXPECT_TRUE( ceres_options_load.bUse_inner_iterations_);
+  EXPECT_EQ( ceres_options_load.max_num_iterations_, 7);
+  EXPECT_NEAR( ceres_options_load.max_solver_time_, 0.25, 1e-12);
+
+  // A scene file is not a BA problem
+  EXPECT_TRUE( Save(sfm_data, "SAVE_LOAD.bin", ALL) );
+  EXPECT_FALSE( Load_BA_Problem(sfm_data_load, optimize_options_load, ceres_options_load, "SAVE_LOAD.bin") );
+}
+
 /* ************************************************************************* */
 int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
 /* ************************************************************************* */
@@ -0,0 +1,170 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/sfm/sfm_landmark_columnar.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace openMVG {
+namespace sfm {
+
+Columnar_Landmarks::Columnar_Landmarks(const Landmarks & landmarks)
+{
+  Assign(landmarks);
+}
+
+void Columnar_Landmarks::Assign(const Landmarks & landmarks)
+{
+  // Sort the landmarks by id (the Landmarks container can be unordered)
+  std::vector<std::pair<IndexT, const Landmark *>> sorted_landmarks;
+  sorted_landmarks.reserve(landmarks.size());
+  size_t observation_count = 0;
+  for (const auto & landmark_it : landmarks)
+  {
+    sorted_landmarks.emplace_back(landmark_it.first, &landmark_it.second);
+    observation_count += landmark_it.second.obs.size();
+  }
+  std::sort(sorted_landmarks.begin(), sorted_landmarks.end(),
+    [](const std::pair<IndexT, const Landmark *> & a,
+       const std::pair<IndexT, const Landmark *> & b)
+    {
+      return a.first < b.first;
+    });
+
+  //-- Landmark and observation columns
+  const size_t landmark_count = sorted_landmarks.size();
+  landmark_ids_.resize(landmark_count);
+  positions_.resize(3, landmark_count);
+  observation_offsets_.resize(landmark_count + 1);
+  observation_view_ids_.resize(observation_count);
+  observation_feature_ids_.resize(observation_count);
+  observation_coordinates_.resize(2, observation_count);
+  observation_landmark_indices_.resize(observation_count);
+
+  std::vector<std::pair<IndexT, const Observation *>> sorted_observations;
+  size_t observation_index = 0;
+  for (size_t i = 0; i < landmark_count; ++i)
+  {
+    const Landmark & landmark = *sorted_landmarks[i].second;
+    landmark_ids_[i] = sorted_landmarks[i].first;
+    positions_.col(i) = landmark.X;
+    observation_offsets_[i] = observation_index;
+
+    sorted_observations.clear();
+    for (const auto & obs_it : landmark.obs)
+      sorted_observations.emplace_back(obs_it.first, &obs_it.second);
+    std::sort(sorted_observations.begin(), sorted_observations.end(),
+      [](const std::pair<IndexT, const Observation *> & a,
+         const std::pair<IndexT, const Observation *> & b)
+      {
+        return a.first < b.first;
+      });
+    for (const auto & obs_it : sorted_observations)
+    {
+      observation_view_ids_[observation_index] = obs_it.first;
+      observation_feature_ids_[observation_index] = obs_it.second->id_feat;
+      observation_coordinates_.col(observation_index) = obs_it.second->x;
+      observation_landmark_indices_[observation_index] = static_cast<IndexT>(i);
+      ++observation_index;
+    }
+  }
+  observation_offsets_[landmark_count] = observation_index;
+
+  //-- View index (counting sort of the observations by view)
+  view_ids_ = observation_view_ids_;
+  std::sort(view_ids_.begin(), view_ids_.end());
+  view_ids_.erase(std::unique(view_ids_.begin(), view_ids_.end()), view_ids_.end());
+
+  std::vector<IndexT> observation_view_indices(observation_count);
+  view_offsets_.assign(view_ids_.size() + 1, 0);
+  for (size_t i = 0; i < observation_count; ++i)
+  {
+    observation_view_indices[i] = static_cast<IndexT>(
+      std::lower_bound(view_ids_.cbegin(), view_ids_.cend(), observation_view_ids_[i])
+      - view_ids_.cbegin());
+    ++view_offsets_[observation_view_indices[i] + 1];
+  }
+  for (size_t i = 0; i < view_ids_.size(); ++i)
+    view_offsets_[i + 1] += view_offsets_[i];
+
+  view_observations_.resize(observation_count);
+  std::vector<size_t> view_positions(view_offsets_.cbegin(), view_offsets_.cend() - 1);
+  for (size_t i = 0; i < observation_count; ++i)
+    view_observations_[view_positions[observation_view_indices[i]]++] = i;
+}
+
+Landmarks Columnar_Landmarks::ToLandmarks() const
+{
+  Landmarks landmarks;
+  for (size_t i = 0; i < LandmarkCount(); ++i)
+    landmarks.emplace_hint(landmarks.end(), landmark_ids_[i], GetLandmark(i));
+  return landmarks;
+}
+
+Landmark Columnar_Landmarks::GetLandmark(const size_t index) const
+{
+  Landmark landmark;
+  landmark.X = positions_.col(index);
+  for (size_t i = ObservationBegin(index); i < ObservationEnd(index); ++i)
+  {
+    landmark.obs.emplace_hint(landmark.obs.end(),
+      observation_view_ids_[i],
+      Observation(observation_coordinates_.col(i), observation_feature_ids_[i]));
+  }
+  return landmark;
+}
+
+void Columnar_Landmarks::UpdatePositions(Landmarks & landmarks) const
+{
+  for (auto & landmark_it : landmarks)
+  {
+    const size_t index = FindLandmark(landmark_it.first);
+    if (index != LandmarkCount())
+      landmark_it.second.X = positions_.col(index);
+  }
+}
+
+size_t Columnar_Landmarks::FindLandmark(const IndexT landmark_id) const
+{
+  const auto it = std::lower_bound(landmark_ids_.cbegin(), landmark_ids_.cend(), landmark_id);
+  if (it == landmark_ids_.cend() || *it != landmark_id)
+    return LandmarkCount();
+  return it - landmark_ids_.cbegin();
+}
+
+Columnar_Landmarks::Index_Range Columnar_Landmarks::ViewObservations
+(
+  const IndexT view_id
+) const
+{
+  const auto it = std::lower_bound(view_ids_.cbegin(), view_ids_.cend(), view_id);
+  if (it == view_ids_.cend() || *it != view_id)
+    return {nullptr, nullptr};
+  const size_t view_index = it - view_ids_.cbegin();
+  return {view_observations_.data() + view_offsets_[view_index],
+          view_observations_.data() + view_offsets_[view_index + 1]};
+}
+
+size_t Columnar_Landmarks::MemoryFootprint() const
+{
+  return
+    landmark_ids_.capacity() * sizeof(IndexT)
+    + positions_.size() * sizeof(double)
+    + observation_offsets_.capacity() * sizeof(size_t)
+    + observation_view_ids_.capacity() * sizeof(IndexT)
+    + observation_feature_ids_.capacity() * sizeof(IndexT)
+    + observation_coordinates_.size() * sizeof(double)
+    + observation_landmark_indices_.capacity() * sizeof(IndexT)
+    + view_ids_.capacity() * sizeof(IndexT)
+    + view_offsets_.capacity() * sizeof(size_t)
+    + view_observations_.capacity() * sizeof(size_t);
+}
+
+} // namespace sfm
+} // namespace openMVG
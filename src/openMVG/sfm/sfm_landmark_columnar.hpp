@@ -0,0 +1,136 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OPENMVG_SFM_SFM_LANDMARK_COLUMNAR_HPP
+#define OPENMVG_SFM_SFM_LANDMARK_COLUMNAR_HPP
+
+#include "openMVG/numeric/eigen_alias_definition.hpp"
+#include "openMVG/sfm/sfm_landmark.hpp"
+
+#include <vector>
+
+namespace openMVG {
+namespace sfm {
+
+/// Columnar (structure of arrays) copy of a landmark collection.
+///
+/// The Landmarks container (a map of landmarks, each one owning a map of
+/// observations) uses a heap node per landmark and per observation. This
+/// copy uses a few contiguous arrays instead:
+/// - the landmark columns (id, position) are indexed by the landmark
+///   index (landmarks are sorted by ascending id),
+/// - the observation columns (view id, feature id, coordinates, landmark
+///   index) are stored in CSR order: the observations of the landmark i are
+///   the range [ObservationBegin(i), ObservationEnd(i)) (sorted by view id),
+/// - a view index lists the observations of each view.
+///
+/// It is not a storage of SfM_Data: SfM_Data::structure stays the reference
+/// container. The copy is built (Assign) for the passes that read the whole
+/// structure or query it per view many times (ColorizeTracks uses its view
+/// index), its cost is one pass over the Landmarks container. The structure (landmark and observation sets) is
+/// immutable once built, the positions can be updated in place and copied
+/// back with UpdatePositions.
+class Columnar_Landmarks
+{
+public:
+  /// Range of observation indices
+  struct Index_Range
+  {
+    const size_t * begin() const { return begin_; }
+    const size_t * end() const { return end_; }
+    size_t size() const { return end_ - begin_; }
+
+    const size_t * begin_;
+    const size_t * end_;
+  };
+
+  Columnar_Landmarks() = default;
+  explicit Columnar_Landmarks(const Landmarks & landmarks);
+
+  //--
+  // Conversion from and to the Landmarks container
+  //--
+
+  /// Replace the content by the given landmarks
+  void Assign(const Landmarks & landmarks);
+
+  /// Return the landmarks as a Landmarks container
+  Landmarks ToLandmarks() const;
+
+  /// Return the landmark of the given index
+  Landmark GetLandmark(const size_t index) const;
+
+  /// Copy the positions to the existing landmarks of a Landmarks container
+  void UpdatePositions(Landmarks & landmarks) const;
+
+  //--
+  // Landmark columns
+  //--
+
+  size_t LandmarkCount() const { return landmark_ids_.size(); }
+
+  /// Index of the landmark of the given id (LandmarkCount() if not found)
+  size_t FindLandmark(const IndexT landmark_id) const;
+
+  const std::vector<IndexT> & LandmarkIds() const { return landmark_ids_; }
+  const Mat3X & Positions() const { return positions_; }
+  Mat3X & Positions() { return positions_; }
+
+  //--
+  // Observation columns
+  //--
+
+  size_t ObservationCount() const { return observation_view_ids_.size(); }
+
+  /// First observation index of the landmark of the given index
+  size_t ObservationBegin(const size_t index) const { return observation_offsets_[index]; }
+  /// Past the end observation index of the landmark of the given index
+  size_t ObservationEnd(const size_t index) const { return observation_offsets_[index + 1]; }
+
+  const std::vector<IndexT> & ObservationViewIds() const { return observation_view_ids_; }
+  const std::vector<IndexT> & ObservationFeatureIds() const { return observation_feature_ids_; }
+  const Mat2X & ObservationCoordinates() const { return observation_coordinates_; }
+  Mat2X & ObservationCoordinates() { return observation_coordinates_; }
+  /// Index of the landmark of each observation
+  const std::vector<IndexT> & ObservationLandmarkIndices() const { return observation_landmark_indices_; }
+
+  //--
+  // View index
+  //--
+
+  /// Ids of the views that have at least one observation (ascending order)
+  const std::vector<IndexT> & ViewIds() const { return view_ids_; }
+
+  /// Observation indices of the given view (empty if the view is unknown)
+  Index_Range ViewObservations(const IndexT view_id) const;
+
+  /// Number of bytes used by the arrays
+  size_t MemoryFootprint() const;
+
+private:
+  // Landmark columns
+  std::vector<IndexT> landmark_ids_;
+  Mat3X positions_;
+
+  // Observation columns (CSR)
+  std::vector<size_t> observation_offsets_;
+  std::vector<IndexT> observation_view_ids_;
+  std::vector<IndexT> observation_feature_ids_;
+  Mat2X observation_coordinates_;
+  std::vector<IndexT> observation_landmark_indices_;
+
+  // View index (CSR)
+  std::vector<IndexT> view_ids_;
+  std::vector<size_t> view_offsets_;
+  std::vector<size_t> view_observations_;
+};
+
+} // namespace sfm
+} // namespace openMVG
+
+#endif // OPENMVG_SFM_SFM_LANDMARK_COLUMNAR_HPP
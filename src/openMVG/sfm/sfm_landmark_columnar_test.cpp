@@ -0,0 +1,130 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/sfm/sfm_landmark_columnar.hpp"
+
+#include "testing/testing.h"
+
+using namespace openMVG;
+using namespace openMVG::sfm;
+
+// Landmark i (id: 10 * i) is seen by the views [i, i + i % 3]
+Landmarks MakeLandmarks(const int nb_landmarks)
+{
+  Landmarks landmarks;
+  for (int i = nb_landmarks - 1; i >= 0; --i)
+  {
+    Landmark & landmark = landmarks[10 * i];
+    landmark.X = Vec3(i, 2 * i, 3 * i);
+    for (int view_id = i + i % 3; view_id >= i; --view_id)
+      landmark.obs[view_id] = Observation(Vec2(view_id, i), 100 * i + view_id);
+  }
+  return landmarks;
+}
+
+TEST(Columnar_Landmarks, Empty) {
+
+  const Columnar_Landmarks columnar_landmarks(Landmarks{});
+  EXPECT_EQ(0, columnar_landmarks.LandmarkCount());
+  EXPECT_EQ(0, columnar_landmarks.ObservationCount());
+  EXPECT_EQ(0, columnar_landmarks.ViewObservations(0).size());
+  EXPECT_TRUE(columnar_landmarks.ToLandmarks().empty());
+}
+
+TEST(Columnar_Landmarks, RoundTrip) {
+
+  const Landmarks landmarks = MakeLandmarks(20);
+  const Columnar_Landmarks columnar_landmarks(landmarks);
+  EXPECT_EQ(20, columnar_landmarks.LandmarkCount());
+
+  size_t observation_count = 0;
+  for (const auto & landmark_it : landmarks)
+    observation_count += landmark_it.second.obs.size();
+  EXPECT_EQ(observation_count, columnar_landmarks.ObservationCount());
+
+  const Landmarks converted_landmarks = columnar_landmarks.ToLandmarks();
+  EXPECT_EQ(landmarks.size(), converted_landmarks.size());
+  for (const auto & landmark_it : landmarks)
+  {
+    const Landmark & landmark = converted_landmarks.at(landmark_it.first);
+    EXPECT_MATRIX_NEAR(landmark_it.second.X, landmark.X, 1e-8);
+    EXPECT_EQ(landmark_it.second.obs.size(), landmark.obs.size());
+    for (const auto & obs_it : landmark_it.second.obs)
+    {
+      const Observation & obs = landmark.obs.at(obs_it.first);
+      EXPECT_EQ(obs_it.second.id_feat, obs.id_feat);
+      EXPECT_MATRIX_NEAR(obs_it.second.x, obs.x, 1e-8);
+    }
+  }
+}
+
+TEST(Columnar_Landmarks, Layout) {
+
+  const Columnar_Landmarks columnar_landmarks(MakeLandmarks(20));
+
+  // Landmarks are sorted by id and observations by view id
+  for (size_t i = 0; i < columnar_landmarks.LandmarkCount(); ++i)
+  {
+    EXPECT_EQ(10 * i, columnar_landmarks.LandmarkIds()[i]);
+    EXPECT_EQ(i, columnar_landmarks.FindLandmark(10 * i));
+    EXPECT_EQ(1 + i % 3,
+      columnar_landmarks.ObservationEnd(i) - columnar_landmarks.ObservationBegin(i));
+    for (size_t j = columnar_landmarks.ObservationBegin(i);
+         j < columnar_landmarks.ObservationEnd(i); ++j)
+    {
+      EXPECT_EQ(i + j - columnar_landmarks.ObservationBegin(i),
+        columnar_landmarks.ObservationViewIds()[j]);
+      EXPECT_EQ(i, columnar_landmarks.ObservationLandmarkIndices()[j]);
+    }
+  }
+  EXPECT_EQ(columnar_landmarks.LandmarkCount(), columnar_landmarks.FindLandmark(5));
+}
+
+TEST(Columnar_Landmarks, ViewIndex) {
+
+  const Landmarks landmarks = MakeLandmarks(20);
+  const Columnar_Landmarks columnar_landmarks(landmarks);
+
+  // Views [0, 20]
+  EXPECT_EQ(21, columnar_landmarks.ViewIds().size());
+  for (const IndexT view_id : columnar_landmarks.ViewIds())
+  {
+    size_t expected_count = 0;
+    for (const auto & landmark_it : landmarks)
+      expected_count += landmark_it.second.obs.count(view_id);
+
+    const Columnar_Landmarks::Index_Range observations =
+      columnar_landmarks.ViewObservations(view_id);
+    EXPECT_EQ(expected_count, observations.size());
+    for (const size_t observation_index : observations)
+    {
+      EXPECT_EQ(view_id, columnar_landmarks.ObservationViewIds()[observation_index]);
+      const IndexT landmark_id = columnar_landmarks.LandmarkIds()
+        [columnar_landmarks.ObservationLandmarkIndices()[observation_index]];
+      EXPECT_EQ(1, landmarks.at(landmark_id).obs.count(view_id));
+    }
+  }
+  EXPECT_EQ(0, columnar_landmarks.ViewObservations(100).size());
+}
+
+TEST(Columnar_Landmarks, UpdatePositions) {
+
+  Landmarks landmarks = MakeLandmarks(20);
+  Columnar_Landmarks columnar_landmarks(landmarks);
+  columnar_landmarks.Positions().colwise() += Vec3(1, 1, 1);
+  columnar_landmarks.UpdatePositions(landmarks);
+  for (const auto & landmark_it : landmarks)
+  {
+    const double i = landmark_it.first / 10;
+    EXPECT_MATRIX_NEAR(Vec3(i + 1, 2 * i + 1, 3 * i + 1), landmark_it.second.X, 1e-8);
+  }
+}
+
+/* ************************************************************************* */
+int main() { TestResult tr; return TestRegistry::runAllTests(tr);}
+/* ************************************************************************* */
@@ -69,18 +69,40 @@ struct TracksBuilder
   /// Build tracks for a given series of pairWise matches
   void Build( const matching::PairWiseMatches &  map_pair_wise_matches)
   {
+    Build(matching::getPairs(map_pair_wise_matches),
+      [&](const Pair & pair, matching::IndMatches &) -> const matching::IndMatches *
+      {
+        return &map_pair_wise_matches.at(pair);
+      });
+  }
+
+  /// Build tracks for the matches of the given pairs, read pair by pair with
+  /// get_matches(pair, buffer) -> const IndMatches * (nullptr: no matches).
+  /// The matches are read twice and do not have to stay in memory: they can be
+  /// decoded in the buffer on demand (e.g. by a Matches_Provider).
+  template <typename GetMatchesFunctor>
+  void Build
+  (
+    const Pair_Set & pairs,
+    const GetMatchesFunctor & get_matches
+  )
+  {
+    matching::IndMatches buffer;
+
     // 1. We need to know how much single set we will have.
     //   i.e each set is made of a tuple : (imageIndex, featureIndex)
     std::set<indexedFeaturePair> allFeatures;
     // For each couple of images list the used features
-    for ( const auto & iter : map_pair_wise_matches )
+    for ( const Pair & pair : pairs )
     {
-      const auto & I = iter.first.first;
-      const auto & J = iter.first.second;
-      const std::vector<matching::IndMatch> & vec_FilteredMatches = iter.second;
+      const auto & I = pair.first;
+      const auto & J = pair.second;
+      const matching::IndMatches * vec_FilteredMatches = get_matches(pair, buffer);
+      if (!vec_FilteredMatches)
+        continue;
 
       // Retrieve all shared features and add them to a set
-      for ( const auto & cur_filtered_match : vec_FilteredMatches )
+      for ( const auto & cur_filtered_match : *vec_FilteredMatches )
       {
         allFeatures.emplace(I,cur_filtered_match.i_);
         allFeatures.emplace(J,cur_filtered_match.j_);
@@ -105,12 +127,14 @@ struct TracksBuilder
     uf_tree.InitSets(map_node_to_index.size());
 
     // 4. Union of the matched features corresponding UF tree sets
-    for ( const auto & iter : map_pair_wise_matches )
+    for ( const Pair & pair : pairs )
     {
-      const auto & I = iter.first.first;
-      const auto & J = iter.first.second;
-      const std::vector<matching::IndMatch> & vec_FilteredMatches = iter.second;
-      for (const matching::IndMatch & match : vec_FilteredMatches)
+      const auto & I = pair.first;
+      const auto & J = pair.second;
+      const matching::IndMatches * vec_FilteredMatches = get_matches(pair, buffer);
+      if (!vec_FilteredMatches)
+        continue;
+      for (const matching::IndMatch & match : *vec_FilteredMatches)
       {
         const indexedFeaturePair pairI(I, match.i_);
         const indexedFeaturePair pairJ(J, match.j_);
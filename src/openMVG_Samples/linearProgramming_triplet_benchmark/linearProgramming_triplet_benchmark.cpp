@@ -0,0 +1,165 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/linearProgramming/bisectionLP.hpp"
+#include "openMVG/linearProgramming/linearProgrammingOSI_X.hpp"
+#include "openMVG/linearProgramming/lInfinityCV/tijsAndXis_From_xi_Ri.hpp"
+#include "openMVG/linearProgramming/lInfinityCV/triplet_tijsAndXis_kernel.hpp"
+#include "openMVG/multiview/test_data_sets.hpp"
+#include "openMVG/system/timer.hpp"
+
+#include "third_party/cmdLine/cmdLine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace openMVG;
+using namespace openMVG::linearProgramming;
+using namespace openMVG::lInfinityCV;
+
+// A view triplet of the translation and structure kernel test data
+// (3 cameras on a ring with unit intrinsics)
+struct Triplet
+{
+  std::vector<Mat3> rotations;
+  Mat megaMat; // (X,Y,index3dPoint, indexCam)^T
+  Mat pt0, pt1, pt2;
+};
+
+std::vector<Triplet> MakeTriplets
+(
+  const int nb_triplets,
+  const int nb_points
+)
+{
+  std::vector<Triplet> triplets(nb_triplets);
+  for (Triplet & triplet : triplets)
+  {
+    const NViewDataSet d = NRealisticCamerasRing(3, nb_points,
+      nViewDatasetConfigurator(1, 1, 0, 0, 5, 0.5));
+    triplet.rotations = d._R;
+    triplet.megaMat.resize(4, 3 * nb_points);
+    int cpt = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+      for (int j = 0; j < nb_points; ++j)
+      {
+        triplet.megaMat.col(cpt++) << d._x[i].col(j), j, i;
+      }
+    }
+    triplet.pt0 = d._x[0];
+    triplet.pt1 = d._x[1];
+    triplet.pt2 = d._x[2];
+  }
+  return triplets;
+}
+
+// Solve the bisection of every triplet, return the found gamma values
+std::vector<double> SolveBisections
+(
+  const std::vector<Triplet> & triplets,
+  const int nb_iterations,
+  const bool bWarmStart
+)
+{
+  std::vector<double> gammas(triplets.size(), -1.0);
+  for (size_t i = 0; i < triplets.size(); ++i)
+  {
+    std::vector<double> vec_solution(3 * (3 + triplets[i].megaMat.cols() / 3));
+    OSI_CLP_SolverWrapper solver(static_cast<int>(vec_solution.size()));
+    Translation_Structure_L1_ConstraintBuilder cstBuilder(
+      triplets[i].rotations, triplets[i].megaMat);
+    BisectionLP<Translation_Structure_L1_ConstraintBuilder, LP_Constraints_Sparse>(
+      solver, cstBuilder, &vec_solution,
+      1.0, 0.0, 1e-8, nb_iterations, &gammas[i], false, bWarmStart);
+  }
+  return gammas;
+}
+
+int main(int argc, char **argv)
+{
+  CmdLine cmd;
+
+  int nb_triplets = 1000;
+  int nb_points = translations_Triplet_Solver::MINIMUM_SAMPLES;
+  int nb_iterations = 20;
+
+  cmd.add( make_option('n', nb_triplets, "triplet_count") );
+  cmd.add( make_option('p', nb_points, "point_count") );
+  cmd.add( make_option('i', nb_iterations, "iteration_count") );
+
+  try {
+    cmd.process(argc, argv);
+    if (nb_triplets < 1 || nb_points < translations_Triplet_Solver::MINIMUM_SAMPLES)
+      throw std::string("Invalid triplet or point count");
+  } catch (const std::string& s) {
+    std::cerr << "Usage: " << argv[0] << '\n'
+      << "[-n|--triplet_count] number of view triplets (default: " << nb_triplets << ")\n"
+      << "[-p|--point_count] points per triplet (default: " << nb_points << ")\n"
+      << "[-i|--iteration_count] bisection iterations (default: " << nb_iterations << ")\n"
+      << std::endl;
+
+    std::cerr << s << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const std::vector<Triplet> triplets = MakeTriplets(nb_triplets, nb_points);
+
+  //-- Bisection: every gamma value is solved from scratch or from the previous basis
+  openMVG::system::Timer timer;
+  const std::vector<double> gammas_cold = SolveBisections(triplets, nb_iterations, false);
+  const double cold_time = timer.elapsedMs() / 1000.0;
+
+  timer.reset();
+  const std::vector<double> gammas_warm = SolveBisections(triplets, nb_iterations, true);
+  const double warm_time = timer.elapsedMs() / 1000.0;
+
+  // The feasibility of a gamma value does not depend on the start basis
+  double max_gamma_difference = 0.0;
+  for (size_t i = 0; i < triplets.size(); ++i)
+    max_gamma_difference = std::max(max_gamma_difference,
+      std::abs(gammas_cold[i] - gammas_warm[i]));
+
+  //-- Triplet kernel (as used by the robust estimation of the global SfM):
+  // the triplets are solved concurrently, each thread reuses its pooled solvers
+  timer.reset();
+  int nb_models = 0;
+#ifdef OPENMVG_USE_OPENMP
+  #pragma omp parallel for schedule(dynamic) reduction(+:nb_models)
+#endif
+  for (int i = 0; i < static_cast<int>(triplets.size()); ++i)
+  {
+    std::vector<trifocal::kernel::TrifocalTensorModel> models;
+    translations_Triplet_Solver::Solve(
+      triplets[i].pt0, triplets[i].pt1, triplets[i].pt2,
+      triplets[i].rotations, &models, 1.0);
+    nb_models += models.size();
+  }
+  const double kernel_time = timer.elapsedMs() / 1000.0;
+
+  const double nb_lp = static_cast<double>(nb_triplets) * nb_iterations;
+  std::cout
+    << "Triplets: " << nb_triplets << ", points per triplet: " << nb_points
+    << ", bisection iterations: " << nb_iterations << "\n\n"
+    << std::setw(30) << std::left << "" << std::setw(14) << "time (s)" << "LP/s\n"
+    << std::setw(30) << "bisection (cold start)"
+    << std::setw(14) << cold_time << nb_lp / cold_time << "\n"
+    << std::setw(30) << "bisection (warm start)"
+    << std::setw(14) << warm_time << nb_lp / warm_time << "\n"
+    << std::setw(30) << "triplet kernel (batched)"
+    << std::setw(14) << kernel_time << "\n\n"
+    << "Max gamma difference (cold/warm): " << max_gamma_difference << "\n"
+    << "Triplet kernel models: " << nb_models << "/" << nb_triplets << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,162 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/multiview/rotation_averaging_l2.hpp"
+#include "openMVG/numeric/numeric.h"
+#include "openMVG/system/timer.hpp"
+
+#include "third_party/cmdLine/cmdLine.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace openMVG;
+using namespace openMVG::rotation_averaging;
+
+// Synthetic aerial survey like scene: random global rotations, the cameras
+// are laid on a square grid and every camera is linked to the cameras of its
+// (2 * radius + 1)^2 neighborhood.
+// The relative rotations are perturbed by a small random rotation.
+void MakeSyntheticScene
+(
+  const int nb_poses,
+  const int radius,
+  const double noise_degree,
+  std::vector<Mat3> & global_rotations,
+  RelativeRotations & relative_rotations
+)
+{
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::normal_distribution<double> normal_distribution;
+
+  const auto random_rotation = [&](const double angle_degree) -> Mat3
+  {
+    const Vec3 axis = Vec3(normal_distribution(random_generator),
+                           normal_distribution(random_generator),
+                           normal_distribution(random_generator)).normalized();
+    return Eigen::AngleAxisd(D2R(angle_degree), axis).toRotationMatrix();
+  };
+
+  global_rotations.resize(nb_poses);
+  for (Mat3 & rotation : global_rotations)
+    rotation = random_rotation(std::uniform_real_distribution<double>(0, 180)(random_generator));
+
+  const auto add_relative_rotation = [&](const IndexT i, const IndexT j)
+  {
+    const Mat3 Rij = global_rotations[j] * global_rotations[i].transpose();
+    relative_rotations.emplace_back(i, j,
+      random_rotation(noise_degree * normal_distribution(random_generator)) * Rij, 1.0f);
+  };
+
+  const int width = std::ceil(std::sqrt(nb_poses));
+  relative_rotations.clear();
+  for (int i = 0; i < nb_poses; ++i)
+  {
+    const int x = i % width, y = i / width;
+    for (int dy = 0; dy <= radius; ++dy)
+    {
+      for (int dx = -radius; dx <= radius; ++dx)
+      {
+        const int j = (y + dy) * width + (x + dx);
+        if ((dy > 0 || dx > 0) && x + dx >= 0 && x + dx < width && j < nb_poses)
+          add_relative_rotation(i, j);
+      }
+    }
+  }
+}
+
+// Mean angular error (degree) of the estimated rotations
+// (both sets are expressed in the frame of the first rotation)
+double MeanAngularError
+(
+  const std::vector<Mat3> & gt_rotations,
+  const std::vector<Mat3> & estimated_rotations
+)
+{
+  double error = 0.0;
+  for (size_t i = 0; i < gt_rotations.size(); ++i)
+  {
+    const Mat3 gt = gt_rotations[i] * gt_rotations[0].transpose();
+    const Mat3 estimated = estimated_rotations[i] * estimated_rotations[0].transpose();
+    error += R2D(getRotationMagnitude(gt.transpose() * estimated));
+  }
+  return error / gt_rotations.size();
+}
+
+int main(int argc, char **argv)
+{
+  CmdLine cmd;
+
+  int max_pose_count = 50000;
+  int max_dense_pose_count = 4000;
+  int radius = 2;
+  double noise_degree = 1.0;
+
+  cmd.add( make_option('n', max_pose_count, "max_pose_count") );
+  cmd.add( make_option('d', max_dense_pose_count, "max_dense_pose_count") );
+  cmd.add( make_option('r', radius, "radius") );
+  cmd.add( make_option('s', noise_degree, "noise") );
+
+  try {
+    cmd.process(argc, argv);
+  } catch (const std::string& s) {
+    std::cerr << "Usage: " << argv[0] << '\n'
+      << "[-n|--max_pose_count] largest benchmarked scene (default: " << max_pose_count << ")\n"
+      << "[-d|--max_dense_pose_count] largest scene solved with the dense solver (default: "
+      << max_dense_pose_count << ")\n"
+      << "[-r|--radius] pose grid neighborhood radius (default: " << radius << ")\n"
+      << "[-s|--noise] relative rotation noise in degree (default: " << noise_degree << ")\n"
+      << std::endl;
+
+    std::cerr << s << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout
+    << "L2 rotation averaging: dense vs. sparse eigen solver\n"
+    << std::setw(10) << "#poses" << std::setw(12) << "#relative"
+    << std::setw(14) << "dense (s)" << std::setw(14) << "error (deg)"
+    << std::setw(14) << "sparse (s)" << std::setw(14) << "error (deg)" << std::endl;
+
+  for (const int nb_poses : {100, 500, 1000, 2000, 4000, 8000, 16000, 32000, 50000})
+  {
+    if (nb_poses > max_pose_count)
+      break;
+
+    std::vector<Mat3> gt_rotations;
+    RelativeRotations relative_rotations;
+    MakeSyntheticScene(nb_poses, radius, noise_degree, gt_rotations, relative_rotations);
+
+    std::cout << std::setw(10) << nb_poses << std::setw(12) << relative_rotations.size();
+    for (const l2::EigenSolverType solver_type :
+         {l2::EigenSolverType::DENSE, l2::EigenSolverType::SPARSE})
+    {
+      if (solver_type == l2::EigenSolverType::DENSE && nb_poses > max_dense_pose_count)
+      {
+        std::cout << std::setw(14) << "-" << std::setw(14) << "-";
+        continue;
+      }
+      std::vector<Mat3> global_rotations;
+      openMVG::system::Timer timer;
+      const bool b_success =
+        l2::L2RotationAveraging(nb_poses, relative_rotations, global_rotations, solver_type);
+      const double time = timer.elapsedMs() / 1000.0;
+      if (b_success)
+        std::cout << std::setw(14) << time
+          << std::setw(14) << MeanAngularError(gt_rotations, global_rotations);
+      else
+        std::cout << std::setw(14) << "failure" << std::setw(14) << "-";
+    }
+    std::cout << std::endl;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,226 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/sfm/sfm_landmark_columnar.hpp"
+#include "openMVG/system/timer.hpp"
+
+#include "third_party/cmdLine/cmdLine.h"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+using namespace openMVG;
+using namespace openMVG::sfm;
+
+// Heap memory in use (the containers use operator new and Eigen aligned
+// allocations: the malloc statistics measure both), 0 if not available.
+size_t HeapBytesInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  const struct mallinfo2 info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+#elif defined(__GLIBC__)
+  const struct mallinfo info = mallinfo();
+  return static_cast<unsigned int>(info.uordblks) + static_cast<unsigned int>(info.hblkhd);
+#else
+  return 0;
+#endif
+}
+
+// Synthetic structure: every landmark is seen by nb_observations consecutive
+// views (of a random first view).
+Landmarks MakeSyntheticLandmarks
+(
+  const int nb_landmarks,
+  const int nb_observations,
+  const int nb_views
+)
+{
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::uniform_int_distribution<int> view_distribution(0, nb_views - nb_observations);
+  std::uniform_real_distribution<double> distribution(0.0, 1000.0);
+
+  Landmarks landmarks;
+  for (int i = 0; i < nb_landmarks; ++i)
+  {
+    Landmark & landmark = landmarks[i];
+    landmark.X = Vec3(distribution(random_generator),
+                      distribution(random_generator),
+                      distribution(random_generator));
+    const int first_view = view_distribution(random_generator);
+    for (int j = 0; j < nb_observations; ++j)
+    {
+      landmark.obs[first_view + j] =
+        Observation(Vec2(distribution(random_generator), distribution(random_generator)), i);
+    }
+  }
+  return landmarks;
+}
+
+int main(int argc, char **argv)
+{
+  CmdLine cmd;
+
+  int nb_landmarks = 1000000;
+  int nb_observations = 8;
+  int nb_views = 1000;
+  int nb_view_queries = 20;
+
+  cmd.add( make_option('n', nb_landmarks, "landmark_count") );
+  cmd.add( make_option('o', nb_observations, "observation_count") );
+  cmd.add( make_option('v', nb_views, "view_count") );
+  cmd.add( make_option('q', nb_view_queries, "view_query_count") );
+
+  try {
+    cmd.process(argc, argv);
+    if (nb_observations < 1 || nb_views < nb_observations)
+      throw std::string("Invalid observation or view count");
+  } catch (const std::string& s) {
+    std::cerr << "Usage: " << argv[0] << '\n'
+      << "[-n|--landmark_count] number of landmarks (default: " << nb_landmarks << ")\n"
+      << "[-o|--observation_count] observations per landmark (default: " << nb_observations << ")\n"
+      << "[-v|--view_count] number of views (default: " << nb_views << ")\n"
+      << "[-q|--view_query_count] number of per view queries (default: " << nb_view_queries << ")\n"
+      << std::endl;
+
+    std::cerr << s << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  openMVG::system::Timer timer;
+  size_t heap_bytes = HeapBytesInUse();
+  const Landmarks landmarks = MakeSyntheticLandmarks(nb_landmarks, nb_observations, nb_views);
+  const double landmarks_build_time = timer.elapsedMs() / 1000.0;
+  const size_t landmarks_bytes = HeapBytesInUse() - heap_bytes;
+
+  // The conversion builds the columns and the view index
+  timer.reset();
+  heap_bytes = HeapBytesInUse();
+  const Columnar_Landmarks columnar_landmarks(landmarks);
+  const double columnar_build_time = timer.elapsedMs() / 1000.0;
+  const size_t columnar_bytes = HeapBytesInUse() - heap_bytes;
+
+  //-- Observation pass (the memory access pattern of a residual evaluation)
+  timer.reset();
+  double landmarks_sum = 0.0;
+  for (const auto & landmark_it : landmarks)
+  {
+    const Vec3 & X = landmark_it.second.X;
+    for (const auto & obs_it : landmark_it.second.obs)
+      landmarks_sum += (obs_it.second.x - X.head<2>()).squaredNorm();
+  }
+  const double landmarks_pass_time = timer.elapsedMs() / 1000.0;
+
+  timer.reset();
+  double columnar_sum = 0.0;
+  {
+    const Mat3X & positions = columnar_landmarks.Positions();
+    const Mat2X & coordinates = columnar_landmarks.ObservationCoordinates();
+    for (size_t i = 0; i < columnar_landmarks.LandmarkCount(); ++i)
+    {
+      for (size_t j = columnar_landmarks.ObservationBegin(i);
+           j < columnar_landmarks.ObservationEnd(i); ++j)
+        columnar_sum += (coordinates.col(j) - positions.col(i).head<2>()).squaredNorm();
+    }
+  }
+  const double columnar_pass_time = timer.elapsedMs() / 1000.0;
+
+  //-- Per view queries (list the landmarks seen by a view)
+  std::mt19937 random_generator(std::mt19937::default_seed);
+  std::uniform_int_distribution<int> view_distribution(0, nb_views - 1);
+  std::vector<IndexT> query_view_ids(nb_view_queries);
+  for (IndexT & view_id : query_view_ids)
+    view_id = view_distribution(random_generator);
+
+  // Full scans of both layouts
+  timer.reset();
+  size_t landmarks_scan_count = 0;
+  for (const IndexT view_id : query_view_ids)
+  {
+    for (const auto & landmark_it : landmarks)
+      landmarks_scan_count += landmark_it.second.obs.count(view_id);
+  }
+  const double landmarks_scan_time = timer.elapsedMs() / 1000.0;
+
+  timer.reset();
+  size_t columnar_scan_count = 0;
+  for (const IndexT view_id : query_view_ids)
+  {
+    for (const IndexT observation_view_id : columnar_landmarks.ObservationViewIds())
+      columnar_scan_count += (observation_view_id == view_id);
+  }
+  const double columnar_scan_time = timer.elapsedMs() / 1000.0;
+
+  // Indexed queries, the index build is included:
+  // - Landmarks: a view id -> landmark ids map built by a pass on the structure,
+  // - Columnar: the conversion (that builds the view index).
+  timer.reset();
+  size_t landmarks_index_count = 0;
+  {
+    std::map<IndexT, std::vector<IndexT>> view_landmarks;
+    for (const auto & landmark_it : landmarks)
+      for (const auto & obs_it : landmark_it.second.obs)
+        view_landmarks[obs_it.first].push_back(landmark_it.first);
+    for (const IndexT view_id : query_view_ids)
+    {
+      const auto it = view_landmarks.find(view_id);
+      if (it != view_landmarks.end())
+        landmarks_index_count += it->second.size();
+    }
+  }
+  const double landmarks_index_time = timer.elapsedMs() / 1000.0;
+
+  timer.reset();
+  size_t columnar_index_count = 0;
+  for (const IndexT view_id : query_view_ids)
+    columnar_index_count += columnar_landmarks.ViewObservations(view_id).size();
+  const double columnar_index_time = columnar_build_time + timer.elapsedMs() / 1000.0;
+
+  const size_t nb_total_observations = columnar_landmarks.ObservationCount();
+  const double MB = 1024.0 * 1024.0;
+  std::cout
+    << "#landmarks: " << nb_landmarks << ", #observations: " << nb_total_observations << "\n"
+    << std::setw(36) << " " << std::setw(16) << "Landmarks" << std::setw(16) << "Columnar" << "\n"
+    << std::setw(36) << "memory (MB)"
+    << std::setw(16) << landmarks_bytes / MB
+    << std::setw(16) << columnar_bytes / MB << "\n"
+    << std::setw(36) << "array sizes (MB)"
+    << std::setw(16) << "-"
+    << std::setw(16) << columnar_landmarks.MemoryFootprint() / MB << "\n"
+    << std::setw(36) << "build (s)"
+    << std::setw(16) << landmarks_build_time
+    << std::setw(16) << columnar_build_time << "\n"
+    << std::setw(36) << "observation pass (Mobs/s)"
+    << std::setw(16) << nb_total_observations / landmarks_pass_time / 1e6
+    << std::setw(16) << nb_total_observations / columnar_pass_time / 1e6 << "\n"
+    << std::setw(36) << "observation pass + conversion (s)"
+    << std::setw(16) << landmarks_pass_time
+    << std::setw(16) << columnar_build_time + columnar_pass_time << "\n"
+    << std::setw(36) << "view queries, full scans (s)"
+    << std::setw(16) << landmarks_scan_time
+    << std::setw(16) << columnar_scan_time << "\n"
+    << std::setw(36) << "view queries, index + queries (s)"
+    << std::setw(16) << landmarks_index_time
+    << std::setw(16) << columnar_index_time << "\n"
+    << "(memory: measured heap growth, 0 if the malloc statistics are not available;\n"
+    << " columnar build: conversion from the Landmarks container, view index included)\n"
+    << "checksums: " << landmarks_sum << " " << columnar_sum << " "
+    << landmarks_scan_count << " " << columnar_scan_count << " "
+    << landmarks_index_count << " " << columnar_index_count << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -301,6 +301,8 @@ int main(int argc, char **argv)
   Intrinsics & intrinsics = sfm_data.intrinsics;
 
   int total_num_images = 0;
+  // The image & decoding buffers are reused from a query image to another one
+  image::Image_Pool<unsigned char> image_pool;
 
 #ifdef OPENMVG_USE_OPENMP
   const unsigned int nb_max_thread = (iNumThreads == 0) ? 0 : omp_get_max_threads();
@@ -322,11 +324,11 @@ int main(int argc, char **argv)
 
     std::cout << "SfM::localization => try with image: " << *iter_image << std::endl;
     std::unique_ptr<Regions> query_regions(regions_type->EmptyClone());
-    image::Image<unsigned char> imageGray;
+    image::Pooled_Image<unsigned char> imageGray(image_pool);
     {
       const std::string sView_filename = stlplus::create_filespec(sQueryDir, *iter_image);
       // Try to open image
-      if (!image::ReadImage(sView_filename.c_str(), &imageGray))
+      if (!image::ReadImage(sView_filename.c_str(), &imageGray, image_pool))
       {
         std::cerr << "Cannot open the input provided image : " << *iter_image << std::endl;
         continue;
@@ -0,0 +1,163 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/cameras/Camera_Common.hpp"
+#include "openMVG/cameras/Cameras_Common_command_line_helper.hpp"
+#include "openMVG/sfm/sfm.hpp"
+#include "openMVG/system/timer.hpp"
+#include "third_party/cmdLine/cmdLine.h"
+#include "third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace openMVG;
+using namespace openMVG::cameras;
+using namespace openMVG::sfm;
+
+// Refine a SfM_Data scene with a partitioned Bundle Adjustment.
+// The view partition is read from the cluster scenes exported by
+// openMVG_main_ComputeClusters (sfm_dataXXXX.bin).
+int main( int argc, char **argv )
+{
+  std::cout << "Partitioned Bundle Adjustment" << std::endl
+            << std::endl;
+
+  CmdLine cmd;
+
+  std::string sSfM_Data_Filename     = "";
+  std::string sClusters_Dir          = "";
+  std::string sOut_Filename          = "";
+  std::string sIntrinsic_refinement_options = "ADJUST_ALL";
+  unsigned int max_admm_iterations   = 50;
+  unsigned int local_max_iterations  = 20;
+  double rho                         = 1.0;
+
+  cmd.add( make_option( 'i', sSfM_Data_Filename, "input_file" ) );
+  cmd.add( make_option( 'c', sClusters_Dir, "clusters_dir" ) );
+  cmd.add( make_option( 'o', sOut_Filename, "output_file" ) );
+  cmd.add( make_option( 'f', sIntrinsic_refinement_options, "refineIntrinsics" ) );
+  cmd.add( make_option( 'n', max_admm_iterations, "max_iterations" ) );
+  cmd.add( make_option( 'l', local_max_iterations, "local_max_iterations" ) );
+  cmd.add( make_option( 'r', rho, "rho" ) );
+
+  try
+  {
+    if ( argc == 1 )
+      throw std::string( "Invalid command line parameter." );
+    cmd.process( argc, argv );
+  }
+  catch ( const std::string &s )
+  {
+    std::cerr << "Usage: " << argv[ 0 ] << "\n"
+              << "[-i|--input_file] path to the SfM_Data scene to refine\n"
+              << "[-c|--clusters_dir] path to the openMVG_main_ComputeClusters output directory\n"
+              << "[-o|--output_file] path to the refined SfM_Data scene\n"
+              << "\n[Optional]\n"
+              << "[-f|--refineIntrinsics] Intrinsic parameters refinement option (default: ADJUST_ALL)\n"
+              << "[-n|--max_iterations] max number of consensus iterations (default: "
+              << max_admm_iterations << ")\n"
+              << "[-l|--local_max_iterations] max number of solver iterations per cluster and"
+              << " consensus iteration (default: " << local_max_iterations << ")\n"
+              << "[-r|--rho] initial consensus penalty, relative to the variable stiffness (default: " << rho << ")\n"
+              << std::endl;
+
+    std::cerr << s << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const Intrinsic_Parameter_Type intrinsic_refinement_options =
+    StringTo_Intrinsic_Parameter_Type( sIntrinsic_refinement_options );
+  if ( intrinsic_refinement_options == static_cast<Intrinsic_Parameter_Type>( 0 ) )
+  {
+    std::cerr << "Invalid input for Bundle Adjusment Intrinsic parameter refinement option" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  SfM_Data sfm_data;
+  if ( !Load( sfm_data, sSfM_Data_Filename, ESfM_Data( ALL ) ) )
+  {
+    std::cerr << std::endl
+              << "The input SfM_Data file \"" << sSfM_Data_Filename << "\" can't be read."
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Read the view ids of every cluster scene
+  std::vector<std::set<IndexT>> view_clusters;
+  while ( true )
+  {
+    std::stringstream filename;
+    filename << sClusters_Dir << "/sfm_data";
+    filename << std::setw( 4 ) << std::setfill( '0' ) << view_clusters.size();
+    filename << ".bin";
+    if ( !stlplus::file_exists( filename.str() ) )
+      break;
+
+    SfM_Data cluster_sfm_data;
+    if ( !Load( cluster_sfm_data, filename.str(), ESfM_Data( VIEWS ) ) )
+    {
+      std::cerr << "Cannot read the cluster: " << filename.str() << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::set<IndexT> view_ids;
+    for ( const auto &view_it : cluster_sfm_data.GetViews() )
+      view_ids.insert( view_it.first );
+    view_clusters.emplace_back( view_ids );
+  }
+
+  if ( view_clusters.empty() )
+  {
+    std::cerr << "No cluster found in: " << sClusters_Dir << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << "Number of clusters = " << view_clusters.size() << std::endl;
+
+  Bundle_Adjustment_Ceres_Partitioned::BA_Partition_options partition_options;
+  partition_options.max_admm_iterations_ = max_admm_iterations;
+  partition_options.local_max_iterations_ = local_max_iterations;
+  partition_options.rho_ = rho;
+
+  openMVG::system::Timer timer;
+  Bundle_Adjustment_Ceres_Partitioned bundle_adjustment_obj( view_clusters, partition_options );
+  if ( !bundle_adjustment_obj.Adjust( sfm_data,
+         Optimize_Options(
+           intrinsic_refinement_options,
+           Extrinsic_Parameter_Type::ADJUST_ALL,
+           Structure_Parameter_Type::ADJUST_ALL ) ) )
+  {
+    std::cerr << "The partitioned Bundle Adjustment failed." << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << "Partitioned Bundle Adjustment took (s): " << timer.elapsed() << std::endl;
+
+  // Report how far the clusters are from an exact consensus
+  const auto & statistics = bundle_adjustment_obj.statistics();
+  std::cout
+    << "Consensus statistics:\n"
+    << " #iterations: " << statistics.num_iterations
+    << (statistics.b_converged ? " (converged)" : " (not converged)") << "\n"
+    << " primal residual: " << statistics.primal_residual << "\n"
+    << " dual residual: " << statistics.dual_residual << "\n"
+    << " max rotation deviation (deg): " << R2D(statistics.max_rotation_deviation) << "\n"
+    << " max translation deviation: " << statistics.max_translation_deviation << "\n"
+    << " max intrinsic deviation: " << statistics.max_intrinsic_deviation << "\n"
+    << " max landmark deviation: " << statistics.max_landmark_deviation << std::endl;
+
+  if ( !Save( sfm_data, sOut_Filename, ESfM_Data( ALL ) ) )
+  {
+    std::cerr << "An error occured while trying to save \"" << sOut_Filename << "\"." << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
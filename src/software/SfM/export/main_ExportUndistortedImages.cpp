@@ -87,6 +87,9 @@ int main(int argc, char *argv[]) {
     // Export views as undistorted images (those with valid Intrinsics)
     Image<RGBColor> image, image_ud;
     Image<uint8_t> image_gray, image_gray_ud;
+    // The image & decoding buffers are reused from an image to another one
+    Image_Pool<RGBColor> image_pool;
+    Image_Pool<uint8_t> image_gray_pool;
     C_Progress_display my_progress_bar( sfm_data.GetViews().size(), std::cout, "\n- EXTRACT UNDISTORTED IMAGES -\n" );
 
     #ifdef OPENMVG_USE_OPENMP
@@ -125,7 +128,7 @@ int main(int argc, char *argv[]) {
       if (cam->have_disto())
       {
         // undistort the image and save it
-        if (ReadImage( srcImage.c_str(), &image))
+        if (ReadImage( srcImage.c_str(), &image, image_pool))
         {
           UndistortImage(image, cam, image_ud, BLACK);
           const bool bRes = WriteImage(dstImage.c_str(), image_ud);
@@ -135,7 +138,7 @@ int main(int argc, char *argv[]) {
           bOk &= bRes;
         }
         else // If RGBColor reading fails, we try to read a gray image
-        if (ReadImage( srcImage.c_str(), &image_gray))
+        if (ReadImage( srcImage.c_str(), &image_gray, image_gray_pool))
         {
           UndistortImage(image_gray, cam, image_gray_ud, BLACK);
           const bool bRes = WriteImage(dstImage.c_str(), image_gray_ud);
@@ -152,7 +155,9 @@ int main(int argc, char *argv[]) {
       }
       ++my_progress_bar;
     }
-    std::cout << "Task done in (s): " << timer.elapsed() << std::endl;
+    std::cout << "Task done in (s): " << timer.elapsed() << "\n"
+      << "Color images:\n" << image_pool.Statistics() << "\n"
+      << "Gray images:\n" << image_gray_pool.Statistics() << std::endl;
   }
 
   // Exit program
@@ -123,6 +123,9 @@ bool exportToOpenMVS(
   C_Progress_display my_progress_bar_images(sfm_data.views.size(),
       std::cout, "\n- UNDISTORT IMAGES -\n" );
   std::atomic<bool> bOk(true); // Use a boolean to track the status of the loop process
+  // The image & decoding buffers are reused from an image to another one
+  Image_Pool<openMVG::image::RGBColor> image_pool;
+  Image_Pool<uint8_t> image_gray_pool;
 #ifdef OPENMVG_USE_OPENMP
   const unsigned int nb_max_thread = (iNumThreads > 0)? iNumThreads : omp_get_max_threads();
 
@@ -156,18 +159,20 @@ bool exportToOpenMVS(
       if (cam->have_disto())
       {
         // undistort image and save it
-        Image<openMVG::image::RGBColor> imageRGB, imageRGB_ud;
-        Image<uint8_t> image_gray, image_gray_ud;
+        Pooled_Image<openMVG::image::RGBColor> imageRGB(image_pool);
+        Pooled_Image<uint8_t> image_gray(image_gray_pool);
         try
         {
-          if (ReadImage(srcImage.c_str(), &imageRGB))
+          if (ReadImage(srcImage.c_str(), &imageRGB, image_pool))
           {
+            Pooled_Image<openMVG::image::RGBColor> imageRGB_ud(image_pool, imageRGB.Width(), imageRGB.Height());
             UndistortImage(imageRGB, cam, imageRGB_ud, BLACK);
             bOk = WriteImage(imageName.c_str(), imageRGB_ud);
           }
           else // If RGBColor reading fails, try to read as gray image
-          if (ReadImage(srcImage.c_str(), &image_gray))
+          if (ReadImage(srcImage.c_str(), &image_gray, image_gray_pool))
           {
+            Pooled_Image<uint8_t> image_gray_ud(image_gray_pool, image_gray.Width(), image_gray.Height());
             UndistortImage(image_gray, cam, image_gray_ud, BLACK);
             const bool bRes = WriteImage(imageName.c_str(), image_gray_ud);
             bOk = bOk & bRes;
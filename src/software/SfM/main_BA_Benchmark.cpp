@@ -0,0 +1,185 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_data_BA_ceres.hpp"
+#include "openMVG/sfm/sfm_data_BA_ceres_io.hpp"
+#include "openMVG/sfm/sfm_data_io.hpp"
+
+#include "third_party/cmdLine/cmdLine.h"
+
+#include <ceres/types.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace openMVG;
+using namespace openMVG::sfm;
+
+// Replay a Bundle Adjustment problem saved by Bundle_Adjustment_Ceres::Adjust
+// (see BA_Ceres_options::problem_dump_prefix_) with some solver settings and
+// report the solver timings.
+int main(int argc, char **argv)
+{
+  CmdLine cmd;
+
+  std::string
+    sBA_Problem_Filename_In,
+    sSfM_Data_Filename_Out,
+    sLinear_solver,
+    sPreconditioner,
+    sSparse_library;
+  int i_large_scene_threshold = -1;
+  int i_inner_iterations = -1;
+  int i_explicit_ordering = -1;
+  int i_nb_threads = 0;
+  int i_repeat = 1;
+
+  cmd.add(make_option('i', sBA_Problem_Filename_In, "input_file"));
+  cmd.add(make_option('o', sSfM_Data_Filename_Out, "output_file"));
+  cmd.add(make_option('l', sLinear_solver, "linear_solver"));
+  cmd.add(make_option('p', sPreconditioner, "preconditioner"));
+  cmd.add(make_option('s', sSparse_library, "sparse_library"));
+  cmd.add(make_option('L', i_large_scene_threshold, "large_scene_threshold"));
+  cmd.add(make_option('I', i_inner_iterations, "inner_iterations"));
+  cmd.add(make_option('O', i_explicit_ordering, "explicit_ordering"));
+  cmd.add(make_option('n', i_nb_threads, "numThreads"));
+  cmd.add(make_option('r', i_repeat, "repeat"));
+
+  try {
+      if (argc == 1) throw std::string("Invalid command line parameter.");
+      cmd.process(argc, argv);
+  } catch (const std::string& s) {
+      std::cerr << "Usage: " << argv[0] << '\n'
+        << "[-i|--input_file] path to a saved Bundle Adjustment problem (.bin)\n"
+        << "\n[Optional]\n"
+        << "[-o|--output_file] path to the refined SfM_Data scene (last run)\n"
+        << "\n[Solver settings (by default the saved settings are used)]\n"
+        << "[-l|--linear_solver] DENSE_SCHUR, SPARSE_SCHUR, ITERATIVE_SCHUR, ...\n"
+        << "[-p|--preconditioner] JACOBI, SCHUR_JACOBI, CLUSTER_JACOBI, CLUSTER_TRIDIAGONAL, ...\n"
+        << "[-s|--sparse_library] SUITE_SPARSE, CX_SPARSE, EIGEN_SPARSE\n"
+        << "[-L|--large_scene_threshold] number of poses that enables the large scene mode\n"
+        << "\t 0: disable the large scene mode\n"
+        << "[-I|--inner_iterations] 0: disable, 1: enable\n"
+        << "[-O|--explicit_ordering] use an explicit Schur ordering 0: disable, 1: enable\n"
+        << "[-n|--numThreads] number of threads (0: use the saved setting)\n"
+        << "[-r|--repeat] number of runs (each run starts from the saved problem)\n"
+        << std::endl;
+
+      std::cerr << s << std::endl;
+      return EXIT_FAILURE;
+  }
+
+  SfM_Data sfm_data;
+  Optimize_Options optimize_options;
+  Bundle_Adjustment_Ceres::BA_Ceres_options ceres_options;
+  if (!Load_BA_Problem(sfm_data, optimize_options, ceres_options, sBA_Problem_Filename_In))
+  {
+    std::cerr << std::endl
+      << "The input Bundle Adjustment problem \"" << sBA_Problem_Filename_In
+      << "\" cannot be read." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Override the saved solver settings
+  if (!sLinear_solver.empty())
+  {
+    ceres::LinearSolverType type;
+    if (!ceres::StringToLinearSolverType(sLinear_solver, &type))
+    {
+      std::cerr << "Unknown linear solver: " << sLinear_solver << std::endl;
+      return EXIT_FAILURE;
+    }
+    ceres_options.linear_solver_type_ = type;
+  }
+  if (!sPreconditioner.empty())
+  {
+    ceres::PreconditionerType type;
+    if (!ceres::StringToPreconditionerType(sPreconditioner, &type))
+    {
+      std::cerr << "Unknown preconditioner: " << sPreconditioner << std::endl;
+      return EXIT_FAILURE;
+    }
+    ceres_options.preconditioner_type_ = type;
+    ceres_options.large_scene_preconditioner_type_ = type;
+  }
+  if (!sSparse_library.empty())
+  {
+    ceres::SparseLinearAlgebraLibraryType type;
+    if (!ceres::StringToSparseLinearAlgebraLibraryType(sSparse_library, &type)
+        || !ceres::IsSparseLinearAlgebraLibraryTypeAvailable(type))
+    {
+      std::cerr << "Unavailable sparse library: " << sSparse_library << std::endl;
+      return EXIT_FAILURE;
+    }
+    ceres_options.sparse_linear_algebra_library_type_ = type;
+  }
+  if (i_large_scene_threshold >= 0)
+    ceres_options.large_scene_pose_threshold_ = i_large_scene_threshold;
+  if (i_inner_iterations >= 0)
+    ceres_options.bUse_inner_iterations_ = (i_inner_iterations != 0);
+  if (i_explicit_ordering >= 0)
+    ceres_options.bUse_explicit_schur_ordering_ = (i_explicit_ordering != 0);
+  if (i_nb_threads > 0)
+    ceres_options.nb_threads_ = i_nb_threads;
+  ceres_options.bVerbose_ = false;
+  // Do not dump the replayed problem again
+  ceres_options.problem_dump_prefix_.clear();
+
+  std::cout
+    << "Bundle Adjustment problem:\n"
+    << " #views: " << sfm_data.GetViews().size() << "\n"
+    << " #poses: " << sfm_data.GetPoses().size() << "\n"
+    << " #intrinsics: " << sfm_data.GetIntrinsics().size() << "\n"
+    << " #tracks: " << sfm_data.GetLandmarks().size() << "\n"
+    << " #control points: " << sfm_data.GetControl_Points().size() << "\n"
+    << std::endl;
+
+  const SfM_Data sfm_data_input = sfm_data;
+  for (int run = 0; run < i_repeat; ++run)
+  {
+    // Each run starts from the saved problem
+    // (intrinsics are shared pointers: they must be deep copied)
+    sfm_data = sfm_data_input;
+    for (auto & intrinsic_it : sfm_data.intrinsics)
+      intrinsic_it.second.reset(intrinsic_it.second->clone());
+
+    Bundle_Adjustment_Ceres bundle_adjustment_obj(ceres_options);
+    const bool b_success = bundle_adjustment_obj.Adjust(sfm_data, optimize_options);
+    const Bundle_Adjustment_Ceres::BA_Ceres_statistics & stats =
+      bundle_adjustment_obj.statistics();
+
+    std::cout
+      << "Run " << run << ": " << (b_success ? "success" : "failure") << "\n"
+      << " Linear solver: " << stats.linear_solver_type << "\n"
+      << " #residuals: " << stats.num_residuals << "\n"
+      << " #iterations: " << stats.num_iterations << "\n"
+      << " Initial cost: " << stats.initial_cost << "\n"
+      << " Final cost: " << stats.final_cost << "\n"
+      << " Total time (s): " << stats.total_time << "\n"
+      << " Preprocessor time (s): " << stats.preprocessor_time << "\n"
+      << " Minimizer time (s): " << stats.minimizer_time << "\n"
+      << " Time per iteration (s): "
+      << (stats.num_iterations > 0 ? stats.minimizer_time / stats.num_iterations : 0.0) << "\n"
+      << " Residual evaluation time (s): " << stats.residual_evaluation_time << "\n"
+      << " Jacobian evaluation time (s): " << stats.jacobian_evaluation_time << "\n"
+      << " Linear solver time (s): " << stats.linear_solver_time << "\n"
+      << std::endl;
+  }
+
+  if (!sSfM_Data_Filename_Out.empty()
+      && !Save(sfm_data, sSfM_Data_Filename_Out, ESfM_Data(ALL)))
+  {
+    std::cerr
+      << std::endl
+      << "An error occured while trying to save \"" << sSfM_Data_Filename_Out << "\"." << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
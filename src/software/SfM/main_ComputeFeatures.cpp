@@ -246,6 +246,8 @@ int main(int argc, char **argv)
   {
     system::Timer timer;
     Image<unsigned char> imageGray;
+    // The image & decoding buffers are reused from an image to another one
+    Image_Pool<unsigned char> image_pool;
 
     C_Progress_display my_progress_bar(sfm_data.GetViews().size(),
       std::cout, "\n- EXTRACT FEATURES -\n" );
@@ -276,7 +278,7 @@ int main(int argc, char **argv)
       // If features or descriptors file are missing, compute them
       if (!preemptive_exit && (bForce || !stlplus::file_exists(sFeat) || !stlplus::file_exists(sDesc)))
       {
-        if (!ReadImage(sView_filename.c_str(), &imageGray))
+        if (!ReadImage(sView_filename.c_str(), &imageGray, image_pool))
           continue;
 
         //
@@ -291,11 +293,11 @@ int main(int argc, char **argv)
           mask__filename_global =
             stlplus::create_filespec(sfm_data.s_root_path, "mask", "png");
 
-        Image<unsigned char> imageMask;
+        Pooled_Image<unsigned char> imageMask(image_pool);
         // Try to read the local mask
         if (stlplus::file_exists(mask_filename_local))
         {
-          if (!ReadImage(mask_filename_local.c_str(), &imageMask))
+          if (!ReadImage(mask_filename_local.c_str(), &imageMask, image_pool))
           {
             std::cerr << "Invalid mask: " << mask_filename_local << std::endl
                       << "Stopping feature extraction." << std::endl;
@@ -311,7 +313,7 @@ int main(int argc, char **argv)
           // Try to read the global mask
           if (stlplus::file_exists(mask__filename_global))
           {
-            if (!ReadImage(mask__filename_global.c_str(), &imageMask))
+            if (!ReadImage(mask__filename_global.c_str(), &imageMask, image_pool))
             {
               std::cerr << "Invalid mask: " << mask__filename_global << std::endl
                         << "Stopping feature extraction." << std::endl;
@@ -335,7 +337,8 @@ int main(int argc, char **argv)
       }
       ++my_progress_bar;
     }
-    std::cout << "Task done in (s): " << timer.elapsed() << std::endl;
+    std::cout << "Task done in (s): " << timer.elapsed() << "\n"
+      << image_pool.Statistics() << std::endl;
   }
   return EXIT_SUCCESS;
 }
@@ -12,6 +12,7 @@
 #include "openMVG/features/descriptor.hpp"
 #include "openMVG/features/feature.hpp"
 #include "openMVG/matching/indMatch.hpp"
+#include "openMVG/matching/indMatch_store.hpp"
 #include "openMVG/matching/indMatch_utils.hpp"
 #include "openMVG/matching_image_collection/Matcher_Regions.hpp"
 #include "openMVG/matching_image_collection/Cascade_Hashing_Matcher_Regions.hpp"
@@ -83,6 +84,7 @@ int main(int argc, char **argv)
   bool bGuided_matching = false;
   int imax_iteration = 2048;
   unsigned int ui_max_cache_size = 0;
+  bool bMatchesStore = false;
 
   //required
   cmd.add( make_option('i', sSfM_Data_Filename, "input_file") );
@@ -97,6 +99,7 @@ int main(int argc, char **argv)
   cmd.add( make_option('m', bGuided_matching, "guided_matching") );
   cmd.add( make_option('I', imax_iteration, "max_iteration") );
   cmd.add( make_option('c', ui_max_cache_size, "cache_size") );
+  cmd.add( make_option('x', bMatchesStore, "matches_store") );
 
 
   try {
@@ -140,7 +143,10 @@ int main(int argc, char **argv)
       << "  use the found model to improve the pairwise correspondences.\n"
       << "[-c|--cache_size]\n"
       << "  Use a regions cache (only cache_size regions will be stored in memory)\n"
-      << "  If not used, all regions will be load in memory."
+      << "  If not used, all regions will be load in memory.\n"
+      << "[-x|--matches_store]\n"
+      << "  Save the matches as indexed match files (.mstore),\n"
+      << "  the putative matches are written as they are computed."
       << std::endl;
 
       std::cerr << s << std::endl;
@@ -159,7 +165,8 @@ int main(int argc, char **argv)
             << "--pair_list " << sPredefinedPairList << "\n"
             << "--nearest_matching_method " << sNearestMatchingMethod << "\n"
             << "--guided_matching " << bGuided_matching << "\n"
-            << "--cache_size " << ((ui_max_cache_size == 0) ? "unlimited" : std::to_string(ui_max_cache_size)) << std::endl;
+            << "--cache_size " << ((ui_max_cache_size == 0) ? "unlimited" : std::to_string(ui_max_cache_size)) << "\n"
+            << "--matches_store " << bMatchesStore << std::endl;
 
   EPairMode ePairmode = (iMatchingVideoMode == -1 ) ? PAIR_EXHAUSTIVE : PAIR_CONTIGUOUS;
 
@@ -182,32 +189,36 @@ int main(int argc, char **argv)
   {
     case 'f': case 'F':
       eGeometricModelToCompute = FUNDAMENTAL_MATRIX;
-      sGeometricMatchesFilename = "matches.f.bin";
+      sGeometricMatchesFilename = "matches.f";
     break;
     case 'e': case 'E':
       eGeometricModelToCompute = ESSENTIAL_MATRIX;
-      sGeometricMatchesFilename = "matches.e.bin";
+      sGeometricMatchesFilename = "matches.e";
     break;
     case 'h': case 'H':
       eGeometricModelToCompute = HOMOGRAPHY_MATRIX;
-      sGeometricMatchesFilename = "matches.h.bin";
+      sGeometricMatchesFilename = "matches.h";
     break;
     case 'a': case 'A':
       eGeometricModelToCompute = ESSENTIAL_MATRIX_ANGULAR;
-      sGeometricMatchesFilename = "matches.f.bin";
+      sGeometricMatchesFilename = "matches.f";
     break;
     case 'o': case 'O':
       eGeometricModelToCompute = ESSENTIAL_MATRIX_ORTHO;
-      sGeometricMatchesFilename = "matches.o.bin";
+      sGeometricMatchesFilename = "matches.o";
     break;
     case 'u': case 'U':
       eGeometricModelToCompute = ESSENTIAL_MATRIX_UPRIGHT;
-      sGeometricMatchesFilename = "matches.f.bin";
+      sGeometricMatchesFilename = "matches.f";
     break;
     default:
       std::cerr << "Unknown geometric model" << std::endl;
       return EXIT_FAILURE;
   }
+  const std::string sMatchesExtension = bMatchesStore ? ".mstore" : ".bin";
+  sGeometricMatchesFilename += sMatchesExtension;
+  const std::string sPutativeMatchesFilename =
+    sMatchesDirectory + "/matches.putative" + sMatchesExtension;
 
   // -----------------------------
   // - Load SfM_Data Views & intrinsics data
@@ -291,10 +302,10 @@ int main(int argc, char **argv)
   // If the matches already exists, reload them
   if (!bForce
         && (stlplus::file_exists(sMatchesDirectory + "/matches.putative.txt")
-        || stlplus::file_exists(sMatchesDirectory + "/matches.putative.bin"))
+        || stlplus::file_exists(sPutativeMatchesFilename))
   )
   {
-    if (!(Load(map_PutativesMatches, sMatchesDirectory + "/matches.putative.bin") ||
+    if (!(Load(map_PutativesMatches, sPutativeMatchesFilename) ||
           Load(map_PutativesMatches, sMatchesDirectory + "/matches.putative.txt")) )
     {
       std::cerr << "Cannot load input matches file";
@@ -386,17 +397,35 @@ int main(int argc, char **argv)
           }
           break;
       }
-      // Photometric matching of putative pairs
-      collectionMatcher->Match(regions_provider, pairs, map_PutativesMatches, &progress);
-      //---------------------------------------
-      //-- Export putative matches
-      //---------------------------------------
-      if (!Save(map_PutativesMatches, std::string(sMatchesDirectory + "/matches.putative.bin")))
+      if (bMatchesStore)
       {
-        std::cerr
-          << "Cannot save computed matches in: "
-          << std::string(sMatchesDirectory + "/matches.putative.bin");
-        return EXIT_FAILURE;
+        // Photometric matching of putative pairs
+        //  (the pairs are appended to the match file as they are computed)
+        Matches_Store_Writer writer(sPutativeMatchesFilename);
+        Matches_Store_Stream matches_stream(writer, &map_PutativesMatches);
+        collectionMatcher->Match(regions_provider, pairs, matches_stream, &progress);
+        if (!matches_stream.IsValid() || !writer.Close())
+        {
+          std::cerr
+            << "Cannot save computed matches in: "
+            << sPutativeMatchesFilename;
+          return EXIT_FAILURE;
+        }
+      }
+      else
+      {
+        // Photometric matching of putative pairs
+        collectionMatcher->Match(regions_provider, pairs, map_PutativesMatches, &progress);
+        //---------------------------------------
+        //-- Export putative matches
+        //---------------------------------------
+        if (!Save(map_PutativesMatches, sPutativeMatchesFilename))
+        {
+          std::cerr
+            << "Cannot save computed matches in: "
+            << sPutativeMatchesFilename;
+          return EXIT_FAILURE;
+        }
       }
     }
     std::cout << "Task (Regions Matching) done in (s): " << timer.elapsed() << std::endl;
@@ -0,0 +1,72 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/matching/indMatch.hpp"
+#include "openMVG/matching/indMatch_utils.hpp"
+#include "openMVG/system/timer.hpp"
+
+#include "third_party/cmdLine/cmdLine.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace openMVG;
+using namespace openMVG::matching;
+
+// Convert a pairwise matches file from a format to another
+int main(int argc, char **argv)
+{
+  CmdLine cmd;
+
+  std::string
+    sMatches_Filename_In,
+    sMatches_Filename_Out;
+
+  cmd.add(make_option('i', sMatches_Filename_In, "input_file"));
+  cmd.add(make_option('o', sMatches_Filename_Out, "output_file"));
+
+  try {
+      if (argc == 1) throw std::string("Invalid command line parameter.");
+      cmd.process(argc, argv);
+  } catch (const std::string& s) {
+      std::cerr << "Usage: " << argv[0] << '\n'
+        << "[-i|--input_file] path to the input matches file\n"
+        << "[-o|--output_file] path to the output matches file\n"
+        << "\t .txt, .bin, .mstore (indexed matches, per pair random access)\n"
+        << std::endl;
+
+      std::cerr << s << std::endl;
+      return EXIT_FAILURE;
+  }
+
+  if (sMatches_Filename_In.empty() || sMatches_Filename_Out.empty())
+  {
+    std::cerr << "Invalid input or output filename." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  system::Timer timer;
+  PairWiseMatches matches;
+  if (!Load(matches, sMatches_Filename_In))
+  {
+    std::cerr << std::endl
+      << "The input matches file \""<< sMatches_Filename_In << "\" cannot be read." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (!Save(matches, sMatches_Filename_Out))
+  {
+    std::cerr << std::endl
+      << "The output matches file \""<< sMatches_Filename_Out << "\" cannot be written." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Converted " << matches.size() << " pairs in " << timer << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -13,6 +13,7 @@
 #include "openMVG/sfm/pipelines/global/sfm_global_engine_relative_motions.hpp"
 #include "openMVG/sfm/pipelines/sfm_features_provider.hpp"
 #include "openMVG/sfm/pipelines/sfm_matches_provider.hpp"
+#include "openMVG/sfm/pipelines/sfm_matches_provider_store.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
 #include "openMVG/sfm/sfm_data_io.hpp"
 #include "openMVG/sfm/sfm_report.hpp"
@@ -94,6 +95,9 @@ int main(int argc, char **argv)
       <<      "\t\t-> refine the principal point position & the distortion coefficient(s) (if any)\n"
     << "[-P|--prior_usage] Enable usage of motion priors (i.e GPS positions)\n"
     << "[-M|--match_file] path to the match file to use.\n"
+    << "\n[Environment variable]\n"
+    << "OPENMVG_BA_PROBLEM_DUMP_PREFIX: if set, the input of each bundle adjustment is saved to\n"
+      << "\t <prefix><call index>.bin (it can be replayed with openMVG_main_BA_Benchmark)\n"
     << std::endl;
 
     std::cerr << s << std::endl;
@@ -146,8 +150,12 @@ int main(int argc, char **argv)
       << "Invalid features." << std::endl;
     return EXIT_FAILURE;
   }
-  // Matches reading
-  std::shared_ptr<Matches_Provider> matches_provider = std::make_shared<Matches_Provider>();
+  // Matches reading (an indexed match file is read with the Matches_Provider_Store)
+  std::shared_ptr<Matches_Provider> matches_provider;
+  if (stlplus::extension_part(sMatchFilename) == "mstore")
+    matches_provider = std::make_shared<Matches_Provider_Store>();
+  else
+    matches_provider = std::make_shared<Matches_Provider>();
   if // Try to read the provided match filename or the default one (matches.e.txt/bin)
   (
     !(matches_provider->load(sfm_data, sMatchFilename) ||
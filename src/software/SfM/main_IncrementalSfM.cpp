@@ -11,6 +11,7 @@
 #include "openMVG/sfm/pipelines/sequential/sequential_SfM.hpp"
 #include "openMVG/sfm/pipelines/sfm_features_provider.hpp"
 #include "openMVG/sfm/pipelines/sfm_matches_provider.hpp"
+#include "openMVG/sfm/pipelines/sfm_matches_provider_store.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
 #include "openMVG/sfm/sfm_data_io.hpp"
 #include "openMVG/sfm/sfm_report.hpp"
@@ -84,6 +85,8 @@ int main(int argc, char **argv)
   bool b_use_motion_priors = false;
   int triangulation_method = static_cast<int>(ETriangulationMethod::DEFAULT);
   int resection_method  = static_cast<int>(resection::SolverType::DEFAULT);
+  double snapshot_period = 0.0;
+  double snapshot_growth = 0.0;
 
   cmd.add( make_option('i', sSfM_Data_Filename, "input_file") );
   cmd.add( make_option('m', sMatchesDir, "matchdir") );
@@ -96,6 +99,8 @@ int main(int argc, char **argv)
   cmd.add( make_switch('P', "prior_usage") );
   cmd.add( make_option('t', triangulation_method, "triangulation_method"));
   cmd.add( make_option('r', resection_method, "resection_method"));
+  cmd.add( make_option('T', snapshot_period, "snapshot_period"));
+  cmd.add( make_option('G', snapshot_growth, "snapshot_growth"));
 
   try {
     if (argc == 1) throw std::string("Invalid parameter.");
@@ -140,6 +145,13 @@ int main(int argc, char **argv)
     << "\t" << static_cast<int>(resection::SolverType::P3P_KNEIP_CVPR11) << ": P3P_KNEIP_CVPR11\n"
     << "\t" << static_cast<int>(resection::SolverType::P3P_NORDBERG_ECCV18) << ": P3P_NORDBERG_ECCV18\n"
     << "\t" << static_cast<int>(resection::SolverType::UP2P_KUKELOVA_ACCV10)  << ": UP2P_KUKELOVA_ACCV10 | 2Points | upright camera\n"
+    << "[-T|--snapshot_period] minimal time in seconds between two intermediate scene exports\n"
+      << "\t (default: 0, a negative value disables the intermediate exports)\n"
+    << "[-G|--snapshot_growth] minimal pose or landmark count growth between two intermediate scene exports\n"
+      << "\t (i.e 0.1 for 10%, default: 0)\n"
+    << "\n[Environment variable]\n"
+    << "OPENMVG_BA_PROBLEM_DUMP_PREFIX: if set, the input of each bundle adjustment is saved to\n"
+      << "\t <prefix><call index>.bin (it can be replayed with openMVG_main_BA_Benchmark)\n"
     << std::endl;
 
     std::cerr << s << std::endl;
@@ -190,8 +202,12 @@ int main(int argc, char **argv)
       << "Invalid features." << std::endl;
     return EXIT_FAILURE;
   }
-  // Matches reading
-  std::shared_ptr<Matches_Provider> matches_provider = std::make_shared<Matches_Provider>();
+  // Matches reading (an indexed match file is read with the Matches_Provider_Store)
+  std::shared_ptr<Matches_Provider> matches_provider;
+  if (stlplus::extension_part(sMatchFilename) == "mstore")
+    matches_provider = std::make_shared<Matches_Provider_Store>();
+  else
+    matches_provider = std::make_shared<Matches_Provider>();
   if // Try to read the provided match filename or the default one (matches.f.txt/bin)
   (
     !(matches_provider->load(sfm_data, sMatchFilename) ||
@@ -238,6 +254,11 @@ int main(int argc, char **argv)
   sfmEngine.Set_Use_Motion_Prior(b_use_motion_priors);
   sfmEngine.SetTriangulationMethod(static_cast<ETriangulationMethod>(triangulation_method));
   sfmEngine.SetResectionMethod(static_cast<resection::SolverType>(resection_method));
+  Snapshot_Options snapshot_options;
+  snapshot_options.enabled_ = snapshot_period >= 0.0;
+  snapshot_options.min_period_ = snapshot_period;
+  snapshot_options.min_growth_ratio_ = snapshot_growth;
+  sfmEngine.SetSnapshotOptions(snapshot_options);
 
   // Handle Initial pair parameter
   if (!initialPairString.first.empty() && !initialPairString.second.empty())
@@ -12,7 +12,9 @@
 #include "openMVG/sfm/pipelines/sequential/SfmSceneInitializerMaxPair.hpp"
 #include "openMVG/sfm/pipelines/sequential/SfmSceneInitializerStellar.hpp"
 #include "openMVG/sfm/pipelines/sfm_features_provider.hpp"
+#include "openMVG/sfm/pipelines/sfm_features_provider_cache.hpp"
 #include "openMVG/sfm/pipelines/sfm_matches_provider.hpp"
+#include "openMVG/sfm/pipelines/sfm_matches_provider_store.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
 #include "openMVG/sfm/sfm_data_io.hpp"
 #include "openMVG/sfm/sfm_report.hpp"
@@ -77,6 +79,9 @@ int main(int argc, char **argv)
   bool b_use_motion_priors = false;
   int triangulation_method = static_cast<int>(ETriangulationMethod::DEFAULT);
   int resection_method  = static_cast<int>(resection::SolverType::DEFAULT);
+  double snapshot_period = 0.0;
+  double snapshot_growth = 0.0;
+  unsigned int ui_max_cache_size = 0;
 
   cmd.add( make_option('i', sSfM_Data_Filename, "input_file") );
   cmd.add( make_option('m', sMatchesDir, "matchdir") );
@@ -88,6 +93,10 @@ int main(int argc, char **argv)
   cmd.add( make_switch('P', "prior_usage") );
   cmd.add( make_option('t', triangulation_method, "triangulation_method"));
   cmd.add( make_option('r', resection_method, "resection_method"));
+  cmd.add( make_option('T', snapshot_period, "snapshot_period"));
+  cmd.add( make_option('G', snapshot_growth, "snapshot_growth"));
+  cmd.add( make_switch('F', "full_triangulation") );
+  cmd.add( make_option('C', ui_max_cache_size, "cache_size") );
 
   try {
     if (argc == 1) throw std::string("Invalid parameter.");
@@ -135,6 +144,18 @@ int main(int argc, char **argv)
     << "\t" << static_cast<int>(resection::SolverType::P3P_KNEIP_CVPR11) << ": P3P_KNEIP_CVPR11\n"
     << "\t" << static_cast<int>(resection::SolverType::P3P_NORDBERG_ECCV18) << ": P3P_NORDBERG_ECCV18\n"
     << "\t" << static_cast<int>(resection::SolverType::UP2P_KUKELOVA_ACCV10)  << ": UP2P_KUKELOVA_ACCV10 | 2Points | upright camera\n"
+    << "[-T|--snapshot_period] minimal time in seconds between two intermediate scene exports\n"
+      << "\t (default: 0, a negative value disables the intermediate exports)\n"
+    << "[-G|--snapshot_growth] minimal pose or landmark count growth between two intermediate scene exports\n"
+      << "\t (i.e 0.1 for 10%, default: 0)\n"
+    << "[-F|--full_triangulation] Triangulate all the tracks at every resection round\n"
+      << "\t (default: only the tracks with new or removed observations are triangulated)\n"
+    << "[-C|--cache_size]\n"
+      << "\t Use a features cache (only cache_size view features are stored in memory,\n"
+      << "\t  they are loaded on demand) (default: 0, all the features are loaded)\n"
+    << "\n[Environment variable]\n"
+    << "OPENMVG_BA_PROBLEM_DUMP_PREFIX: if set, the input of each bundle adjustment is saved to\n"
+      << "\t <prefix><call index>.bin (it can be replayed with openMVG_main_BA_Benchmark)\n"
     << std::endl;
 
     std::cerr << s << std::endl;
@@ -186,14 +207,28 @@ int main(int argc, char **argv)
   }
 
   // Features reading
-  std::shared_ptr<Features_Provider> feats_provider = std::make_shared<Features_Provider>();
+  std::shared_ptr<Features_Provider> feats_provider;
+  if (ui_max_cache_size == 0)
+  {
+    // Default features provider (load & store all the features in memory)
+    feats_provider = std::make_shared<Features_Provider>();
+  }
+  else
+  {
+    // Cached features provider (load & store the features on demand)
+    feats_provider = std::make_shared<Features_Provider_Cache>(ui_max_cache_size);
+  }
   if (!feats_provider->load(sfm_data, sMatchesDir, regions_type)) {
     std::cerr << std::endl
       << "Invalid features." << std::endl;
     return EXIT_FAILURE;
   }
-  // Matches reading
-  std::shared_ptr<Matches_Provider> matches_provider = std::make_shared<Matches_Provider>();
+  // Matches reading (an indexed match file is read with the Matches_Provider_Store)
+  std::shared_ptr<Matches_Provider> matches_provider;
+  if (stlplus::extension_part(sMatchFilename) == "mstore")
+    matches_provider = std::make_shared<Matches_Provider_Store>();
+  else
+    matches_provider = std::make_shared<Matches_Provider>();
   if // Try to read the provided match filename or the default one (matches.f.txt/bin)
   (
     !(matches_provider->load(sfm_data, sMatchFilename) ||
@@ -273,6 +308,12 @@ int main(int argc, char **argv)
   sfmEngine.Set_Use_Motion_Prior(b_use_motion_priors);
   sfmEngine.SetTriangulationMethod(static_cast<ETriangulationMethod>(triangulation_method));
   sfmEngine.SetResectionMethod(static_cast<resection::SolverType>(resection_method));
+  Snapshot_Options snapshot_options;
+  snapshot_options.enabled_ = snapshot_period >= 0.0;
+  snapshot_options.min_period_ = snapshot_period;
+  snapshot_options.min_growth_ratio_ = snapshot_growth;
+  sfmEngine.SetSnapshotOptions(snapshot_options);
+  sfmEngine.SetFullTriangulation(cmd.used('F'));
 
   if (sfmEngine.Process())
   {
@@ -6,8 +6,11 @@
 // License, v. 2.0. If a copy of the MPL was not distributed with this
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
+#include "openMVG/features/regions.hpp"
 #include "openMVG/matching/matcher_brute_force.hpp"
 #include "openMVG/matching_image_collection/Pair_Builder.hpp"
+#include "openMVG/matching_image_collection/Retrieval_Pair_Builder.hpp"
+#include "openMVG/sfm/pipelines/sfm_regions_provider_cache.hpp"
 #include "openMVG/sfm/sfm_data.hpp"
 #include "openMVG/sfm/sfm_data_io.hpp"
 #include "openMVG/system/timer.hpp"
@@ -28,7 +31,8 @@ enum ePairMode
 {
   PAIR_MODE_EXHAUSTIVE = 0,
   PAIR_MODE_CONTIGUOUS = 1,
-  PAIR_MODE_NEIGHBORHOOD = 2
+  PAIR_MODE_NEIGHBORHOOD = 2,
+  PAIR_MODE_RETRIEVAL = 3
 };
 
 /// Export an adjacency matrix as a SVG file
@@ -97,6 +101,8 @@ int main(int argc, char **argv)
   std::string s_out_file;
   int i_neighbor_count = 5;
   int i_mode(PAIR_MODE_EXHAUSTIVE);
+  std::string s_matches_directory;
+  matching_image_collection::Retrieval_Pair_Options retrieval_options;
 
   cmd.add( make_option('i', s_SfM_Data_filename, "input_file") );
   cmd.add( make_option('o', s_out_file, "output_file") );
@@ -104,6 +110,10 @@ int main(int argc, char **argv)
   cmd.add( make_switch('G', "gps_mode"));
   cmd.add( make_switch('V', "video_mode"));
   cmd.add( make_switch('E', "exhaustive_mode"));
+  cmd.add( make_switch('R', "retrieval_mode"));
+  cmd.add( make_option('m', s_matches_directory, "matchdir") );
+  cmd.add( make_option('b', retrieval_options.branching_factor_, "branching_factor") );
+  cmd.add( make_option('d', retrieval_options.depth_, "vocabulary_depth") );
 
   try {
     if (argc == 1) throw std::string("Invalid parameter.");
@@ -113,12 +123,20 @@ int main(int argc, char **argv)
     << "[-i|--input_file] path to a SfM_Data scene\n"
     << "[-o|--output_file] the output pairlist file (i.e ./pair_list.txt)\n"
     << "optional:\n"
-    << "Matching pair modes [E/V/G]:\n"
+    << "Matching pair modes [E/V/G/R]:\n"
     << "\t[-E|--exhaustive_mode] exhaustive mode (default mode)\n"
     << "\t[-V|--video_mode] link views that belongs to contiguous poses ids\n"
     << "\t[-G|--gps_mode] use the pose center priors to link neighbor views\n"
-    << "Note: options V & G are linked the following parameter:\n"
+    << "\t[-R|--retrieval_mode] link every view to its most similar views\n"
+    << "\t  (vocabulary tree image retrieval on the computed features)\n"
+    << "Note: options V, G & R are linked the following parameter:\n"
     << "\t [-n|--neighbor_count] number of maximum neighbor\n"
+    << "Note: option R is linked to the following parameters:\n"
+    << "\t [-m|--matchdir] path to the directory that contains the features\n"
+    << "\t [-b|--branching_factor] vocabulary tree branching factor (default: "
+    << retrieval_options.branching_factor_ << ")\n"
+    << "\t [-d|--vocabulary_depth] vocabulary tree depth (default: "
+    << retrieval_options.depth_ << ")\n"
     << std::endl;
 
     std::cerr << s << std::endl;
@@ -133,9 +151,15 @@ int main(int argc, char **argv)
     << "Optional parameters:" << "\n"
     << "--exhaustive_mode " << (cmd.used('E') ? "ON" : "OFF") << "\n"
     << "--video_mode " <<  (cmd.used('V') ? "ON" : "OFF") << "\n"
-    << "--gps_mode "  << (cmd.used('G') ? "ON" : "OFF") << "\n";
-  if (cmd.used('V') || cmd.used('G'))
+    << "--gps_mode "  << (cmd.used('G') ? "ON" : "OFF") << "\n"
+    << "--retrieval_mode "  << (cmd.used('R') ? "ON" : "OFF") << "\n";
+  if (cmd.used('V') || cmd.used('G') || cmd.used('R'))
     std::cout << "--neighbor_count " << i_neighbor_count << std::endl;
+  if (cmd.used('R'))
+    std::cout
+      << "--matchdir " << s_matches_directory << "\n"
+      << "--branching_factor " << retrieval_options.branching_factor_ << "\n"
+      << "--vocabulary_depth " << retrieval_options.depth_ << std::endl;
 
   std::cout << std::endl;
 
@@ -144,7 +168,7 @@ int main(int argc, char **argv)
   //--
 
   // pair list mode
-  if ( int(cmd.used('E')) + int(cmd.used('V')) + int(cmd.used('G')) > 1)
+  if ( int(cmd.used('E')) + int(cmd.used('V')) + int(cmd.used('G')) + int(cmd.used('R')) > 1)
   {
     std::cerr << "You can use only one matching mode." << std::endl;
     return EXIT_FAILURE;
@@ -155,6 +179,8 @@ int main(int argc, char **argv)
     i_mode = PAIR_MODE_CONTIGUOUS;
   else if (cmd.used('G'))
     i_mode = PAIR_MODE_NEIGHBORHOOD;
+  else if (cmd.used('R'))
+    i_mode = PAIR_MODE_RETRIEVAL;
 
   // Input SfM_Data scene
   SfM_Data sfm_data;
@@ -186,6 +212,61 @@ int main(int argc, char **argv)
     }
   }
 
+  //---------------------------------------
+  // Retrieval mode: the view graph is built directly from the image similarity
+  //---------------------------------------
+  if (i_mode == PAIR_MODE_RETRIEVAL)
+  {
+    // Init the regions_type from the image describer file (used for image regions extraction)
+    const std::string sImage_describer =
+      stlplus::create_filespec(s_matches_directory, "image_describer", "json");
+    std::unique_ptr<features::Regions> regions_type =
+      features::Init_region_type_from_file(sImage_describer);
+    if (!regions_type)
+    {
+      std::cerr << "Invalid: "
+        << sImage_describer << " regions type file." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // The regions are loaded on demand (every view is read twice)
+    const unsigned int max_cache_size = 1;
+    Regions_Provider_Cache regions_provider(max_cache_size);
+    if (!regions_provider.load(sfm_data, s_matches_directory, regions_type, nullptr))
+    {
+      std::cerr << std::endl << "Invalid regions." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    std::set<IndexT> view_ids;
+    for (const auto & view_it : sfm_data.GetViews())
+      view_ids.insert(view_it.first);
+
+    openMVG::system::Timer timer;
+    retrieval_options.nb_neighbors_ = i_neighbor_count;
+    C_Progress_display progress;
+    const Pair_Set view_pair =
+      matching_image_collection::retrievalPairs(regions_provider, view_ids, retrieval_options, &progress);
+    std::cout << "Image retrieval took (s): " << timer.elapsed() << std::endl;
+
+    if (view_pair.empty())
+    {
+      std::cout << "Warning: The computed pair list is empty...!" << std::endl;
+    }
+
+    AdjacencyMatrixToSVG(sfm_data.GetViews().size(), view_pair,
+      stlplus::create_filespec(
+        stlplus::folder_part(s_out_file),
+        stlplus::filename_part(s_out_file), "svg"));
+
+    if (savePairs(s_out_file, view_pair))
+    {
+      std::cout << "Exported " << view_pair.size() << " view pairs." << std::endl;
+      return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+  }
+
   //---------------------------------------
   // a. List the view pose as a linear sequence of ids.
   // b. Establish a pose graph according the user chosen mode:
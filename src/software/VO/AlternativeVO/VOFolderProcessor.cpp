@@ -128,16 +128,16 @@ std::vector< VOViewerPoint > VOFolderProcessor::GetCurrentTrackedPoints( void )
   std::vector< VOViewerPoint > res;
   res.reserve(m_monocular_vo->landmark_.size());
 
-  for ( size_t idx = 0; idx < m_monocular_vo->landmark_.size(); ++idx )
+  for ( const auto & landmark_it : m_monocular_vo->landmark_ )
   {
     if ( std::find( m_monocular_vo->trackedLandmarkIds_.begin(),
-                    m_monocular_vo->trackedLandmarkIds_.end(), idx )
+                    m_monocular_vo->trackedLandmarkIds_.end(), landmark_it.first )
          == m_monocular_vo->trackedLandmarkIds_.end() )
     {
       continue;
     }
 
-    const openMVG::VO::Landmark & landmark = m_monocular_vo->landmark_[idx];
+    const openMVG::VO::Landmark & landmark = landmark_it.second;
     if ( landmark.obs_.back().frameId_ == m_current_file_ID - 1 && landmark.obs_.size() > 1 )
     {
       const std::deque<openMVG::VO::Measurement> & obs = landmark.obs_;
@@ -163,16 +163,16 @@ std::vector< VOViewerPoint > VOFolderProcessor::GetCreatedPoints( void ) const
   std::vector< VOViewerPoint > res;
   res.reserve(m_monocular_vo->landmark_.size());
 
-  for ( size_t idx = 0; idx < m_monocular_vo->landmark_.size(); ++idx )
+  for ( const auto & landmark_it : m_monocular_vo->landmark_ )
   {
     if ( std::find( m_monocular_vo->trackedLandmarkIds_.begin(),
-                    m_monocular_vo->trackedLandmarkIds_.end(), idx )
+                    m_monocular_vo->trackedLandmarkIds_.end(), landmark_it.first )
          == m_monocular_vo->trackedLandmarkIds_.end() )
     {
       continue;
     }
 
-    const openMVG::VO::Landmark & landmark = m_monocular_vo->landmark_[idx];
+    const openMVG::VO::Landmark & landmark = landmark_it.second;
     if ( landmark.obs_.back().frameId_ == m_current_file_ID - 1 && landmark.obs_.size() > 1 )
     {
 
@@ -202,16 +202,16 @@ std::vector< VOViewerLine > VOFolderProcessor::GetCurrentTrackTrajectories( void
   std::vector< VOViewerLine > res;
   res.reserve(m_monocular_vo->landmark_.size());
 
-  for ( size_t idx = 0; idx < m_monocular_vo->landmark_.size(); ++idx )
+  for ( const auto & landmark_it : m_monocular_vo->landmark_ )
   {
     if ( std::find( m_monocular_vo->trackedLandmarkIds_.begin(),
-                    m_monocular_vo->trackedLandmarkIds_.end(), idx )
+                    m_monocular_vo->trackedLandmarkIds_.end(), landmark_it.first )
          == m_monocular_vo->trackedLandmarkIds_.end() )
     {
       continue;
     }
 
-    const openMVG::VO::Landmark & landmark = m_monocular_vo->landmark_[idx];
+    const openMVG::VO::Landmark & landmark = landmark_it.second;
     if ( landmark.obs_.back().frameId_ == m_current_file_ID - 1 && landmark.obs_.size() > 1 )
     {
       const std::deque<openMVG::VO::Measurement> & obs = landmark.obs_;
@@ -9,18 +9,32 @@
 #ifndef MONOCULAR_VO_HPP
 #define MONOCULAR_VO_HPP
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <deque>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <numeric>
 #include <set>
+#include <vector>
 
+#include "openMVG/cameras/Camera_Intrinsics.hpp"
 #include "openMVG/features/feature.hpp"
+#include "openMVG/geometry/pose3.hpp"
 #include "openMVG/image/image_container.hpp"
+#include "openMVG/multiview/triangulation.hpp"
 #include "openMVG/numeric/eigen_alias_definition.hpp"
-
+#include "openMVG/sfm/pipelines/localization/SfM_Localizer.hpp"
+#include "openMVG/sfm/pipelines/sfm_robust_model_estimation.hpp"
+#include "openMVG/sfm/sfm_data.hpp"
 #include "openMVG/sfm/sfm_landmark.hpp"
+#include "openMVG/system/timer.hpp"
+#include "openMVG/types.hpp"
 
 #include "software/VO/Abstract_Tracker.hpp"
+#include "software/VO/Sliding_Window_BA.hpp"
 
 namespace openMVG  {
 namespace VO  {
@@ -43,43 +57,191 @@ struct Measurement
 /// A 3D point with it's associated image observations
 struct Landmark
 {
-  Landmark():pt_(-1,-1,-1) {}
+  Landmark():pt_(-1,-1,-1), bTriangulated_(false) {}
 
   Vec3 pt_;
-  std::deque<Measurement> obs_;
+  bool bTriangulated_; // Tell if pt_ is valid
+  std::deque<Measurement> obs_; // Sorted by increasing frame id
+
+  /// Return the observation of the frameId frame (nullptr if there is none)
+  const Measurement * findObservation(const uint32_t frameId) const
+  {
+    const auto it = std::lower_bound(obs_.cbegin(), obs_.cend(), frameId,
+      [](const Measurement & obs, const uint32_t id) { return obs.frameId_ < id; });
+    return (it != obs_.cend() && it->frameId_ == frameId) ? &(*it) : nullptr;
+  }
 };
 
+using Landmarks = Hash_Map<uint32_t, Landmark>;
+
 /// Function that converts VO landmark observations to the OpenMVG sfm landmark format.
 inline bool ConvertVOLandmarkToSfMDataLandmark
 (
-  const std::deque<openMVG::VO::Landmark> & vo_landmark,
+  const Landmarks & vo_landmark,
   openMVG::sfm::Landmarks & sfm_landmark
 )
 {
-  for (size_t idx = 0; idx < vo_landmark.size(); ++idx)
+  for (const auto & landmark_it : vo_landmark)
   {
     // Create a sfm_landmark
     sfm::Landmark landmark;
+    if (landmark_it.second.bTriangulated_)
+      landmark.X = landmark_it.second.pt_;
     sfm::Observations & obs = landmark.obs;
 
-    for (const auto & track_it : vo_landmark.at(idx).obs_)
+    for (const auto & track_it : landmark_it.second.obs_)
     {
       obs[track_it.frameId_].x = track_it.pos_.cast<double>();
     }
-    sfm_landmark.insert({idx, landmark});
+    sfm_landmark.insert({landmark_it.first, landmark});
   }
   return true;
 }
 
+/// The keyframe poses and the triangulated landmarks of a map
+/// (the map is restarted if the tracking is lost: each map has its own scale)
+struct Map_Segment
+{
+  std::map<uint32_t, geometry::Pose3> keyframePoses_;
+  sfm::Landmarks landmarks_; // Observed by at least two of the keyframes
+};
+
+/// A keyframe of the sliding window
+struct Keyframe
+{
+  uint32_t frameId_;
+  geometry::Pose3 pose_;
+  std::set<uint32_t> landmarkIds_; // Landmarks observed in the keyframe
+};
+
+/// Keyframe & sliding window settings
+struct VO_Options
+{
+  // Number of keyframes in the sliding window
+  uint32_t windowSize_ = 5;
+  // A keyframe is inserted once the ratio of the tracks shared with the last
+  // keyframe drops under this value, or after maxKeyframeInterval_ frames
+  double keyframeTrackRatio_ = 0.7;
+  uint32_t maxKeyframeInterval_ = 30;
+  // Upper bound of the landmark residuals (pixels)
+  double maxReprojectionError_ = 4.0;
+  // Minimal angle between the rays of a triangulated landmark (degrees)
+  double minTriangulationAngle_ = 2.0;
+  // Map initialization: minimal number of tracks & median triangulation angle (degrees)
+  uint32_t minInitTracks_ = 50;
+  double minInitAngle_ = 3.0;
+  // Minimal number of 2D-3D correspondences used to compute the frame pose
+  uint32_t minResectionPoints_ = 20;
+  // Robust estimations iteration count (bounds the per frame cost)
+  uint32_t maxRansacIterations_ = 256;
+  // Local bundle adjustment of the keyframe window (on a background thread)
+  bool bLocalBA_ = true;
+  int localBAIterations_ = 20;
+  double localBAMaxTime_ = 0.1; // seconds
+  // Remove the landmarks that left the window (bounded memory).
+  // If false, all the landmark observations are kept (i.e to export the full tracks).
+  bool bCullLandmarks_ = true;
+};
+
+/// Frame processing time & local bundle adjustment statistics (constant memory)
+struct VO_Statistics
+{
+  // Frame latency histogram (1 ms bins, the last bin gathers the slower frames)
+  std::array<size_t, 200> latencyHistogram_{};
+  size_t frameCount_ = 0;
+  size_t keyframeCount_ = 0;
+  double totalLatencyMs_ = 0.0;
+  double maxLatencyMs_ = 0.0;
+  double lastLatencyMs_ = 0.0;
+
+  size_t localBACount_ = 0;
+  double totalLocalBAMs_ = 0.0;
+  double maxLocalBAMs_ = 0.0;
+
+  void addFrame(const double latencyMs, const bool bKeyframe)
+  {
+    ++frameCount_;
+    keyframeCount_ += bKeyframe;
+    totalLatencyMs_ += latencyMs;
+    maxLatencyMs_ = std::max(maxLatencyMs_, latencyMs);
+    lastLatencyMs_ = latencyMs;
+    ++latencyHistogram_[std::min(static_cast<size_t>(latencyMs), latencyHistogram_.size() - 1)];
+  }
+
+  void addLocalBA(const double durationMs)
+  {
+    ++localBACount_;
+    totalLocalBAMs_ += durationMs;
+    maxLocalBAMs_ = std::max(maxLocalBAMs_, durationMs);
+  }
+
+  /// Latency (upper bound of the histogram bin) under which falls the ratio of the frames
+  double latencyPercentile(const double ratio) const
+  {
+    const size_t rank = static_cast<size_t>(std::ceil(ratio * frameCount_));
+    size_t count = 0;
+    for (size_t i = 0; i < latencyHistogram_.size(); ++i)
+    {
+      count += latencyHistogram_[i];
+      if (count >= rank && count > 0)
+        return (i == latencyHistogram_.size() - 1) ? maxLatencyMs_ : i + 1.0;
+    }
+    return 0.0;
+  }
+
+  friend std::ostream & operator<<(std::ostream & os, const VO_Statistics & stats)
+  {
+    os << "#frames: " << stats.frameCount_ << ", #keyframes: " << stats.keyframeCount_ << "\n"
+      << "Frame latency (ms): mean " << stats.totalLatencyMs_ / std::max<size_t>(stats.frameCount_, 1)
+      << ", median <= " << stats.latencyPercentile(0.5)
+      << ", 95% <= " << stats.latencyPercentile(0.95)
+      << ", max " << stats.maxLatencyMs_ << "\n"
+      << "#local BA: " << stats.localBACount_ << ", duration (ms): mean "
+      << stats.totalLocalBAMs_ / std::max<size_t>(stats.localBACount_, 1)
+      << ", max " << stats.maxLocalBAMs_;
+    return os;
+  }
+};
+
 /// Monocular test interface
+/// - Landmarks are tracked from frame to frame,
+/// - Keyframes are selected when the tracks shared with the last keyframe decrease,
+/// - If a camera model is provided:
+///   - the map is initialized from the relative pose of two keyframes,
+///   - each frame is localized from the tracked triangulated landmarks,
+///   - the landmarks are triangulated between the keyframes of the window,
+///   - the keyframe window is refined by a local bundle adjustment running on a
+///     background thread (the refined window is merged at the next frames).
+/// - The landmarks that are no longer tracked and left the window are removed.
 struct VO_Monocular
 {
   // Structure and visibility
-  std::deque<Landmark> landmark_;
+  Landmarks landmark_;
+  uint32_t nextLandmarkId_;
   std::vector<uint32_t> trackedLandmarkIds_;
 
-  // Landmark Id per frame (for easier pairing)
-  std::deque<std::set<uint32_t>> landmarkListPerFrame_;
+  // Landmark Ids of the current frame
+  std::set<uint32_t> currentLandmarkIds_;
+
+  // Sliding window of keyframes (oldest first) and the pose of every keyframe
+  // of the current map
+  std::deque<Keyframe> keyframes_;
+  std::map<uint32_t, geometry::Pose3> keyframePoses_;
+  bool bMapInitialized_; // The window keyframes have a pose
+  uint32_t mapGeneration_; // Incremented at each map reset
+  std::vector<Map_Segment> mapSegments_; // The maps closed by a reset
+
+  // Pose of the current frame
+  geometry::Pose3 currentPose_;
+  bool bCurrentPose_;
+
+  // Camera model (optional)
+  std::shared_ptr<cameras::IntrinsicBase> camera_;
+  Pair imageSize_;
+
+  VO_Options options_;
+  std::unique_ptr<Sliding_Window_BA> localBA_;
+  VO_Statistics statistics_;
 
   // Tracking
   Abstract_Tracker * tracker_;
@@ -90,12 +252,23 @@ struct VO_Monocular
   VO_Monocular
   (
     Abstract_Tracker * tracker,
-    const uint32_t maxTrackedFeatures = 1500
-    // Add an abstract camera model here
+    const uint32_t maxTrackedFeatures = 1500,
+    const std::shared_ptr<cameras::IntrinsicBase> & camera = nullptr,
+    const VO_Options & options = VO_Options()
   )
-  : tracker_(tracker),
+  : nextLandmarkId_(0),
+  bMapInitialized_(false),
+  mapGeneration_(0),
+  bCurrentPose_(false),
+  camera_(camera),
+  imageSize_(0, 0),
+  options_(options),
+  tracker_(tracker),
   maxTrackedFeatures_(maxTrackedFeatures)
   {
+    options_.windowSize_ = std::max<uint32_t>(options_.windowSize_, 2);
+    if (camera_ && options_.bLocalBA_)
+      localBA_.reset(new Sliding_Window_BA(options_.localBAIterations_, options_.localBAMaxTime_));
   }
 
   bool nextFrame
@@ -104,42 +277,60 @@ struct VO_Monocular
     const size_t frameId
   )
   {
+    system::Timer timer;
+    imageSize_ = {static_cast<IndexT>(ima.Width()), static_cast<IndexT>(ima.Height())};
+
+    // Merge the last refined keyframe window (if any)
+    collectLocalBA();
+
     const bool bTrackerStatus = tracker_->track(ima, pt_to_track_, pt_tracked_, tracking_status_);
     std::cout << (int) bTrackerStatus  << " : tracker status" << std::endl;
-    landmarkListPerFrame_.emplace_back(std::set<uint32_t>());
-    if (landmarkListPerFrame_.size()==1 || bTrackerStatus)
+    currentLandmarkIds_.clear();
+    bCurrentPose_ = false;
+    bool bKeyframe = false;
+    if (keyframes_.empty() || bTrackerStatus)
     {
-      // Update landmark observation
-      // Update tracking point set (if necessary)
-      // Compute pose if ?
-      // Refine if ?
-
+      // The status are updated in a byte buffer by the threads
+      // (std::vector<bool> packs its values in shared words)
+      std::vector<unsigned char> tracked(tracking_status_.cbegin(), tracking_status_.cend());
       //-- Update landmark observation
       #ifdef OPENMVG_USE_OPENMP
       #pragma omp parallel for schedule(dynamic)
       #endif
-      for (int i = 0; i < (int)tracking_status_.size(); ++i)
+      for (int i = 0; i < (int)tracked.size(); ++i)
       {
-        if (tracking_status_[i]) // if the feature has been tracked
+        if (tracked[i]) // if the feature has been tracked
         {
           const features::PointFeature & a = pt_to_track_[i];
           const features::PointFeature b = pt_tracked_[i];
+          // A slot that lost its landmark (tracking failure, culling) is not
+          // tracked: the tracker may report a stale point as tracked
+          const auto tracker_landmark_id = trackedLandmarkIds_[i];
+          bool bTracked = false;
           // Use a spatial filter to remove features that moved too much
-          if ((a.coords() - b.coords()).norm() < ima.Width()*.08)
+          if ((a.coords() - b.coords()).norm() < ima.Width()*.08
+              && tracker_landmark_id != UndefinedIndexT)
           {
-            const auto tracker_landmark_id = trackedLandmarkIds_[i];
             #ifdef OPENMVG_USE_OPENMP
             #pragma omp critical
             #endif
             {
-              landmark_[tracker_landmark_id].obs_.emplace_back(frameId , b.coords());
-              landmarkListPerFrame_.back().insert(tracker_landmark_id);
+              const auto landmark_it = landmark_.find(tracker_landmark_id);
+              if (landmark_it != landmark_.end())
+              {
+                landmark_it->second.obs_.emplace_back(frameId , b.coords());
+                currentLandmarkIds_.insert(tracker_landmark_id);
+                bTracked = true;
+              }
             }
+          }
+          if (bTracked)
+          {
             pt_to_track_[i] = b; // update the tracked point
           }
           else // the feature does not longer appear or tracking failed to find the feature
           {
-            tracking_status_[i] = 0;
+            tracked[i] = 0;
           }
         }
         else
@@ -148,21 +339,25 @@ struct VO_Monocular
         }
       }
 
+      tracking_status_.assign(tracked.cbegin(), tracked.cend());
+
+      // The failed slots no longer track a landmark (until a new point fills them)
+      for (size_t i = 0; i < tracking_status_.size(); ++i)
+      {
+        if (!tracking_status_[i])
+          trackedLandmarkIds_[i] = UndefinedIndexT;
+      }
+
       // Count the number of tracked features
       const size_t countTracked = std::accumulate(tracking_status_.cbegin(), tracking_status_.cend(), 0);
       std::cout << "#tracked: " << countTracked << std::endl;
 
-      // try compute pose and decide if it's a Keyframe
-      if (frameId > 0 && landmarkListPerFrame_.size() > 1)
+      // Decide if it's a Keyframe and compute the pose
+      bKeyframe = isKeyframe(frameId);
+      if (camera_ && bMapInitialized_)
       {
-        size_t lastKf = frameId-1;
-        std::vector<uint32_t> ids;
-        ids.reserve(std::min(landmarkListPerFrame_[lastKf].size(), landmarkListPerFrame_[frameId].size()));
-        std::set_intersection(
-          landmarkListPerFrame_[lastKf].cbegin(), landmarkListPerFrame_[lastKf].cend(),
-          landmarkListPerFrame_[frameId].cbegin(), landmarkListPerFrame_[frameId].cend(),
-          std::back_inserter(ids));
-        std::cout << "Track in common with the last Keyframe: " << ids.size() << std::endl;
+        // The keyframe poses are refined since they are used for triangulation
+        bCurrentPose_ = localize(currentPose_, bKeyframe);
       }
 
       // Update tracking point set (if necessary)
@@ -172,7 +367,7 @@ struct VO_Monocular
         {
           pt_to_track_.resize(maxTrackedFeatures_);
           pt_tracked_.resize(maxTrackedFeatures_);
-          trackedLandmarkIds_.resize(maxTrackedFeatures_);
+          trackedLandmarkIds_.resize(maxTrackedFeatures_, UndefinedIndexT);
           tracking_status_.resize(maxTrackedFeatures_);
           std::fill(tracking_status_.begin(), tracking_status_.end(), false);
         }
@@ -185,18 +380,19 @@ struct VO_Monocular
         {
           std::cout << "#features added: " << new_pt.size() << std::endl;
           size_t j = 0;
-          for (size_t i = 0; i < tracking_status_.size(); ++i)
+          for (size_t i = 0; i < tracking_status_.size() && j < new_pt.size(); ++i)
           {
             if (!tracking_status_[i])
             {
               // Create a new landmark
               Landmark landmark;
               landmark.obs_.emplace_back(frameId, new_pt[j].coords());
-              landmark_.push_back(landmark);
               // a new landmark ID have be tracked
+              const uint32_t landmarkId = nextLandmarkId_++;
+              landmark_.insert({landmarkId, landmark});
 
-              trackedLandmarkIds_[i] = landmark_.size()-1;
-              landmarkListPerFrame_.back().insert(landmark_.size() - 1);
+              trackedLandmarkIds_[i] = landmarkId;
+              currentLandmarkIds_.insert(landmarkId);
 
               pt_to_track_[i] = new_pt[j];
               ++j;
@@ -205,13 +401,397 @@ struct VO_Monocular
           std::cout << "_landmark.size() " << landmark_.size() << std::endl;
         }
       }
+
+      if (bKeyframe)
+        addKeyframe(frameId);
     }
     if (!bTrackerStatus)
     {
        // re-localization
     }
+    statistics_.addFrame(timer.elapsedMs(), bKeyframe);
     return bTrackerStatus;
   }
+
+  /// Wait for the running local bundle adjustment and merge its result
+  /// (i.e at the end of the sequence)
+  void flush()
+  {
+    collectLocalBA(true);
+  }
+
+  /// Return the keyframe poses and the landmarks of the current map
+  Map_Segment currentMapSegment() const
+  {
+    Map_Segment segment;
+    segment.keyframePoses_ = keyframePoses_;
+    for (const auto & landmark_it : landmark_)
+    {
+      if (!landmark_it.second.bTriangulated_)
+        continue;
+      sfm::Landmark landmark;
+      landmark.X = landmark_it.second.pt_;
+      for (const auto & track_it : landmark_it.second.obs_)
+      {
+        if (keyframePoses_.count(track_it.frameId_))
+          landmark.obs[track_it.frameId_].x = track_it.pos_.cast<double>();
+      }
+      if (landmark.obs.size() >= 2)
+        segment.landmarks_.insert({landmark_it.first, landmark});
+    }
+    return segment;
+  }
+
+private:
+
+  // Keyframe selection: drop of the tracks shared with the last keyframe
+  bool isKeyframe(const size_t frameId) const
+  {
+    if (keyframes_.empty())
+      return true;
+
+    const Keyframe & lastKf = keyframes_.back();
+    std::vector<uint32_t> ids;
+    ids.reserve(std::min(lastKf.landmarkIds_.size(), currentLandmarkIds_.size()));
+    std::set_intersection(
+      lastKf.landmarkIds_.cbegin(), lastKf.landmarkIds_.cend(),
+      currentLandmarkIds_.cbegin(), currentLandmarkIds_.cend(),
+      std::back_inserter(ids));
+    std::cout << "Track in common with the last Keyframe: " << ids.size() << std::endl;
+
+    return frameId - lastKf.frameId_ >= options_.maxKeyframeInterval_
+      || ids.size() < options_.keyframeTrackRatio_ * lastKf.landmarkIds_.size();
+  }
+
+  // Compute the current frame pose from the tracked triangulated landmarks
+  bool localize
+  (
+    geometry::Pose3 & pose,
+    const bool bRefine
+  ) const
+  {
+    sfm::Image_Localizer_Match_Data resection_data;
+    resection_data.pt3D.resize(3, currentLandmarkIds_.size());
+    resection_data.pt2D.resize(2, currentLandmarkIds_.size());
+    int count = 0;
+    for (const uint32_t landmarkId : currentLandmarkIds_)
+    {
+      const Landmark & landmark = landmark_.at(landmarkId);
+      if (landmark.bTriangulated_)
+      {
+        resection_data.pt3D.col(count) = landmark.pt_;
+        resection_data.pt2D.col(count) = landmark.obs_.back().pos_.cast<double>();
+        ++count;
+      }
+    }
+    if (count < static_cast<int>(options_.minResectionPoints_))
+      return false;
+    resection_data.pt3D.conservativeResize(3, count);
+    resection_data.pt2D.conservativeResize(2, count);
+    resection_data.error_max = options_.maxReprojectionError_;
+    resection_data.max_iteration = options_.maxRansacIterations_;
+
+    if (!sfm::SfM_Localizer::Localize(resection::SolverType::P3P_NORDBERG_ECCV18,
+          imageSize_, camera_.get(), resection_data, pose))
+      return false;
+    if (bRefine)
+      sfm::SfM_Localizer::RefinePose(camera_.get(), pose, resection_data, true, false);
+    return true;
+  }
+
+  // Triangulate a landmark from two posed observations
+  bool triangulate
+  (
+    const geometry::Pose3 & pose1,
+    const Vec2 & x1,
+    const geometry::Pose3 & pose2,
+    const Vec2 & x2,
+    Vec3 & X,
+    double * angle = nullptr
+  ) const
+  {
+    const Vec2
+      x1_ud = camera_->get_ud_pixel(x1),
+      x2_ud = camera_->get_ud_pixel(x2);
+    const double rayAngle = cameras::AngleBetweenRay(
+      pose1, camera_.get(), pose2, camera_.get(), x1_ud, x2_ud);
+    if (angle)
+      *angle = rayAngle;
+    return rayAngle > options_.minTriangulationAngle_
+      && Triangulate2View(
+        pose1.rotation(), pose1.translation(), (*camera_)(x1_ud),
+        pose2.rotation(), pose2.translation(), (*camera_)(x2_ud),
+        X)
+      && camera_->residual(pose1(X), x1).norm() < options_.maxReprojectionError_
+      && camera_->residual(pose2(X), x2).norm() < options_.maxReprojectionError_;
+  }
+
+  // Compute the relative pose of two keyframes and triangulate their shared landmarks
+  bool initializeMap
+  (
+    Keyframe & first,
+    Keyframe & second
+  )
+  {
+    std::vector<uint32_t> ids;
+    std::set_intersection(
+      first.landmarkIds_.cbegin(), first.landmarkIds_.cend(),
+      second.landmarkIds_.cbegin(), second.landmarkIds_.cend(),
+      std::back_inserter(ids));
+    if (ids.size() < options_.minInitTracks_)
+      return false;
+
+    Mat x1(2, ids.size()), x2(2, ids.size());
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+      const Landmark & landmark = landmark_.at(ids[i]);
+      x1.col(i) = landmark.findObservation(first.frameId_)->pos_.cast<double>();
+      x2.col(i) = landmark.findObservation(second.frameId_)->pos_.cast<double>();
+    }
+
+    sfm::RelativePose_Info relativePose_info;
+    relativePose_info.initial_residual_tolerance = Square(options_.maxReprojectionError_);
+    if (!sfm::robustRelativePose(camera_.get(), camera_.get(), x1, x2, relativePose_info,
+          imageSize_, imageSize_, options_.maxRansacIterations_))
+      return false;
+
+    const geometry::Pose3 pose1, pose2 = relativePose_info.relativePose;
+    std::vector<std::pair<uint32_t, Vec3>> points;
+    std::vector<double> angles;
+    for (const uint32_t i : relativePose_info.vec_inliers)
+    {
+      Vec3 X;
+      double angle;
+      if (triangulate(pose1, x1.col(i), pose2, x2.col(i), X, &angle))
+        points.emplace_back(ids[i], X);
+      angles.push_back(angle);
+    }
+    if (points.size() < options_.minInitTracks_)
+      return false;
+    // Require a sufficient baseline (a small median angle leads to an imprecise structure)
+    std::nth_element(angles.begin(), angles.begin() + angles.size() / 2, angles.end());
+    std::cout << "Map initialization: #points " << points.size()
+      << ", median angle " << angles[angles.size() / 2] << std::endl;
+    if (angles[angles.size() / 2] < options_.minInitAngle_)
+      return false;
+
+    first.pose_ = pose1;
+    second.pose_ = pose2;
+    for (const auto & point : points)
+    {
+      Landmark & landmark = landmark_.at(point.first);
+      landmark.pt_ = point.second;
+      landmark.bTriangulated_ = true;
+    }
+    return true;
+  }
+
+  // Triangulate the landmarks of the keyframe with their oldest window observation
+  void triangulateKeyframe(const Keyframe & keyframe)
+  {
+    size_t count = 0;
+    for (const uint32_t landmarkId : keyframe.landmarkIds_)
+    {
+      Landmark & landmark = landmark_.at(landmarkId);
+      if (landmark.bTriangulated_)
+        continue;
+      const Measurement * obs = landmark.findObservation(keyframe.frameId_);
+      for (const Keyframe & other : keyframes_)
+      {
+        if (other.frameId_ == keyframe.frameId_)
+          break;
+        const Measurement * other_obs = landmark.findObservation(other.frameId_);
+        if (other_obs)
+        {
+          Vec3 X;
+          if (triangulate(other.pose_, other_obs->pos_.cast<double>(),
+                keyframe.pose_, obs->pos_.cast<double>(), X))
+          {
+            landmark.pt_ = X;
+            landmark.bTriangulated_ = true;
+            ++count;
+          }
+          break;
+        }
+      }
+    }
+    std::cout << "#triangulated landmarks: " << count << std::endl;
+  }
+
+  void addKeyframe(const size_t frameId)
+  {
+    Keyframe keyframe;
+    keyframe.frameId_ = frameId;
+    keyframe.landmarkIds_ = currentLandmarkIds_;
+
+    if (camera_)
+    {
+      if (!bMapInitialized_)
+      {
+        if (!keyframes_.empty() && initializeMap(keyframes_.front(), keyframe))
+        {
+          // The keyframes in between the two initial keyframes have no pose
+          keyframes_.erase(keyframes_.begin() + 1, keyframes_.end());
+          keyframePoses_[keyframes_.front().frameId_] = keyframes_.front().pose_;
+          bMapInitialized_ = true;
+          bCurrentPose_ = true;
+          currentPose_ = keyframe.pose_;
+        }
+      }
+      else if (bCurrentPose_)
+      {
+        keyframe.pose_ = currentPose_;
+      }
+      else
+      {
+        // Tracking is lost: the map is restarted from this keyframe
+        std::cout << "Map reset" << std::endl;
+        resetMap();
+      }
+    }
+
+    keyframes_.push_back(keyframe);
+    if (bMapInitialized_)
+    {
+      keyframePoses_[keyframe.frameId_] = keyframe.pose_;
+      triangulateKeyframe(keyframes_.back());
+    }
+
+    // Slide the window
+    while (keyframes_.size() > options_.windowSize_)
+      keyframes_.pop_front();
+    if (options_.bCullLandmarks_)
+      cullLandmarks();
+
+    if (localBA_ && bMapInitialized_ && keyframes_.size() >= 2)
+      localBA_->Push(windowScene(), mapGeneration_);
+  }
+
+  void resetMap()
+  {
+    // A window refined before the reset is dropped by collectLocalBA
+    ++mapGeneration_;
+    if (!keyframePoses_.empty())
+    {
+      mapSegments_.push_back(currentMapSegment());
+      keyframePoses_.clear();
+    }
+    keyframes_.clear();
+    bMapInitialized_ = false;
+    for (auto & landmark_it : landmark_)
+      landmark_it.second.bTriangulated_ = false;
+  }
+
+  // Remove the observations older than the window and the landmarks that can no
+  // longer be tracked, triangulated or refined
+  void cullLandmarks()
+  {
+    const uint32_t oldestFrameId = keyframes_.front().frameId_;
+    size_t count = 0;
+    for (auto landmark_it = landmark_.begin(); landmark_it != landmark_.end();)
+    {
+      Landmark & landmark = landmark_it->second;
+      while (!landmark.obs_.empty() && landmark.obs_.front().frameId_ < oldestFrameId)
+        landmark.obs_.pop_front();
+
+      if (currentLandmarkIds_.count(landmark_it->first) == 0)
+      {
+        size_t keyframeObservationCount = 0;
+        for (const Keyframe & keyframe : keyframes_)
+          keyframeObservationCount += (landmark.findObservation(keyframe.frameId_) != nullptr);
+        if (keyframeObservationCount < 2)
+        {
+          landmark_it = landmark_.erase(landmark_it);
+          ++count;
+          continue;
+        }
+      }
+      ++landmark_it;
+    }
+    std::cout << "#culled landmarks: " << count << std::endl;
+  }
+
+  // Copy the keyframe window and its landmarks as a SfM_Data scene
+  sfm::SfM_Data windowScene() const
+  {
+    sfm::SfM_Data window;
+    window.intrinsics[0] = std::shared_ptr<cameras::IntrinsicBase>(camera_->clone());
+    for (const Keyframe & keyframe : keyframes_)
+    {
+      window.views[keyframe.frameId_] = std::make_shared<sfm::View>(
+        "", keyframe.frameId_, 0, keyframe.frameId_, imageSize_.first, imageSize_.second);
+      window.poses[keyframe.frameId_] = keyframe.pose_;
+    }
+    for (const auto & landmark_it : landmark_)
+    {
+      const Landmark & landmark = landmark_it.second;
+      if (!landmark.bTriangulated_)
+        continue;
+      sfm::Landmark window_landmark;
+      window_landmark.X = landmark.pt_;
+      for (const Keyframe & keyframe : keyframes_)
+      {
+        const Measurement * obs = landmark.findObservation(keyframe.frameId_);
+        if (obs)
+          window_landmark.obs[keyframe.frameId_] =
+            sfm::Observation(obs->pos_.cast<double>(), landmark_it.first);
+      }
+      if (window_landmark.obs.size() >= 2)
+        window.structure.insert({landmark_it.first, window_landmark});
+    }
+    return window;
+  }
+
+  // Update the keyframes & landmarks that are still in the window with the last
+  // refined window, the refined landmarks with a large residual are untriangulated
+  void collectLocalBA(const bool bWait = false)
+  {
+    if (!localBA_)
+      return;
+    if (bWait)
+      localBA_->Wait();
+    Sliding_Window_BA::Result result;
+    if (!localBA_->Poll(result))
+      return;
+    statistics_.addLocalBA(result.elapsed_ms);
+    if (!result.bSuccess)
+      return;
+    if (result.generation != mapGeneration_)
+    {
+      std::cout << "Local BA: drop a window of a previous map" << std::endl;
+      return;
+    }
+
+    for (Keyframe & keyframe : keyframes_)
+    {
+      const auto pose_it = result.window.poses.find(keyframe.frameId_);
+      if (pose_it != result.window.poses.end())
+      {
+        keyframe.pose_ = pose_it->second;
+        keyframePoses_[keyframe.frameId_] = pose_it->second;
+      }
+    }
+
+    size_t count = 0;
+    for (const auto & window_landmark_it : result.window.structure)
+    {
+      const auto landmark_it = landmark_.find(window_landmark_it.first);
+      if (landmark_it == landmark_.end() || !landmark_it->second.bTriangulated_)
+        continue;
+      const sfm::Landmark & window_landmark = window_landmark_it.second;
+      bool bInlier = true;
+      for (const auto & obs_it : window_landmark.obs)
+      {
+        const geometry::Pose3 & pose = result.window.poses.at(obs_it.first);
+        bInlier &= camera_->residual(pose(window_landmark.X), obs_it.second.x).norm()
+          < options_.maxReprojectionError_;
+      }
+      landmark_it->second.pt_ = window_landmark.X;
+      landmark_it->second.bTriangulated_ = bInlier;
+      count += !bInlier;
+    }
+    std::cout << "Local BA: " << result.elapsed_ms << " ms, #outliers: " << count << std::endl;
+  }
 };
 
 } // namespace VO
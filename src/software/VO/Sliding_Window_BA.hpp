@@ -0,0 +1,217 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef SLIDING_WINDOW_BA_VO_HPP
+#define SLIDING_WINDOW_BA_VO_HPP
+
+#include "openMVG/geometry/Similarity3.hpp"
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_data_BA_ceres.hpp"
+#include "openMVG/sfm/sfm_data_transform.hpp"
+#include "openMVG/system/timer.hpp"
+
+#include "ceres/ceres.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace openMVG  {
+namespace VO  {
+
+/// Local bundle adjustment of the VO keyframe window on a background thread.
+/// - The window is a small SfM_Data scene copied by the frame thread: the
+///   frame thread never waits for the optimization.
+/// - A window pushed while the previous one is optimized replaces the pending
+///   one (only the newest window is refined).
+/// - The gauge of the refined window is fixed by its two oldest poses: the
+///   refined window is mapped back to their input position and distance.
+/// - Each window carries the generation of the map it was copied from, so the
+///   caller can drop a result computed for a map that has been reset since.
+class Sliding_Window_BA
+{
+public:
+  struct Result
+  {
+    sfm::SfM_Data window;
+    uint32_t generation = 0; // Map generation of the window (see Push)
+    double elapsed_ms = 0.0;
+    bool bSuccess = false;
+  };
+
+  explicit Sliding_Window_BA
+  (
+    const int max_iteration_count = 20,
+    const double max_solver_time = 0.1 // seconds
+  )
+  : max_iteration_count_(max_iteration_count),
+    max_solver_time_(max_solver_time)
+  {
+    thread_ = std::thread(&Sliding_Window_BA::Run, this);
+  }
+
+  /// Stop the worker thread (a pending window is dropped)
+  ~Sliding_Window_BA()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      bStop_ = true;
+    }
+    condition_.notify_all();
+    thread_.join();
+  }
+
+  /// Queue a window for refinement, generation is returned with its result
+  void Push(sfm::SfM_Data && window, const uint32_t generation = 0)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (pending_)
+        ++coalesced_count_;
+      pending_.reset(new sfm::SfM_Data(std::move(window)));
+      pending_generation_ = generation;
+    }
+    condition_.notify_all();
+  }
+
+  /// Return true and move the last refined window to result if one is ready
+  /// (non blocking)
+  bool Poll(Result & result)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!result_)
+      return false;
+    result = std::move(*result_);
+    result_.reset();
+    return true;
+  }
+
+  /// Wait until the queued window is refined
+  void Wait()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [&]{ return !pending_ && !bRunning_; });
+  }
+
+  size_t RunCount() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return run_count_;
+  }
+
+  size_t CoalescedCount() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return coalesced_count_;
+  }
+
+  /// Refine the window poses & structure (the intrinsics are kept constant)
+  static bool Adjust
+  (
+    sfm::SfM_Data & window,
+    const int max_iteration_count,
+    const double max_solver_time
+  )
+  {
+    if (window.GetPoses().size() < 2)
+      return false;
+
+    // The two oldest poses (the frame ids are increasing)
+    IndexT idA = UndefinedIndexT, idB = UndefinedIndexT;
+    for (const auto & pose_it : window.GetPoses())
+    {
+      if (idA == UndefinedIndexT || pose_it.first < idA)
+      {
+        idB = idA;
+        idA = pose_it.first;
+      }
+      else if (idB == UndefinedIndexT || pose_it.first < idB)
+        idB = pose_it.first;
+    }
+    const geometry::Pose3 poseA = window.poses.at(idA), poseB = window.poses.at(idB);
+
+    sfm::Bundle_Adjustment_Ceres::BA_Ceres_options options(false, false);
+    options.linear_solver_type_ = ceres::DENSE_SCHUR; // A few poses only
+    options.max_num_iterations_ = max_iteration_count;
+    options.max_solver_time_ = max_solver_time;
+    sfm::Bundle_Adjustment_Ceres bundle_adjustment(options);
+    if (!bundle_adjustment.Adjust(window,
+          sfm::Optimize_Options(
+            cameras::Intrinsic_Parameter_Type::NONE,
+            sfm::Extrinsic_Parameter_Type::ADJUST_ALL,
+            sfm::Structure_Parameter_Type::ADJUST_ALL)))
+      return false;
+
+    // Fix the gauge: map the refined poses A & B back to their input position & distance
+    const geometry::Pose3 & refinedA = window.poses.at(idA);
+    const double refined_baseline =
+      (window.poses.at(idB).center() - refinedA.center()).norm();
+    if (refined_baseline < std::numeric_limits<double>::epsilon())
+      return false;
+    const double scale = (poseB.center() - poseA.center()).norm() / refined_baseline;
+    const Mat3 R = poseA.rotation().transpose() * refinedA.rotation();
+    const geometry::Similarity3 sim(
+      geometry::Pose3(R, refinedA.center() - R.transpose() * poseA.center() / scale),
+      scale);
+    sfm::ApplySimilarity(sim, window);
+    return true;
+  }
+
+private:
+
+  void Run()
+  {
+    for (;;)
+    {
+      std::unique_ptr<sfm::SfM_Data> window;
+      std::unique_ptr<Result> result(new Result);
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [&]{ return bStop_ || pending_; });
+        if (bStop_)
+          return;
+        window = std::move(pending_);
+        result->generation = pending_generation_;
+        bRunning_ = true;
+      }
+
+      system::Timer timer;
+      result->bSuccess = Adjust(*window, max_iteration_count_, max_solver_time_);
+      result->elapsed_ms = timer.elapsedMs();
+      result->window = std::move(*window);
+
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        result_ = std::move(result);
+        bRunning_ = false;
+        ++run_count_;
+      }
+      condition_.notify_all();
+    }
+  }
+
+  const int max_iteration_count_;
+  const double max_solver_time_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  std::unique_ptr<sfm::SfM_Data> pending_;
+  uint32_t pending_generation_ = 0;
+  std::unique_ptr<Result> result_;
+  bool bRunning_ = false;
+  bool bStop_ = false;
+  size_t run_count_ = 0;
+  size_t coalesced_count_ = 0;
+  std::thread thread_;
+};
+
+} // namespace VO
+} // namespace openMVG
+
+#endif // SLIDING_WINDOW_BA_VO_HPP
@@ -0,0 +1,438 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef TRACKER_KLT_VO_HPP
+#define TRACKER_KLT_VO_HPP
+
+#include "openMVG/features/feature.hpp"
+#include "openMVG/image/image_container.hpp"
+#include "openMVG/numeric/eigen_alias_definition.hpp"
+#include <software/VO/Abstract_Tracker.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace openMVG  {
+namespace VO  {
+
+// Pyramidal Lucas-Kanade tracker implemented with the openMVG image containers:
+//  - The pyramid (intensity and gradients) of the last frame is kept in a ring
+//    buffer of two pyramids. The pyramid of a new frame replaces the oldest one,
+//    so the buffers are allocated only once for a given image size.
+//  - The patches are interpolated row by row on contiguous memory and the
+//    normal equations are accumulated with Eigen arrays (vectorized), the patch
+//    buffers live on the stack: tracking allocates nothing in steady state.
+//  - New points are the best Shi-Tomasi corners of a grid of cells (computed
+//    from the gradients of the last tracked frame).
+struct Tracker_KLT : public Abstract_Tracker
+{
+  static const int kMaxWindowSize = 31;
+
+  struct Pyramid_Level
+  {
+    image::Image<float> ima, gx, gy;
+  };
+  using Pyramid = std::vector<Pyramid_Level>;
+
+  explicit Tracker_KLT
+  (
+    const int level_count = 3,
+    const int half_window_size = 7,
+    const int max_iteration_count = 20,
+    const float epsilon = 0.01f,   // Displacement update stop criterion (pixel)
+    const float max_residual = 20.f // Max mean absolute intensity difference
+  )
+  : level_count_(std::max(level_count, 1)),
+    half_window_size_(std::min(std::max(half_window_size, 1), (kMaxWindowSize - 1) / 2)),
+    max_iteration_count_(max_iteration_count),
+    epsilon_(epsilon),
+    max_residual_(max_residual),
+    current_(0),
+    frame_count_(0),
+    source_(nullptr)
+  {
+  }
+
+  /// Try to track current point set in the provided image
+  /// return false when tracking failed (=> to send frame to relocalization)
+  bool track
+  (
+    const image::Image<unsigned char> & ima,
+    const std::vector<features::PointFeature> & pt_to_track,
+    std::vector<features::PointFeature> & pt_tracked,
+    std::vector<bool> & status
+  ) override
+  {
+    // The pyramid of the previous frame is kept, the oldest one is recycled
+    const Pyramid & prev = pyramids_[current_];
+    Pyramid & next = pyramids_[1 - current_];
+    BuildPyramid(ima, next);
+    source_ = ima.data();
+
+    pt_tracked.resize(pt_to_track.size());
+    // The status are written in a byte buffer by the threads (std::vector<bool>
+    // packs its values in shared words), then copied in status
+    tracked_.resize(pt_to_track.size());
+    if (frame_count_ > 0 && !pt_to_track.empty() && prev.size() == next.size()
+        && prev[0].ima.Width() == next[0].ima.Width()
+        && prev[0].ima.Height() == next[0].ima.Height())
+    {
+      #ifdef OPENMVG_USE_OPENMP
+      #pragma omp parallel for schedule(static)
+      #endif
+      for (int i = 0; i < static_cast<int>(pt_to_track.size()); ++i)
+      {
+        Vec2f pos;
+        tracked_[i] = TrackPoint(prev, next, pt_to_track[i].coords(), pos);
+        pt_tracked[i].coords() = pos;
+      }
+    }
+    else
+    {
+      std::fill(tracked_.begin(), tracked_.end(), 0);
+    }
+    status.assign(tracked_.begin(), tracked_.end());
+    current_ = 1 - current_;
+    ++frame_count_;
+
+    const size_t tracked_point_count = std::accumulate(tracked_.begin(), tracked_.end(), size_t(0));
+    return (tracked_point_count != 0);
+  }
+
+  // suggest new feature point for tracking (count point are kept)
+  bool detect
+  (
+    const image::Image<unsigned char> & ima,
+    std::vector<features::PointFeature> & pt_to_track,
+    const size_t count
+  ) const override
+  {
+    if (count == 0)
+      return false;
+
+    // Use the gradients of the last tracked frame if ima is this frame
+    const Pyramid_Level * level = nullptr;
+    Pyramid_Level detect_level;
+    if (frame_count_ > 0 && source_ == ima.data()
+        && pyramids_[current_][0].ima.Width() == ima.Width()
+        && pyramids_[current_][0].ima.Height() == ima.Height())
+    {
+      level = &pyramids_[current_][0];
+    }
+    else
+    {
+      detect_level.ima = ima.GetMat().cast<float>();
+      detect_level.gx.resize(ima.Width(), ima.Height(), false);
+      detect_level.gy.resize(ima.Width(), ima.Height(), false);
+      ComputeGradients(detect_level);
+      level = &detect_level;
+    }
+
+    ComputeMinEigenValues(*level);
+
+    // Keep the best corner of each cell
+    const int w = ima.Width(), h = ima.Height();
+    const int border = half_window_size_ + 2;
+    const int cell_size = std::max(2 * half_window_size_ + 1,
+      static_cast<int>(std::sqrt(static_cast<double>(w) * h / count)));
+    const int cell_count_x = (w + cell_size - 1) / cell_size;
+    const int cell_count_y = (h + cell_size - 1) / cell_size;
+    cells_.assign(cell_count_x * cell_count_y, Corner{0.f, 0, 0});
+    float max_score = 0.f;
+    for (int y = border; y < h - border; ++y)
+    {
+      for (int x = border; x < w - border; ++x)
+      {
+        const float score = score_(y, x);
+        Corner & cell = cells_[(y / cell_size) * cell_count_x + x / cell_size];
+        if (score > cell.score)
+          cell = Corner{score, x, y};
+        max_score = std::max(max_score, score);
+      }
+    }
+
+    // Keep the count strongest corners (weak corners are rejected)
+    const auto end = std::remove_if(cells_.begin(), cells_.end(),
+      [&](const Corner & corner) { return corner.score <= 0.01f * max_score; });
+    const size_t kept_count = std::min(count, static_cast<size_t>(end - cells_.begin()));
+    std::partial_sort(cells_.begin(), cells_.begin() + kept_count, end,
+      [](const Corner & a, const Corner & b) { return a.score > b.score; });
+
+    pt_to_track.resize(kept_count);
+    for (size_t i = 0; i < kept_count; ++i)
+      pt_to_track[i] = features::PointFeature(cells_[i].x, cells_[i].y);
+    return kept_count != 0;
+  }
+
+private:
+
+  struct Corner
+  {
+    float score;
+    int x, y;
+  };
+
+  // Patch buffers (on the stack)
+  using Patch = Eigen::Array<float, Eigen::Dynamic, 1, 0, kMaxWindowSize * kMaxWindowSize, 1>;
+
+  void BuildPyramid
+  (
+    const image::Image<unsigned char> & ima,
+    Pyramid & pyramid
+  )
+  {
+    // Do not create levels smaller than a patch
+    int level_count = 1;
+    while (level_count < level_count_
+           && (ima.Width() >> level_count) > 2 * half_window_size_ + 2
+           && (ima.Height() >> level_count) > 2 * half_window_size_ + 2)
+      ++level_count;
+    pyramid.resize(level_count);
+
+    for (int l = 0; l < level_count; ++l)
+    {
+      Pyramid_Level & level = pyramid[l];
+      const int w = ima.Width() >> l, h = ima.Height() >> l;
+      if (level.ima.Width() != w || level.ima.Height() != h)
+      {
+        level.ima.resize(w, h, false);
+        level.gx.resize(w, h, false);
+        level.gy.resize(w, h, false);
+      }
+      if (l == 0)
+        level.ima = ima.GetMat().cast<float>();
+      else
+        Downsample(pyramid[l - 1].ima, level.ima);
+      ComputeGradients(level);
+    }
+  }
+
+  // Gaussian [1 4 6 4 1]/16 smoothing and decimation by 2
+  void Downsample
+  (
+    const image::Image<float> & src,
+    image::Image<float> & out
+  )
+  {
+    const int w = out.Width(), h = out.Height();
+    const int src_w = src.Width(), src_h = src.Height();
+    if (tmp_.Width() != w || tmp_.Height() != src_h)
+      tmp_.resize(w, src_h, false);
+
+    static const float kernel[5] = {1.f / 16.f, 4.f / 16.f, 6.f / 16.f, 4.f / 16.f, 1.f / 16.f};
+    // Horizontal pass (borders are clamped)
+    for (int y = 0; y < src_h; ++y)
+    {
+      const float * row = src.data() + y * src_w;
+      float * tmp_row = tmp_.data() + y * w;
+      for (int x = 0; x < w; ++x)
+      {
+        float sum = 0.f;
+        for (int k = -2; k <= 2; ++k)
+          sum += kernel[k + 2] * row[std::min(std::max(2 * x + k, 0), src_w - 1)];
+        tmp_row[x] = sum;
+      }
+    }
+    // Vertical pass (on whole rows)
+    for (int y = 0; y < h; ++y)
+    {
+      Eigen::Map<Eigen::ArrayXf> out_row(out.data() + y * w, w);
+      out_row.setZero();
+      for (int k = -2; k <= 2; ++k)
+      {
+        const int src_y = std::min(std::max(2 * y + k, 0), src_h - 1);
+        out_row += kernel[k + 2] * Eigen::Map<const Eigen::ArrayXf>(tmp_.data() + src_y * w, w);
+      }
+    }
+  }
+
+  // Scharr derivatives (the borders are set to 0)
+  static void ComputeGradients(Pyramid_Level & level)
+  {
+    const int w = level.ima.Width(), h = level.ima.Height();
+    level.gx.fill(0.f);
+    level.gy.fill(0.f);
+    if (w < 3 || h < 3)
+      return;
+    const auto I = level.ima.GetMat().array();
+    level.gx.block(1, 1, h - 2, w - 2).array() =
+      (3.f * (I.block(0, 2, h - 2, w - 2) - I.block(0, 0, h - 2, w - 2))
+      + 10.f * (I.block(1, 2, h - 2, w - 2) - I.block(1, 0, h - 2, w - 2))
+      + 3.f * (I.block(2, 2, h - 2, w - 2) - I.block(2, 0, h - 2, w - 2))) / 32.f;
+    level.gy.block(1, 1, h - 2, w - 2).array() =
+      (3.f * (I.block(2, 0, h - 2, w - 2) - I.block(0, 0, h - 2, w - 2))
+      + 10.f * (I.block(2, 1, h - 2, w - 2) - I.block(0, 1, h - 2, w - 2))
+      + 3.f * (I.block(2, 2, h - 2, w - 2) - I.block(0, 2, h - 2, w - 2))) / 32.f;
+  }
+
+  // Minimal eigen value of the 3x3 structure tensor of each pixel (the borders are set to 0)
+  void ComputeMinEigenValues(const Pyramid_Level & level) const
+  {
+    const int w = level.gx.Width(), h = level.gx.Height();
+    if (score_.Width() != w || score_.Height() != h)
+    {
+      score_.resize(w, h, false);
+      for (image::Image<float> & tensor : tensor_)
+        tensor.resize(w - 2, h - 2, false);
+    }
+    score_.fill(0.f);
+    if (w < 3 || h < 3)
+      return;
+    auto a = tensor_[0].array();
+    auto b = tensor_[1].array();
+    auto c = tensor_[2].array();
+    a.setZero();
+    b.setZero();
+    c.setZero();
+    for (int dy = 0; dy < 3; ++dy)
+    {
+      for (int dx = 0; dx < 3; ++dx)
+      {
+        const auto gx = level.gx.block(dy, dx, h - 2, w - 2).array();
+        const auto gy = level.gy.block(dy, dx, h - 2, w - 2).array();
+        a += gx.square();
+        b += gx * gy;
+        c += gy.square();
+      }
+    }
+    score_.block(1, 1, h - 2, w - 2).array() =
+      0.5f * (a + c - ((a - c).square() + 4.f * b.square()).sqrt());
+  }
+
+  // Tell if the bilinear interpolation of a patch centered on (x,y) is inside the image
+  bool IsPatchInside(const image::Image<float> & ima, const float x, const float y) const
+  {
+    const float x0 = x - half_window_size_, y0 = y - half_window_size_;
+    return x0 >= 0.f && y0 >= 0.f
+      && x0 + 2 * half_window_size_ + 1 < ima.Width() - 1
+      && y0 + 2 * half_window_size_ + 1 < ima.Height() - 1;
+  }
+
+  // Bilinear interpolation of the patch centered on (x,y) (row by row)
+  void SamplePatch
+  (
+    const image::Image<float> & ima,
+    const float x,
+    const float y,
+    Patch & patch
+  ) const
+  {
+    const int size = 2 * half_window_size_ + 1;
+    const float xf = x - half_window_size_, yf = y - half_window_size_;
+    const int x0 = static_cast<int>(std::floor(xf)), y0 = static_cast<int>(std::floor(yf));
+    const float ax = xf - x0, ay = yf - y0;
+    const float
+      w00 = (1.f - ax) * (1.f - ay), w01 = ax * (1.f - ay),
+      w10 = (1.f - ax) * ay, w11 = ax * ay;
+    const int stride = ima.Width();
+    for (int r = 0; r < size; ++r)
+    {
+      const float * row0 = ima.data() + (y0 + r) * stride + x0;
+      const float * row1 = row0 + stride;
+      patch.segment(r * size, size) =
+          w00 * Eigen::Map<const Eigen::ArrayXf>(row0, size)
+        + w01 * Eigen::Map<const Eigen::ArrayXf>(row0 + 1, size)
+        + w10 * Eigen::Map<const Eigen::ArrayXf>(row1, size)
+        + w11 * Eigen::Map<const Eigen::ArrayXf>(row1 + 1, size);
+    }
+  }
+
+  // Coarse to fine tracking of a point from the prev pyramid to the next one
+  bool TrackPoint
+  (
+    const Pyramid & prev,
+    const Pyramid & next,
+    const Vec2f & pt,
+    Vec2f & tracked
+  ) const
+  {
+    const int size = 2 * half_window_size_ + 1;
+    const int area = size * size;
+    Patch T(area), Tx(area), Ty(area), J(area);
+
+    Vec2f d = Vec2f::Zero(); // displacement at the current level
+    float residual = std::numeric_limits<float>::max();
+    for (int l = static_cast<int>(prev.size()) - 1; l >= 0; --l)
+    {
+      const Vec2f p = pt / static_cast<float>(1 << l);
+      const bool bTemplate = IsPatchInside(prev[l].ima, p(0), p(1));
+      if (!bTemplate && l == 0)
+        return false;
+      if (bTemplate)
+      {
+        SamplePatch(prev[l].ima, p(0), p(1), T);
+        SamplePatch(prev[l].gx, p(0), p(1), Tx);
+        SamplePatch(prev[l].gy, p(0), p(1), Ty);
+        const float gxx = (Tx * Tx).sum(), gxy = (Tx * Ty).sum(), gyy = (Ty * Ty).sum();
+        const float det = gxx * gyy - gxy * gxy;
+        // Reject the textureless patches (small minimal eigen value)
+        const float min_eigen = 0.5f * (gxx + gyy - std::sqrt((gxx - gyy) * (gxx - gyy) + 4.f * gxy * gxy));
+        if (min_eigen < 1e-3f * area || det < std::numeric_limits<float>::epsilon())
+        {
+          if (l == 0)
+            return false;
+        }
+        else
+        {
+          for (int iter = 0; iter < max_iteration_count_; ++iter)
+          {
+            const Vec2f q = p + d;
+            if (!IsPatchInside(next[l].ima, q(0), q(1)))
+            {
+              if (l == 0)
+                return false;
+              break;
+            }
+            SamplePatch(next[l].ima, q(0), q(1), J);
+            J -= T;
+            const float bx = (J * Tx).sum(), by = (J * Ty).sum();
+            const Vec2f delta(
+              (gxy * by - gyy * bx) / det,
+              (gxy * bx - gxx * by) / det);
+            d += delta;
+            if (l == 0)
+              residual = J.abs().mean();
+            if (delta.squaredNorm() < epsilon_ * epsilon_)
+              break;
+          }
+        }
+      }
+      if (l > 0)
+        d *= 2.f;
+    }
+    tracked = pt + d;
+    return residual < max_residual_;
+  }
+
+  const int level_count_;
+  const int half_window_size_;
+  const int max_iteration_count_;
+  const float epsilon_;
+  const float max_residual_;
+
+  // Ring buffer of pyramids: pyramids_[current_] is the last tracked frame
+  std::array<Pyramid, 2> pyramids_;
+  int current_;
+  size_t frame_count_;
+  const unsigned char * source_; // Pixels of the last tracked frame
+  image::Image<float> tmp_;      // Downsampling buffer
+  std::vector<unsigned char> tracked_; // Tracking status of the points
+  // Detection buffers
+  mutable image::Image<float> score_;
+  mutable std::array<image::Image<float>, 3> tensor_;
+  mutable std::vector<Corner> cells_;
+};
+
+} // namespace VO
+} // namespace openMVG
+
+#endif // TRACKER_KLT_VO_HPP
@@ -6,12 +6,14 @@
 // License, v. 2.0. If a copy of the MPL was not distributed with this
 // file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
+#include "openMVG/cameras/Camera_Pinhole.hpp"
 #include "openMVG/image/image_io.hpp"
 #include "openMVG/features/feature.hpp"
 
 #include "software/VO/CGlWindow.hpp"
 #include "software/VO/Monocular_VO.hpp"
 #include "software/VO/Tracker.hpp"
+#include "software/VO/Tracker_klt.hpp"
 #if defined HAVE_OPENCV
 #include "software/VO/Tracker_opencv_klt.hpp"
 #endif
@@ -24,6 +26,9 @@
 
 #include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
 
 using namespace openMVG;
 
@@ -38,12 +43,18 @@ int main(int argc, char **argv)
   std::string sOutFile = "";
   unsigned int uTracker = 0;
   unsigned int uTrackerPointCount = 1500;
+  double dFocal = -1.0;
+  VO::VO_Options vo_options;
 
   cmd.add( make_option('i', sImaDirectory, "imadir") );
   cmd.add( make_option('t', uTracker, "tracker") );
   cmd.add( make_option('o', sOutFile, "output_file") );
   cmd.add( make_option('p', uTrackerPointCount, "point_count") );
   cmd.add( make_switch('d', "disable_tracking_display") );
+  cmd.add( make_option('f', dFocal, "focal") );
+  cmd.add( make_option('w', vo_options.windowSize_, "window_size") );
+  cmd.add( make_switch('b', "disable_local_ba") );
+  cmd.add( make_switch('k', "keep_landmarks") );
 
   try {
     if (argc == 1) throw std::string("Invalid command line parameter.");
@@ -57,8 +68,14 @@ int main(int argc, char **argv)
 #if defined HAVE_OPENCV
     << "\t 1: Feature tracking based tracking; Fast + KLT pyramidal tracking. \n"
 #endif
+    << "\t 2: Feature tracking based tracking; Shi-Tomasi + KLT pyramidal tracking (openMVG). \n"
     << "[-p|--point_count] Number of points to track. (default: " << uTrackerPointCount << ")\n"
     << "[-d|--disable_tracking_display] Disable tracking display \n"
+    << "[-f|--focal] Focal length in pixels (the principal point is the image center).\n"
+    << "\t If set, the keyframe poses are estimated and refined in a sliding window.\n"
+    << "[-w|--window_size] Number of keyframes in the sliding window. (default: " << vo_options.windowSize_ << ")\n"
+    << "[-b|--disable_local_ba] Disable the bundle adjustment of the keyframe window \n"
+    << "[-k|--keep_landmarks] Keep all the landmark observations (unbounded memory) \n"
     << std::endl;
 
     std::cerr << s << std::endl;
@@ -71,7 +88,11 @@ int main(int argc, char **argv)
             << "--output_file " << sOutFile << std::endl
             << "--point_count " << uTrackerPointCount << std::endl
             << "--tracker " << uTracker << std::endl
-            << "--disable_tracking_display " << static_cast<int>(cmd.used('d')) << std::endl;
+            << "--disable_tracking_display " << static_cast<int>(cmd.used('d')) << std::endl
+            << "--focal " << dFocal << std::endl
+            << "--window_size " << vo_options.windowSize_ << std::endl
+            << "--disable_local_ba " << static_cast<int>(cmd.used('b')) << std::endl
+            << "--keep_landmarks " << static_cast<int>(cmd.used('k')) << std::endl;
 
   if (sImaDirectory.empty() || !stlplus::is_folder(sImaDirectory))
   {
@@ -91,6 +112,8 @@ int main(int argc, char **argv)
   }
 
   const bool disable_tracking_display = cmd.used('d');
+  vo_options.bLocalBA_ = !cmd.used('b');
+  vo_options.bCullLandmarks_ = !cmd.used('k');
 
   //--
 
@@ -136,6 +159,9 @@ int main(int argc, char **argv)
       tracker_ptr.reset(new Tracker_opencv_KLT);
     break;
 #endif
+    case 2:
+      tracker_ptr.reset(new Tracker_KLT);
+    break;
     default:
     std::cerr << "Unknow tracking method" << std::endl;
     return EXIT_FAILURE;
@@ -146,8 +172,22 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
+  // Initialize the camera model (if the focal length is known)
+  std::shared_ptr<cameras::IntrinsicBase> camera;
+  if (dFocal > 0.0 && !vec_image.empty())
+  {
+    image::ImageHeader imgHeader;
+    if (!image::ReadImageHeader(stlplus::create_filespec(sImaDirectory, vec_image.front()).c_str(), &imgHeader))
+    {
+      std::cerr << "Cannot read the image size of the first frame" << std::endl;
+      return EXIT_FAILURE;
+    }
+    camera = std::make_shared<cameras::Pinhole_Intrinsic>(
+      imgHeader.width, imgHeader.height, dFocal, imgHeader.width / 2.0, imgHeader.height / 2.0);
+  }
+
   // Initialize the monocular tracking framework
-  VO_Monocular monocular_vo(tracker_ptr.get(), uTrackerPointCount);
+  VO_Monocular monocular_vo(tracker_ptr.get(), uTrackerPointCount, camera, vo_options);
 
   size_t frameId = 0;
   for (std::vector<std::string>::const_iterator iterFile = vec_image.begin();
@@ -203,14 +243,14 @@ int main(int argc, char **argv)
 
       if (!disable_tracking_display)
       {
-        for (size_t idx = 0; idx < monocular_vo.landmark_.size(); ++idx)
+        for (const auto & landmark_it : monocular_vo.landmark_)
         {
           if (std::find(monocular_vo.trackedLandmarkIds_.cbegin(),
-                        monocular_vo.trackedLandmarkIds_.cend(), idx)
+                        monocular_vo.trackedLandmarkIds_.cend(), landmark_it.first)
               == monocular_vo.trackedLandmarkIds_.cend())
             continue;
 
-          const Landmark & landmark = monocular_vo.landmark_[idx];
+          const Landmark & landmark = landmark_it.second;
           if (landmark.obs_.back().frameId_ == frameId && landmark.obs_.size() > 1 )
           {
             const std::deque<Measurement> & obs = landmark.obs_;
@@ -263,11 +303,51 @@ int main(int argc, char **argv)
     }
   }
 
-  openMVG::sfm::SfM_Data sfm_data;
-  ConvertVOLandmarkToSfMDataLandmark(monocular_vo.landmark_, sfm_data.structure);
-  std::cout << "Found SFM #landmarks: " << sfm_data.structure.size() << std::endl;
-  if (!Save(sfm_data, sOutFile, openMVG::sfm::ESfM_Data(openMVG::sfm::ALL)))
-    return EXIT_FAILURE;
+  monocular_vo.flush();
+  std::cout << monocular_vo.statistics_ << std::endl;
+
+  if (camera)
+  {
+    // Export the keyframe poses and the triangulated landmarks of each map
+    // (the map is restarted if the tracking is lost: each map has its own scale,
+    //  the maps after the first one are saved to <output_file>_<map index>)
+    std::vector<VO::Map_Segment> segments = monocular_vo.mapSegments_;
+    segments.push_back(monocular_vo.currentMapSegment());
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+      const VO::Map_Segment & segment = segments[i];
+      if (i > 0 && segment.keyframePoses_.empty())
+        continue;
+      openMVG::sfm::SfM_Data sfm_data;
+      sfm_data.s_root_path = sImaDirectory;
+      sfm_data.intrinsics[0] = camera;
+      for (const auto & pose_it : segment.keyframePoses_)
+      {
+        sfm_data.views[pose_it.first] = std::make_shared<sfm::View>(
+          vec_image[pose_it.first], pose_it.first, 0, pose_it.first, camera->w(), camera->h());
+        sfm_data.poses[pose_it.first] = pose_it.second;
+      }
+      sfm_data.structure = segment.landmarks_;
+
+      const std::string sSegmentFile = (i == 0) ? sOutFile :
+        stlplus::create_filespec(
+          stlplus::folder_part(sOutFile),
+          stlplus::basename_part(sOutFile) + "_" + std::to_string(i),
+          stlplus::extension_part(sOutFile));
+      std::cout << "Map " << i << ": #poses: " << sfm_data.poses.size()
+        << ", #landmarks: " << sfm_data.structure.size() << std::endl;
+      if (!Save(sfm_data, sSegmentFile, openMVG::sfm::ESfM_Data(openMVG::sfm::ALL)))
+        return EXIT_FAILURE;
+    }
+  }
+  else
+  {
+    openMVG::sfm::SfM_Data sfm_data;
+    ConvertVOLandmarkToSfMDataLandmark(monocular_vo.landmark_, sfm_data.structure);
+    std::cout << "Found SFM #landmarks: " << sfm_data.structure.size() << std::endl;
+    if (!Save(sfm_data, sOutFile, openMVG::sfm::ESfM_Data(openMVG::sfm::ALL)))
+      return EXIT_FAILURE;
+  }
 
   glfwTerminate();
   return 0;
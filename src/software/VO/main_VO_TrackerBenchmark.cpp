@@ -0,0 +1,268 @@
+// This file is part of OpenMVG, an Open Multiple View Geometry C++ library.
+
+// Copyright (c) 2020 Pierre MOULON.
+
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include "openMVG/features/feature.hpp"
+#include "openMVG/image/image_container.hpp"
+#include "openMVG/image/image_filtering.hpp"
+#include "openMVG/image/image_io.hpp"
+#include "openMVG/system/timer.hpp"
+
+#include "software/VO/Tracker.hpp"
+#include "software/VO/Tracker_klt.hpp"
+#if defined HAVE_OPENCV
+#include "software/VO/Tracker_opencv_klt.hpp"
+#endif
+
+#include "third_party/cmdLine/cmdLine.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace openMVG;
+using namespace openMVG::VO;
+
+// A synthetic sequence: a camera moving (similarity motion) over a texture
+struct Synthetic_Sequence
+{
+  std::vector<image::Image<unsigned char>> frames;
+  std::vector<Mat3> frame_to_texture; // Pixel mapping (affine) of each frame in the texture
+
+  // Position of the pixel x of the frame i in the frame j
+  Vec2 Map(const Vec2 & x, const size_t i, const size_t j) const
+  {
+    return (frame_to_texture[j].inverse() * frame_to_texture[i] * x.homogeneous()).hnormalized();
+  }
+};
+
+// A blob texture made of smoothed noise at two scales
+image::Image<float> MakeTexture(const int width, const int height)
+{
+  std::mt19937 random_generator(0);
+  std::uniform_real_distribution<float> distribution(0.f, 1.f);
+  image::Image<float> noise(width, height), fine, coarse;
+  for (int i = 0; i < noise.size(); ++i)
+    noise.data()[i] = distribution(random_generator);
+  ImageGaussianFilter(noise, 1.5, fine);
+  ImageGaussianFilter(noise, 4.0, coarse);
+  image::Image<float> texture(fine.GetMat() + 2.f * coarse.GetMat());
+  const float min_value = texture.minCoeff(), max_value = texture.maxCoeff();
+  texture = (texture.GetMat().array() - min_value) * (255.f / (max_value - min_value));
+  return texture;
+}
+
+Synthetic_Sequence MakeSequence
+(
+  const image::Image<float> & texture,
+  const int width,
+  const int height,
+  const int frame_count
+)
+{
+  // The translation amplitude keeps the frames inside the texture
+  const double amplitude_x = std::max(0.0, (texture.Width() - 1.3 * width) / 2.0);
+  const double amplitude_y = std::max(0.0, (texture.Height() - 1.3 * height) / 2.0);
+
+  std::mt19937 random_generator(0);
+  std::normal_distribution<float> noise(0.f, 1.f);
+
+  Synthetic_Sequence sequence;
+  sequence.frames.resize(frame_count);
+  sequence.frame_to_texture.resize(frame_count);
+  for (int k = 0; k < frame_count; ++k)
+  {
+    const double angle = 0.15 * std::sin(2.0 * M_PI * k / 170.0);
+    const double scale = 1.0 + 0.1 * std::sin(2.0 * M_PI * k / 230.0);
+    const Vec2 center(
+      texture.Width() / 2.0 + amplitude_x * std::sin(2.0 * M_PI * k / 200.0),
+      texture.Height() / 2.0 + amplitude_y * std::sin(2.0 * M_PI * k / 130.0));
+    Mat3 & A = sequence.frame_to_texture[k];
+    A.setIdentity();
+    A.topLeftCorner<2, 2>() = scale * Eigen::Rotation2Dd(angle).toRotationMatrix();
+    A.block<2, 1>(0, 2) = center - A.topLeftCorner<2, 2>() * Vec2(width / 2.0, height / 2.0);
+
+    image::Image<unsigned char> & frame = sequence.frames[k];
+    frame.resize(width, height);
+    for (int y = 0; y < height; ++y)
+    {
+      for (int x = 0; x < width; ++x)
+      {
+        const Vec2 X = A.topLeftCorner<2, 2>() * Vec2(x, y) + A.block<2, 1>(0, 2);
+        const int x0 = static_cast<int>(std::floor(X(0))), y0 = static_cast<int>(std::floor(X(1)));
+        float value = 0.f;
+        if (x0 >= 0 && y0 >= 0 && x0 + 1 < texture.Width() && y0 + 1 < texture.Height())
+        {
+          const float ax = X(0) - x0, ay = X(1) - y0;
+          value =
+            (1.f - ax) * (1.f - ay) * texture(y0, x0) + ax * (1.f - ay) * texture(y0, x0 + 1)
+            + (1.f - ax) * ay * texture(y0 + 1, x0) + ax * ay * texture(y0 + 1, x0 + 1);
+        }
+        value += noise(random_generator);
+        frame(y, x) = static_cast<unsigned char>(std::min(std::max(value, 0.f), 255.f));
+      }
+    }
+  }
+  return sequence;
+}
+
+// Track the sequence (the lost points are replaced as in the VO) and
+// compare the tracked points to the known motion
+void Benchmark
+(
+  const std::string & name,
+  Abstract_Tracker & tracker,
+  const Synthetic_Sequence & sequence,
+  const size_t point_count
+)
+{
+  const double kOutlierThreshold = 2.0; // pixels
+
+  std::vector<features::PointFeature> pt_to_track, pt_tracked, new_pt;
+  std::vector<bool> status;
+  double track_time = 0.0, detect_time = 0.0, error_sum = 0.0;
+  size_t to_track_count = 0, tracked_count = 0, inlier_count = 0;
+
+  system::Timer timer;
+  tracker.track(sequence.frames[0], pt_to_track, pt_tracked, status);
+  tracker.detect(sequence.frames[0], pt_to_track, point_count);
+  track_time += timer.elapsedMs();
+
+  for (size_t k = 1; k < sequence.frames.size(); ++k)
+  {
+    pt_tracked.resize(pt_to_track.size());
+    status.resize(pt_to_track.size());
+    timer.reset();
+    tracker.track(sequence.frames[k], pt_to_track, pt_tracked, status);
+    track_time += timer.elapsedMs();
+
+    // Keep the tracked points
+    size_t kept_count = 0;
+    for (size_t i = 0; i < pt_to_track.size(); ++i)
+    {
+      if (!status[i])
+        continue;
+      const double error = (sequence.Map(pt_to_track[i].coords().cast<double>(), k - 1, k)
+        - pt_tracked[i].coords().cast<double>()).norm();
+      if (error < kOutlierThreshold)
+      {
+        error_sum += error;
+        ++inlier_count;
+      }
+      pt_to_track[kept_count++] = pt_tracked[i];
+    }
+    to_track_count += pt_to_track.size();
+    tracked_count += kept_count;
+    pt_to_track.resize(kept_count);
+
+    // Replace the lost points
+    if (kept_count < point_count)
+    {
+      timer.reset();
+      if (tracker.detect(sequence.frames[k], new_pt, point_count - kept_count))
+        pt_to_track.insert(pt_to_track.end(), new_pt.begin(), new_pt.end());
+      detect_time += timer.elapsedMs();
+    }
+  }
+
+  const double frame_count = sequence.frames.size();
+  std::cout
+    << std::setw(14) << std::left << name
+    << std::setw(12) << std::fixed << std::setprecision(2) << track_time / frame_count
+    << std::setw(12) << detect_time / frame_count
+    << std::setw(10) << std::setprecision(1) << 1000.0 * frame_count / (track_time + detect_time)
+    << std::setw(12) << std::setprecision(3) << tracked_count / std::max(1.0, static_cast<double>(to_track_count))
+    << std::setw(12) << inlier_count / std::max(1.0, static_cast<double>(tracked_count))
+    << std::setw(12) << error_sum / std::max(1.0, static_cast<double>(inlier_count))
+    << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  CmdLine cmd;
+
+  std::string sTexture = "";
+  int frame_count = 300;
+  int point_count = 1000;
+  int width = 640, height = 480;
+
+  cmd.add( make_option('i', sTexture, "texture") );
+  cmd.add( make_option('n', frame_count, "frame_count") );
+  cmd.add( make_option('p', point_count, "point_count") );
+  cmd.add( make_option('x', width, "width") );
+  cmd.add( make_option('y', height, "height") );
+
+  try {
+    cmd.process(argc, argv);
+    if (frame_count < 2 || point_count < 1 || width < 64 || height < 64)
+      throw std::string("Invalid frame count, point count or frame size");
+  } catch (const std::string& s) {
+    std::cerr << "Usage: " << argv[0] << '\n'
+      << "[-i|--texture] image seen by the synthetic camera (default: procedural texture)\n"
+      << "[-n|--frame_count] number of frames (default: " << frame_count << ")\n"
+      << "[-p|--point_count] number of points to track (default: " << point_count << ")\n"
+      << "[-x|--width] frame width (default: " << width << ")\n"
+      << "[-y|--height] frame height (default: " << height << ")\n"
+      << std::endl;
+
+    std::cerr << s << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  image::Image<float> texture;
+  if (!sTexture.empty())
+  {
+    image::Image<unsigned char> image;
+    if (!ReadImage(sTexture.c_str(), &image))
+    {
+      std::cerr << "Cannot read the texture image: " << sTexture << std::endl;
+      return EXIT_FAILURE;
+    }
+    texture = image.GetMat().cast<float>();
+  }
+  else
+  {
+    texture = MakeTexture(2 * width, 2 * height);
+  }
+
+  const Synthetic_Sequence sequence = MakeSequence(texture, width, height, frame_count);
+
+  std::cout
+    << "Frames: " << frame_count << " (" << width << "x" << height << ")"
+    << ", points to track: " << point_count << "\n\n"
+    << std::setw(14) << std::left << "tracker"
+    << std::setw(12) << "track (ms)" << std::setw(12) << "detect (ms)"
+    << std::setw(10) << "fps" << std::setw(12) << "tracked"
+    << std::setw(12) << "inliers" << std::setw(12) << "error (px)" << std::endl;
+
+  {
+    Tracker_fast_dipole tracker;
+    Benchmark("FAST+dipole", tracker, sequence, point_count);
+  }
+  {
+    Tracker_KLT tracker;
+    Benchmark("KLT", tracker, sequence, point_count);
+  }
+#if defined HAVE_OPENCV
+  {
+    Tracker_opencv_KLT tracker;
+    Benchmark("OpenCV KLT", tracker, sequence, point_count);
+  }
+#endif
+
+  std::cout << "\n"
+    << "tracked: ratio of the points to track that are tracked\n"
+    << "inliers: ratio of the tracked points closer than 2 pixels to the true position\n"
+    << "error (px): mean error of the inliers" << std::endl;
+
+  return EXIT_SUCCESS;
+}
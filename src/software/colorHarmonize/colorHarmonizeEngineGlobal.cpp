@@ -37,7 +37,11 @@
 #include <iomanip>
 #include <iterator>
 #include <algorithm>
+#include <atomic>
 #include <functional>
+#include <future>
+#include <list>
+#include <mutex>
 #include <sstream>
 
 
@@ -52,15 +56,99 @@ using namespace openMVG::sfm;
 using FeatureT = features::SIOPointFeature;
 using featsT = std::vector< FeatureT >;
 
+namespace {
+
+/// Thread safe cache of the decoded images.
+/// Each image is decoded by the first thread that asks for it, the concurrent
+/// requests of the same image wait for this decoding.
+/// At most max_size images are kept, the least recently used ones are released
+/// first (0: unbounded). The image buffers are borrowed from a pool and given
+/// back once the images are released.
+class Image_Cache
+{
+public:
+  using ImagePtr = std::shared_ptr<const Image<RGBColor>>;
+
+  Image_Cache
+  (
+    const std::vector<std::string> & filenames,
+    const unsigned int max_size
+  ): filenames_(filenames), max_size_(max_size), decoded_count_(0)
+  {}
+
+  /// Return the decoded image (nullptr if the image cannot be read)
+  ImagePtr get(const size_t index)
+  {
+    std::promise<ImagePtr> promise;
+    std::shared_future<ImagePtr> image;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      const auto it = cache_.find(index);
+      if (it != cache_.end())
+      {
+        // Mark the image as the most recently used one
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return it->second->second.get();
+      }
+      image = promise.get_future().share();
+      lru_.emplace_front(index, image);
+      cache_[index] = lru_.begin();
+      while (max_size_ > 0 && lru_.size() > max_size_)
+      {
+        cache_.erase(lru_.back().first);
+        lru_.pop_back();
+      }
+    }
+    // Decode the image outside of the lock
+    Image_Pool<RGBColor> * pool = &pool_;
+    std::shared_ptr<Image<RGBColor>> decoded(new Image<RGBColor>,
+      [pool](Image<RGBColor> * released)
+      {
+        pool->Release(std::move(*released));
+        delete released;
+      });
+    if (!ReadImage(filenames_[index].c_str(), decoded.get(), pool_))
+    {
+      std::cerr << "Unable to read the image: " << filenames_[index] << std::endl;
+      decoded.reset();
+    }
+    ++decoded_count_;
+    promise.set_value(decoded);
+    return image.get();
+  }
+
+  /// Number of image decodings
+  size_t decoded_count() const { return decoded_count_; }
+
+  /// Pool of the image buffers
+  Image_Pool<RGBColor> & pool() { return pool_; }
+
+private:
+  using LRU_List = std::list<std::pair<size_t, std::shared_future<ImagePtr>>>;
+
+  const std::vector<std::string> & filenames_;
+  const unsigned int max_size_;
+  std::atomic<size_t> decoded_count_;
+
+  Image_Pool<RGBColor> pool_; // Must outlive the cached images
+  std::mutex mutex_;
+  LRU_List lru_; // Cached images, most recently used first
+  std::map<size_t, LRU_List::iterator> cache_; // image index -> lru_ entry
+};
+
+} // namespace
+
 ColorHarmonizationEngineGlobal::ColorHarmonizationEngineGlobal(
   const std::string & sSfM_Data_Filename,
   const std::string & sMatchesPath,
   const std::string & sMatchesFile,
   const std::string & sOutDirectory,
   const int selectionMethod,
-  const int imgRef):
+  const int imgRef,
+  const unsigned int imageCacheSize):
   _selectionMethod( selectionMethod ),
   _imgRef( imgRef ),
+  _imageCacheSize( imageCacheSize ),
   _sMatchesFile(sMatchesFile),
   _sSfM_Data_Path(sSfM_Data_Filename),
   _sMatchesPath(sMatchesPath),
@@ -94,8 +182,11 @@ bool ColorHarmonizationEngineGlobal::Process()
   // Load data
   //-------------------
 
+  openMVG::system::Timer timer_stage;
+
   if ( !ReadInputData() )
     return false;
+  const double time_loading = timer_stage.elapsed();
   if (_map_Matches.size() == 0 )
   {
     std::cout << std::endl << "Matches file is empty" <<std:: endl;
@@ -195,9 +286,32 @@ bool ColorHarmonizationEngineGlobal::Process()
   std::cout << "\n Remaining cameras after CC filter : \n"
     << map_cameraIndexTocameraNode.size() << " from a total of " << _vec_fileNames.size() << std::endl;
 
-  size_t bin      = 256;
-  double minvalue = 0.0;
-  double maxvalue = 255.0;
+  const size_t bin      = 256;
+  const double minvalue = 0.0;
+  const double maxvalue = 255.0;
+
+  enum EHistogramSelectionMethod
+  {
+      eHistogramHarmonizeFullFrame     = 0,
+      eHistogramHarmonizeMatchedPoints = 1,
+      eHistogramHarmonizeVLDSegment    = 2,
+  };
+
+  timer_stage.reset();
+
+  // The decoded images are shared by the edges (each image is decoded once if
+  // the cache is large enough to keep the images of the concurrently processed edges)
+  Image_Cache image_cache(_vec_fileNames, _imageCacheSize);
+  Image_Pool<unsigned char> mask_pool;
+
+  // Random access to the edges
+  std::vector<matching::PairWiseMatches::const_iterator> vec_edges;
+  vec_edges.reserve(_map_Matches.size());
+  for (matching::PairWiseMatches::const_iterator iter = _map_Matches.begin();
+    iter != _map_Matches.end(); ++iter)
+  {
+    vec_edges.push_back(iter);
+  }
 
   // For each edge computes the selection masks and histograms (for the RGB channels)
   std::vector<relativeColorHistogramEdge> map_relativeHistograms[3];
@@ -205,10 +319,20 @@ bool ColorHarmonizationEngineGlobal::Process()
   map_relativeHistograms[1].resize(_map_Matches.size());
   map_relativeHistograms[2].resize(_map_Matches.size());
 
-  for (size_t i = 0; i < _map_Matches.size(); ++i)
+  std::cout << "\n Compute the selection masks and histograms of the "
+    << vec_edges.size() << " edges" << std::endl;
+  C_Progress_display my_progress_bar_edges( vec_edges.size() );
+  std::atomic<bool> bContinue(true);
+
+#ifdef OPENMVG_USE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int i = 0; i < static_cast<int>(vec_edges.size()); ++i)
   {
-    matching::PairWiseMatches::const_iterator iter = _map_Matches.begin();
-    std::advance(iter, i);
+    if (!bContinue)
+      continue;
+
+    matching::PairWiseMatches::const_iterator iter = vec_edges[i];
 
     const size_t I = iter->first.first;
     const size_t J = iter->first.second;
@@ -216,25 +340,26 @@ bool ColorHarmonizationEngineGlobal::Process()
     const std::vector<IndMatch> & vec_matchesInd = iter->second;
 
     //-- Edges names:
-    std::pair<std::string, std::string> p_imaNames;
-    p_imaNames = make_pair( _vec_fileNames[ I ], _vec_fileNames[ J ] );
-    std::cout << "Current edge : "
-      << stlplus::filename_part(p_imaNames.first) << "\t"
-      << stlplus::filename_part(p_imaNames.second) << std::endl;
+    const std::pair<std::string, std::string> p_imaNames =
+      std::make_pair( _vec_fileNames[ I ], _vec_fileNames[ J ] );
+
+    //-- Decoded images
+    const Image_Cache::ImagePtr imageI = image_cache.get(I);
+    const Image_Cache::ImagePtr imageJ = image_cache.get(J);
+    if (!imageI || !imageJ)
+    {
+      bContinue = false;
+      continue;
+    }
 
     //-- Compute the masks from the data selection:
-    Image< unsigned char > maskI ( _vec_imageSize[ I ].first, _vec_imageSize[ I ].second );
-    Image< unsigned char > maskJ ( _vec_imageSize[ J ].first, _vec_imageSize[ J ].second );
+    Pooled_Image< unsigned char > maskI ( mask_pool, _vec_imageSize[ I ].first, _vec_imageSize[ I ].second );
+    Pooled_Image< unsigned char > maskJ ( mask_pool, _vec_imageSize[ J ].first, _vec_imageSize[ J ].second );
+    maskI.fill( 0 );
+    maskJ.fill( 0 );
 
     switch (_selectionMethod)
     {
-      enum EHistogramSelectionMethod
-      {
-          eHistogramHarmonizeFullFrame     = 0,
-          eHistogramHarmonizeMatchedPoints = 1,
-          eHistogramHarmonizeVLDSegment    = 2,
-      };
-
       case eHistogramHarmonizeFullFrame:
       {
         color_harmonization::commonDataByPair_FullFrame  dataSelector(
@@ -250,8 +375,8 @@ bool ColorHarmonizationEngineGlobal::Process()
           p_imaNames.first,
           p_imaNames.second,
           vec_matchesInd,
-          _map_feats[ I ],
-          _map_feats[ J ],
+          _map_feats.at( I ),
+          _map_feats.at( J ),
           circleSize);
         dataSelector.computeMask( maskI, maskJ );
       }
@@ -262,15 +387,18 @@ bool ColorHarmonizationEngineGlobal::Process()
           p_imaNames.first,
           p_imaNames.second,
           vec_matchesInd,
-          _map_feats[ I ],
-          _map_feats[ J ]);
+          _map_feats.at( I ),
+          _map_feats.at( J ),
+          imageI.get(),
+          imageJ.get());
 
         dataSelector.computeMask( maskI, maskJ );
       }
       break;
       default:
         std::cout << "Selection method unsupported" << std::endl;
-        return false;
+        bContinue = false;
+        continue;
     }
 
     //-- Export the masks
@@ -292,38 +420,33 @@ bool ColorHarmonizationEngineGlobal::Process()
       WriteImage( out_filename_J.c_str(), maskJ );
     }
 
-    //-- Compute the histograms
-    Image< RGBColor > imageI, imageJ;
-    ReadImage( p_imaNames.first.c_str(), &imageI );
-    ReadImage( p_imaNames.second.c_str(), &imageJ );
-
-    Histogram< double > histoI( minvalue, maxvalue, bin);
-    Histogram< double > histoJ( minvalue, maxvalue, bin);
-
-    int channelIndex = 0; // RED channel
-    color_harmonization::commonDataByPair::computeHisto( histoI, maskI, channelIndex, imageI );
-    color_harmonization::commonDataByPair::computeHisto( histoJ, maskJ, channelIndex, imageJ );
-    relativeColorHistogramEdge & edgeR = map_relativeHistograms[channelIndex][i];
-    edgeR = relativeColorHistogramEdge(map_cameraNodeToCameraIndex[I], map_cameraNodeToCameraIndex[J],
-      histoI.GetHist(), histoJ.GetHist());
-
-    histoI = histoJ = Histogram< double >( minvalue, maxvalue, bin);
-    channelIndex = 1; // GREEN channel
-    color_harmonization::commonDataByPair::computeHisto( histoI, maskI, channelIndex, imageI );
-    color_harmonization::commonDataByPair::computeHisto( histoJ, maskJ, channelIndex, imageJ );
-    relativeColorHistogramEdge & edgeG = map_relativeHistograms[channelIndex][i];
-    edgeG = relativeColorHistogramEdge(map_cameraNodeToCameraIndex[I], map_cameraNodeToCameraIndex[J],
-      histoI.GetHist(), histoJ.GetHist());
-
-    histoI = histoJ = Histogram< double >( minvalue, maxvalue, bin);
-    channelIndex = 2; // BLUE channel
-    color_harmonization::commonDataByPair::computeHisto( histoI, maskI, channelIndex, imageI );
-    color_harmonization::commonDataByPair::computeHisto( histoJ, maskJ, channelIndex, imageJ );
-    relativeColorHistogramEdge & edgeB = map_relativeHistograms[channelIndex][i];
-    edgeB = relativeColorHistogramEdge(map_cameraNodeToCameraIndex[I], map_cameraNodeToCameraIndex[J],
-      histoI.GetHist(), histoJ.GetHist());
+    //-- Compute the histograms (for the RED, GREEN and BLUE channels)
+    for (int channelIndex = 0; channelIndex < 3; ++channelIndex)
+    {
+      Histogram< double > histoI( minvalue, maxvalue, bin);
+      Histogram< double > histoJ( minvalue, maxvalue, bin);
+      color_harmonization::commonDataByPair::computeHisto( histoI, maskI, channelIndex, *imageI );
+      color_harmonization::commonDataByPair::computeHisto( histoJ, maskJ, channelIndex, *imageJ );
+      map_relativeHistograms[channelIndex][i] =
+        relativeColorHistogramEdge(
+          map_cameraNodeToCameraIndex.at(I), map_cameraNodeToCameraIndex.at(J),
+          histoI.GetHist(), histoJ.GetHist());
+    }
+
+#ifdef OPENMVG_USE_OPENMP
+#pragma omp critical
+#endif
+    ++my_progress_bar_edges;
   }
 
+  if (!bContinue)
+    return false;
+
+  const double time_histograms = timer_stage.elapsed();
+  std::cout << "\n Masks and histograms computation took (s): " << time_histograms << "\n"
+    << " #image decodings: " << image_cache.decoded_count()
+    << " for " << set_indeximage.size() << " images" << std::endl;
+
   std::cout << "\n -- \n SOLVE for color consistency with linear programming\n --" << std::endl;
   //-- Solve for the gains and offsets:
   std::vector<size_t> vec_indexToFix;
@@ -335,7 +458,7 @@ bool ColorHarmonizationEngineGlobal::Process()
   std::vector<double> vec_solution_g(_vec_fileNames.size() * 2 + 1);
   std::vector<double> vec_solution_b(_vec_fileNames.size() * 2 + 1);
 
-  openMVG::system::Timer timer;
+  timer_stage.reset();
 
   // Red channel
   {
@@ -370,10 +493,11 @@ bool ColorHarmonizationEngineGlobal::Process()
     lpSolver.solve();
     lpSolver.getSolution(vec_solution_b);
   }
+  const double time_solving = timer_stage.elapsed();
 
   std::cout << std::endl
     << " ColorHarmonization solving on a graph with: " << _map_Matches.size() << " edges took (s): "
-    << timer.elapsed() << std::endl
+    << time_solving << std::endl
     << "LInfinity fitting error: \n"
     << "- for the red channel is: " << vec_solution_r.back() << " gray level(s)" <<std::endl
     << "- for the green channel is: " << vec_solution_g.back() << " gray level(s)" << std::endl
@@ -391,6 +515,8 @@ bool ColorHarmonizationEngineGlobal::Process()
 
   std::cout << "\n\nThere is :\n" << set_indeximage.size() << " images to transform." << std::endl;
 
+  timer_stage.reset();
+
   //-> convert solution to gain offset and creation of the LUT per image
   C_Progress_display my_progress_bar( set_indeximage.size() );
   for (std::set<size_t>::const_iterator iterSet = set_indeximage.begin();
@@ -416,8 +542,12 @@ bool ColorHarmonizationEngineGlobal::Process()
       vec_map_lut[2][k] = clamp( k * g_b + offset_b, 0., 255. );
     }
 
-    Image< RGBColor > image_c;
-    ReadImage( _vec_fileNames[ imaNum ].c_str(), &image_c );
+    // Reuse the decoded image if it is still in the cache
+    const Image_Cache::ImagePtr image = image_cache.get(imaNum);
+    if (!image)
+      return false;
+    Pooled_Image< RGBColor > image_c( image_cache.pool(), image->Width(), image->Height() );
+    image_c = *image;
 
 #ifdef OPENMVG_USE_OPENMP
 #pragma omp parallel for
@@ -440,6 +570,15 @@ bool ColorHarmonizationEngineGlobal::Process()
 
     WriteImage( out_filename.c_str(), image_c );
   }
+  const double time_exporting = timer_stage.elapsed();
+
+  std::cout << "\n ColorHarmonization timings (s):\n"
+    << " - input data loading: " << time_loading << "\n"
+    << " - masks and histograms: " << time_histograms << "\n"
+    << " - gain/offset solving: " << time_solving << "\n"
+    << " - images correction and export: " << time_exporting << "\n"
+    << "\n Color image pool:\n" << image_cache.pool().Statistics() << "\n"
+    << " Mask image pool:\n" << mask_pool.Statistics() << std::endl;
   return true;
 }
 
@@ -26,7 +26,8 @@ public:
     const std::string & sMatchesFile,
     const std::string & sOutDirectory,
     const int selectionMethod = -1,
-    const int imgRef = -1);
+    const int imgRef = -1,
+    const unsigned int imageCacheSize = 64);
 
   ~ColorHarmonizationEngineGlobal();
 
@@ -49,6 +50,7 @@ private:
 
   int _selectionMethod;
   int _imgRef;
+  unsigned int _imageCacheSize; // Maximal count of decoded images kept in memory (0: unbounded)
   std::string _sMatchesFile;
 
   // -----
@@ -30,12 +30,14 @@ int main( int argc, char **argv )
   std::string sOutDir = "";
   int selectionMethod = -1;
   int imgRef = -1;
+  unsigned int image_cache_size = 64;
 
   cmd.add( make_option( 'i', sSfM_Data_Filename, "input_file" ) );
   cmd.add( make_option( 'm', sMatchesFile, "matchesFile" ) );
   cmd.add( make_option( 'o', sOutDir, "outdir" ) );
   cmd.add( make_option( 's', selectionMethod, "selectionMethod" ) );
   cmd.add( make_option( 'r', imgRef, "referenceImage" ) );
+  cmd.add( make_option( 'C', image_cache_size, "cache_size" ) );
 
   try
   {
@@ -51,6 +53,9 @@ int main( int argc, char **argv )
     << "\n[Optional]\n"
     << "[-s|--selectionMethod int]\n"
     << "[-r|--referenceImage int]\n"
+    << "[-C|--cache_size]\n"
+    << "  Maximal count of decoded images kept in memory (default: 64)\n"
+    << "  (0: unbounded, each image is decoded only once)\n"
     << std::endl;
 
     std::cerr << s << std::endl;
@@ -79,7 +84,8 @@ int main( int argc, char **argv )
     sMatchesFile,
     sOutDir,
     selectionMethod,
-    imgRef));
+    imgRef,
+    image_cache_size));
 
   if ( m_colorHarmonizeEngine->Process() )
   {